@@ -0,0 +1,213 @@
+/*
+ * K2579 Step Sequencer - Arpeggiator
+ *
+ * Copyright 2011: Kilpatrick Audio
+ * Written by: Andrew Kilpatrick
+ *
+ * Arpeggiator Handling
+ *  - the held keys of each part are kept as a 128 bit set so they are
+ *    always in pitch order - a key press or release is a single bit and
+ *    nothing is ever sorted
+ *  - the pattern remembers the last note it played, so the next note up
+ *    or down is found from the set even if the chord changed in between
+ *  - the keys are also kept in the order they were pressed for the
+ *    played and random modes - random uses the song's seeded generator
+ *    so it repeats like the random steps do
+ *  - the sequencer asks for the next note on each step
+ *
+ */
+#include "arp.h"
+#include "sequencer.h"
+
+// held keys
+unsigned int arp_held[2][4];  // bit set of MIDI notes
+unsigned char arp_played[2][ARP_MAX_NOTES];  // in the order pressed
+unsigned char arp_count[2];  // keys held
+
+// pattern position
+unsigned char arp_last[2];  // last note played or ARP_NO_NOTE to restart
+unsigned char arp_oct[2];  // current octave
+unsigned char arp_index[2];  // current played order index
+unsigned char arp_falling[2];  // ping pong is going down
+
+// local functions
+int arp_find_up(unsigned char part, int from);
+int arp_find_down(unsigned char part, int from);
+
+// initialize the arpeggiator
+void arp_init(void) {
+	arp_clear(0);
+	arp_clear(1);
+}
+
+// a key was pressed
+void arp_note_on(unsigned char part, unsigned char note) {
+	if(part > 1 || note > 127) return;
+	if(arp_held[part][note >> 5] & (1U << (note & 0x1f))) return;
+	if(arp_count[part] == ARP_MAX_NOTES) return;
+	arp_held[part][note >> 5] |= (1U << (note & 0x1f));
+	arp_played[part][arp_count[part]] = note;
+	arp_count[part] ++;
+}
+
+// a key was released
+void arp_note_off(unsigned char part, unsigned char note) {
+	int i;
+	if(part > 1 || note > 127) return;
+	if(!(arp_held[part][note >> 5] & (1U << (note & 0x1f)))) return;
+	arp_held[part][note >> 5] &= ~(1U << (note & 0x1f));
+	for(i = 0; i < arp_count[part]; i ++) {
+		if(arp_played[part][i] == note) break;
+	}
+	for(; i < (arp_count[part] - 1); i ++) {
+		arp_played[part][i] = arp_played[part][i + 1];
+	}
+	arp_count[part] --;
+	if(arp_count[part] == 0) arp_reset(part);
+}
+
+// release all keys of a part
+void arp_clear(unsigned char part) {
+	if(part > 1) return;
+	arp_held[part][0] = 0;
+	arp_held[part][1] = 0;
+	arp_held[part][2] = 0;
+	arp_held[part][3] = 0;
+	arp_count[part] = 0;
+	arp_reset(part);
+}
+
+// get the number of keys held on a part
+unsigned char arp_get_count(unsigned char part) {
+	if(part > 1) return 0;
+	return arp_count[part];
+}
+
+// restart the pattern from the beginning
+void arp_reset(unsigned char part) {
+	if(part > 1) return;
+	arp_last[part] = ARP_NO_NOTE;
+	arp_oct[part] = 0;
+	arp_index[part] = 0;
+	arp_falling[part] = 0;
+}
+
+// get the next MIDI note of the pattern - returns ARP_NO_NOTE if no keys are held
+unsigned char arp_next(unsigned char part, unsigned char mode, unsigned char octaves) {
+	int note;
+	if(part > 1) return ARP_NO_NOTE;
+	if(arp_count[part] == 0) return ARP_NO_NOTE;
+	if(octaves < 1) octaves = 1;
+	if(octaves > ARP_MAX_OCTAVES) octaves = ARP_MAX_OCTAVES;
+	if(arp_oct[part] >= octaves) arp_oct[part] = 0;
+
+	// up
+	if(mode == ARP_UP) {
+		if(arp_last[part] == ARP_NO_NOTE) note = -1;
+		else note = arp_find_up(part, arp_last[part]);
+		if(note == -1) {
+			if(arp_last[part] != ARP_NO_NOTE) arp_oct[part] ++;
+			if(arp_oct[part] >= octaves) arp_oct[part] = 0;
+			note = arp_find_up(part, -1);
+		}
+	}
+	// down
+	else if(mode == ARP_DOWN) {
+		if(arp_last[part] == ARP_NO_NOTE) {
+			arp_oct[part] = octaves - 1;
+			note = -1;
+		}
+		else note = arp_find_down(part, arp_last[part]);
+		if(note == -1) {
+			if(arp_last[part] != ARP_NO_NOTE) {
+				if(arp_oct[part] == 0) arp_oct[part] = octaves - 1;
+				else arp_oct[part] --;
+			}
+			note = arp_find_down(part, 128);
+		}
+	}
+	// ping pong - the end notes are not repeated
+	else if(mode == ARP_PINGPONG) {
+		if(arp_last[part] == ARP_NO_NOTE) {
+			note = arp_find_up(part, -1);
+		}
+		else if(arp_falling[part]) {
+			note = arp_find_down(part, arp_last[part]);
+			if(note == -1 && arp_oct[part] > 0) {
+				arp_oct[part] --;
+				note = arp_find_down(part, 128);
+			}
+			else if(note == -1) {
+				arp_falling[part] = 0;
+				note = arp_find_up(part, arp_last[part]);
+			}
+		}
+		else {
+			note = arp_find_up(part, arp_last[part]);
+			if(note == -1 && (arp_oct[part] + 1) < octaves) {
+				arp_oct[part] ++;
+				note = arp_find_up(part, -1);
+			}
+			else if(note == -1) {
+				arp_falling[part] = 1;
+				note = arp_find_down(part, arp_last[part]);
+			}
+		}
+		// a single key was left - play it again
+		if(note == -1) note = arp_find_up(part, -1);
+	}
+	// random
+	else if(mode == ARP_RANDOM) {
+		note = arp_played[part][(sequencer_rand() >> 4) % arp_count[part]];
+		arp_oct[part] = (sequencer_rand() >> 4) % octaves;
+	}
+	// as played
+	else if(mode == ARP_PLAYED) {
+		if(arp_last[part] != ARP_NO_NOTE) arp_index[part] ++;
+		if(arp_index[part] >= arp_count[part]) {
+			arp_index[part] = 0;
+			if(arp_last[part] != ARP_NO_NOTE) arp_oct[part] ++;
+			if(arp_oct[part] >= octaves) arp_oct[part] = 0;
+		}
+		note = arp_played[part][arp_index[part]];
+	}
+	else return ARP_NO_NOTE;
+
+	arp_last[part] = note;
+	note += arp_oct[part] * 12;
+	if(note > 127) note = 127;
+	return note;
+}
+
+//
+// local functions
+//
+// find the lowest held key above a note - returns -1 if there is none
+int arp_find_up(unsigned char part, int from) {
+	int n;
+	unsigned int bits;
+	for(n = from + 1; n < 128; n ++) {
+		bits = arp_held[part][n >> 5] >> (n & 0x1f);
+		if(bits == 0) {
+			n |= 0x1f;  // skip the rest of the word
+			continue;
+		}
+		if(bits & 0x01) return n;
+	}
+	return -1;
+}
+
+// find the highest held key below a note - returns -1 if there is none
+int arp_find_down(unsigned char part, int from) {
+	int n;
+	unsigned int bits;
+	for(n = from - 1; n >= 0; n --) {
+		bits = arp_held[part][n >> 5] << (0x1f - (n & 0x1f));
+		if(bits == 0) {
+			n &= ~0x1f;  // skip the rest of the word
+			continue;
+		}
+		if(bits & 0x80000000U) return n;
+	}
+	return -1;
+}
@@ -0,0 +1,41 @@
+/*
+ * K2579 Step Sequencer - Arpeggiator
+ *
+ * Copyright 2011: Kilpatrick Audio
+ * Written by: Andrew Kilpatrick
+ *
+ */
+// arp modes
+#define ARP_OFF 0
+#define ARP_UP 1
+#define ARP_DOWN 2
+#define ARP_PINGPONG 3
+#define ARP_RANDOM 4
+#define ARP_PLAYED 5  // in the order the keys were pressed
+#define ARP_MAX_MODE 5
+
+// limits
+#define ARP_MAX_OCTAVES 4
+#define ARP_MAX_NOTES 16  // held notes remembered in played order
+#define ARP_NO_NOTE 255
+
+// initialize the arpeggiator
+void arp_init(void);
+
+// a key was pressed
+void arp_note_on(unsigned char part, unsigned char note);
+
+// a key was released
+void arp_note_off(unsigned char part, unsigned char note);
+
+// release all keys of a part
+void arp_clear(unsigned char part);
+
+// get the number of keys held on a part
+unsigned char arp_get_count(unsigned char part);
+
+// restart the pattern from the beginning
+void arp_reset(unsigned char part);
+
+// get the next MIDI note of the pattern - returns ARP_NO_NOTE if no keys are held
+unsigned char arp_next(unsigned char part, unsigned char mode, unsigned char octaves);
@@ -1,266 +1,266 @@
-/*
- * K2579 Step Sequencer - Clock Timing Table
- *
- * Copyright 2011: Kilpatrick Audio
- * Written by: Andrew Kilpatrick
- *
- */
-unsigned int clock_table[] = {
-125000	,
-125000	,
-125000	,
-125000	,
-125000	,
-125000	,
-125000	,
-125000	,
-125000	,
-125000	,
-125000	,
-125000	,
-125000	,
-125000	,
-125000	,
-125000	,
-125000	,
-125000	,
-125000	,
-125000	,
-125000	,
-119048	,
-113636	,
-108696	,
-104167	,
-100000	,
-96154	,
-92593	,
-89286	,
-86207	,
-83333	,
-80645	,
-78125	,
-75758	,
-73529	,
-71429	,
-69444	,
-67568	,
-65789	,
-64103	,
-62500	,
-60976	,
-59524	,
-58140	,
-56818	,
-55556	,
-54348	,
-53191	,
-52083	,
-51020	,
-50000	,
-49020	,
-48077	,
-47170	,
-46296	,
-45455	,
-44643	,
-43860	,
-43103	,
-42373	,
-41667	,
-40984	,
-40323	,
-39683	,
-39063	,
-38462	,
-37879	,
-37313	,
-36765	,
-36232	,
-35714	,
-35211	,
-34722	,
-34247	,
-33784	,
-33333	,
-32895	,
-32468	,
-32051	,
-31646	,
-31250	,
-30864	,
-30488	,
-30120	,
-29762	,
-29412	,
-29070	,
-28736	,
-28409	,
-28090	,
-27778	,
-27473	,
-27174	,
-26882	,
-26596	,
-26316	,
-26042	,
-25773	,
-25510	,
-25253	,
-25000	,
-24752	,
-24510	,
-24272	,
-24038	,
-23810	,
-23585	,
-23364	,
-23148	,
-22936	,
-22727	,
-22523	,
-22321	,
-22124	,
-21930	,
-21739	,
-21552	,
-21368	,
-21186	,
-21008	,
-20833	,
-20661	,
-20492	,
-20325	,
-20161	,
-20000	,
-19841	,
-19685	,
-19531	,
-19380	,
-19231	,
-19084	,
-18939	,
-18797	,
-18657	,
-18519	,
-18382	,
-18248	,
-18116	,
-17986	,
-17857	,
-17730	,
-17606	,
-17483	,
-17361	,
-17241	,
-17123	,
-17007	,
-16892	,
-16779	,
-16667	,
-16556	,
-16447	,
-16340	,
-16234	,
-16129	,
-16026	,
-15924	,
-15823	,
-15723	,
-15625	,
-15528	,
-15432	,
-15337	,
-15244	,
-15152	,
-15060	,
-14970	,
-14881	,
-14793	,
-14706	,
-14620	,
-14535	,
-14451	,
-14368	,
-14286	,
-14205	,
-14124	,
-14045	,
-13966	,
-13889	,
-13812	,
-13736	,
-13661	,
-13587	,
-13514	,
-13441	,
-13369	,
-13298	,
-13228	,
-13158	,
-13089	,
-13021	,
-12953	,
-12887	,
-12821	,
-12755	,
-12690	,
-12626	,
-12563	,
-12500	,
-12438	,
-12376	,
-12315	,
-12255	,
-12195	,
-12136	,
-12077	,
-12019	,
-11962	,
-11905	,
-11848	,
-11792	,
-11737	,
-11682	,
-11628	,
-11574	,
-11521	,
-11468	,
-11416	,
-11364	,
-11312	,
-11261	,
-11211	,
-11161	,
-11111	,
-11062	,
-11013	,
-10965	,
-10917	,
-10870	,
-10823	,
-10776	,
-10730	,
-10684	,
-10638	,
-10593	,
-10549	,
-10504	,
-10460	,
-10417	,
-10373	,
-10331	,
-10288	,
-10246	,
-10204	,
-10163	,
-10121	,
-10081	,
-10040	,
-10000	,
-10000	,
-10000	,
-10000	,
-10000	,
-10000	
-};
-
+/*
+ * K2579 Step Sequencer - Clock Timing Table
+ *
+ * Copyright 2011: Kilpatrick Audio
+ * Written by: Andrew Kilpatrick
+ *
+ */
+unsigned int clock_table[] = {
+125000	,
+125000	,
+125000	,
+125000	,
+125000	,
+125000	,
+125000	,
+125000	,
+125000	,
+125000	,
+125000	,
+125000	,
+125000	,
+125000	,
+125000	,
+125000	,
+125000	,
+125000	,
+125000	,
+125000	,
+125000	,
+119048	,
+113636	,
+108696	,
+104167	,
+100000	,
+96154	,
+92593	,
+89286	,
+86207	,
+83333	,
+80645	,
+78125	,
+75758	,
+73529	,
+71429	,
+69444	,
+67568	,
+65789	,
+64103	,
+62500	,
+60976	,
+59524	,
+58140	,
+56818	,
+55556	,
+54348	,
+53191	,
+52083	,
+51020	,
+50000	,
+49020	,
+48077	,
+47170	,
+46296	,
+45455	,
+44643	,
+43860	,
+43103	,
+42373	,
+41667	,
+40984	,
+40323	,
+39683	,
+39063	,
+38462	,
+37879	,
+37313	,
+36765	,
+36232	,
+35714	,
+35211	,
+34722	,
+34247	,
+33784	,
+33333	,
+32895	,
+32468	,
+32051	,
+31646	,
+31250	,
+30864	,
+30488	,
+30120	,
+29762	,
+29412	,
+29070	,
+28736	,
+28409	,
+28090	,
+27778	,
+27473	,
+27174	,
+26882	,
+26596	,
+26316	,
+26042	,
+25773	,
+25510	,
+25253	,
+25000	,
+24752	,
+24510	,
+24272	,
+24038	,
+23810	,
+23585	,
+23364	,
+23148	,
+22936	,
+22727	,
+22523	,
+22321	,
+22124	,
+21930	,
+21739	,
+21552	,
+21368	,
+21186	,
+21008	,
+20833	,
+20661	,
+20492	,
+20325	,
+20161	,
+20000	,
+19841	,
+19685	,
+19531	,
+19380	,
+19231	,
+19084	,
+18939	,
+18797	,
+18657	,
+18519	,
+18382	,
+18248	,
+18116	,
+17986	,
+17857	,
+17730	,
+17606	,
+17483	,
+17361	,
+17241	,
+17123	,
+17007	,
+16892	,
+16779	,
+16667	,
+16556	,
+16447	,
+16340	,
+16234	,
+16129	,
+16026	,
+15924	,
+15823	,
+15723	,
+15625	,
+15528	,
+15432	,
+15337	,
+15244	,
+15152	,
+15060	,
+14970	,
+14881	,
+14793	,
+14706	,
+14620	,
+14535	,
+14451	,
+14368	,
+14286	,
+14205	,
+14124	,
+14045	,
+13966	,
+13889	,
+13812	,
+13736	,
+13661	,
+13587	,
+13514	,
+13441	,
+13369	,
+13298	,
+13228	,
+13158	,
+13089	,
+13021	,
+12953	,
+12887	,
+12821	,
+12755	,
+12690	,
+12626	,
+12563	,
+12500	,
+12438	,
+12376	,
+12315	,
+12255	,
+12195	,
+12136	,
+12077	,
+12019	,
+11962	,
+11905	,
+11848	,
+11792	,
+11737	,
+11682	,
+11628	,
+11574	,
+11521	,
+11468	,
+11416	,
+11364	,
+11312	,
+11261	,
+11211	,
+11161	,
+11111	,
+11062	,
+11013	,
+10965	,
+10917	,
+10870	,
+10823	,
+10776	,
+10730	,
+10684	,
+10638	,
+10593	,
+10549	,
+10504	,
+10460	,
+10417	,
+10373	,
+10331	,
+10288	,
+10246	,
+10204	,
+10163	,
+10121	,
+10081	,
+10040	,
+10000	,
+10000	,
+10000	,
+10000	,
+10000	,
+10000	
+};
+
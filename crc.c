@@ -0,0 +1,28 @@
+/*
+ * K2579 Step Sequencer - CRC Routines
+ *
+ * Copyright 2011: Kilpatrick Audio
+ * Written by: Andrew Kilpatrick
+ *
+ */
+#include "crc.h"
+
+// update a CRC-16 (CCITT) with a new byte
+unsigned int crc16_update(unsigned int crc, unsigned char data) {
+	int i;
+	crc ^= (data << 8);
+	for(i = 0; i < 8; i ++) {
+		if(crc & 0x8000) crc = (crc << 1) ^ 0x1021;
+		else crc = (crc << 1);
+	}
+	return crc & 0xffff;
+}
+
+// compute a CRC-16 (CCITT) over a buffer
+unsigned int crc16_buf(unsigned int crc, unsigned char buf[], int len) {
+	int i;
+	for(i = 0; i < len; i ++) {
+		crc = crc16_update(crc, buf[i]);
+	}
+	return crc;
+}
@@ -0,0 +1,14 @@
+/*
+ * K2579 Step Sequencer - CRC Routines
+ *
+ * Copyright 2011: Kilpatrick Audio
+ * Written by: Andrew Kilpatrick
+ *
+ */
+#define CRC16_INIT 0xffff
+
+// update a CRC-16 (CCITT) with a new byte
+unsigned int crc16_update(unsigned int crc, unsigned char data);
+
+// compute a CRC-16 (CCITT) over a buffer
+unsigned int crc16_buf(unsigned int crc, unsigned char buf[], int len);
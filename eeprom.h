@@ -1,16 +1,37 @@
-/*
- * K2579 Step Sequencer - EEPROM Driver
- *
- * Copyright 2011: Kilpatrick Audio
- * Written by: Andrew Kilpatrick
- *
- */
-// initialize the EEPROM driver
-void eeprom_init(void);
-
-// write a page of 32 bytes to the EEPROM
-void eeprom_write_page(int addr, unsigned char buf[]);
-
-// read a page of 32 bytes from the EEPROM
-void eeprom_read_page(int addr, unsigned char buf[]);
-
+/*
+ * K2579 Step Sequencer - EEPROM Driver
+ *
+ * Copyright 2011: Kilpatrick Audio
+ * Written by: Andrew Kilpatrick
+ *
+ */
+// 24LC64 memory map - 256 pages of 32 bytes
+//
+// - the 24LC64 ignores address bits A13-A15 so addresses alias every 8K
+//
+#define EEPROM_SIZE 0x2000
+#define EEPROM_PAGE_SIZE 32
+#define EEPROM_SYSTEM_ADDR 0x0000  // system config area - 32 pages
+#define EEPROM_SONG_DIR_ADDR 0x0400  // song directory - 1 page
+#define EEPROM_SONG_HEAP_ADDR 0x0420  // song data - remaining pages
+
+// initialize the EEPROM driver
+void eeprom_init(void);
+
+// write a page of 32 bytes to the EEPROM
+void eeprom_write_page(int addr, unsigned char buf[]);
+
+// read a page of 32 bytes from the EEPROM
+void eeprom_read_page(int addr, unsigned char buf[]);
+
+// read any number of bytes from the EEPROM in a single transaction
+void eeprom_read(int addr, unsigned char buf[], int len);
+
+// start a sequential read - returns 0 if the EEPROM did not respond
+unsigned char eeprom_read_start(int addr);
+
+// read the next byte of a sequential read - set last on the final byte
+unsigned char eeprom_read_byte(unsigned char last);
+
+// end a sequential read - this can be called before the last byte
+void eeprom_read_stop(void);
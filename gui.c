@@ -1,1494 +1,1724 @@
-/*
- * K2579 Step Sequencer - User Interface
- *
- * Copyright 2011: Kilpatrick Audio
- * Written by: Andrew Kilpatrick
- *
- */
-#include <stdio.h>
-#include <string.h>
-#include "gui.h"
-#include "panel.h"
-#include "song.h"
-#include "song_file.h"
-#include "sequencer.h"
-#include "eeprom.h"
-#include "scale.h"
-#include "sysconfig.h"
-#include "clock.h"
-#include "screen_handler.h"
-
-// menu modes
-char menu_mode;
-#define MENU_SEQ 0
-#define MENU_PART1 1
-#define MENU_PART2 2
-#define MENU_SYSTEM 3
-#define MENU_MAX_MENU 3
-char live_menu_override;
-
-// main page
-char seq_page;
-#define SEQ_START 0
-#define SEQ_LEN 1
-#define SEQ_STEP_LEN 2
-#define SEQ_LOOP 3
-#define SEQ_DIR 4
-#define SEQ_NEXT 5
-#define SEQ_CPY 6
-#define SEQ_CLR 7
-#define SEQ_MAX_PAGE 7
-
-// part pages
-char part1_page;
-char part2_page;
-#define PART_NOTE_SET 0
-#define PART_GATE_LEN 1
-#define PART_SCALE 2
-#define PART_SPAN 3
-#define PART_OFFSET 4
-#define PART_COPY 5
-#define PART_TRANS 6
-#define PART_MAX_PAGE 6
-
-// system page
-char system_page;
-#define SYSTEM_SONG_LOAD 0
-#define SYSTEM_SONG_SAV 1
-#define SYSTEM_SONG_CLR 2
-#define SYSTEM_CONTROL_CANCEL 3
-#define SYSTEM_CLK_DIV 4
-#define SYSTEM_RESET_MODE 5
-#define SYSTEM_MOD1_ASSN 6
-#define SYSTEM_MOD2_ASSN 7
-#define SYSTEM_LIVE_AUD 8
-#define SYSTEM_MIDI_PT1 9
-#define SYSTEM_MIDI_PT2 10
-#define SYSTEM_KEY_TRANSPOSE 11
-#define SYSTEM_KEY_TRIGGER 12
-#define SYSTEM_KEY_MAP 13
-#define SYSTEM_LCD_CONT 14
-#define SYSTEM_CV_CAL 15
-#define SYSTEM_FACTORY_RESET 16
-#define SYSTEM_MAX_PAGE 16
-
-// live page
-char live_page;
-#define LIVE_PLAY 0
-#define LIVE_SEQ 1
-#define LIVE_STEP 2
-#define LIVE_MAX_PAGE 2
-
-char current_edit_seq;
-char str[256];
-char temp;
-char temp2;
-unsigned char utemp;
-unsigned char utemp2;
-unsigned char pot1_val;
-unsigned char pot2_val;
-
-// event flags
-unsigned char startup_delay;
-unsigned char playback_updated;
-unsigned char control_override_updated;
-unsigned char song_load_updated;
-unsigned char song_save_updated;
-
-// UI events
-#define EVENT_NONE 0
-#define EVENT_PAGE_UP 1
-#define EVENT_PAGE_DOWN 2
-#define EVENT_PAGE_CLICK 3
-#define EVENT_ENTER_CLICK 4
-#define EVENT_POT1_CHANGE 5
-#define EVENT_POT2_CHANGE 6
-#define EVENT_REFRESH 7
-
-//
-// local functions
-//
-// page mode increment
-void gui_mode_inc(void);
-void gui_mode_live(void);
-// page dispatchers
-void gui_set_seq(char evnt);
-void gui_set_part(char evnt);
-void gui_set_system(char evnt);
-void gui_set_live(char evnt);
-//
-// page handlers
-//
-// global
-void gui_play_bar(void);
-// sequence
-void gui_seq_start(char event);
-void gui_seq_len(char event);
-void gui_seq_step_len(char event);
-void gui_seq_loop(char event);
-void gui_seq_dir(char event);
-void gui_seq_next(char event);
-void gui_seq_cpy(char event);
-void gui_seq_clr(char event);
-// part
-void gui_part_note_set(char event);
-void gui_part_gate_len(char event);
-void gui_part_scale(char event);
-void gui_part_span(char event);
-void gui_part_offset(char event);
-void gui_part_copy(char event);
-void gui_part_trans(char event);
-// system
-void gui_system_song_load(char event);
-void gui_system_song_sav(char event);
-void gui_system_song_clr(char event);
-void gui_system_midi_control_cancel(char event);
-void gui_system_clock_div(char event);
-void gui_system_reset_mode(char event);
-void gui_system_mod1_assign(char event);
-void gui_system_mod2_assign(char event);
-void gui_system_live_audition(char event);
-void gui_system_midi_pt1(char event);
-void gui_system_midi_pt2(char event);
-void gui_system_key_transpose(char event);
-void gui_system_key_trigger(char event);
-void gui_system_key_map(char event);
-void gui_system_lcd_cont(char event);
-void gui_system_cv_cal(char event);
-void gui_system_system_reset(char event);
-// live
-void gui_live_play(char event);
-void gui_live_seq(char event);
-void gui_live_step(char event);
-
-// initialize the GUI
-void gui_init(void) {
-	menu_mode = MENU_SEQ;
-	live_menu_override = 0;
-	seq_page = SEQ_START;
-	part1_page = PART_NOTE_SET;
-	part2_page = PART_NOTE_SET;
-	system_page = SYSTEM_SONG_LOAD;
-	live_page = LIVE_PLAY;
-	gui_set_seq(EVENT_REFRESH);
-	gui_play_bar();
-
-	// events
-	startup_delay = 10;
-	playback_updated = 0;
-	control_override_updated = 0;
-	song_load_updated = 0;
-	song_save_updated = 0;
-}
-
-// run this every 16ms
-void gui_task(void) {
-	unsigned char key;
-	unsigned char val;
-
-	// prevent panel controls from affecting system at startup
-	if(startup_delay) {
-		key = panel_get_sw();
-		pot1_val = panel_get_step_pot(0);
-		pot2_val = panel_get_step_pot(1);
-		startup_delay --;
-		return;
-	}
-
-	//
-	// PANEL CONTROLS
-	// 
-	key = panel_get_sw();
-	if(key == PANEL_MODE_SW) {
- 		gui_mode_inc();
-	}
-	else if(key == PANEL_ENTER_SW) {
-		if(live_menu_override) {
-			gui_set_live(EVENT_ENTER_CLICK);
-		}
-		else {
-			// sequence
-			if(menu_mode == MENU_SEQ) {
-				gui_set_seq(EVENT_ENTER_CLICK);
-			}
-			// part 1/2
-			else if(menu_mode == MENU_PART1 ||
-					menu_mode == MENU_PART2) {
-				gui_set_part(EVENT_ENTER_CLICK);
-			}
-			// system
-			else if(menu_mode == MENU_SYSTEM) {
-				gui_set_system(EVENT_ENTER_CLICK);
-			}
-		}
-	}
-	else if(key == PANEL_PAGE_UP_SW) {
-		if(live_menu_override) {
-			gui_set_live(EVENT_PAGE_UP);
-		}
-		else {
-			// system
-			if(menu_mode == MENU_SEQ) {
-				gui_set_seq(EVENT_PAGE_UP);
-			}
-			// part 1/2
-			else if(menu_mode == MENU_PART1 ||
-					menu_mode == MENU_PART2) {
-				gui_set_part(EVENT_PAGE_UP);
-			}
-			// system
-			else if(menu_mode == MENU_SYSTEM) {
-				gui_set_system(EVENT_PAGE_UP);
-			}
-		}	
-	}
-	else if(key == PANEL_PAGE_DOWN_SW) {
-		if(live_menu_override) {
-				gui_set_live(EVENT_PAGE_DOWN);
-		}
-		else {
-			// system
-			if(menu_mode == MENU_SEQ) {
-				gui_set_seq(EVENT_PAGE_DOWN);
-			}
-			// part 1/2
-			else if(menu_mode == MENU_PART1 ||
-					menu_mode == MENU_PART2) {
-				gui_set_part(EVENT_PAGE_DOWN);
-			}
-			// system
-			else if(menu_mode == MENU_SYSTEM) {
-				gui_set_system(EVENT_PAGE_DOWN);
-			}
-		}
-	}
-	else if(key == PANEL_LIVE_SW) {
-		gui_mode_live();
-	}
-	else if(key == PANEL_RUN_STOP_SW) {
-		clock_run_stop_toggle();
-	}
-	else if(key == PANEL_RESET_SW) {
-		clock_reset_input();
-	}
-
-	// value pots
-	val = panel_get_step_pot(0);
-	if(val != pot1_val) {
-		pot1_val = val;
-		if(live_menu_override) {
-			gui_set_live(EVENT_POT1_CHANGE);
-		}
-		else {
-			// system
-			if(menu_mode == MENU_SEQ) {
-				gui_set_seq(EVENT_POT1_CHANGE);
-			}
-			// part 1/2
-			else if(menu_mode == MENU_PART1 ||
-					menu_mode == MENU_PART2) {
-				gui_set_part(EVENT_POT1_CHANGE);
-			}
-			// system
-			else if(menu_mode == MENU_SYSTEM) {
-				gui_set_system(EVENT_POT1_CHANGE);
-			}
-		}
-	}
-
-	val = panel_get_step_pot(1);
-	if(val != pot2_val) {
-		pot2_val = val;
-		if(live_menu_override) {
-			gui_set_live(EVENT_POT2_CHANGE);
-		}
-		else {
-			// system
-			if(menu_mode == MENU_SEQ) {
-				gui_set_seq(EVENT_POT2_CHANGE);
-			}
-			// part 1/2
-			else if(menu_mode == MENU_PART1 ||
-					menu_mode == MENU_PART2) {
-				gui_set_part(EVENT_POT2_CHANGE);
-			}
-			// system
-			else if(menu_mode == MENU_SYSTEM) {
-				gui_set_system(EVENT_POT2_CHANGE);
-			}
-		}
-	}
-
-	// check if we're asking for LCD contrast set
-	if(panel_set_lcd_contrast()) {
-		menu_mode = MENU_SYSTEM;
-		system_page = SYSTEM_LCD_CONT;
-		gui_set_system(EVENT_REFRESH);
-	}
-
-	//
-	// UPDATE EVENTS
-	//
-	if(playback_updated) {
-		gui_play_bar();
-		playback_updated = 0;
-	}
-
-	if(control_override_updated) {
-		if(live_menu_override) {
-			gui_set_live(EVENT_NONE);
-		}
-		else if(menu_mode == MENU_SYSTEM && system_page == SYSTEM_KEY_MAP) {
-			gui_set_system(EVENT_REFRESH);
-		}
-		control_override_updated = 0;
-	}
-
-	if(song_load_updated) {
-		// current song name
-		if(!live_menu_override) {
-			if(menu_mode == MENU_SEQ) {
-				gui_set_seq(EVENT_REFRESH);
-			}
-			else if(menu_mode == MENU_SYSTEM) {
-				gui_set_system(EVENT_REFRESH);
-			}
-		}
-		sprintf(str, "song loaded %02d", (sysconfig_get_current_song() + 1));
-		screen_write_popup(2000, "", str);
-		song_load_updated = 0;
-	}
-
-	if(song_save_updated) {
-		// current song name
-		if(!live_menu_override) {
-			if(menu_mode == MENU_SEQ) {
-				gui_set_seq(EVENT_REFRESH);
-			}
-			else if(menu_mode == MENU_SYSTEM) {
-				gui_set_system(EVENT_REFRESH);
-			}
-		}
-		sprintf(str, "song saved %02d", (sysconfig_get_current_song() + 1));
-		screen_write_popup(2000, "", str);
-		song_save_updated = 0;
-	}
-}
-
-// notify the GUI that a playback value has changed
-void gui_playback_updated(void) {
-	playback_updated = 1;
-}
-
-// notify the GUI that a control override has changed
-void gui_control_override_updated(void) {
-	control_override_updated = 1;
-}
-
-// notify the GUI that a song has just been loaded
-void gui_song_load_updated(void) {
-	song_load_updated = 1;
-}
-
-// notify the GUI that a song has just been saved
-void gui_song_save_updated(void) {
-	song_save_updated = 1;
-}
-
-// change menu modes
-void gui_mode_inc(void) {
-	// cancel live mode without advancing to a new menu
-	if(live_menu_override) {
-		live_menu_override = 0;
-	}
-	else {
-		menu_mode ++;
-		if(menu_mode > MENU_MAX_MENU) menu_mode = 0;
-	}
-	if(menu_mode == MENU_SEQ) {
-		gui_set_seq(EVENT_REFRESH);
-	}
-	else if(menu_mode == MENU_PART1) {
-		gui_set_part(EVENT_REFRESH);
-	}
-	else if(menu_mode == MENU_PART2) {
-		gui_set_part(EVENT_REFRESH);
-	}
-	else if(menu_mode == MENU_SYSTEM) {
-		gui_set_system(EVENT_REFRESH);
-	}
-}
-
-// change to the live mode
-void gui_mode_live(void) {
-	live_menu_override = 1;
-	gui_set_live(EVENT_REFRESH);
-}
-
-// set the seq page
-void gui_set_seq(char evnt) {
-	char event = evnt;
-	if(menu_mode != MENU_SEQ) return;
-
-	// change pages
-	if(event == EVENT_PAGE_UP) {
-		seq_page ++;
-		if(seq_page > SEQ_MAX_PAGE) seq_page = SEQ_MAX_PAGE;
-		event = EVENT_REFRESH;
-	}
-	else if(event == EVENT_PAGE_DOWN) {
-		seq_page --;
-		if(seq_page < 0) seq_page = 0;
-		event = EVENT_REFRESH;
-	}
-
-	// dispatch page events
-	if(seq_page == SEQ_START) {
-		gui_seq_start(event);
-	}
-	else if(seq_page == SEQ_LEN) {
-		gui_seq_len(event);
-	}
-	else if(seq_page == SEQ_STEP_LEN) {
-		gui_seq_step_len(event);
-	}
-	else if(seq_page == SEQ_LOOP) {
-		gui_seq_loop(event);
-	}
-	else if(seq_page == SEQ_DIR) {
-		gui_seq_dir(event);
-	}
-	else if(seq_page == SEQ_NEXT) {
-		gui_seq_next(event);
-	}
-	else if(seq_page == SEQ_CPY) {
-		gui_seq_cpy(event);
-	}
-	else if(seq_page == SEQ_CLR) {
-		gui_seq_clr(event);
-	}
-}
-
-// set the part page and value
-void gui_set_part(char evnt) {
-	char event = evnt;
-	char page;
-	if(menu_mode != MENU_PART1 &&
-		menu_mode != MENU_PART2) return;
-
-	// change pages
-	if(event == EVENT_PAGE_UP) {
-		if(menu_mode == MENU_PART2) {
-			part2_page ++;
-			if(part2_page > PART_MAX_PAGE) part2_page = PART_MAX_PAGE;
-			event = EVENT_REFRESH;
-		}
-		else {
-			part1_page ++;
-			if(part1_page > PART_MAX_PAGE) part1_page = PART_MAX_PAGE;
-			event = EVENT_REFRESH;
-		}
-	}
-	else if(event == EVENT_PAGE_DOWN) {
-		if(menu_mode == MENU_PART2) {
-			part2_page --;
-			if(part2_page < 0) part2_page = 0;
-			event = EVENT_REFRESH;
-		}
-		else {
-			part1_page --;
-			if(part1_page < 0) part1_page = 0;
-			event = EVENT_REFRESH;
-		}
-	}
-
-	if(menu_mode == MENU_PART2) {
-		page = part2_page;
-	}
-	else {
-		page = part1_page;
-	}
-
-	// dispatch page events
-	if(page == PART_NOTE_SET) {
-		gui_part_note_set(event);
-	}
-	else if(page == PART_GATE_LEN) {
-		gui_part_gate_len(event);
-	}
-	else if(page == PART_SCALE) {
-		gui_part_scale(event);
-	}
-	else if(page == PART_SPAN) {
-		gui_part_span(event);
-	}
-	else if(page == PART_OFFSET) {
-		gui_part_offset(event);
-	}
-	else if(page == PART_COPY) {
-		gui_part_copy(event);
-	}
-	else if(page == PART_TRANS) {
-		gui_part_trans(event);
-	}
-}
-
-// set the system page and value
-void gui_set_system(char evnt) {
-	char event = evnt;
-	if(menu_mode != MENU_SYSTEM) return;
-
-	// change pages
-	if(event == EVENT_PAGE_UP) {
-		system_page ++;
-		if(system_page > SYSTEM_MAX_PAGE) system_page = SYSTEM_MAX_PAGE;
-		event = EVENT_REFRESH;
-	}
-	else if(event == EVENT_PAGE_DOWN) {
-		system_page --;
-		if(system_page < 0) system_page = 0;
-		event = EVENT_REFRESH;
-	}
-
-	// dispatch page events
-	if(system_page == SYSTEM_SONG_LOAD) {
-		gui_system_song_load(event);
-	}
-	else if(system_page == SYSTEM_SONG_SAV) {
-		gui_system_song_sav(event);
-	}
-	else if(system_page == SYSTEM_SONG_CLR) {
-		gui_system_song_clr(event);
-	}
-	else if(system_page == SYSTEM_CONTROL_CANCEL) {
-		gui_system_midi_control_cancel(event);
-	}
-	else if(system_page == SYSTEM_CLK_DIV) {
-		gui_system_clock_div(event);
-	}
-	else if(system_page == SYSTEM_RESET_MODE) {
-		gui_system_reset_mode(event);
-	}
-	else if(system_page == SYSTEM_MOD1_ASSN) {
-		gui_system_mod1_assign(event);
-	}
-	else if(system_page == SYSTEM_MOD2_ASSN) {
-		gui_system_mod2_assign(event);
-	}
-	else if(system_page == SYSTEM_LIVE_AUD) {
-		gui_system_live_audition(event);
-	}
-	else if(system_page == SYSTEM_MIDI_PT1) {
-		gui_system_midi_pt1(event);
-	}
-	else if(system_page == SYSTEM_MIDI_PT2) {
-		gui_system_midi_pt2(event);
-	}
-	else if(system_page == SYSTEM_KEY_TRANSPOSE) {
-		gui_system_key_transpose(event);
-	}
-	else if(system_page == SYSTEM_KEY_TRIGGER) {
-		gui_system_key_trigger(event);
-	}
-	else if(system_page == SYSTEM_KEY_MAP) {
-		gui_system_key_map(event);
-	}
-	else if(system_page == SYSTEM_LCD_CONT) {
-		gui_system_lcd_cont(event);
-	}
-	else if(system_page == SYSTEM_CV_CAL) {
-		gui_system_cv_cal(event);
-	}
-	else if(system_page == SYSTEM_FACTORY_RESET) {
-		gui_system_system_reset(event);
-	}
-}
-
-// set the live page and value 
-void gui_set_live(char evnt) {
-	char event = evnt;
-	// change pages
-	if(event == EVENT_PAGE_UP) {
-		live_page ++;
-		if(live_page > LIVE_MAX_PAGE) live_page = LIVE_MAX_PAGE;
-		event = EVENT_REFRESH;
-	}
-	else if(event == EVENT_PAGE_DOWN) {
-		live_page --;
-		if(live_page < 0) live_page = 0;
-		event = EVENT_REFRESH;
-	}
-	
-	if(live_page == LIVE_PLAY) {
-		gui_live_play(event);
-	}
-	else if(live_page == LIVE_SEQ) {
-		gui_live_seq(event);
-	}
-	else if(live_page == LIVE_STEP) {
-		gui_live_step(event);
-	}
-}
-
-//
-// PAGE HANDLERS
-//
-// lower play bar
-void gui_play_bar(void) {
-	unsigned char play_seq = sequencer_get_current_seq();
-	unsigned char play_step_pos = sequencer_get_current_step_index();
-	unsigned char play_playing = clock_get_song_playing();
-	if(play_playing) {
-		sprintf(str, "playing:  %02d:%02d", play_seq + 1, play_step_pos + 1);
-	}
-	else {
-		sprintf(str, "stopped:  %02d:%02d", play_seq + 1, play_step_pos + 1);
-	}
-	screen_write_line(2, str);
-}
-
-// seq start
-void gui_seq_start(char event) {
-	if(event == EVENT_REFRESH) {
-		screen_write_line(0, "SEQ START");
-	}
-	else if(event == EVENT_POT1_CHANGE) {
-		current_edit_seq = (pot1_val >> 4) & 0x0f;	
-	}
-	else if(event == EVENT_POT2_CHANGE) {
-		song_set_seq_start(current_edit_seq, (pot2_val >> 4) & 0x0f);
-	}
-
-	sprintf(str, " %02d    step %02d", (current_edit_seq + 1), 
-		song_get_seq_start(current_edit_seq) + 1);
-	screen_write_line(1, str);
-}
-
-// seq length
-void gui_seq_len(char event) {
-	if(event == EVENT_REFRESH) {
-		screen_write_line(0, "SEQ LENGTH");
-	}
-	else if(event == EVENT_POT1_CHANGE) {
-		current_edit_seq = (pot1_val >> 4) & 0x0f;		
-	}
-	else if(event == EVENT_POT2_CHANGE) {
-		song_set_seq_len(current_edit_seq, ((pot2_val >> 4) & 0x0f) + 1);
-	}
-
-	sprintf(str, " %02d   steps %02d", (current_edit_seq + 1), 
-		song_get_seq_len(current_edit_seq));
-	screen_write_line(1, str);
-}
-
-// seq step length
-void gui_seq_step_len(char event) {
-	if(event == EVENT_REFRESH) {
-		sprintf(str, "SEQ %02d STEP LEN", (current_edit_seq + 1));
-		screen_write_line(0, str);
-		temp = (pot1_val >> 4) & 0x0f;
-	}
-	else if(event == EVENT_POT1_CHANGE) {
-		temp = (pot1_val >> 4) & 0x0f;
-	}
-	else if(event == EVENT_POT2_CHANGE) {
-		song_set_step_len(current_edit_seq, temp, ((pot2_val >> 3) & 0x1f));
-	}
-
-	char len = song_get_step_len(current_edit_seq, temp);
-	if(len == 0) {
-		sprintf(str, "st %02d   len DIV", (temp + 1));
-	}
-	else {
-		sprintf(str, "st %02d   len %02d", (temp + 1), len);
-	}
-	screen_write_line(1, str);
-}
-
-// seq loop
-void gui_seq_loop(char event) {
-	if(event == EVENT_REFRESH) {
-		screen_write_line(0, "SEQ LOOP");
-	}
-	else if(event == EVENT_POT1_CHANGE) {
-		current_edit_seq = (pot1_val >> 4) & 0x0f;	
-	}
-	else if(event == EVENT_POT2_CHANGE) {
-		song_set_seq_loop(current_edit_seq, (pot2_val >> 4) & 0x0f);
-	}
-
-	sprintf(str, " %02d  counts %02d", (current_edit_seq + 1), song_get_seq_loop(current_edit_seq));
-	screen_write_line(1, str);
-}
-
-// seq direction
-void gui_seq_dir(char event) {
-	char dir;
-	if(event == EVENT_REFRESH) {
-		screen_write_line(0, "SEQ DIRECTION");
-	}
-	else if(event == EVENT_POT1_CHANGE) {
-		current_edit_seq = (pot1_val >> 4) & 0x0f;
-	}
-	else if(event == EVENT_POT2_CHANGE) {
-		song_set_seq_dir(current_edit_seq, (pot2_val >> 6) & 0x03);
-	}
-	dir = song_get_seq_dir(current_edit_seq);
-	
-	if(dir == SONG_DIR_BACK) {
-		sprintf(str, " %02d        bkwd", (current_edit_seq + 1));
-	}
-	else if(dir == SONG_DIR_PONG) {
-		sprintf(str, " %02d        pong", (current_edit_seq + 1));
-	}
-	else if(dir == SONG_DIR_RAND) {
-		sprintf(str, " %02d        rand", (current_edit_seq + 1));
-	}
-	else if(dir == SONG_DIR_FWD) {
-		sprintf(str, " %02d        fwd", (current_edit_seq + 1));
-	}
-	screen_write_line(1, str);
-}
-
-// seq next
-void gui_seq_next(char event) {
-	char next;
-	if(event == EVENT_REFRESH) {
-		screen_write_line(0, "SEQ NEXT");
-	}
-	else if(event == EVENT_POT1_CHANGE) {
-		current_edit_seq = (pot1_val >> 4) & 0x0f;
-	}
-	else if(event == EVENT_POT2_CHANGE) {
-		song_set_seq_next(current_edit_seq, (pot2_val >> 4) & 0x0f);
-	}
-	next = song_get_seq_next(current_edit_seq);
-	
-	if(next == current_edit_seq) {
-		sprintf(str, " %02d  to seq %02d*", (current_edit_seq + 1), (next + 1));
-	}
-	else {
-		sprintf(str, " %02d  to seq %02d", (current_edit_seq + 1), (next + 1));
-	}
-	screen_write_line(1, str);
-}
-
-// seq copy
-void gui_seq_cpy(char event) {
-	if(event == EVENT_REFRESH) {
-		temp = current_edit_seq;
-		temp2 = temp;
-		screen_write_line(0, "SEQ COPY");
-	}
-	else if(event == EVENT_POT1_CHANGE) {
-		temp = (pot1_val >> 4) & 0x0f;	
-	}
-	else if(event == EVENT_POT2_CHANGE) {
-		temp2 = (pot2_val >> 4) & 0x0f;
-	}
-	else if(event == EVENT_ENTER_CLICK) {
-		song_copy_seq(temp2, temp);
-		screen_write_popup(750, "SEQ COPY", "copied");
-	}
-
-	sprintf(str, " %02d copy to %02d?", temp + 1, temp2 + 1);
-	screen_write_line(1, str);
-}
-
-// seq clear
-void gui_seq_clr(char event) {
-	if(event == EVENT_REFRESH) {
-		temp = current_edit_seq;
-		screen_write_line(0, "SEQ CLEAR");
-	}
-	else if(event == EVENT_POT1_CHANGE) {
-		temp = (pot1_val >> 4) & 0x0f;
-	}
-	else if(event == EVENT_ENTER_CLICK) {
-		song_clear_seq(temp);
-		screen_write_popup(750, "SEQ CLR", "cleared");
-	}
-
-	sprintf(str, " %02d      clear?", temp + 1);
-	screen_write_line(1, str);
-}
-
-// part note set
-void gui_part_note_set(char event) {
-	unsigned char part;
-	unsigned char note;
-	unsigned char span;
-	unsigned char audition;
-	if(menu_mode == MENU_PART2) part = 1;
-	else part = 0;
-
-	audition = 0;
-	if(event == EVENT_REFRESH) {
-		if(part) {
-			sprintf(str, "PART 2 SEQ %02d", (current_edit_seq + 1));
-		}
-		else {
-			sprintf(str, "PART 1 SEQ %02d ", (current_edit_seq + 1));
-		}
-		screen_write_line(0, str);
-		temp = 0;  // step note
-	}
-	else if(event == EVENT_POT1_CHANGE) {
-		temp = (pot1_val >> 4) & 0x0f;
-		audition = 1;
-	}
-	else if(event == EVENT_POT2_CHANGE) {
-		note = (pot2_val >> 2) & 0x3f;
-		span = song_get_span(current_edit_seq, part);
-		if(note < 52) {
-			// adjust span to reduce the pot resolution
-			// span = 1 - 0-12
-			if(span == 1) note = note / 4;
-			// span = 2 - 0-24
-			else if(span == 2) {
-				note = note / 2;
-				if(note > 24) note = 24;
-			}
-			// span = 3 - 0-36
-			else if(span == 3) {
-				note = (note / 4) * 2;
-				if(note > 36) note = 36;
-			}
-		}
-		else if(note > 51 && note < 55) note = SONG_STEP_RAND;
-		else if(note > 55 && note < 60) note = SONG_STEP_NONE;
-		else if(note > 57) note = SONG_STEP_REST;
-
-		// scale quantize
-		note = scale_quantize(note, song_get_scale(current_edit_seq, part));
-		song_set_note(current_edit_seq, part, temp, note);
-		audition = 1;
-	}
-
-	// get the note to display / audition
-	note = scale_quantize(song_get_note(current_edit_seq, part, temp), 
-		song_get_scale(current_edit_seq, part));
-	note = scale_span_adjust(note, song_get_span(current_edit_seq, part));
-
-	// audition the note
-	if(audition && sysconfig_get_live_aud() && note < 49) {
-		sequencer_play_audition_note(part, note);
-	}
-
-	char notename[16];
-	scale_note_to_name(note, song_get_scale(current_edit_seq, part), notename);	
-	sprintf(str, "st %02d  note %s", temp + 1, notename);
-	screen_write_line(1, str);
-}
-
-// part gate len
-void gui_part_gate_len(char event) {
-	unsigned char part;
-	if(menu_mode == MENU_PART2) part = 1;
-	else part = 0;
-
-	if(event == EVENT_REFRESH) {
-		if(part) {
-			sprintf(str, "PART 2 SEQ %02d", (current_edit_seq + 1));
-		}
-		else {
-			sprintf(str, "PART 1 SEQ %02d ", (current_edit_seq + 1));
-		}
-		screen_write_line(0, str);
-	}
-	else if(event == EVENT_POT2_CHANGE) {
-		song_set_gate(current_edit_seq, part, (pot2_val >> 2) & 0x3f);
-	}
-
-	sprintf(str, "gate length %02d", song_get_gate(current_edit_seq, part));
-	screen_write_line(1, str);
-}
-
-// part scale
-void gui_part_scale(char event) {
-	unsigned char part;
-	if(menu_mode == MENU_PART2) part = 1;
-	else part = 0;
-
-	if(event == EVENT_REFRESH) {
-		if(part) {
-			sprintf(str, "PART 2 SEQ %02d", (current_edit_seq + 1));
-		}
-		else {
-			sprintf(str, "PART 1 SEQ %02d ", (current_edit_seq + 1));
-		}
-		screen_write_line(0, str);
-	}
-	else if(event == EVENT_POT2_CHANGE) {
-		song_set_scale(current_edit_seq, part, (pot2_val >> 5) & 0x07);
-	}
-
-	char scalename[16];
-	scale_type_to_name(song_get_scale(current_edit_seq, part), scalename);
-
-	sprintf(str, "scale %s", scalename);
-	screen_write_line(1, str);
-}
-
-// part span
-void gui_part_span(char event) {
-	unsigned char part;
-	if(menu_mode == MENU_PART2) part = 1;
-	else part = 0;
-
-	if(event == EVENT_REFRESH) {
-		if(part) {
-			sprintf(str, "PART 2 SEQ %02d", (current_edit_seq + 1));
-		}
-		else {
-			sprintf(str, "PART 1 SEQ %02d ", (current_edit_seq + 1));
-		}
-		screen_write_line(0, str);
-	}
-	else if(event == EVENT_POT2_CHANGE) {
-		song_set_span(current_edit_seq, part, ((pot2_val >> 6) & 0x03) + 1);
-	}
-
-	char span = song_get_span(current_edit_seq, part);
-
-	sprintf(str, "octave span %2d", span);
-	screen_write_line(1, str);
-}
-
-// part offset
-void gui_part_offset(char event) {
-	unsigned char part;
-	if(menu_mode == MENU_PART2) part = 1;
-	else part = 0;
-
-	if(event == EVENT_REFRESH) {
-		if(part) {
-			sprintf(str, "PART 2 SEQ %02d", (current_edit_seq + 1));
-		}
-		else {
-			sprintf(str, "PART 1 SEQ %02d ", (current_edit_seq + 1));
-		}
-		screen_write_line(0, str);
-	}
-	else if(event == EVENT_POT2_CHANGE) {
-		song_set_offset(current_edit_seq, part, (char)((pot2_val >> 3) & 0x1f) - 16);
-	}
-
-	char offset = song_get_offset(current_edit_seq, part);
-	if(offset == 0) {
-		sprintf(str, "note offset  0");		
-	}
-	else if(offset > -10 && offset < 10) {
-		sprintf(str, "note offset %+2d", offset);
-	}
-	else {
-		sprintf(str, "note offset %+2d", offset);
-	}
-	screen_write_line(1, str);
-}
-
-// part copy
-void gui_part_copy(char event) {
-	unsigned char part;
-	if(menu_mode == MENU_PART2) part = 1;
-	else part = 0;
-
-	if(event == EVENT_REFRESH) {
-		temp = 0;
-		if(part) {
-			sprintf(str, "PART 2 SEQ %02d", (current_edit_seq + 1));
-		}
-		else {
-			sprintf(str, "PART 1 SEQ %02d ", (current_edit_seq + 1));
-		}
-		screen_write_line(0, str);
-	}
-	else if(event == EVENT_POT2_CHANGE) {
-		temp = (pot2_val >> 7) & 0x01;
-	}
-	else if(event == EVENT_ENTER_CLICK) {
-		song_part_copy(current_edit_seq, temp);
-		screen_write_popup(750, "", "copied");
-	}
-	
-	if(temp == 0) {
-		sprintf(str, "part copy  1>2?");
-	}
-	else {
-		sprintf(str, "part copy  2>1?");
-	}
-	screen_write_line(1, str);
-}
-
-// part trans
-void gui_part_trans(char event) {
-	unsigned char part;
-	if(menu_mode == MENU_PART2) part = 1;
-	else part = 0;
-
-	if(event == EVENT_REFRESH) {
-		temp = 0;
-		if(part) {
-			sprintf(str, "PART 2 SEQ %02d", (current_edit_seq + 1));
-		}
-		else {
-			sprintf(str, "PART 1 SEQ %02d ", (current_edit_seq + 1));
-		}
-		screen_write_line(0, str);
-	}
-	else if(event == EVENT_POT2_CHANGE) {
-		temp = (pot2_val >> 6) & 0x03;
-	}
-	else if(event == EVENT_ENTER_CLICK) {
-		if(temp == 3) {
-			song_part_clear(current_edit_seq, part);
-			screen_write_popup(750, "", "cleared");
-		}
-		else if(temp == 2) {
-			song_part_randomize(current_edit_seq, part);
-			screen_write_popup(750, "", "randomized");
-		}
-		else if(temp == 1) {
-			song_part_retrograde(current_edit_seq, part);
-			screen_write_popup(750, "", "retrograded");
-		}
-		else {
-			song_part_invert(current_edit_seq, part);
-			screen_write_popup(750, "", "inverted");
-		}
-	}
-
-	if(temp == 0) {
-		sprintf(str, "part     invert?");
-	}
-	else if(temp == 1) {
-		sprintf(str, "part retrograde?");
-	}
-	else if(temp == 2) {
-		sprintf(str, "part  randomize?");
-	}
-	else {
-		sprintf(str, "part      clear?");
-	}
-	screen_write_line(1, str);
-}
-
-// system song load
-void gui_system_song_load(char event) {
-	if(event == EVENT_REFRESH) {
-		screen_write_line(0, "SONG LOAD");
-		temp = sysconfig_get_current_song();
-	}
-	else if(event == EVENT_POT2_CHANGE) {
-		temp = (pot2_val >> 5) & 0x07;
-	}
-	if(event == EVENT_ENTER_CLICK) {
-		song_file_load(temp);
-	}
-
-	if(temp == sysconfig_get_current_song()) {
-		sprintf(str, "  load song %02d*?", (temp + 1));
-	}
-	else {
-		sprintf(str, "  load song %02d ?", (temp + 1));
-	}
-	screen_write_line(1, str);
-}
-
-// system song save
-void gui_system_song_sav(char event) {
-	if(event == EVENT_REFRESH) {
-		screen_write_line(0, "SONG SAVE");
-		temp = sysconfig_get_current_song();
-	}
-	else if(event == EVENT_POT2_CHANGE) {
-		temp = (pot2_val >> 5) & 0x07;
-	}
-	else if(event == EVENT_ENTER_CLICK) {
-		song_file_save(temp);
-	}
-
-	if(temp == sysconfig_get_current_song()) {
-		sprintf(str, "  save song %02d*?", (temp + 1));
-	}
-	else {
-		sprintf(str, "  save song %02d ?", (temp + 1));
-	}
-	screen_write_line(1, str);
-}
-
-// syste, song clear
-void gui_system_song_clr(char event) {
-	if(event == EVENT_REFRESH) {
-		screen_write_line(0, "SONG CLEAR");
-	}
-	else if(event == EVENT_ENTER_CLICK) {
-		song_clear_song();
-		screen_write_popup(750, "SONG CLEAR", "cleared");
-	}
-	screen_write_line(1, "     song clear?");
-}
-
-// system MIDI control cancel
-void gui_system_midi_control_cancel(char event) {
-	if(event == EVENT_REFRESH) {
-		screen_write_line(0, "MOD CTRL CANCEL");
-	}
-	else if(event == EVENT_ENTER_CLICK) {
-		sequencer_control_restore();
-		screen_write_popup(750, "", "canceled");
-	}
-	screen_write_line(1, " control cancel?");
-}
-
-// system clock divide
-void gui_system_clock_div(char event) {
-	if(event == EVENT_REFRESH) {
-		screen_write_line(0, "CLOCK DIVIDER");
-	}
-	else if(event == EVENT_POT2_CHANGE) {
-		sysconfig_set_clock_div(((pot2_val >> 3) & 0x1f) + 1);
-	}
-	sprintf(str, "div ratio   1/%d", sysconfig_get_clock_div());
-	screen_write_line(1, str);
-}
-
-// system reset mode
-void gui_system_reset_mode(char event) {
-	if(event == EVENT_REFRESH) {
-		screen_write_line(0, "RESET MODE");
-	}
-	else if(event == EVENT_POT2_CHANGE) {
-		sysconfig_set_reset_mode((pot2_val >> 7) & 0x01);
-	}
-	if(sysconfig_get_reset_mode()) {
-		sprintf(str, "reset mode  SEQ");
-	}
-	else {
-		sprintf(str, "reset mode  SONG");
-	}
-	screen_write_line(1, str);
-
-}
-
-// system mod1 assign
-void gui_system_mod1_assign(char event) {
-	char assign;
-	if(event == EVENT_REFRESH) {
-		screen_write_line(0, "MOD1 CV ASSIGN");
-	}
-	else if(event == EVENT_POT2_CHANGE) {
-		sysconfig_set_mod_assign(0, (pot2_val >> 5) & 0x07);
-	}
-
-	assign = sysconfig_get_mod_assign(0);
-	if(assign == SYSCONFIG_MOD_NONE) {
-		sprintf(str, " 1 none");
-	}
-	else if(assign == SYSCONFIG_MOD_NEXT_SEQ) {
-		sprintf(str, " 1 seq next");
-	}
-	else if(assign == SYSCONFIG_MOD_SEQ_START) {
-		sprintf(str, " 1 seq start");
-	}
-	else if(assign == SYSCONFIG_MOD_SEQ_LEN) {
-		sprintf(str, " 1 seq length");
-	}
-	else if(assign == SYSCONFIG_MOD_RUN_STOP) {
-		sprintf(str, " 1 seq run/stop");
-	}
-	else if(assign == SYSCONFIG_MOD_GATE1) {
-		sprintf(str, " 1 gate 1 time");
-	}
-	else if(assign == SYSCONFIG_MOD_GATE2) {
-		sprintf(str, " 1 gate 2 time");
-	}
-	else if(assign == SYSCONFIG_MOD_SEQ_DIR) {
-		sprintf(str, " 1 seq direction");
-	}
-	screen_write_line(1, str);
-}
-
-// system mod2 assign
-void gui_system_mod2_assign(char event) {
-	char assign;
-	if(event == EVENT_REFRESH) {
-		screen_write_line(0, "MOD2 CV ASSIGN");
-	}
-	else if(event == EVENT_POT2_CHANGE) {
-		sysconfig_set_mod_assign(1, (pot2_val >> 5) & 0x07);
-	}
-
-	assign = sysconfig_get_mod_assign(1);
-	if(assign == SYSCONFIG_MOD_NONE) {
-		sprintf(str, " 2 none");
-	}
-	else if(assign == SYSCONFIG_MOD_NEXT_SEQ) {
-		sprintf(str, " 2 seq next");
-	}
-	else if(assign == SYSCONFIG_MOD_SEQ_START) {
-		sprintf(str, " 2 seq start");
-	}
-	else if(assign == SYSCONFIG_MOD_SEQ_LEN) {
-		sprintf(str, " 2 seq length");
-	}
-	else if(assign == SYSCONFIG_MOD_RUN_STOP) {
-		sprintf(str, " 2 seq run/stop");
-	}
-	else if(assign == SYSCONFIG_MOD_GATE1) {
-		sprintf(str, " 2 gate 1 time");
-	}
-	else if(assign == SYSCONFIG_MOD_GATE2) {
-		sprintf(str, " 2 gate 2 time");
-	}
-	else if(assign == SYSCONFIG_MOD_SEQ_DIR) {
-		sprintf(str, " 2 seq direction");
-	}
-	screen_write_line(1, str);
-}
-
-// system live audition
-void gui_system_live_audition(char event) {
-	if(event == EVENT_REFRESH) {
-		screen_write_line(0, "LIVE AUDITION");
-	}
-	else if(event == EVENT_POT2_CHANGE) {
-		sysconfig_set_live_aud((pot2_val >> 7) & 0x01);
-	}
-
-	if(sysconfig_get_live_aud()) screen_write_line(1, "live aud    on");
-	else screen_write_line(1, "live aud    off");
-}
-
-// system MIDI part 1
-void gui_system_midi_pt1(char event) {
-	if(event == EVENT_REFRESH) {
-		screen_write_line(0, "MIDI PART 1");
-	}
-	else if(event == EVENT_POT2_CHANGE) {
-		sysconfig_set_midi_channel(0, (pot2_val >> 4) & 0x0f);
-	}
-	sprintf(str, "channel     %02d", sysconfig_get_midi_channel(0) + 1);
-	screen_write_line(1, str);
-}
-
-// system MIDI part 2
-void gui_system_midi_pt2(char event) {
-	if(event == EVENT_REFRESH) {
-		screen_write_line(0, "MIDI PART 2");
-	}
-	else if(event == EVENT_POT2_CHANGE) {
-		sysconfig_set_midi_channel(1, (pot2_val >> 4) & 0x0f);
-	}
-	sprintf(str, "channel     %02d", sysconfig_get_midi_channel(1) + 1);
-	screen_write_line(1, str);
-}
-
-// system key transpose
-void gui_system_key_transpose(char event) {
-	if(event == EVENT_REFRESH) {
-		screen_write_line(0, "KEY TRANSPOSE");
-	}
-	else if(event == EVENT_POT2_CHANGE) {
-		sysconfig_set_key_transpose((pot2_val >> 6) & 0x03);
-	}
-	char transpose = sysconfig_get_key_transpose();
-	if(transpose == SYSCONFIG_KEY_TRANSPOSE1) sprintf(str, "transpose part 1");
-	else if(transpose == SYSCONFIG_KEY_TRANSPOSE2) sprintf(str, "transpose part 2");
-	else if(transpose == SYSCONFIG_KEY_TRANSPOSE12) sprintf(str, "transpose both");
-	else sprintf(str, "transpose off");
-	screen_write_line(1, str);
-}
-
-// system key trigger
-void gui_system_key_trigger(char event) {
-	if(event == EVENT_REFRESH) {
-		screen_write_line(0, "KEY TRIGGER");
-	}
-	else if(event == EVENT_POT2_CHANGE) {
-		sysconfig_set_key_trigger(pot2_val >> 6);
-	}
-	if(sysconfig_get_key_trigger() == SYSCONFIG_KEY_TRIGGER_MOM) sprintf(str, "trigger    mom");
-	else sprintf(str, "trigger    latch");
-	screen_write_line(1, str);
-}
-
-// system key map
-void gui_system_key_map(char event) {
-	if(event == EVENT_REFRESH) {
-		screen_write_line(0, "KEY MAP");
-	}
-	else if(event == EVENT_POT2_CHANGE) {
-		sysconfig_set_key_map(pot2_val >> 7);
-	}
-	if(sequencer_get_control_override(SYSCONFIG_MOD_KEY_MAP) == 1) {
-		if(sysconfig_get_key_map() == SYSCONFIG_KEY_MAP_B) {
-			sprintf(str, "key map      B>A");
-		}
-		else {
-			sprintf(str, "key map      A>B");
-		}
-	}
-	else {
-		if(sysconfig_get_key_map() == SYSCONFIG_KEY_MAP_B) {
-			sprintf(str, "key map      B");
-		}
-		else {
-			sprintf(str, "key map      A");
-		}
-	}
-	screen_write_line(1, str);
-}
-
-// system LCD contrast
-void gui_system_lcd_cont(char event) {
-	if(event == EVENT_REFRESH) {
-		screen_write_line(0, "LCD CONTRAST");
-	}
-	else if(event == EVENT_POT2_CHANGE) {
-		sysconfig_set_lcd_contrast(pot2_val);
-	}
-	sprintf(str, "contrast    %d", ((sysconfig_get_lcd_contrast() >> 4) + 1));
-	screen_write_line(1, str);
-}
-
-// system CV cal
-void gui_system_cv_cal(char event) {
-	if(event == EVENT_REFRESH) {
-		screen_write_line(0, "CV CALIBRATE");
-		temp = 127;
-		temp2 = 127;
-	}
-	else if(event == EVENT_POT1_CHANGE) {
-		temp = (pot1_val >> 5) & 0x07;
-		if(temp > 6) temp = 6;
-		if(temp2 == 127) {
-			sequencer_cv_cal_start();
-			temp2 = (pot2_val >> 5) & 0x07;
-			if(temp2 > 6) temp2 = 6;
-			sequencer_cv_set_cal(1, temp2);	
-		}
-		sequencer_cv_set_cal(0, temp);
-	}
-	else if(event == EVENT_POT2_CHANGE) {
-		temp2 = (pot2_val >> 5) & 0x07;
-		if(temp2 > 6) temp2 = 6;
-		if(temp == 127) {
-			sequencer_cv_cal_start();
-			temp = (pot1_val >> 5) & 0x07;
-			if(temp > 6) temp = 6;
-			sequencer_cv_set_cal(0, temp);	
-		}
-		sequencer_cv_set_cal(1, temp2);	
-	}
-	if(temp == 127 || temp2 == 127) {
-		sprintf(str, "cv1  ?V cv2  ?V");
-	}
-	else {
-		sprintf(str, "cv1 %+dV cv2 %+dV", (temp - 3), (temp2 - 3));
-	}
-	screen_write_line(1, str);
-}
-
-// system reset
-void gui_system_system_reset(char event) {
-	if(event == EVENT_REFRESH) {
-		screen_write_line(0, "SYSTEM RESET");
-	}
-	else if(event == EVENT_ENTER_CLICK) {
-		sysconfig_reset_all();
-		screen_write_popup(750, "", "done!");
-		// this doesn't work correctly
-//		system_page = SYSTEM_SONG_LOAD;  // force us out of here on the next entry
-	}
-	screen_write_line(1, " reset settings?");
-}
-
-// live clock control
-void gui_live_play(char event) {
-	if(event == EVENT_REFRESH) {
-		screen_write_line(0, "LIVE PLAY CTRL");
-		temp = current_edit_seq;
-	}
-	else if(event == EVENT_POT1_CHANGE) {
-		sysconfig_set_clock_speed(pot1_val);
-	}
-	else if(event == EVENT_POT2_CHANGE) {
-		temp = (pot2_val >> 4) & 0x0f;
-	}
-	else if(event == EVENT_ENTER_CLICK) {
-		sequencer_control_change(SYSCONFIG_MOD_NEXT_SEQ, ((temp << 3) & 0x7f));
-		current_edit_seq = temp;
-	}
-	if(clock_get_speed() < 20) {
-		sprintf(str, "EXT CLK  seq %02d?", (temp + 1));
-	}
-	else {
-		sprintf(str, "%3d BPM  seq %02d?", sysconfig_get_clock_speed(), (temp + 1));
-	}
-	screen_write_line(1, str);
-}
-
-// live seq control
-void gui_live_seq(char event) {
-	if(event == EVENT_REFRESH) {
-		screen_write_line(0, "LIVE SEQ CTRL");
-	}
-	else if(event == EVENT_POT1_CHANGE) {
-		sequencer_control_change(SYSCONFIG_MOD_GATE1, pot1_val >> 1);
-		sequencer_control_change(SYSCONFIG_MOD_GATE2, pot1_val >> 1);
-	}
-	else if(event == EVENT_POT2_CHANGE) {
-		sequencer_control_change(SYSCONFIG_MOD_SEQ_DIR, pot2_val >> 1);
-	}
-	else if(event == EVENT_ENTER_CLICK) {
-		sequencer_control_restore();
-	}
-	utemp = sequencer_get_control_override(SYSCONFIG_MOD_GATE1);
-	utemp2 = sequencer_get_control_override(SYSCONFIG_MOD_SEQ_DIR);
-	char dir_str[16];
-	if(utemp2 == 1) {
-		sprintf(dir_str, "FLIP");
-	}
-	else {
-		sprintf(dir_str, "NORM");
-	}
-	if(utemp == 255) {
-		sprintf(str, "gate ?? dir %s", dir_str);
-	}
-	else {
-		sprintf(str, "gate %02d dir %s", utemp, dir_str);
-	}
-	screen_write_line(1, str);
-}
-
-// live step control
-void gui_live_step(char event) {
-	if(event == EVENT_REFRESH) {
-		screen_write_line(0, "LIVE STEP CTRL");
-	}
-	else if(event == EVENT_POT1_CHANGE) {
-		sequencer_control_change(SYSCONFIG_MOD_SEQ_START, pot1_val >> 1);
-	}
-	else if(event == EVENT_POT2_CHANGE) {
-		sequencer_control_change(SYSCONFIG_MOD_SEQ_LEN, pot2_val >> 1);
-	}
-	else if(event == EVENT_ENTER_CLICK) {
-		sequencer_control_restore();
-	}
-	utemp = sequencer_get_control_override(SYSCONFIG_MOD_SEQ_START);
-	utemp2 = sequencer_get_control_override(SYSCONFIG_MOD_SEQ_LEN);
-	if(utemp == 255 && utemp2 == 255) {
-		sprintf(str, "start ?? len ??");
-	}
-	else if(utemp == 255) {
-		sprintf(str, "start ?? len %02d", utemp2);
-	}
-	else if(utemp2 == 255) {
-		sprintf(str, "start %02d len ??", utemp + 1);
-	}
-	else {
-		sprintf(str, "start %02d len %02d", utemp + 1, utemp2);
-	}
-	screen_write_line(1, str);
-}
+/*
+ * K2579 Step Sequencer - User Interface
+ *
+ * Copyright 2011: Kilpatrick Audio
+ * Written by: Andrew Kilpatrick
+ *
+ */
+#include <stddef.h>
+#include "gui.h"
+#include "panel.h"
+#include "song.h"
+#include "song_file.h"
+#include "sequencer.h"
+#include "eeprom.h"
+#include "scale.h"
+#include "sysconfig.h"
+#include "clock.h"
+#include "screen_handler.h"
+#include "seq_midi.h"
+#include "arp.h"
+#include "text.h"
+
+// menu modes
+char menu_mode;
+#define MENU_SEQ 0
+#define MENU_PART1 1
+#define MENU_PART2 2  // part 2 and the MIDI only parts - MODE steps through them
+#define MENU_SYSTEM 3
+#define MENU_MAX_MENU 3
+char live_menu_override;
+
+// main page
+char seq_page;
+#define SEQ_START 0
+#define SEQ_LEN 1
+#define SEQ_STEPS 2
+#define SEQ_STEP_LEN 3
+#define SEQ_LOOP 4
+#define SEQ_DIR 5
+#define SEQ_NEXT 6
+#define SEQ_ARRANGE 7
+#define SEQ_CPY 8
+#define SEQ_CLR 9
+#define SEQ_MAX_PAGE 9
+unsigned char step_page;  // the page of 16 steps shown on the step edit pages
+unsigned char edit_lane;  // the lane shown on the part lanes page
+
+// part pages
+char part1_page;
+char part2_page;
+unsigned char edit_part;  // the part shown in the MENU_PART2 pages
+#define PART_NOTE_SET 0
+#define PART_LANES 1
+#define PART_GATE_LEN 2
+#define PART_SCALE 3
+#define PART_SPAN 4
+#define PART_OFFSET 5
+#define PART_STEPS 6
+#define PART_CLOCK 7
+#define PART_COPY 8
+#define PART_TRANS 9
+#define PART_GEN 10
+#define PART_ARP 11
+#define PART_MAX_PAGE 11
+
+// system page
+char system_page;
+#define SYSTEM_SONG_LOAD 0
+#define SYSTEM_SONG_SAV 1
+#define SYSTEM_SONG_CLR 2
+#define SYSTEM_CONTROL_CANCEL 3
+#define SYSTEM_CLK_DIV 4
+#define SYSTEM_RESET_MODE 5
+#define SYSTEM_MOD1_ASSN 6
+#define SYSTEM_MOD2_ASSN 7
+#define SYSTEM_LIVE_AUD 8
+#define SYSTEM_MIDI_PT1 9
+#define SYSTEM_MIDI_PT2 10
+#define SYSTEM_MIDI_TRACKS 11
+#define SYSTEM_PARAM_CHAN 12
+#define SYSTEM_CC_MAP 13
+#define SYSTEM_LANE_CC 14
+#define SYSTEM_ACCENT_GATE 15
+#define SYSTEM_RAND_SEED 16
+#define SYSTEM_SEQ_LAUNCH 17
+#define SYSTEM_SEQ_SWITCH 18
+#define SYSTEM_KEY_TRANSPOSE 19
+#define SYSTEM_KEY_TRIGGER 20
+#define SYSTEM_KEY_MAP 21
+#define SYSTEM_LCD_CONT 22
+#define SYSTEM_CV_CAL 23
+#define SYSTEM_FACTORY_RESET 24
+#define SYSTEM_MAX_PAGE 24
+
+// part lanes page
+#define EDIT_LANE_VEL 0
+#define EDIT_LANE_ACCENT 1
+#define EDIT_LANE_CC1 2
+#define EDIT_LANE_CC2 3
+#define EDIT_LANE_RATCHET 4
+#define EDIT_LANE_NUDGE 5
+#define EDIT_LANE_COND 6
+#define EDIT_LANE_MAX 6
+// step condition choices on the pot
+#define COND_PROB_STEPS 19  // 5-95%
+#define COND_RATIO_FIRST (1 + COND_PROB_STEPS + 4)  // after the probs and specials
+#define COND_NUM_CHOICES (COND_RATIO_FIRST + 35)  // 1:2 to 8:8
+
+// live page
+char live_page;
+#define LIVE_PLAY 0
+#define LIVE_SEQ 1
+#define LIVE_STEP 2
+#define LIVE_MAX_PAGE 2
+
+char current_edit_seq;
+char str[TEXT_LINE_LEN + 1];
+char temp;
+char temp2;
+unsigned char utemp;
+unsigned char utemp2;
+unsigned char pot1_val;
+unsigned char pot2_val;
+
+// event flags
+unsigned char startup_delay;
+unsigned char playback_updated;
+unsigned char control_override_updated;
+unsigned char song_load_updated;
+unsigned char song_save_updated;
+unsigned char song_save_failed;
+unsigned char cc_learned;
+unsigned char params_updated;
+
+// UI events
+#define EVENT_NONE 0
+#define EVENT_PAGE_UP 1
+#define EVENT_PAGE_DOWN 2
+#define EVENT_PAGE_CLICK 3
+#define EVENT_ENTER_CLICK 4
+#define EVENT_POT1_CHANGE 5
+#define EVENT_POT2_CHANGE 6
+#define EVENT_REFRESH 7
+
+// menu pages
+//
+// - each menu has a table of its pages in page order
+// - a page with a handler runs everything itself
+// - a page without a handler edits one setting with pot 2 - the table
+//   gives the range, how to get and set it and how to show it
+//
+struct gui_page_info {
+	char *title;  // top line - NULL shows the part and seq
+	void (*handler)(char event);  // page handler - NULL for a setting page
+	unsigned char index;  // setting index - or GUI_INDEX_SEQ / GUI_INDEX_PART
+	int choices;  // values on pot 2 - or GUI_CHOICES_STEPS
+	char first;  // value at the bottom of pot 2 - signed if below 0
+	unsigned char (*get)(void);  // settings with no index
+	void (*set)(unsigned char val);
+	unsigned char (*get_index)(unsigned char index);  // indexed settings
+	void (*set_index)(unsigned char index, unsigned char val);
+	char *text;  // shown before the value
+	unsigned char fmt;  // number format - TEXT_ZERO / TEXT_SIGN | width
+	char disp;  // added to the value shown
+	char *const *names;  // value names from first up
+	char *zero;  // shown for a value of 0 - NULL shows the number
+	void (*format)(char *dest, int val);  // value formatter - NULL uses text
+};
+#define GUI_INDEX_SEQ 0x80  // the seq being edited - pot 1 selects it
+#define GUI_INDEX_PART 0x81  // the part being edited
+#define GUI_CHOICES_STEPS 0  // the steps in the seq being edited
+struct gui_menu_info {
+	const struct gui_page_info *pages;
+	char max_page;
+	char *page;  // current page
+};
+#define GUI_SHOWN_NONE -1
+int param_shown;  // the last setting value drawn
+
+//
+// local functions
+//
+// page mode increment
+void gui_mode_inc(void);
+void gui_mode_live(void);
+// page dispatch
+const struct gui_menu_info *gui_get_menu(void);
+void gui_set_menu(const struct gui_menu_info *menu, char evnt);
+void gui_page_param(const struct gui_page_info *info, char event);
+// get the part being edited
+unsigned char gui_get_part(void);
+// show the part and seq being edited on the top line
+void gui_part_title(unsigned char part);
+// start a line with a seq or step number
+char *gui_text_seq(unsigned char seq);
+char *gui_text_step(unsigned char step);
+// get the step picked by pot 1 on the current step page
+unsigned char gui_get_step(void);
+// get a step condition from its place on the pot
+unsigned char gui_get_cond(unsigned char choice);
+// go to the next step page of the seq being edited
+void gui_next_step_page(void);
+//
+// page handlers
+//
+// global
+void gui_play_bar(void);
+// sequence
+void gui_seq_steps(char event);
+void gui_seq_step_len(char event);
+void gui_seq_arrange(char event);
+void gui_seq_cpy(char event);
+void gui_seq_clr(char event);
+// part
+void gui_part_note_set(char event);
+void gui_part_lanes(char event);
+void gui_part_steps(char event);
+void gui_part_clock(char event);
+void gui_part_copy(char event);
+void gui_part_trans(char event);
+void gui_part_gen(char event);
+void gui_part_arp(char event);
+// system
+void gui_system_song_load(char event);
+void gui_system_song_sav(char event);
+void gui_system_song_clr(char event);
+void gui_system_midi_control_cancel(char event);
+void gui_system_midi_tracks(char event);
+void gui_system_cc_map(char event);
+void gui_system_lane_cc(char event);
+void gui_system_seq_launch(char event);
+void gui_system_key_map(char event);
+void gui_system_cv_cal(char event);
+void gui_system_system_reset(char event);
+// live
+void gui_live_play(char event);
+void gui_live_seq(char event);
+void gui_live_step(char event);
+// part settings of the seq being edited
+unsigned char gui_get_gate(unsigned char part);
+void gui_set_gate(unsigned char part, unsigned char gate);
+unsigned char gui_get_scale(unsigned char part);
+void gui_set_scale(unsigned char part, unsigned char scale);
+unsigned char gui_get_span(unsigned char part);
+void gui_set_span(unsigned char part, unsigned char span);
+unsigned char gui_get_offset(unsigned char part);
+void gui_set_offset(unsigned char part, unsigned char offset);
+// value formatters
+void gui_format_seq_next(char *dest, int val);
+void gui_format_scale(char *dest, int val);
+void gui_format_lcd_cont(char *dest, int val);
+void gui_format_param_chan(char *dest, int val);
+
+//
+// page tables
+//
+char *const dir_names[] = {"bkwd", "pong", "rand", "fwd"};
+char *const part_dir_names[] = {"bkwd", "pong", "rand", "fwd "};
+char *const mod_names[] = {"none", "seq next", "seq start", "seq length",
+	"seq run/stop", "gate 1 time", "gate 2 time", "seq direction"};
+char *const on_off_names[] = {"off", "on"};
+char *const reset_names[] = {"SONG", "SEQ"};
+char *const switch_names[] = {"restart", "  phase", " legato"};
+char *const transpose_names[] = {"off", "part 1", "part 2", "both"};
+char *const trigger_names[] = {"latch", "mom"};
+char *const cc_target_names[] = {"none", "seq next", "seq start", "seq len",
+	"run/stop", "gate 1", "gate 2", "seq dir", "key map", "restore", "ignore", "fill"};
+
+const struct gui_page_info seq_pages[] = {
+	{"SEQ START", NULL, GUI_INDEX_SEQ, GUI_CHOICES_STEPS, 0,  // SEQ_START
+		NULL, NULL, song_get_seq_start, song_set_seq_start,
+		"    step ", TEXT_ZERO | 2, 1, NULL, NULL, NULL},
+	{"SEQ LENGTH", NULL, GUI_INDEX_SEQ, GUI_CHOICES_STEPS, 1,  // SEQ_LEN
+		NULL, NULL, song_get_seq_len, song_set_seq_len,
+		"   steps ", TEXT_ZERO | 2, 0, NULL, NULL, NULL},
+	{NULL, gui_seq_steps},  // SEQ_STEPS
+	{NULL, gui_seq_step_len},  // SEQ_STEP_LEN
+	{"SEQ LOOP", NULL, GUI_INDEX_SEQ, SONG_MAX_LOOPS + 1, 0,  // SEQ_LOOP
+		NULL, NULL, song_get_seq_loop, song_set_seq_loop,
+		"  counts ", TEXT_ZERO | 2, 0, NULL, NULL, NULL},
+	{"SEQ DIRECTION", NULL, GUI_INDEX_SEQ, SONG_MAX_DIR + 1, 0,  // SEQ_DIR
+		NULL, NULL, song_get_seq_dir, song_set_seq_dir,
+		"        ", 0, 0, dir_names, NULL, NULL},
+	{"SEQ NEXT", NULL, GUI_INDEX_SEQ, SONG_NUM_SEQ, 0,  // SEQ_NEXT
+		NULL, NULL, song_get_seq_next, song_set_seq_next,
+		NULL, 0, 0, NULL, NULL, gui_format_seq_next},
+	{NULL, gui_seq_arrange},  // SEQ_ARRANGE
+	{NULL, gui_seq_cpy},  // SEQ_CPY
+	{NULL, gui_seq_clr}  // SEQ_CLR
+};
+
+const struct gui_page_info part_pages[] = {
+	{NULL, gui_part_note_set},  // PART_NOTE_SET
+	{NULL, gui_part_lanes},  // PART_LANES
+	{NULL, NULL, GUI_INDEX_PART, 48, 1,  // PART_GATE_LEN
+		NULL, NULL, gui_get_gate, gui_set_gate,
+		"gate length ", TEXT_ZERO | 2, 0, NULL, NULL, NULL},
+	{NULL, NULL, GUI_INDEX_PART, 8, 0,  // PART_SCALE
+		NULL, NULL, gui_get_scale, gui_set_scale,
+		NULL, 0, 0, NULL, NULL, gui_format_scale},
+	{NULL, NULL, GUI_INDEX_PART, 4, 1,  // PART_SPAN
+		NULL, NULL, gui_get_span, gui_set_span,
+		"octave span ", 2, 0, NULL, NULL, NULL},
+	{NULL, NULL, GUI_INDEX_PART, 25, -12,  // PART_OFFSET
+		NULL, NULL, gui_get_offset, gui_set_offset,
+		"note offset ", TEXT_SIGN | 2, 0, NULL, "note offset  0", NULL},
+	{NULL, gui_part_steps},  // PART_STEPS
+	{NULL, gui_part_clock},  // PART_CLOCK
+	{NULL, gui_part_copy},  // PART_COPY
+	{NULL, gui_part_trans},  // PART_TRANS
+	{NULL, gui_part_gen},  // PART_GEN
+	{NULL, gui_part_arp}  // PART_ARP
+};
+
+const struct gui_page_info system_pages[] = {
+	{NULL, gui_system_song_load},  // SYSTEM_SONG_LOAD
+	{NULL, gui_system_song_sav},  // SYSTEM_SONG_SAV
+	{NULL, gui_system_song_clr},  // SYSTEM_SONG_CLR
+	{NULL, gui_system_midi_control_cancel},  // SYSTEM_CONTROL_CANCEL
+	{"CLOCK DIVIDER", NULL, 0, SYSCONFIG_MAX_CLOCK_DIV, 1,  // SYSTEM_CLK_DIV
+		sysconfig_get_clock_div, sysconfig_set_clock_div, NULL, NULL,
+		"div ratio   1/", 0, 0, NULL, NULL, NULL},
+	{"RESET MODE", NULL, 0, 2, 0,  // SYSTEM_RESET_MODE
+		sysconfig_get_reset_mode, sysconfig_set_reset_mode, NULL, NULL,
+		"reset mode  ", 0, 0, reset_names, NULL, NULL},
+	{"MOD1 CV ASSIGN", NULL, 0, SYSCONFIG_MAX_MOD_ASSIGN + 1, 0,  // SYSTEM_MOD1_ASSN
+		NULL, NULL, sysconfig_get_mod_assign, sysconfig_set_mod_assign,
+		" 1 ", 0, 0, mod_names, NULL, NULL},
+	{"MOD2 CV ASSIGN", NULL, 1, SYSCONFIG_MAX_MOD_ASSIGN + 1, 0,  // SYSTEM_MOD2_ASSN
+		NULL, NULL, sysconfig_get_mod_assign, sysconfig_set_mod_assign,
+		" 2 ", 0, 0, mod_names, NULL, NULL},
+	{"LIVE AUDITION", NULL, 0, 2, 0,  // SYSTEM_LIVE_AUD
+		sysconfig_get_live_aud, sysconfig_set_live_aud, NULL, NULL,
+		"live aud    ", 0, 0, on_off_names, NULL, NULL},
+	{"MIDI PART 1", NULL, 0, 16, 0,  // SYSTEM_MIDI_PT1
+		NULL, NULL, sysconfig_get_midi_channel, sysconfig_set_midi_channel,
+		"channel     ", TEXT_ZERO | 2, 1, NULL, NULL, NULL},
+	{"MIDI PART 2", NULL, 1, 16, 0,  // SYSTEM_MIDI_PT2
+		NULL, NULL, sysconfig_get_midi_channel, sysconfig_set_midi_channel,
+		"channel     ", TEXT_ZERO | 2, 1, NULL, NULL, NULL},
+	{NULL, gui_system_midi_tracks},  // SYSTEM_MIDI_TRACKS
+	{"MIDI PARAM CHAN", NULL, 0, 17, 0,  // SYSTEM_PARAM_CHAN
+		sysconfig_get_param_channel, sysconfig_set_param_channel, NULL, NULL,
+		NULL, 0, 0, NULL, NULL, gui_format_param_chan},
+	{NULL, gui_system_cc_map},  // SYSTEM_CC_MAP
+	{NULL, gui_system_lane_cc},  // SYSTEM_LANE_CC
+	{"ACCENT GATE", NULL, 0, SYSCONFIG_MAX_ACCENT_GATE + 1, 0,  // SYSTEM_ACCENT_GATE
+		sysconfig_get_accent_gate, sysconfig_set_accent_gate, NULL, NULL,
+		"gate       +", TEXT_ZERO | 2, 0, NULL, "gate       off", NULL},
+	{"RANDOM SEED", NULL, 0, SYSCONFIG_MAX_RAND_SEED + 1, 0,  // SYSTEM_RAND_SEED
+		sysconfig_get_rand_seed, sysconfig_set_rand_seed, NULL, NULL,
+		"seed       ", TEXT_ZERO | 3, 0, NULL, "seed       free", NULL},
+	{NULL, gui_system_seq_launch},  // SYSTEM_SEQ_LAUNCH
+	{"SEQ SWITCH", NULL, 0, SYSCONFIG_SWITCH_LEGATO + 1, 0,  // SYSTEM_SEQ_SWITCH
+		sysconfig_get_switch_mode, sysconfig_set_switch_mode, NULL, NULL,
+		"switch  ", 0, 0, switch_names, NULL, NULL},
+	{"KEY TRANSPOSE", NULL, 0, SYSCONFIG_KEY_TRANSPOSE12 + 1, 0,  // SYSTEM_KEY_TRANSPOSE
+		sysconfig_get_key_transpose, sysconfig_set_key_transpose, NULL, NULL,
+		"transpose ", 0, 0, transpose_names, NULL, NULL},
+	{"KEY TRIGGER", NULL, 0, SYSCONFIG_KEY_TRIGGER_MOM + 1, 0,  // SYSTEM_KEY_TRIGGER
+		sysconfig_get_key_trigger, sysconfig_set_key_trigger, NULL, NULL,
+		"trigger    ", 0, 0, trigger_names, NULL, NULL},
+	{NULL, gui_system_key_map},  // SYSTEM_KEY_MAP
+	{"LCD CONTRAST", NULL, 0, 256, 0,  // SYSTEM_LCD_CONT
+		sysconfig_get_lcd_contrast, sysconfig_set_lcd_contrast, NULL, NULL,
+		NULL, 0, 0, NULL, NULL, gui_format_lcd_cont},
+	{NULL, gui_system_cv_cal},  // SYSTEM_CV_CAL
+	{NULL, gui_system_system_reset}  // SYSTEM_FACTORY_RESET
+};
+
+const struct gui_page_info live_pages[] = {
+	{NULL, gui_live_play},  // LIVE_PLAY
+	{NULL, gui_live_seq},  // LIVE_SEQ
+	{NULL, gui_live_step}  // LIVE_STEP
+};
+
+// indexed by menu mode - the part menus share their pages
+const struct gui_menu_info menus[] = {
+	{seq_pages, SEQ_MAX_PAGE, &seq_page},
+	{part_pages, PART_MAX_PAGE, &part1_page},
+	{part_pages, PART_MAX_PAGE, &part2_page},
+	{system_pages, SYSTEM_MAX_PAGE, &system_page}
+};
+const struct gui_menu_info live_menu = {live_pages, LIVE_MAX_PAGE, &live_page};
+
+// initialize the GUI
+void gui_init(void) {
+	menu_mode = MENU_SEQ;
+	live_menu_override = 0;
+	seq_page = SEQ_START;
+	step_page = 0;
+	edit_lane = EDIT_LANE_VEL;
+	part1_page = PART_NOTE_SET;
+	part2_page = PART_NOTE_SET;
+	edit_part = 1;
+	system_page = SYSTEM_SONG_LOAD;
+	live_page = LIVE_PLAY;
+	param_shown = GUI_SHOWN_NONE;
+	gui_set_menu(&menus[MENU_SEQ], EVENT_REFRESH);
+	gui_play_bar();
+
+	// events
+	startup_delay = 10;
+	playback_updated = 0;
+	control_override_updated = 0;
+	song_load_updated = 0;
+	song_save_updated = 0;
+	song_save_failed = 0;
+	cc_learned = 0;
+	params_updated = 0;
+}
+
+// run this every 16ms
+void gui_task(void) {
+	unsigned char key;
+	unsigned char val;
+	char *p;
+
+	// prevent panel controls from affecting system at startup
+	if(startup_delay) {
+		key = panel_get_sw();
+		pot1_val = panel_get_step_pot(0);
+		pot2_val = panel_get_step_pot(1);
+		startup_delay --;
+		return;
+	}
+
+	//
+	// PANEL CONTROLS
+	// 
+	key = panel_get_sw();
+	if(key == PANEL_MODE_SW) {
+ 		gui_mode_inc();
+	}
+	else if(key == PANEL_ENTER_SW) {
+		gui_set_menu(gui_get_menu(), EVENT_ENTER_CLICK);
+	}
+	else if(key == PANEL_PAGE_UP_SW) {
+		gui_set_menu(gui_get_menu(), EVENT_PAGE_UP);
+	}
+	else if(key == PANEL_PAGE_DOWN_SW) {
+		gui_set_menu(gui_get_menu(), EVENT_PAGE_DOWN);
+	}
+	else if(key == PANEL_LIVE_SW) {
+		gui_mode_live();
+	}
+	else if(key == PANEL_RUN_STOP_SW) {
+		clock_run_stop_toggle();
+	}
+	else if(key == PANEL_RESET_SW) {
+		clock_reset_input();
+	}
+	else if(key == PANEL_UNDO_SW) {
+		if(song_undo()) screen_write_popup(750, "", "undo");
+		else screen_write_popup(750, "", "nothing to undo");
+		params_updated = 1;
+	}
+	else if(key == PANEL_REDO_SW) {
+		if(song_redo()) screen_write_popup(750, "", "redo");
+		else screen_write_popup(750, "", "nothing to redo");
+		params_updated = 1;
+	}
+
+	// value pots
+	val = panel_get_step_pot(0);
+	if(val != pot1_val) {
+		pot1_val = val;
+		gui_set_menu(gui_get_menu(), EVENT_POT1_CHANGE);
+	}
+
+	val = panel_get_step_pot(1);
+	if(val != pot2_val) {
+		pot2_val = val;
+		gui_set_menu(gui_get_menu(), EVENT_POT2_CHANGE);
+	}
+
+	// check if we're asking for LCD contrast set
+	if(panel_set_lcd_contrast()) {
+		menu_mode = MENU_SYSTEM;
+		system_page = SYSTEM_LCD_CONT;
+		gui_set_menu(&menus[MENU_SYSTEM], EVENT_REFRESH);
+	}
+
+	//
+	// UPDATE EVENTS
+	//
+	if(playback_updated) {
+		gui_play_bar();
+		playback_updated = 0;
+	}
+
+	if(control_override_updated) {
+		if(live_menu_override) {
+			gui_set_menu(&live_menu, EVENT_NONE);
+		}
+		else if(menu_mode == MENU_SYSTEM && system_page == SYSTEM_KEY_MAP) {
+			gui_set_menu(&menus[MENU_SYSTEM], EVENT_REFRESH);
+		}
+		control_override_updated = 0;
+	}
+
+	if(song_load_updated) {
+		// current song name
+		if(!live_menu_override &&
+				(menu_mode == MENU_SEQ || menu_mode == MENU_SYSTEM)) {
+			gui_set_menu(gui_get_menu(), EVENT_REFRESH);
+		}
+		p = text_str(str, "song loaded ");
+		text_int(p, sysconfig_get_current_song() + 1, TEXT_ZERO | 2);
+		screen_write_popup(2000, "", str);
+		song_load_updated = 0;
+	}
+
+	if(song_save_updated) {
+		// current song name
+		if(!live_menu_override &&
+				(menu_mode == MENU_SEQ || menu_mode == MENU_SYSTEM)) {
+			gui_set_menu(gui_get_menu(), EVENT_REFRESH);
+		}
+		char str2[TEXT_LINE_LEN + 1];
+		p = text_str(str, "song saved ");
+		text_int(p, sysconfig_get_current_song() + 1, TEXT_ZERO | 2);
+		p = text_str(str2, "wrote ");
+		p = text_int(p, song_file_get_pages_written(), 0);
+		text_str(p, " pages");
+		screen_write_popup(2000, str, str2);
+		song_save_updated = 0;
+	}
+
+	if(song_save_failed) {
+		screen_write_popup(2000, "", "song mem full");
+		song_save_failed = 0;
+	}
+
+	if(params_updated) {
+		gui_set_menu(gui_get_menu(), EVENT_REFRESH);
+		params_updated = 0;
+	}
+
+	if(cc_learned) {
+		// show the learned controller
+		if(!live_menu_override && menu_mode == MENU_SYSTEM &&
+				system_page == SYSTEM_CC_MAP) {
+			utemp = seq_midi_get_learned_cc();
+			utemp2 = sysconfig_get_cc_target(utemp);
+			gui_set_menu(&menus[MENU_SYSTEM], EVENT_NONE);
+		}
+		p = text_str(str, "learned cc ");
+		text_int(p, seq_midi_get_learned_cc(), TEXT_ZERO | 3);
+		screen_write_popup(2000, "", str);
+		cc_learned = 0;
+	}
+}
+
+// notify the GUI that a playback value has changed
+void gui_playback_updated(void) {
+	playback_updated = 1;
+}
+
+// notify the GUI that a control override has changed
+void gui_control_override_updated(void) {
+	control_override_updated = 1;
+}
+
+// notify the GUI that a song has just been loaded
+void gui_song_load_updated(void) {
+	song_load_updated = 1;
+}
+
+// notify the GUI that a song has just been saved
+void gui_song_save_updated(void) {
+	song_save_updated = 1;
+}
+
+// notify the GUI that a song could not be saved
+void gui_song_save_failed(void) {
+	song_save_failed = 1;
+}
+
+// notify the GUI that a CC has been learned
+void gui_cc_learned(void) {
+	cc_learned = 1;
+}
+
+// notify the GUI that params have been changed remotely
+void gui_params_updated(void) {
+	params_updated = 1;
+}
+
+// change menu modes
+void gui_mode_inc(void) {
+	// cancel live mode without advancing to a new menu
+	if(live_menu_override) {
+		live_menu_override = 0;
+	}
+	// step through the parts after part 1 before moving on
+	else if(menu_mode == MENU_PART2 && edit_part < (SONG_NUM_PARTS - 1)) {
+		edit_part ++;
+	}
+	else {
+		menu_mode ++;
+		if(menu_mode > MENU_MAX_MENU) menu_mode = 0;
+		edit_part = 1;
+	}
+	gui_set_menu(gui_get_menu(), EVENT_REFRESH);
+}
+
+// change to the live mode
+void gui_mode_live(void) {
+	live_menu_override = 1;
+	gui_set_menu(&live_menu, EVENT_REFRESH);
+}
+
+// get the menu being shown
+const struct gui_menu_info *gui_get_menu(void) {
+	if(live_menu_override) return &live_menu;
+	return &menus[(unsigned char)menu_mode];
+}
+
+// run an event on the current page of a menu
+void gui_set_menu(const struct gui_menu_info *menu, char evnt) {
+	char event = evnt;
+	const struct gui_page_info *info;
+
+	// change pages
+	if(event == EVENT_PAGE_UP) {
+		(*menu->page) ++;
+		if(*menu->page > menu->max_page) *menu->page = menu->max_page;
+		event = EVENT_REFRESH;
+	}
+	else if(event == EVENT_PAGE_DOWN) {
+		(*menu->page) --;
+		if(*menu->page < 0) *menu->page = 0;
+		event = EVENT_REFRESH;
+	}
+
+	// dispatch page events
+	info = &menu->pages[(unsigned char)*menu->page];
+	if(info->handler) info->handler(event);
+	else gui_page_param(info, event);
+}
+
+// setting page - the table entry describes the setting
+void gui_page_param(const struct gui_page_info *info, char event) {
+	unsigned char index;
+	int choices, val, shown;
+	char *p;
+	if(info->index == GUI_INDEX_SEQ) index = current_edit_seq;
+	else if(info->index == GUI_INDEX_PART) index = gui_get_part();
+	else index = info->index;
+
+	if(event == EVENT_REFRESH) {
+		if(info->title) screen_write_line(0, info->title);
+		else gui_part_title(index);
+		param_shown = GUI_SHOWN_NONE;
+	}
+	else if(event == EVENT_POT1_CHANGE && info->index == GUI_INDEX_SEQ) {
+		current_edit_seq = (pot1_val >> 4) & 0x0f;
+		index = current_edit_seq;
+	}
+	else if(event == EVENT_POT2_CHANGE) {
+		choices = info->choices;
+		if(choices == GUI_CHOICES_STEPS) choices = song_get_seq_steps(current_edit_seq);
+		val = ((pot2_val * choices) >> 8) + info->first;
+		if(info->set) info->set(val);
+		else info->set_index(index, val);
+	}
+
+	if(info->get) val = info->get();
+	else val = info->get_index(index);
+	if(info->first < 0 && val > 127) val -= 256;
+
+	// only draw the value when it changes
+	shown = (index << 8) | (val & 0xff);
+	if(shown == param_shown) return;
+	param_shown = shown;
+
+	// the seq pages start with the seq being edited
+	p = str;
+	if(info->index == GUI_INDEX_SEQ) p = gui_text_seq(index);
+	if(info->format) info->format(p, val);
+	else if(val == 0 && info->zero) text_str(p, info->zero);
+	else {
+		p = text_str(p, info->text);
+		if(info->names) text_name(p, info->names, val - info->first, info->choices);
+		else text_int(p, val + info->disp, info->fmt);
+	}
+	screen_write_line(1, str);
+}
+
+// get the part being edited
+unsigned char gui_get_part(void) {
+	if(menu_mode == MENU_PART2) return edit_part;
+	return 0;
+}
+
+// show the part and seq being edited on the top line
+void gui_part_title(unsigned char part) {
+	char *p;
+	p = text_str(str, "PART ");
+	p = text_int(p, part + 1, 0);
+	p = text_str(p, " SEQ ");
+	text_int(p, current_edit_seq + 1, TEXT_ZERO | 2);
+	screen_write_line(0, str);
+}
+
+// start a line with a seq number
+char *gui_text_seq(unsigned char seq) {
+	return text_int(text_char(str, ' '), seq + 1, TEXT_ZERO | 2);
+}
+
+// start a line with a step number
+char *gui_text_step(unsigned char step) {
+	return text_int(text_str(str, "st "), step + 1, TEXT_ZERO | 2);
+}
+
+// get the step picked by pot 1 on the current step page
+unsigned char gui_get_step(void) {
+	// the seq may have been changed or made shorter
+	if(step_page > ((song_get_seq_steps(current_edit_seq) / SONG_PAGE_STEPS) - 1)) {
+		step_page = 0;
+	}
+	return (step_page * SONG_PAGE_STEPS) + ((pot1_val >> 4) & 0x0f);
+}
+
+// get a step condition from its place on the pot
+unsigned char gui_get_cond(unsigned char choice) {
+	unsigned char of;
+	if(choice == 0) return SONG_COND_ALWAYS;
+	if(choice <= COND_PROB_STEPS) return choice * 5;
+	if(choice < COND_RATIO_FIRST) return SONG_COND_FIRST + (choice - COND_PROB_STEPS - 1);
+	// pass 1:2, 2:2, 1:3 ... 8:8
+	choice -= COND_RATIO_FIRST;
+	for(of = 2; of < SONG_COND_MAX_OF && choice >= of; of ++) choice -= of;
+	if(choice >= of) choice = of - 1;
+	return SONG_COND_RATIO | ((of - 1) << 3) | choice;
+}
+
+// go to the next step page of the seq being edited
+void gui_next_step_page(void) {
+	step_page ++;
+	if(step_page > ((song_get_seq_steps(current_edit_seq) / SONG_PAGE_STEPS) - 1)) {
+		step_page = 0;
+	}
+}
+
+// get the gate length of a part
+unsigned char gui_get_gate(unsigned char part) {
+	return song_get_gate(current_edit_seq, part);
+}
+
+// set the gate length of a part
+void gui_set_gate(unsigned char part, unsigned char gate) {
+	song_set_gate(current_edit_seq, part, gate);
+}
+
+// get the scale of a part
+unsigned char gui_get_scale(unsigned char part) {
+	return song_get_scale(current_edit_seq, part);
+}
+
+// set the scale of a part
+void gui_set_scale(unsigned char part, unsigned char scale) {
+	song_set_scale(current_edit_seq, part, scale);
+}
+
+// get the octave span of a part
+unsigned char gui_get_span(unsigned char part) {
+	return song_get_span(current_edit_seq, part);
+}
+
+// set the octave span of a part
+void gui_set_span(unsigned char part, unsigned char span) {
+	song_set_span(current_edit_seq, part, span);
+}
+
+// get the note offset of a part
+unsigned char gui_get_offset(unsigned char part) {
+	return (unsigned char)song_get_offset(current_edit_seq, part);
+}
+
+// set the note offset of a part
+void gui_set_offset(unsigned char part, unsigned char offset) {
+	song_set_offset(current_edit_seq, part, (char)offset);
+}
+
+// show the next seq - marked if it is the seq itself
+void gui_format_seq_next(char *dest, int val) {
+	dest = text_int(text_str(dest, "  to seq "), val + 1, TEXT_ZERO | 2);
+	if(val == current_edit_seq) text_char(dest, '*');
+}
+
+// show a scale name
+void gui_format_scale(char *dest, int val) {
+	scale_type_to_name(val, text_str(dest, "scale "));
+}
+
+// show the LCD contrast in 16 steps
+void gui_format_lcd_cont(char *dest, int val) {
+	text_int(text_str(dest, "contrast    "), (val >> 4) + 1, 0);
+}
+
+// NRPN param channel
+void gui_format_param_chan(char *dest, int val) {
+	if(val == SYSCONFIG_PARAM_CHAN_OFF) text_str(dest, "channel     off");
+	else text_int(text_str(dest, "channel     "), val + 1, TEXT_ZERO | 2);
+}
+
+//
+// PAGE HANDLERS
+//
+// lower play bar
+void gui_play_bar(void) {
+	unsigned char play_seq = sequencer_get_current_seq();
+	unsigned char play_step_pos = sequencer_get_current_step_index();
+	unsigned char play_playing = clock_get_song_playing();
+	unsigned char play_entry = sequencer_get_arr_entry();
+	char *p;
+	// arrangement entry and progress
+	if(play_playing && play_entry != 255) {
+		p = text_int(text_str(str, "arr"), play_entry + 1, TEXT_ZERO | 2);
+		p = text_int(text_char(p, ' '), sequencer_get_arr_progress(), TEXT_ZERO | 2);
+		p = text_str(p, "%  ");
+	}
+	else if(play_playing) {
+		p = text_str(str, "playing:  ");
+	}
+	else {
+		p = text_str(str, "stopped:  ");
+	}
+	p = text_int(p, play_seq + 1, TEXT_ZERO | 2);
+	text_int(text_char(p, ':'), play_step_pos + 1, TEXT_ZERO | 2);
+	screen_write_line(2, str);
+}
+
+// seq steps - the number of steps the seq has room for
+void gui_seq_steps(char event) {
+	char *p;
+	if(event == EVENT_REFRESH) {
+		screen_write_line(0, "SEQ STEPS");
+	}
+	else if(event == EVENT_POT1_CHANGE) {
+		current_edit_seq = (pot1_val >> 4) & 0x0f;
+	}
+	else if(event == EVENT_POT2_CHANGE) {
+		utemp = ((pot2_val * SONG_NUM_STEP_PAGES) >> 8) + 1;
+		if(utemp != (song_get_seq_steps(current_edit_seq) / SONG_PAGE_STEPS) &&
+				!song_set_seq_pages(current_edit_seq, utemp)) {
+			screen_write_popup(750, "SEQ STEPS", "no free pages");
+		}
+	}
+
+	p = text_str(gui_text_seq(current_edit_seq), "   steps ");
+	text_int(p, song_get_seq_steps(current_edit_seq), TEXT_ZERO | 2);
+	screen_write_line(1, str);
+}
+
+// seq step length
+void gui_seq_step_len(char event) {
+	char *p;
+	if(event == EVENT_REFRESH) {
+		p = text_int(text_str(str, "SEQ "), current_edit_seq + 1, TEXT_ZERO | 2);
+		text_str(p, " STEP LEN");
+		screen_write_line(0, str);
+		temp = gui_get_step();
+	}
+	else if(event == EVENT_POT1_CHANGE) {
+		temp = gui_get_step();
+	}
+	// the next 16 steps
+	else if(event == EVENT_ENTER_CLICK) {
+		gui_next_step_page();
+		temp = gui_get_step();
+	}
+	else if(event == EVENT_POT2_CHANGE) {
+		song_set_step_len(current_edit_seq, temp, ((pot2_val >> 3) & 0x1f));
+	}
+
+	char len = song_get_step_len(current_edit_seq, temp);
+	p = text_str(gui_text_step(temp), "   len ");
+	if(len == 0) {
+		text_str(p, "DIV");
+	}
+	else {
+		text_int(p, len, TEXT_ZERO | 2);
+	}
+	screen_write_line(1, str);
+}
+
+// seq arrangement
+//
+// - pot 1 selects the entry and pot 2 changes the setting shown
+// - enter steps through the seq, repeat and transpose settings
+// - the entry after the last adds an entry and setting an entry to end
+//   cuts the arrangement there
+//
+void gui_seq_arrange(char event) {
+	unsigned char seq, repeat;
+	char transpose;
+	char *p;
+	if(event == EVENT_REFRESH) {
+		screen_write_line(0, "SONG ARRANGE");
+		utemp = 0;  // entry
+		utemp2 = 0;  // setting
+	}
+	else if(event == EVENT_POT1_CHANGE) {
+		utemp = (pot1_val * SONG_ARR_LEN) >> 8;
+		if(utemp > song_get_arr_len()) utemp = song_get_arr_len();
+	}
+	else if(event == EVENT_ENTER_CLICK) {
+		utemp2 ++;
+		if(utemp2 > 2) utemp2 = 0;
+	}
+	seq = song_get_arr_seq(utemp);
+	repeat = song_get_arr_repeat(utemp);
+	transpose = song_get_arr_transpose(utemp);
+	if(event == EVENT_POT2_CHANGE) {
+		if(utemp2 == 0) {
+			seq = (pot2_val * (SONG_NUM_SEQ + 1)) >> 8;
+			if(seq == SONG_NUM_SEQ) song_set_arr_len(utemp);
+			else song_set_arr_entry(utemp, seq, repeat, transpose);
+		}
+		else if(utemp < song_get_arr_len()) {
+			if(utemp2 == 1) repeat = ((pot2_val * SONG_ARR_MAX_REPEAT) >> 8) + 1;
+			else {
+				transpose = ((pot2_val * ((SONG_ARR_MAX_TRANSPOSE * 2) + 1)) >> 8) -
+					SONG_ARR_MAX_TRANSPOSE;
+			}
+			song_set_arr_entry(utemp, seq, repeat, transpose);
+		}
+	}
+
+	p = text_int(text_str(str, "en "), utemp + 1, TEXT_ZERO | 2);
+	if(utemp >= song_get_arr_len()) text_str(p, "  end");
+	else if(utemp2 == 1) text_int(text_str(p, "  repeat "), repeat, 0);
+	else if(utemp2 == 2) text_int(text_str(p, "  trans "), transpose, TEXT_SIGN);
+	else text_int(text_str(p, "  seq "), seq + 1, TEXT_ZERO | 2);
+	screen_write_line(1, str);
+}
+
+// seq copy
+void gui_seq_cpy(char event) {
+	char *p;
+	if(event == EVENT_REFRESH) {
+		temp = current_edit_seq;
+		temp2 = temp;
+		screen_write_line(0, "SEQ COPY");
+	}
+	else if(event == EVENT_POT1_CHANGE) {
+		temp = (pot1_val >> 4) & 0x0f;	
+	}
+	else if(event == EVENT_POT2_CHANGE) {
+		temp2 = (pot2_val >> 4) & 0x0f;
+	}
+	else if(event == EVENT_ENTER_CLICK) {
+		song_copy_seq(temp2, temp);
+		screen_write_popup(750, "SEQ COPY", "copied");
+	}
+
+	p = text_str(gui_text_seq(temp), " copy to ");
+	text_char(text_int(p, temp2 + 1, TEXT_ZERO | 2), '?');
+	screen_write_line(1, str);
+}
+
+// seq clear
+void gui_seq_clr(char event) {
+	if(event == EVENT_REFRESH) {
+		temp = current_edit_seq;
+		screen_write_line(0, "SEQ CLEAR");
+	}
+	else if(event == EVENT_POT1_CHANGE) {
+		temp = (pot1_val >> 4) & 0x0f;
+	}
+	else if(event == EVENT_ENTER_CLICK) {
+		song_clear_seq(temp);
+		screen_write_popup(750, "SEQ CLR", "cleared");
+	}
+
+	text_str(gui_text_seq(temp), "      clear?");
+	screen_write_line(1, str);
+}
+
+// part note set
+void gui_part_note_set(char event) {
+	unsigned char part;
+	unsigned char note;
+	unsigned char span;
+	unsigned char audition;
+	part = gui_get_part();
+
+	audition = 0;
+	if(event == EVENT_REFRESH) {
+		gui_part_title(part);
+		gui_get_step();  // check the step page
+		temp = step_page * SONG_PAGE_STEPS;  // step note
+	}
+	else if(event == EVENT_POT1_CHANGE) {
+		temp = gui_get_step();
+		audition = 1;
+	}
+	// the next 16 steps
+	else if(event == EVENT_ENTER_CLICK) {
+		gui_next_step_page();
+		temp = gui_get_step();
+	}
+	else if(event == EVENT_POT2_CHANGE) {
+		note = (pot2_val >> 2) & 0x3f;
+		span = song_get_span(current_edit_seq, part);
+		if(note < 52) {
+			// adjust span to reduce the pot resolution
+			// span = 1 - 0-12
+			if(span == 1) note = note / 4;
+			// span = 2 - 0-24
+			else if(span == 2) {
+				note = note / 2;
+				if(note > 24) note = 24;
+			}
+			// span = 3 - 0-36
+			else if(span == 3) {
+				note = (note / 4) * 2;
+				if(note > 36) note = 36;
+			}
+		}
+		else if(note > 51 && note < 55) note = SONG_STEP_RAND;
+		else if(note > 55 && note < 60) note = SONG_STEP_NONE;
+		else if(note > 57) note = SONG_STEP_REST;
+
+		// scale quantize
+		note = scale_quantize(note, song_get_scale(current_edit_seq, part));
+		song_set_note(current_edit_seq, part, temp, note);
+		audition = 1;
+	}
+
+	// get the note to display / audition
+	note = scale_quantize(song_get_note(current_edit_seq, part, temp), 
+		song_get_scale(current_edit_seq, part));
+	note = scale_span_adjust(note, song_get_span(current_edit_seq, part));
+
+	// audition the note
+	if(audition && sysconfig_get_live_aud() && note < 49) {
+		sequencer_play_audition_note(part, note);
+	}
+
+	scale_note_to_name(note, song_get_scale(current_edit_seq, part),
+		text_str(gui_text_step(temp), "  note "));
+	screen_write_line(1, str);
+}
+
+// part lanes - velocity, accent, CC, ratchet, nudge and condition per step
+void gui_part_lanes(char event) {
+	unsigned char part;
+	unsigned char lane;
+	unsigned char val;
+	char *p;
+	part = gui_get_part();
+
+	if(event == EVENT_REFRESH) {
+		text_str(text_int(text_str(str, "PART "), part + 1, 0), " LANES");
+		screen_write_line(0, str);
+		temp = 0;
+	}
+	else if(event == EVENT_POT1_CHANGE) {
+		temp = (pot1_val * song_get_seq_steps(current_edit_seq)) >> 8;
+	}
+	// the next lane
+	else if(event == EVENT_ENTER_CLICK) {
+		edit_lane ++;
+		if(edit_lane > EDIT_LANE_MAX) edit_lane = EDIT_LANE_VEL;
+	}
+	if(temp >= song_get_seq_steps(current_edit_seq)) temp = 0;
+
+	// velocity and accent share the velocity lane
+	if(edit_lane == EDIT_LANE_CC1) lane = SONG_LANE_CC1;
+	else if(edit_lane == EDIT_LANE_CC2) lane = SONG_LANE_CC2;
+	else if(edit_lane == EDIT_LANE_RATCHET || edit_lane == EDIT_LANE_NUDGE) {
+		lane = SONG_LANE_TIMING;
+	}
+	else if(edit_lane == EDIT_LANE_COND) lane = SONG_LANE_COND;
+	else lane = SONG_LANE_VEL;
+	val = song_get_lane(current_edit_seq, part, lane, temp);
+
+	// ratchet and nudge are set through the song so they share the lane
+	if(event == EVENT_POT2_CHANGE && lane == SONG_LANE_TIMING) {
+		if(edit_lane == EDIT_LANE_RATCHET) {
+			utemp = song_set_ratchet(current_edit_seq, part, temp,
+				((pot2_val * SONG_MAX_RATCHET) >> 8) + 1);
+		}
+		else {
+			utemp = song_set_nudge(current_edit_seq, part, temp,
+				((pot2_val * ((SONG_MAX_NUDGE * 2) + 1)) >> 8) - SONG_MAX_NUDGE);
+		}
+		if(!utemp) screen_write_popup(750, "PART LANES", "no free lanes");
+	}
+	else if(event == EVENT_POT2_CHANGE && lane == SONG_LANE_COND) {
+		if(!song_set_cond(current_edit_seq, part, temp,
+				gui_get_cond((pot2_val * COND_NUM_CHOICES) >> 8))) {
+			screen_write_popup(750, "PART LANES", "no free lanes");
+		}
+		val = song_get_cond(current_edit_seq, part, temp);
+	}
+	else if(event == EVENT_POT2_CHANGE) {
+		if(edit_lane == EDIT_LANE_VEL) {
+			val = (val & SONG_LANE_ACCENT) | (pot2_val >> 1);
+		}
+		else if(edit_lane == EDIT_LANE_ACCENT) {
+			val = (val & ~SONG_LANE_ACCENT) | (pot2_val & SONG_LANE_ACCENT);
+		}
+		// CC - the bottom of the pot holds the controller
+		else {
+			val = (pot2_val * 129) >> 8;
+			if(val == 0) val = SONG_LANE_HOLD;
+			else val --;
+		}
+		if(!song_set_lane(current_edit_seq, part, lane, temp, val)) {
+			screen_write_popup(750, "PART LANES", "no free lanes");
+		}
+		val = song_get_lane(current_edit_seq, part, lane, temp);
+	}
+
+	p = gui_text_step(temp);
+	if(edit_lane == EDIT_LANE_VEL) {
+		if((val & ~SONG_LANE_ACCENT) == 0) text_str(p, "  vel def");
+		else text_int(text_str(p, "  vel "), val & ~SONG_LANE_ACCENT, 3);
+	}
+	else if(edit_lane == EDIT_LANE_ACCENT) {
+		if(val & SONG_LANE_ACCENT) text_str(p, "  acc on");
+		else text_str(p, "  acc off");
+	}
+	else if(edit_lane == EDIT_LANE_RATCHET) {
+		text_int(text_str(p, "  ratch "), song_get_ratchet(current_edit_seq, part, temp), 0);
+	}
+	else if(edit_lane == EDIT_LANE_NUDGE) {
+		text_int(text_str(p, "  nudge "), song_get_nudge(current_edit_seq, part, temp),
+			TEXT_SIGN);
+	}
+	else if(edit_lane == EDIT_LANE_COND) {
+		if(val & SONG_COND_RATIO) {
+			p = text_int(text_str(p, "  pass "), (val & 0x07) + 1, 0);
+			text_int(text_char(p, ':'), ((val >> 3) & 0x07) + 1, 0);
+		}
+		else if(val == SONG_COND_FIRST) text_str(p, "  1st");
+		else if(val == SONG_COND_NOT_FIRST) text_str(p, "  not 1st");
+		else if(val == SONG_COND_FILL) text_str(p, "  fill");
+		else if(val == SONG_COND_NOT_FILL) text_str(p, "  not fill");
+		else if(val == SONG_COND_ALWAYS) text_str(p, "  always");
+		else text_char(text_int(text_str(p, "  prob "), val, 0), '%');
+	}
+	else {
+		p = text_int(text_str(p, "  cc"), lane, 0);
+		if(val == SONG_LANE_HOLD) text_str(p, " --");
+		else text_int(text_char(p, ' '), val, 3);
+	}
+	screen_write_line(1, str);
+}
+
+// part start / length - 0 on the pot follows the seq
+void gui_part_steps(char event) {
+	unsigned char part, start, len;
+	char *p;
+	part = gui_get_part();
+
+	if(event == EVENT_REFRESH) {
+		gui_part_title(part);
+	}
+	else if(event == EVENT_POT1_CHANGE) {
+		start = (pot1_val * (song_get_seq_steps(current_edit_seq) + 1)) >> 8;
+		if(start == 0) song_set_part_start(current_edit_seq, part, SONG_PART_FOLLOW);
+		else song_set_part_start(current_edit_seq, part, start - 1);
+	}
+	else if(event == EVENT_POT2_CHANGE) {
+		len = (pot2_val * (song_get_seq_steps(current_edit_seq) + 1)) >> 8;
+		if(len == 0) song_set_part_len(current_edit_seq, part, SONG_PART_FOLLOW);
+		else song_set_part_len(current_edit_seq, part, len);
+	}
+
+	start = song_get_part_start(current_edit_seq, part);
+	len = song_get_part_len(current_edit_seq, part);
+	if(start == SONG_PART_FOLLOW) p = text_str(str, "start --");
+	else p = text_int(text_str(str, "start "), start + 1, TEXT_ZERO | 2);
+	if(len == SONG_PART_FOLLOW) text_str(p, "  len --");
+	else text_int(text_str(p, "  len "), len, TEXT_ZERO | 2);
+	screen_write_line(1, str);
+}
+
+// part direction / clock divide - 0 on the pot follows the seq
+void gui_part_clock(char event) {
+	unsigned char part, dir, div;
+	char *p;
+	part = gui_get_part();
+
+	if(event == EVENT_REFRESH) {
+		gui_part_title(part);
+	}
+	else if(event == EVENT_POT1_CHANGE) {
+		dir = (pot1_val * (SONG_MAX_DIR + 2)) >> 8;
+		if(dir == 0) song_set_part_dir(current_edit_seq, part, SONG_PART_FOLLOW);
+		else song_set_part_dir(current_edit_seq, part, dir - 1);
+	}
+	else if(event == EVENT_POT2_CHANGE) {
+		div = (pot2_val * (SONG_MAX_PART_DIV + 1)) >> 8;
+		if(div == 0) song_set_part_div(current_edit_seq, part, SONG_PART_FOLLOW);
+		else song_set_part_div(current_edit_seq, part, div);
+	}
+
+	dir = song_get_part_dir(current_edit_seq, part);
+	div = song_get_part_div(current_edit_seq, part);
+	p = text_str(str, "dir ");
+	if(dir == SONG_PART_FOLLOW) p = text_str(p, "--  ");
+	else p = text_name(p, part_dir_names, dir, SONG_MAX_DIR + 1);
+	if(div == SONG_PART_FOLLOW) text_str(p, "  div --");
+	else text_int(text_str(p, "  div "), div, TEXT_ZERO | 2);
+	screen_write_line(1, str);
+}
+
+// part copy
+void gui_part_copy(char event) {
+	unsigned char part;
+	char *p;
+	part = gui_get_part();
+
+	if(event == EVENT_REFRESH) {
+		temp = 0;
+		gui_part_title(part);
+	}
+	// pot 2 picks the part to copy to - any part but this one
+	else if(event == EVENT_POT2_CHANGE) {
+		temp = (pot2_val * (SONG_NUM_PARTS - 1)) >> 8;
+	}
+	utemp = temp;
+	if(utemp >= part) utemp ++;
+	if(event == EVENT_ENTER_CLICK) {
+		song_part_copy(current_edit_seq, part, utemp);
+		screen_write_popup(750, "", "copied");
+	}
+
+	p = text_int(text_str(str, "part copy  "), part + 1, 0);
+	text_char(text_int(text_char(p, '>'), utemp + 1, 0), '?');
+	screen_write_line(1, str);
+}
+
+// part trans
+void gui_part_trans(char event) {
+	unsigned char part;
+	part = gui_get_part();
+
+	if(event == EVENT_REFRESH) {
+		temp = 0;
+		gui_part_title(part);
+	}
+	else if(event == EVENT_POT2_CHANGE) {
+		temp = (pot2_val >> 6) & 0x03;
+	}
+	else if(event == EVENT_ENTER_CLICK) {
+		if(temp == 3) {
+			song_part_clear(current_edit_seq, part);
+			screen_write_popup(750, "", "cleared");
+		}
+		else if(temp == 2) {
+			song_part_randomize(current_edit_seq, part);
+			screen_write_popup(750, "", "randomized");
+		}
+		else if(temp == 1) {
+			song_part_retrograde(current_edit_seq, part);
+			screen_write_popup(750, "", "retrograded");
+		}
+		else {
+			song_part_invert(current_edit_seq, part);
+			screen_write_popup(750, "", "inverted");
+		}
+	}
+
+	if(temp == 0) {
+		text_str(str, "part     invert?");
+	}
+	else if(temp == 1) {
+		text_str(str, "part retrograde?");
+	}
+	else if(temp == 2) {
+		text_str(str, "part  randomize?");
+	}
+	else {
+		text_str(str, "part      clear?");
+	}
+	screen_write_line(1, str);
+}
+
+// part pattern generators
+void gui_part_gen(char event) {
+	unsigned char part, len, amount;
+	char *p;
+	part = gui_get_part();
+	len = song_get_seq_steps(current_edit_seq);
+
+	if(event == EVENT_REFRESH) {
+		temp = 0;
+		utemp2 = 0;
+		gui_part_title(part);
+	}
+	// pot 1 picks the generator
+	else if(event == EVENT_POT1_CHANGE) {
+		temp = (pot1_val * 5) >> 8;
+	}
+	// pot 2 sets the amount
+	else if(event == EVENT_POT2_CHANGE) {
+		utemp2 = pot2_val;
+	}
+
+	if(temp == 0) amount = (utemp2 * (len + 1)) >> 8;  // hits
+	else if(temp == 1) amount = (utemp2 * len) >> 8;  // steps
+	else if(temp == 2) amount = (utemp2 * 17) >> 8;  // steps + 8
+	else if(temp == 3) amount = (utemp2 * 101) >> 8;  // percent
+	else amount = 0;
+
+	if(event == EVENT_ENTER_CLICK) {
+		if(temp == 0) song_part_euclid(current_edit_seq, part, amount, len, 0);
+		else if(temp == 1) song_part_rotate(current_edit_seq, part, amount);
+		else if(temp == 2) song_part_shift(current_edit_seq, part, (char)amount - 8);
+		else if(temp == 3) song_part_random_gates(current_edit_seq, part, amount);
+		else song_part_markov(current_edit_seq, part);
+		screen_write_popup(750, "", "generated");
+	}
+
+	if(temp == 0) {
+		p = text_int(text_str(str, "part eucl "), amount, TEXT_ZERO | 2);
+		text_char(text_int(text_char(p, '/'), len, TEXT_ZERO | 2), '?');
+	}
+	else if(temp == 1) {
+		text_char(text_int(text_str(str, "part rotate  "), amount, TEXT_ZERO | 2), '?');
+	}
+	else if(temp == 2) {
+		p = text_str(str, "part shift  ");
+		text_char(text_int(p, (char)amount - 8, TEXT_ZERO | TEXT_SIGN | 3), '?');
+	}
+	else if(temp == 3) {
+		text_str(text_int(text_str(str, "rand gates "), amount, 3), "%?");
+	}
+	else {
+		text_str(str, "part     markov?");
+	}
+	screen_write_line(1, str);
+}
+
+// part arpeggiator
+void gui_part_arp(char event) {
+	unsigned char part, mode;
+	char *p;
+	part = gui_get_part();
+
+	if(event == EVENT_REFRESH) {
+		text_str(text_int(text_str(str, "PART "), part + 1, 0), " ARP");
+		screen_write_line(0, str);
+	}
+	// the MIDI only parts play their steps
+	if(part > (SONG_NUM_CV_PARTS - 1)) {
+		screen_write_line(1, "CV parts only");
+		return;
+	}
+	else if(event == EVENT_POT1_CHANGE) {
+		sysconfig_set_arp_octaves(part, (pot1_val >> 6) + 1);
+	}
+	else if(event == EVENT_POT2_CHANGE) {
+		sysconfig_set_arp_mode(part, (pot2_val * (ARP_MAX_MODE + 1)) >> 8);
+	}
+
+	mode = sysconfig_get_arp_mode(part);
+	if(mode == ARP_UP) p = text_str(str, "arp up  ");
+	else if(mode == ARP_DOWN) p = text_str(str, "arp down");
+	else if(mode == ARP_PINGPONG) p = text_str(str, "arp pong");
+	else if(mode == ARP_RANDOM) p = text_str(str, "arp rand");
+	else if(mode == ARP_PLAYED) p = text_str(str, "arp play");
+	else p = text_str(str, "arp off ");
+	text_int(text_str(p, "   oct "), sysconfig_get_arp_octaves(part), 0);
+	screen_write_line(1, str);
+}
+
+// system song load
+void gui_system_song_load(char event) {
+	char *p;
+	if(event == EVENT_REFRESH) {
+		screen_write_line(0, "SONG LOAD");
+		temp = sysconfig_get_current_song();
+	}
+	else if(event == EVENT_POT2_CHANGE) {
+		temp = (pot2_val >> 5) & 0x07;
+	}
+	if(event == EVENT_ENTER_CLICK) {
+		song_file_load(temp);
+	}
+
+	p = text_int(text_str(str, "  load song "), temp + 1, TEXT_ZERO | 2);
+	if(temp == sysconfig_get_current_song()) text_str(p, "*?");
+	else text_str(p, " ?");
+	screen_write_line(1, str);
+}
+
+// system song save
+void gui_system_song_sav(char event) {
+	char *p;
+	if(event == EVENT_REFRESH) {
+		screen_write_line(0, "SONG SAVE");
+		temp = sysconfig_get_current_song();
+	}
+	else if(event == EVENT_POT2_CHANGE) {
+		temp = (pot2_val >> 5) & 0x07;
+	}
+	else if(event == EVENT_ENTER_CLICK) {
+		song_file_save(temp);
+	}
+
+	p = text_int(text_str(str, "  save song "), temp + 1, TEXT_ZERO | 2);
+	if(temp == sysconfig_get_current_song()) text_str(p, "*?");
+	else text_str(p, " ?");
+	screen_write_line(1, str);
+}
+
+// syste, song clear
+void gui_system_song_clr(char event) {
+	if(event == EVENT_REFRESH) {
+		screen_write_line(0, "SONG CLEAR");
+	}
+	else if(event == EVENT_ENTER_CLICK) {
+		song_clear_song();
+		screen_write_popup(750, "SONG CLEAR", "cleared");
+	}
+	screen_write_line(1, "     song clear?");
+}
+
+// system MIDI control cancel
+void gui_system_midi_control_cancel(char event) {
+	if(event == EVENT_REFRESH) {
+		screen_write_line(0, "MOD CTRL CANCEL");
+	}
+	else if(event == EVENT_ENTER_CLICK) {
+		sequencer_control_restore();
+		screen_write_popup(750, "", "canceled");
+	}
+	screen_write_line(1, " control cancel?");
+}
+
+// system MIDI only part channels - pot 1 selects the part
+void gui_system_midi_tracks(char event) {
+	char *p;
+	if(event == EVENT_REFRESH) {
+		screen_write_line(0, "MIDI PARTS");
+		utemp = SONG_NUM_CV_PARTS;
+	}
+	else if(event == EVENT_POT1_CHANGE) {
+		utemp = ((pot1_val * (SONG_NUM_PARTS - SONG_NUM_CV_PARTS)) >> 8) +
+			SONG_NUM_CV_PARTS;
+	}
+	else if(event == EVENT_POT2_CHANGE) {
+		sysconfig_set_midi_channel(utemp, (pot2_val >> 4) & 0x0f);
+	}
+	p = text_int(text_str(str, "part "), utemp + 1, 0);
+	text_int(text_str(p, "  chan "), sysconfig_get_midi_channel(utemp) + 1, TEXT_ZERO | 2);
+	screen_write_line(1, str);
+}
+
+// system MIDI CC map
+//
+// - pot 1 selects the controller and pot 2 its target
+// - enter learns the controller for the target shown
+//
+void gui_system_cc_map(char event) {
+	unsigned char target;
+	char *p;
+	if(event == EVENT_REFRESH) {
+		utemp = 1;  // controller
+		utemp2 = sysconfig_get_cc_target(utemp);  // target
+	}
+	else if(event == EVENT_POT1_CHANGE) {
+		utemp = pot1_val >> 1;
+		if(utemp > 119) utemp = 119;
+		utemp2 = sysconfig_get_cc_target(utemp);
+	}
+	else if(event == EVENT_POT2_CHANGE) {
+		utemp2 = (pot2_val * (SYSCONFIG_CC_MAX_TARGET + 1)) >> 8;
+		if(seq_midi_get_learn_cc() == SEQ_MIDI_LEARN_OFF) {
+			sysconfig_set_cc_map(utemp, utemp2, sysconfig_get_cc_channel(utemp));
+		}
+	}
+	else if(event == EVENT_ENTER_CLICK) {
+		if(seq_midi_get_learn_cc() == SEQ_MIDI_LEARN_OFF) {
+			seq_midi_learn_cc(utemp2);
+		}
+		else {
+			seq_midi_learn_cc(SEQ_MIDI_LEARN_OFF);
+		}
+	}
+	if(seq_midi_get_learn_cc() != SEQ_MIDI_LEARN_OFF) {
+		screen_write_line(0, "MIDI CC LEARN");
+		p = text_str(str, "cc??? ");
+	}
+	else {
+		screen_write_line(0, "MIDI CC MAP");
+		p = text_char(text_int(text_str(str, "cc"), utemp, TEXT_ZERO | 3), ' ');
+	}
+	target = utemp2;
+	text_name(p, cc_target_names, target, SYSCONFIG_CC_MAX_TARGET + 1);
+	screen_write_line(1, str);
+}
+
+// system lane CC - the controllers sent by the CC lanes
+void gui_system_lane_cc(char event) {
+	char *p;
+	if(event == EVENT_REFRESH) {
+		screen_write_line(0, "LANE CC");
+	}
+	else if(event == EVENT_POT1_CHANGE) {
+		sysconfig_set_lane_cc(0, (pot1_val * (SYSCONFIG_MAX_LANE_CC + 1)) >> 8);
+	}
+	else if(event == EVENT_POT2_CHANGE) {
+		sysconfig_set_lane_cc(1, (pot2_val * (SYSCONFIG_MAX_LANE_CC + 1)) >> 8);
+	}
+	p = text_int(text_str(str, "1 cc"), sysconfig_get_lane_cc(0), TEXT_ZERO | 3);
+	text_int(text_str(p, "  2 cc"), sysconfig_get_lane_cc(1), TEXT_ZERO | 3);
+	screen_write_line(1, str);
+}
+
+// system seq launch - when a cued seq starts
+//
+// - pot 1 selects the launch mode and pot 2 the steps in a bar
+//
+void gui_system_seq_launch(char event) {
+	unsigned char mode;
+	char *name, *p;
+	if(event == EVENT_REFRESH) {
+		screen_write_line(0, "SEQ LAUNCH");
+	}
+	else if(event == EVENT_POT1_CHANGE) {
+		sysconfig_set_launch_mode((pot1_val >> 6) & 0x03);
+	}
+	else if(event == EVENT_POT2_CHANGE) {
+		sysconfig_set_launch_bar((pot2_val >> 2) + 1);
+	}
+	mode = sysconfig_get_launch_mode();
+	if(mode == SYSCONFIG_LAUNCH_NOW) name = "now ";
+	else if(mode == SYSCONFIG_LAUNCH_BEAT) name = "beat";
+	else if(mode == SYSCONFIG_LAUNCH_BAR) name = "bar ";
+	else name = "loop";
+	p = text_int(text_str(text_str(str, name), "   "), sysconfig_get_launch_bar(), TEXT_ZERO | 2);
+	text_str(p, " steps");
+	screen_write_line(1, str);
+}
+
+// system key map
+void gui_system_key_map(char event) {
+	if(event == EVENT_REFRESH) {
+		screen_write_line(0, "KEY MAP");
+	}
+	else if(event == EVENT_POT1_CHANGE) {
+		sysconfig_set_rec_mode(pot1_val >> 7);
+	}
+	else if(event == EVENT_POT2_CHANGE) {
+		sysconfig_set_key_map((pot2_val * 3) >> 8);
+	}
+	// record map - pot 1 picks the record mode
+	if(sysconfig_get_key_map() == SYSCONFIG_KEY_MAP_REC) {
+		if(sysconfig_get_rec_mode() == SYSCONFIG_REC_REPLACE) {
+			text_str(str, "key map  REC rpl");
+		}
+		else {
+			text_str(str, "key map  REC ovr");
+		}
+	}
+	else if(sequencer_get_control_override(SYSCONFIG_MOD_KEY_MAP) == 1) {
+		if(sysconfig_get_key_map() == SYSCONFIG_KEY_MAP_B) {
+			text_str(str, "key map      B>A");
+		}
+		else {
+			text_str(str, "key map      A>B");
+		}
+	}
+	else {
+		if(sysconfig_get_key_map() == SYSCONFIG_KEY_MAP_B) {
+			text_str(str, "key map      B");
+		}
+		else {
+			text_str(str, "key map      A");
+		}
+	}
+	screen_write_line(1, str);
+}
+
+// system CV cal
+void gui_system_cv_cal(char event) {
+	char *p;
+	if(event == EVENT_REFRESH) {
+		screen_write_line(0, "CV CALIBRATE");
+		temp = 127;
+		temp2 = 127;
+	}
+	else if(event == EVENT_POT1_CHANGE) {
+		temp = (pot1_val >> 5) & 0x07;
+		if(temp > 6) temp = 6;
+		if(temp2 == 127) {
+			sequencer_cv_cal_start();
+			temp2 = (pot2_val >> 5) & 0x07;
+			if(temp2 > 6) temp2 = 6;
+			sequencer_cv_set_cal(1, temp2);	
+		}
+		sequencer_cv_set_cal(0, temp);
+	}
+	else if(event == EVENT_POT2_CHANGE) {
+		temp2 = (pot2_val >> 5) & 0x07;
+		if(temp2 > 6) temp2 = 6;
+		if(temp == 127) {
+			sequencer_cv_cal_start();
+			temp = (pot1_val >> 5) & 0x07;
+			if(temp > 6) temp = 6;
+			sequencer_cv_set_cal(0, temp);	
+		}
+		sequencer_cv_set_cal(1, temp2);	
+	}
+	if(temp == 127 || temp2 == 127) {
+		text_str(str, "cv1  ?V cv2  ?V");
+	}
+	else {
+		p = text_char(text_int(text_str(str, "cv1 "), temp - 3, TEXT_SIGN), 'V');
+		text_char(text_int(text_str(p, " cv2 "), temp2 - 3, TEXT_SIGN), 'V');
+	}
+	screen_write_line(1, str);
+}
+
+// system reset
+void gui_system_system_reset(char event) {
+	if(event == EVENT_REFRESH) {
+		screen_write_line(0, "SYSTEM RESET");
+	}
+	else if(event == EVENT_ENTER_CLICK) {
+		sysconfig_reset_all();
+		screen_write_popup(750, "", "done!");
+		// this doesn't work correctly
+//		system_page = SYSTEM_SONG_LOAD;  // force us out of here on the next entry
+	}
+	screen_write_line(1, " reset settings?");
+}
+
+// live clock control
+void gui_live_play(char event) {
+	char *p;
+	if(event == EVENT_REFRESH) {
+		screen_write_line(0, "LIVE PLAY CTRL");
+		temp = current_edit_seq;
+	}
+	else if(event == EVENT_POT1_CHANGE) {
+		sysconfig_set_clock_speed(pot1_val);
+	}
+	else if(event == EVENT_POT2_CHANGE) {
+		temp = (pot2_val >> 4) & 0x0f;
+	}
+	else if(event == EVENT_ENTER_CLICK) {
+		sequencer_control_change(SYSCONFIG_MOD_NEXT_SEQ, ((temp << 3) & 0x7f));
+		current_edit_seq = temp;
+	}
+	if(clock_get_speed() < 20) {
+		p = text_str(str, "EXT CLK");
+	}
+	else {
+		p = text_str(text_int(str, sysconfig_get_clock_speed(), 3), " BPM");
+	}
+	text_char(text_int(text_str(p, "  seq "), temp + 1, TEXT_ZERO | 2), '?');
+	screen_write_line(1, str);
+}
+
+// live seq control
+void gui_live_seq(char event) {
+	char *p;
+	if(event == EVENT_REFRESH) {
+		screen_write_line(0, "LIVE SEQ CTRL");
+	}
+	else if(event == EVENT_POT1_CHANGE) {
+		sequencer_control_change(SYSCONFIG_MOD_GATE1, pot1_val >> 1);
+		sequencer_control_change(SYSCONFIG_MOD_GATE2, pot1_val >> 1);
+	}
+	else if(event == EVENT_POT2_CHANGE) {
+		sequencer_control_change(SYSCONFIG_MOD_SEQ_DIR, pot2_val >> 1);
+	}
+	else if(event == EVENT_ENTER_CLICK) {
+		sequencer_control_restore();
+	}
+	utemp = sequencer_get_control_override(SYSCONFIG_MOD_GATE1);
+	utemp2 = sequencer_get_control_override(SYSCONFIG_MOD_SEQ_DIR);
+	p = text_str(str, "gate ");
+	if(utemp == 255) {
+		p = text_str(p, "??");
+	}
+	else {
+		p = text_int(p, utemp, TEXT_ZERO | 2);
+	}
+	if(utemp2 == 1) {
+		text_str(p, " dir FLIP");
+	}
+	else {
+		text_str(p, " dir NORM");
+	}
+	screen_write_line(1, str);
+}
+
+// live step control
+void gui_live_step(char event) {
+	char *p;
+	if(event == EVENT_REFRESH) {
+		screen_write_line(0, "LIVE STEP CTRL");
+	}
+	else if(event == EVENT_POT1_CHANGE) {
+		sequencer_control_change(SYSCONFIG_MOD_SEQ_START, pot1_val >> 1);
+	}
+	else if(event == EVENT_POT2_CHANGE) {
+		sequencer_control_change(SYSCONFIG_MOD_SEQ_LEN, pot2_val >> 1);
+	}
+	else if(event == EVENT_ENTER_CLICK) {
+		sequencer_control_restore();
+	}
+	utemp = sequencer_get_control_override(SYSCONFIG_MOD_SEQ_START);
+	utemp2 = sequencer_get_control_override(SYSCONFIG_MOD_SEQ_LEN);
+	p = text_str(str, "start ");
+	if(utemp == 255) p = text_str(p, "??");
+	else p = text_int(p, utemp + 1, TEXT_ZERO | 2);
+	p = text_str(p, " len ");
+	if(utemp2 == 255) text_str(p, "??");
+	else text_int(p, utemp2, TEXT_ZERO | 2);
+	screen_write_line(1, str);
+}
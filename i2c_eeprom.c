@@ -1,10 +1,10 @@
-/*
- * K2579 Step Sequencer - I2C EEPROM Driver
- *
- * Copyright 2011: Kilpatrick Audio
- * Written by: Andrew Kilpatrick
- *
- *
- */
-#include "i2c_eeprom.h"
-
+/*
+ * K2579 Step Sequencer - I2C EEPROM Driver
+ *
+ * Copyright 2011: Kilpatrick Audio
+ * Written by: Andrew Kilpatrick
+ *
+ *
+ */
+#include "i2c_eeprom.h"
+
@@ -0,0 +1,212 @@
+/*
+ * K2579 Step Sequencer - MIDI Time Code Chase
+ *
+ * Copyright 2011: Kilpatrick Audio
+ * Written by: Andrew Kilpatrick
+ *
+ * MTC Handling
+ *  - quarter frames are assembled one at a time as they arrive - each
+ *    one is a few instructions and a full time code is decoded when the
+ *    8th piece comes in
+ *  - two full time codes in a row that agree put us into lock - the song
+ *    is located to the time code and started on the internal clock
+ *  - the sequencer walks to the position over a number of timer passes -
+ *    the locate follows the time code until it gets there and the song
+ *    is then started with an SPP if the position fits in one
+ *  - the position is converted to clock ticks using the internal clock
+ *    rate so the tempo is set by the clock speed, not by the time code
+ *  - each full time code while locked is checked against the sequencer
+ *    and a position that has drifted too far is located again
+ *  - if the time code stops we keep running (freewheel) for a short time
+ *    and then stop
+ *  - drop frame rates are counted as 30fps
+ *
+ */
+#include "mtc.h"
+#include "clock.h"
+#include "sequencer.h"
+#include "midi.h"
+
+// timing
+#define MTC_FREEWHEEL_TIME 3  // 48ms without quarter frames
+#define MTC_DROPOUT_TIME 62  // 1s without quarter frames
+#define MTC_MAX_ERROR 6  // clock ticks - a 16th note
+#define MTC_TICK_RATE 976562UL  // clock interval counts per second
+#define MTC_MAX_SPP 0x3fff  // 16th notes
+
+// state
+unsigned char mtc_state;
+unsigned char mtc_piece;  // the next piece expected
+unsigned char mtc_pieces;  // pieces received in order - stops counting at 8
+unsigned char mtc_nibbles[8];
+unsigned char mtc_fps;
+unsigned long mtc_qf;  // current position in quarter frames
+unsigned long mtc_last_tc;  // last full time code in quarter frames
+unsigned char mtc_timeout;  // 16ms ticks since the last quarter frame
+unsigned int mtc_lock_timer;  // 16ms ticks since we started chasing
+unsigned char mtc_locating;  // waiting for the sequencer to reach the time code
+int mtc_stats[MTC_NUM_STATS];
+
+// frame rates by the rate bits of the hours
+const unsigned char mtc_rates[4] = {24, 25, 30, 30};
+
+// local functions
+void mtc_timecode(unsigned long tc);
+long mtc_expected_ticks(void);
+void mtc_locate(void);
+
+// initialize the MTC handler
+void mtc_init(void) {
+	int i;
+	mtc_state = MTC_STOPPED;
+	mtc_piece = 0;
+	mtc_pieces = 0;
+	mtc_fps = 30;
+	mtc_qf = 0;
+	mtc_last_tc = 0;
+	mtc_timeout = 0;
+	mtc_lock_timer = 0;
+	mtc_locating = 0;
+	for(i = 0; i < MTC_NUM_STATS; i ++) {
+		mtc_stats[i] = 0;
+	}
+}
+
+// run the MTC task - call every 16ms
+void mtc_task(void) {
+	unsigned int pos;
+	if(mtc_state == MTC_STOPPED) return;
+	if(mtc_timeout < 255) mtc_timeout ++;
+	if(mtc_state == MTC_CHASE) {
+		mtc_lock_timer ++;
+		if(mtc_timeout > MTC_DROPOUT_TIME) mtc_state = MTC_STOPPED;
+	}
+	else if(mtc_state == MTC_LOCKED) {
+		if(mtc_timeout > MTC_FREEWHEEL_TIME) mtc_state = MTC_FREEWHEEL;
+	}
+	else if(mtc_state == MTC_FREEWHEEL) {
+		if(mtc_timeout > MTC_DROPOUT_TIME) {
+			mtc_state = MTC_STOPPED;
+			clock_stop_command();
+		}
+	}
+	if(!mtc_locating) return;
+	if(mtc_state == MTC_STOPPED || mtc_state == MTC_CHASE) {
+		mtc_locating = 0;
+		return;
+	}
+
+	// keep the locate up with the time code and run once it gets there
+	sequencer_locate_update(mtc_expected_ticks() / 6);
+	if(sequencer_locating()) return;
+	mtc_locating = 0;
+	pos = sequencer_get_clock_tick_count() / 6;
+	if(pos <= MTC_MAX_SPP) _midi_tx_song_position(pos);
+	clock_run_command();
+}
+
+// handle a quarter frame message
+void mtc_qframe(unsigned char data) {
+	unsigned char piece = (data >> 4) & 0x07;
+	unsigned long tc;
+
+	mtc_timeout = 0;
+	if(mtc_state == MTC_STOPPED) {
+		mtc_state = MTC_CHASE;
+		mtc_lock_timer = 0;
+		mtc_pieces = 0;
+	}
+	else if(mtc_state == MTC_FREEWHEEL) {
+		mtc_state = MTC_LOCKED;
+	}
+
+	// pieces must arrive in order - start again from piece 0
+	if(piece != mtc_piece) {
+		mtc_pieces = 0;
+		mtc_piece = 0;
+		if(piece != 0) return;
+	}
+	mtc_nibbles[piece] = data & 0x0f;
+	mtc_piece = (piece + 1) & 0x07;
+	if(mtc_pieces < 8) mtc_pieces ++;
+	mtc_qf ++;
+	if(piece != 7 || mtc_pieces < 8) return;
+
+	// full time code - it was true when piece 0 arrived 7 quarter frames ago
+	mtc_fps = mtc_rates[(mtc_nibbles[7] >> 1) & 0x03];
+	tc = ((mtc_nibbles[7] & 0x01) << 4) | mtc_nibbles[6];  // hours
+	tc = (tc * 60) + ((mtc_nibbles[5] << 4) | mtc_nibbles[4]);  // minutes
+	tc = (tc * 60) + ((mtc_nibbles[3] << 4) | mtc_nibbles[2]);  // seconds
+	tc = (tc * mtc_fps) + ((mtc_nibbles[1] << 4) | mtc_nibbles[0]);  // frames
+	mtc_timecode((tc << 2) + 7);
+}
+
+// get the chase state
+unsigned char mtc_get_state(void) {
+	return mtc_state;
+}
+
+// get the time code position in quarter frames
+unsigned long mtc_get_position(void) {
+	return mtc_qf;
+}
+
+// get an MTC stat
+int mtc_get_stat(unsigned char stat) {
+	if(stat > (MTC_NUM_STATS - 1)) return 0;
+	return mtc_stats[stat];
+}
+
+//
+// local functions
+//
+// handle a full time code
+void mtc_timecode(unsigned long tc) {
+	long err;
+	unsigned char steady = (tc == (mtc_last_tc + 8));
+	mtc_last_tc = tc;
+
+	// wait for two time codes in a row before locking
+	if(mtc_state == MTC_CHASE) {
+		if(!steady) return;
+		mtc_qf = tc;
+		mtc_stats[MTC_STAT_LOCK_TIME] = mtc_lock_timer << 4;
+		mtc_stats[MTC_STAT_LAST_ERROR] = 0;
+		mtc_stats[MTC_STAT_MAX_ERROR] = 0;
+		mtc_state = MTC_LOCKED;
+		mtc_locate();
+		return;
+	}
+
+	// the time code jumped
+	if(tc != mtc_qf) {
+		mtc_qf = tc;
+		mtc_locate();
+		return;
+	}
+
+	// check how far the sequencer has drifted
+	if(!clock_get_speed() || !clock_get_song_playing()) return;
+	err = (long)sequencer_get_clock_tick_count() - mtc_expected_ticks();
+	mtc_stats[MTC_STAT_LAST_ERROR] = err;
+	if(err < 0) err = -err;
+	if(err > mtc_stats[MTC_STAT_MAX_ERROR]) mtc_stats[MTC_STAT_MAX_ERROR] = err;
+	if(err > MTC_MAX_ERROR) mtc_locate();
+}
+
+// get the clock tick count for the time code position at the internal tempo
+long mtc_expected_ticks(void) {
+	unsigned long long counts = (unsigned long long)mtc_qf * (MTC_TICK_RATE / 4);
+	return counts / ((unsigned long long)mtc_fps * clock_get_interval());
+}
+
+// locate the song to the time code - it is run by mtc_task() once the
+// sequencer gets there
+void mtc_locate(void) {
+	// the internal clock sets the tempo
+	if(!clock_get_speed()) return;
+	mtc_stats[MTC_STAT_RELOCATES] ++;
+	clock_stop_command();
+	sequencer_locate(mtc_expected_ticks() / 6);
+	mtc_locating = 1;
+}
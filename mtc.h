@@ -0,0 +1,37 @@
+/*
+ * K2579 Step Sequencer - MIDI Time Code Chase
+ *
+ * Copyright 2011: Kilpatrick Audio
+ * Written by: Andrew Kilpatrick
+ *
+ */
+// chase states
+#define MTC_STOPPED 0  // no time code
+#define MTC_CHASE 1  // time code is arriving - waiting for it to be steady
+#define MTC_LOCKED 2  // following the time code
+#define MTC_FREEWHEEL 3  // time code dropped out - still running
+
+// stats
+#define MTC_STAT_LOCK_TIME 0  // ms from the first quarter frame to lock
+#define MTC_STAT_LAST_ERROR 1  // clock ticks ahead (+) or behind (-) at the last frame
+#define MTC_STAT_MAX_ERROR 2  // largest error seen while locked
+#define MTC_STAT_RELOCATES 3  // times the position was corrected
+#define MTC_NUM_STATS 4
+
+// initialize the MTC handler
+void mtc_init(void);
+
+// run the MTC task - call every 16ms
+void mtc_task(void);
+
+// handle a quarter frame message
+void mtc_qframe(unsigned char data);
+
+// get the chase state
+unsigned char mtc_get_state(void);
+
+// get the time code position in quarter frames
+unsigned long mtc_get_position(void);
+
+// get an MTC stat
+int mtc_get_stat(unsigned char stat);
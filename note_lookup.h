@@ -1,82 +1,82 @@
-/*
- * K2579 Step Sequencer - CV DAC Note Lookup Table
- *
- * Copyright 2011: Kilpatrick Audio
- * Written by: Andrew Kilpatrick
- *
- */
-unsigned int note_lookup[] = {	
-3920	,
-3868	,
-3816	,
-3764	,
-3712	,
-3660	,
-3608	,
-3556	,
-3504	,
-3452	,
-3400	,
-3348	,
-3296	,
-3244	,
-3192	,
-3140	,
-3088	,
-3036	,
-2984	,
-2932	,
-2880	,
-2828	,
-2776	,
-2724	,
-2672	,
-2620	,
-2568	,
-2516	,
-2464	,
-2412	,
-2360	,
-2308	,
-2256	,
-2204	,
-2152	,
-2100	,
-2048	,
-1996	,
-1944	,
-1892	,
-1840	,
-1788	,
-1736	,
-1684	,
-1632	,
-1580	,
-1528	,
-1476	,
-1424	,
-1372	,
-1320	,
-1268	,
-1216	,
-1164	,
-1112	,
-1060	,
-1008	,
-956	,
-904	,
-852	,
-800	,
-748	,
-696	,
-644	,
-592	,
-540	,
-488	,
-436	,
-384	,
-332	,
-280	,
-228	,
-176	
-};
+/*
+ * K2579 Step Sequencer - CV DAC Note Lookup Table
+ *
+ * Copyright 2011: Kilpatrick Audio
+ * Written by: Andrew Kilpatrick
+ *
+ */
+unsigned int note_lookup[] = {	
+3920	,
+3868	,
+3816	,
+3764	,
+3712	,
+3660	,
+3608	,
+3556	,
+3504	,
+3452	,
+3400	,
+3348	,
+3296	,
+3244	,
+3192	,
+3140	,
+3088	,
+3036	,
+2984	,
+2932	,
+2880	,
+2828	,
+2776	,
+2724	,
+2672	,
+2620	,
+2568	,
+2516	,
+2464	,
+2412	,
+2360	,
+2308	,
+2256	,
+2204	,
+2152	,
+2100	,
+2048	,
+1996	,
+1944	,
+1892	,
+1840	,
+1788	,
+1736	,
+1684	,
+1632	,
+1580	,
+1528	,
+1476	,
+1424	,
+1372	,
+1320	,
+1268	,
+1216	,
+1164	,
+1112	,
+1060	,
+1008	,
+956	,
+904	,
+852	,
+800	,
+748	,
+696	,
+644	,
+592	,
+540	,
+488	,
+436	,
+384	,
+332	,
+280	,
+228	,
+176	
+};
@@ -0,0 +1,579 @@
+/*
+ * K2579 Step Sequencer - Parameter Access
+ *
+ * Copyright 2011: Kilpatrick Audio
+ * Written by: Andrew Kilpatrick
+ *
+ * The system settings, the CC map and the settings, parts and notes of
+ * each sequence are given parameter numbers so they can be read and
+ * written remotely, by NRPN on the param channel or by SysEx. The
+ * arrangement is not.
+ *
+ * Parameter groups (the NRPN MSB):
+ *  - 0 - system settings
+ *  - 1-16 - sequence settings, parts 1 and 2 and the step lengths
+ *  - 32-36 - the CC map - the index is the controller
+ *  - 40-55 - parts 3-8 of each sequence and the step lanes of all the
+ *    parts - a value for every step would need more numbers than there
+ *    are, so the lane params edit the step set by PARAM_SYS_LANE_STEP
+ *  - 64-127 - notes of all the parts - one group per sequence and step
+ *    page, the index is part x 16 + step - page 1 is the same as NOTE1
+ *    and NOTE2 for parts 1 and 2
+ *  - 17-31, 37-39 and 56-63 are free
+ *
+ * NRPN:
+ *  - only listened for on the param channel set in the system menu -
+ *    these CCs on other channels are handled like any other CC
+ *  - CC 99 / 98 select the param - group (MSB) and index (LSB)
+ *  - CC 6 sets the value - for params above 127 it is the top 7 bits
+ *  - CC 38 sets the bottom 7 bits of params above 127
+ *  - CC 96 / 97 step the value up / down
+ *  - CC 101 / 100 select an RPN - these are not supported
+ *
+ * SysEx:
+ *  - SET holds any number of [num, value] pairs, each in 2 x 7 bits
+ *  - GET asks for up to 32 params from a starting number and is
+ *    answered with a VALUES message
+ *
+ * Changes are applied as they arrive but the GUI is only refreshed once
+ * a burst of changes is over: at the end of a SET message or when no
+ * changes have arrived for PARAM_FLUSH_TIME.
+ *
+ */
+#include <stddef.h>
+#include "param.h"
+#include "song.h"
+#include "song_file.h"
+#include "sysconfig.h"
+#include "arp.h"
+#include "midi.h"
+#include "gui.h"
+
+// registry
+struct param_info {
+	unsigned char index;  // first index
+	unsigned char count;  // number of indexes - parts, steps or controllers
+	unsigned char scope;
+	unsigned char min;
+	unsigned char max;
+};
+const struct param_info sys_params[] = {
+	{PARAM_SYS_CLOCK_DIV, 1, PARAM_SCOPE_SYSTEM, 1, SYSCONFIG_MAX_CLOCK_DIV},
+	{PARAM_SYS_MOD1_ASSIGN, 1, PARAM_SCOPE_SYSTEM, 0, SYSCONFIG_MAX_MOD_ASSIGN},
+	{PARAM_SYS_MOD2_ASSIGN, 1, PARAM_SCOPE_SYSTEM, 0, SYSCONFIG_MAX_MOD_ASSIGN},
+	{PARAM_SYS_LIVE_AUD, 1, PARAM_SCOPE_SYSTEM, 0, 1},
+	{PARAM_SYS_MIDI_PT1_CHAN, 1, PARAM_SCOPE_SYSTEM, 0, 15},
+	{PARAM_SYS_MIDI_PT2_CHAN, 1, PARAM_SCOPE_SYSTEM, 0, 15},
+	{PARAM_SYS_KEY_TRANSPOSE, 1, PARAM_SCOPE_SYSTEM, 0, SYSCONFIG_KEY_TRANSPOSE12},
+	{PARAM_SYS_KEY_TRIGGER, 1, PARAM_SCOPE_SYSTEM, 0, SYSCONFIG_KEY_TRIGGER_MOM},
+	{PARAM_SYS_LCD_CONTRAST, 1, PARAM_SCOPE_SYSTEM, 0, 255},
+	{PARAM_SYS_CLOCK_SPEED, 1, PARAM_SCOPE_SYSTEM, 20, 250},
+	{PARAM_SYS_RESET_MODE, 1, PARAM_SCOPE_SYSTEM, 0, SYSCONFIG_RESET_MODE_SEQ},
+	{PARAM_SYS_CURRENT_SONG, 1, PARAM_SCOPE_SYSTEM, 0, 7},
+	{PARAM_SYS_KEY_MAP, 1, PARAM_SCOPE_SYSTEM, 0, SYSCONFIG_KEY_MAP_REC},
+	{PARAM_SYS_REC_MODE, 1, PARAM_SCOPE_SYSTEM, 0, SYSCONFIG_REC_REPLACE},
+	{PARAM_SYS_ARP1_MODE, 1, PARAM_SCOPE_SYSTEM, 0, ARP_MAX_MODE},
+	{PARAM_SYS_ARP2_MODE, 1, PARAM_SCOPE_SYSTEM, 0, ARP_MAX_MODE},
+	{PARAM_SYS_ARP1_OCTAVES, 1, PARAM_SCOPE_SYSTEM, 1, ARP_MAX_OCTAVES},
+	{PARAM_SYS_ARP2_OCTAVES, 1, PARAM_SCOPE_SYSTEM, 1, ARP_MAX_OCTAVES},
+	{PARAM_SYS_MIDI_TRACK_CHAN, SONG_NUM_PARTS - SONG_NUM_CV_PARTS, PARAM_SCOPE_SYSTEM, 0, 15},
+	{PARAM_SYS_LANE_CC, 2, PARAM_SCOPE_SYSTEM, 0, SYSCONFIG_MAX_LANE_CC},
+	{PARAM_SYS_ACCENT_GATE, 1, PARAM_SCOPE_SYSTEM, 0, SYSCONFIG_MAX_ACCENT_GATE},
+	{PARAM_SYS_RAND_SEED, 1, PARAM_SCOPE_SYSTEM, 0, SYSCONFIG_MAX_RAND_SEED},
+	{PARAM_SYS_LAUNCH_MODE, 1, PARAM_SCOPE_SYSTEM, 0, SYSCONFIG_LAUNCH_BAR},
+	{PARAM_SYS_SWITCH_MODE, 1, PARAM_SCOPE_SYSTEM, 0, SYSCONFIG_SWITCH_LEGATO},
+	{PARAM_SYS_LAUNCH_BAR, 1, PARAM_SCOPE_SYSTEM, 1, SONG_NUM_STEPS},
+	{PARAM_SYS_PARAM_CHAN, 1, PARAM_SCOPE_SYSTEM, 0, SYSCONFIG_PARAM_CHAN_OFF},
+	{PARAM_SYS_LANE_STEP, 1, PARAM_SCOPE_SYSTEM, 0, SONG_NUM_STEPS - 1}
+};
+#define PARAM_NUM_SYS (sizeof(sys_params) / sizeof(struct param_info))
+const struct param_info seq_params[] = {
+	{PARAM_SEQ_START, 1, PARAM_SCOPE_SEQ, 0, SONG_NUM_STEPS - 1},
+	{PARAM_SEQ_LEN, 1, PARAM_SCOPE_SEQ, 1, SONG_NUM_STEPS},
+	{PARAM_SEQ_DIR, 1, PARAM_SCOPE_SEQ, 0, SONG_MAX_DIR},
+	{PARAM_SEQ_LOOP, 1, PARAM_SCOPE_SEQ, 0, SONG_MAX_LOOPS},
+	{PARAM_SEQ_NEXT, 1, PARAM_SCOPE_SEQ, 0, SONG_NUM_SEQ - 1},
+	{PARAM_SEQ_STEPS, 1, PARAM_SCOPE_SEQ, 1, SONG_NUM_STEP_PAGES},
+	{PARAM_SEQ_GATE, 2, PARAM_SCOPE_PART, 1, 48},
+	{PARAM_SEQ_SCALE, 2, PARAM_SCOPE_PART, 0, 7},
+	{PARAM_SEQ_SPAN, 2, PARAM_SCOPE_PART, 1, 4},
+	{PARAM_SEQ_OFFSET, 2, PARAM_SCOPE_PART, 0, 24},
+	{PARAM_SEQ_STEP_LEN, SONG_PAGE_STEPS, PARAM_SCOPE_STEP, 0, 31},
+	{PARAM_SEQ_NOTE1, SONG_PAGE_STEPS, PARAM_SCOPE_STEP, 0, 127},
+	{PARAM_SEQ_NOTE2, SONG_PAGE_STEPS, PARAM_SCOPE_STEP, 0, 127},
+	{PARAM_SEQ_PART_START, 2, PARAM_SCOPE_PART, 0, SONG_NUM_STEPS},
+	{PARAM_SEQ_PART_LEN, 2, PARAM_SCOPE_PART, 0, SONG_NUM_STEPS},
+	{PARAM_SEQ_PART_DIR, 2, PARAM_SCOPE_PART, 0, SONG_MAX_DIR + 1},
+	{PARAM_SEQ_PART_DIV, 2, PARAM_SCOPE_PART, 0, SONG_MAX_PART_DIV},
+	{PARAM_SEQ_STEP_LEN_EXT, SONG_NUM_STEPS - SONG_PAGE_STEPS, PARAM_SCOPE_STEP, 0, 31}
+};
+#define PARAM_NUM_SEQ (sizeof(seq_params) / sizeof(struct param_info))
+const struct param_info part_params[] = {
+	{PARAM_PART_GATE, SONG_NUM_PARTS - SONG_NUM_CV_PARTS, PARAM_SCOPE_PART, 1, 48},
+	{PARAM_PART_SCALE, SONG_NUM_PARTS - SONG_NUM_CV_PARTS, PARAM_SCOPE_PART, 0, 7},
+	{PARAM_PART_SPAN, SONG_NUM_PARTS - SONG_NUM_CV_PARTS, PARAM_SCOPE_PART, 1, 4},
+	{PARAM_PART_OFFSET, SONG_NUM_PARTS - SONG_NUM_CV_PARTS, PARAM_SCOPE_PART, 0, 24},
+	{PARAM_PART_START, SONG_NUM_PARTS - SONG_NUM_CV_PARTS, PARAM_SCOPE_PART, 0, SONG_NUM_STEPS},
+	{PARAM_PART_LEN, SONG_NUM_PARTS - SONG_NUM_CV_PARTS, PARAM_SCOPE_PART, 0, SONG_NUM_STEPS},
+	{PARAM_PART_DIR, SONG_NUM_PARTS - SONG_NUM_CV_PARTS, PARAM_SCOPE_PART, 0, SONG_MAX_DIR + 1},
+	{PARAM_PART_DIV, SONG_NUM_PARTS - SONG_NUM_CV_PARTS, PARAM_SCOPE_PART, 0, SONG_MAX_PART_DIV},
+	{PARAM_PART_LANE, SONG_NUM_PARTS * SONG_NUM_LANE_TYPES, PARAM_SCOPE_PART, 0, 255}
+};
+#define PARAM_NUM_PART (sizeof(part_params) / sizeof(struct param_info))
+// the sequence params that each part param works like
+const unsigned char part_kinds[] = {
+	PARAM_SEQ_GATE, PARAM_SEQ_SCALE, PARAM_SEQ_SPAN, PARAM_SEQ_OFFSET,
+	PARAM_SEQ_PART_START, PARAM_SEQ_PART_LEN, PARAM_SEQ_PART_DIR, PARAM_SEQ_PART_DIV
+};
+const struct param_info note_params[] = {
+	{0, SONG_NUM_PARTS * SONG_PAGE_STEPS, PARAM_SCOPE_STEP, 0, 127}
+};
+const struct param_info cc_params[] = {
+	{0, 120, PARAM_SCOPE_CC, 0, SYSCONFIG_CC_MAX_TARGET},  // PARAM_GROUP_CC_TARGET
+	{0, 120, PARAM_SCOPE_CC, 0, SYSCONFIG_CC_CHAN_PARTS},  // PARAM_GROUP_CC_CHAN
+	{0, 120, PARAM_SCOPE_CC, 0, 127},  // PARAM_GROUP_CC_MIN
+	{0, 120, PARAM_SCOPE_CC, 0, 127},  // PARAM_GROUP_CC_MAX
+	{0, 120, PARAM_SCOPE_CC, 0, SYSCONFIG_CC_NUM_CURVES - 1}  // PARAM_GROUP_CC_CURVE
+};
+
+// step lanes
+unsigned char param_lane_step;  // the step the lane params edit
+
+// coalesced changes
+#define PARAM_FLUSH_TIME 3  // 48ms
+unsigned char param_pending;
+unsigned char param_idle;
+
+// NRPN state
+#define NRPN_NONE 0x3fff
+unsigned int nrpn_num;  // selected param or NRPN_NONE
+unsigned char nrpn_rpn;  // an RPN is selected
+unsigned char nrpn_msb;  // last data entry MSB
+
+// SysEx receive
+unsigned char param_rx_cmd;
+unsigned char param_rx_count;
+unsigned char param_rx_buf[4];
+
+// local functions
+const struct param_info *param_find(unsigned int num);
+int param_get_system(unsigned char index);
+void param_set_system(unsigned char index, unsigned char value);
+int param_get_note(unsigned char seq, unsigned char part, unsigned char step);
+void param_set_note(unsigned char seq, unsigned char part, unsigned char step,
+	unsigned char value);
+void param_flush(void);
+void param_send_values(unsigned int num, unsigned char count);
+
+// initialize the parameter handler
+void param_init(void) {
+	param_lane_step = 0;
+	param_pending = 0;
+	param_idle = 0;
+	nrpn_num = NRPN_NONE;
+	nrpn_rpn = 0;
+	nrpn_msb = 0;
+	param_rx_cmd = 0;
+	param_rx_count = 0;
+}
+
+// run the parameter task - call every 16ms
+void param_task(void) {
+	if(!param_pending) return;
+	param_idle ++;
+	if(param_idle >= PARAM_FLUSH_TIME) param_flush();
+}
+
+// get a parameter value - returns -1 if there is no such param
+int param_get(unsigned int num) {
+	const struct param_info *info = param_find(num);
+	unsigned char group = (num >> 7) & 0x7f;
+	unsigned char index = num & 0x7f;
+	unsigned char seq, n, kind, value;
+	if(info == NULL) return -1;
+	n = index - info->index;  // part, step or controller
+
+	if(group == PARAM_GROUP_SYSTEM) return param_get_system(index);
+	if(group == PARAM_GROUP_CC_TARGET) return sysconfig_get_cc_target(n);
+	if(group == PARAM_GROUP_CC_CHAN) return sysconfig_get_cc_channel(n);
+	if(group == PARAM_GROUP_CC_MIN) return sysconfig_get_cc_min(n);
+	if(group == PARAM_GROUP_CC_MAX) return sysconfig_get_cc_max(n);
+	if(group == PARAM_GROUP_CC_CURVE) return sysconfig_get_cc_curve(n);
+
+	// note pages
+	if(group >= PARAM_GROUP_NOTES) {
+		seq = (group - PARAM_GROUP_NOTES) >> 2;
+		return param_get_note(seq, n >> 4, (((group - PARAM_GROUP_NOTES) & 0x03) << 4) | (n & 0x0f));
+	}
+
+	// sequence params - MIDI only parts work like parts 1 and 2
+	if(group >= PARAM_GROUP_PART) {
+		seq = group - PARAM_GROUP_PART;
+		// step lanes - at the lane step
+		if(info->index == PARAM_PART_LANE) {
+			return song_get_lane(seq, n / SONG_NUM_LANE_TYPES, n % SONG_NUM_LANE_TYPES,
+				param_lane_step);
+		}
+		kind = part_kinds[info - part_params];
+		n += SONG_NUM_CV_PARTS;
+	}
+	else {
+		seq = group - PARAM_GROUP_SEQ;
+		kind = info->index;
+	}
+	if(kind == PARAM_SEQ_START) return song_get_seq_start(seq);
+	if(kind == PARAM_SEQ_LEN) return song_get_seq_len(seq);
+	if(kind == PARAM_SEQ_DIR) return song_get_seq_dir(seq);
+	if(kind == PARAM_SEQ_LOOP) return song_get_seq_loop(seq);
+	if(kind == PARAM_SEQ_NEXT) return song_get_seq_next(seq);
+	if(kind == PARAM_SEQ_STEPS) return song_get_seq_steps(seq) / SONG_PAGE_STEPS;
+	if(kind == PARAM_SEQ_GATE) return song_get_gate(seq, n);
+	if(kind == PARAM_SEQ_SCALE) return song_get_scale(seq, n);
+	if(kind == PARAM_SEQ_SPAN) return song_get_span(seq, n);
+	if(kind == PARAM_SEQ_OFFSET) return song_get_offset(seq, n) + 12;
+	if(kind == PARAM_SEQ_STEP_LEN) return song_get_step_len(seq, n);
+	if(kind == PARAM_SEQ_STEP_LEN_EXT) return song_get_step_len(seq, n + SONG_PAGE_STEPS);
+	// part overrides - 0 means the part follows the seq
+	if(kind == PARAM_SEQ_PART_START) {
+		value = song_get_part_start(seq, n);
+		return (value == SONG_PART_FOLLOW) ? 0 : value + 1;
+	}
+	if(kind == PARAM_SEQ_PART_LEN) {
+		value = song_get_part_len(seq, n);
+		return (value == SONG_PART_FOLLOW) ? 0 : value;
+	}
+	if(kind == PARAM_SEQ_PART_DIR) {
+		value = song_get_part_dir(seq, n);
+		return (value == SONG_PART_FOLLOW) ? 0 : value + 1;
+	}
+	if(kind == PARAM_SEQ_PART_DIV) {
+		value = song_get_part_div(seq, n);
+		return (value == SONG_PART_FOLLOW) ? 0 : value;
+	}
+	return param_get_note(seq, (kind == PARAM_SEQ_NOTE2), n);
+}
+
+// set a parameter value - returns 0 if there is no such param
+unsigned char param_set(unsigned int num, unsigned int value) {
+	const struct param_info *info = param_find(num);
+	unsigned char group = (num >> 7) & 0x7f;
+	unsigned char index = num & 0x7f;
+	unsigned char seq, n, kind;
+	if(info == NULL) return 0;
+	n = index - info->index;  // part, step or controller
+	if(value < info->min) value = info->min;
+	if(value > info->max) value = info->max;
+
+	if(group == PARAM_GROUP_SYSTEM) {
+		param_set_system(index, value);
+	}
+	else if(group == PARAM_GROUP_CC_TARGET) {
+		sysconfig_set_cc_map(n, value, sysconfig_get_cc_channel(n));
+	}
+	else if(group == PARAM_GROUP_CC_CHAN) {
+		sysconfig_set_cc_map(n, sysconfig_get_cc_target(n), value);
+	}
+	else if(group == PARAM_GROUP_CC_MIN) {
+		sysconfig_set_cc_range(n, value, sysconfig_get_cc_max(n), sysconfig_get_cc_curve(n));
+	}
+	else if(group == PARAM_GROUP_CC_MAX) {
+		sysconfig_set_cc_range(n, sysconfig_get_cc_min(n), value, sysconfig_get_cc_curve(n));
+	}
+	else if(group == PARAM_GROUP_CC_CURVE) {
+		sysconfig_set_cc_range(n, sysconfig_get_cc_min(n), sysconfig_get_cc_max(n), value);
+	}
+	// note pages
+	else if(group >= PARAM_GROUP_NOTES) {
+		seq = (group - PARAM_GROUP_NOTES) >> 2;
+		param_set_note(seq, n >> 4, (((group - PARAM_GROUP_NOTES) & 0x03) << 4) | (n & 0x0f),
+			value);
+	}
+	// step lanes - at the lane step
+	else if(group >= PARAM_GROUP_PART && info->index == PARAM_PART_LANE) {
+		song_set_lane(group - PARAM_GROUP_PART, n / SONG_NUM_LANE_TYPES,
+			n % SONG_NUM_LANE_TYPES, param_lane_step, value);
+	}
+	// sequence params - MIDI only parts work like parts 1 and 2
+	else {
+		if(group >= PARAM_GROUP_PART) {
+			seq = group - PARAM_GROUP_PART;
+			kind = part_kinds[info - part_params];
+			n += SONG_NUM_CV_PARTS;
+		}
+		else {
+			seq = group - PARAM_GROUP_SEQ;
+			kind = info->index;
+		}
+		if(kind == PARAM_SEQ_START) song_set_seq_start(seq, value);
+		else if(kind == PARAM_SEQ_LEN) song_set_seq_len(seq, value);
+		else if(kind == PARAM_SEQ_DIR) song_set_seq_dir(seq, value);
+		else if(kind == PARAM_SEQ_LOOP) song_set_seq_loop(seq, value);
+		else if(kind == PARAM_SEQ_NEXT) song_set_seq_next(seq, value);
+		else if(kind == PARAM_SEQ_STEPS) song_set_seq_pages(seq, value);
+		else if(kind == PARAM_SEQ_GATE) song_set_gate(seq, n, value);
+		else if(kind == PARAM_SEQ_SCALE) song_set_scale(seq, n, value);
+		else if(kind == PARAM_SEQ_SPAN) song_set_span(seq, n, value);
+		else if(kind == PARAM_SEQ_OFFSET) song_set_offset(seq, n, (char)value - 12);
+		else if(kind == PARAM_SEQ_STEP_LEN) song_set_step_len(seq, n, value);
+		else if(kind == PARAM_SEQ_STEP_LEN_EXT) {
+			song_set_step_len(seq, n + SONG_PAGE_STEPS, value);
+		}
+		else if(kind == PARAM_SEQ_PART_START) {
+			song_set_part_start(seq, n, value ? (value - 1) : SONG_PART_FOLLOW);
+		}
+		else if(kind == PARAM_SEQ_PART_LEN) {
+			song_set_part_len(seq, n, value ? value : SONG_PART_FOLLOW);
+		}
+		else if(kind == PARAM_SEQ_PART_DIR) {
+			song_set_part_dir(seq, n, value ? (value - 1) : SONG_PART_FOLLOW);
+		}
+		else if(kind == PARAM_SEQ_PART_DIV) {
+			song_set_part_div(seq, n, value ? value : SONG_PART_FOLLOW);
+		}
+		else param_set_note(seq, (kind == PARAM_SEQ_NOTE2), n, value);
+	}
+
+	// refresh things once the burst is over
+	param_pending = 1;
+	param_idle = 0;
+	return 1;
+}
+
+// get the scope of a param - returns 255 if there is no such param
+unsigned char param_get_scope(unsigned int num) {
+	const struct param_info *info = param_find(num);
+	if(info == NULL) return 255;
+	return info->scope;
+}
+
+// get the highest value of a param
+unsigned int param_get_max(unsigned int num) {
+	const struct param_info *info = param_find(num);
+	if(info == NULL) return 0;
+	return info->max;
+}
+
+// handle NRPN controllers on the param channel - returns 1 if used
+unsigned char param_nrpn(unsigned char controller, unsigned char value) {
+	int val;
+	// select a param
+	if(controller == 99) {
+		nrpn_num = (value << 7) | (nrpn_num & 0x7f);
+		nrpn_rpn = 0;
+		return 1;
+	}
+	if(controller == 98) {
+		nrpn_num = (nrpn_num & 0x3f80) | value;
+		nrpn_rpn = 0;
+		return 1;
+	}
+	// RPNs are selected so that their data entry is not taken as ours
+	if(controller == 101 || controller == 100) {
+		nrpn_rpn = 1;
+		return 1;
+	}
+	if(controller != 6 && controller != 38 && controller != 96 && controller != 97) return 0;
+	if(nrpn_rpn) return 1;
+	if(nrpn_num == NRPN_NONE) return 0;
+
+	// data entry
+	if(controller == 6) {
+		nrpn_msb = value;
+		if(param_get_max(nrpn_num) > 127) param_set(nrpn_num, value << 7);
+		else param_set(nrpn_num, value);
+	}
+	else if(controller == 38) {
+		if(param_get_max(nrpn_num) > 127) param_set(nrpn_num, (nrpn_msb << 7) | value);
+	}
+	// increment / decrement
+	else {
+		val = param_get(nrpn_num);
+		if(val < 0) return 1;
+		if(controller == 96) param_set(nrpn_num, val + 1);
+		else if(val > 0) param_set(nrpn_num, val - 1);
+	}
+	return 1;
+}
+
+// start receiving a parameter command
+void param_rx_start(unsigned char cmd) {
+	param_rx_cmd = cmd;
+	param_rx_count = 0;
+}
+
+// receive a parameter command byte
+void param_rx_data(unsigned char data_byte) {
+	if(param_rx_cmd == 0 || param_rx_count > 3) return;
+	param_rx_buf[param_rx_count] = data_byte;
+	param_rx_count ++;
+	// set each param as soon as its value is in
+	if(param_rx_cmd == PARAM_CMD_SET && param_rx_count == 4) {
+		param_set((param_rx_buf[0] << 7) | param_rx_buf[1], (param_rx_buf[2] << 7) | param_rx_buf[3]);
+		param_rx_count = 0;
+	}
+}
+
+// end of a parameter command
+void param_rx_end(void) {
+	if(param_rx_cmd == PARAM_CMD_SET) {
+		if(param_pending) param_flush();
+	}
+	else if(param_rx_cmd == PARAM_CMD_GET && param_rx_count == 3) {
+		param_send_values((param_rx_buf[0] << 7) | param_rx_buf[1], param_rx_buf[2]);
+	}
+	param_rx_cmd = 0;
+}
+
+//
+// local functions
+//
+// find the registry entry of a param
+const struct param_info *param_find(unsigned int num) {
+	unsigned char group = (num >> 7) & 0x7f;
+	unsigned char index = num & 0x7f;
+	const struct param_info *info;
+	int i, count;
+
+	if(group == PARAM_GROUP_SYSTEM) {
+		info = sys_params;
+		count = PARAM_NUM_SYS;
+	}
+	else if(group >= PARAM_GROUP_SEQ && group < (PARAM_GROUP_SEQ + SONG_NUM_SEQ)) {
+		info = seq_params;
+		count = PARAM_NUM_SEQ;
+	}
+	else if(group >= PARAM_GROUP_CC_TARGET && group <= PARAM_GROUP_CC_CURVE) {
+		info = &cc_params[group - PARAM_GROUP_CC_TARGET];
+		count = 1;
+	}
+	else if(group >= PARAM_GROUP_PART && group < (PARAM_GROUP_PART + SONG_NUM_SEQ)) {
+		info = part_params;
+		count = PARAM_NUM_PART;
+	}
+	else if(group >= PARAM_GROUP_NOTES) {
+		info = note_params;
+		count = 1;
+	}
+	else return NULL;
+
+	for(i = 0; i < count; i ++) {
+		if(index >= info[i].index && index < (info[i].index + info[i].count)) {
+			return &info[i];
+		}
+	}
+	return NULL;
+}
+
+// get a system param
+int param_get_system(unsigned char index) {
+	if(index == PARAM_SYS_CLOCK_DIV) return sysconfig_get_clock_div();
+	if(index == PARAM_SYS_MOD1_ASSIGN) return sysconfig_get_mod_assign(0);
+	if(index == PARAM_SYS_MOD2_ASSIGN) return sysconfig_get_mod_assign(1);
+	if(index == PARAM_SYS_LIVE_AUD) return sysconfig_get_live_aud();
+	if(index == PARAM_SYS_MIDI_PT1_CHAN) return sysconfig_get_midi_channel(0);
+	if(index == PARAM_SYS_MIDI_PT2_CHAN) return sysconfig_get_midi_channel(1);
+	if(index == PARAM_SYS_KEY_TRANSPOSE) return sysconfig_get_key_transpose();
+	if(index == PARAM_SYS_KEY_TRIGGER) return sysconfig_get_key_trigger();
+	if(index == PARAM_SYS_LCD_CONTRAST) return sysconfig_get_lcd_contrast();
+	if(index == PARAM_SYS_CLOCK_SPEED) return sysconfig_get_clock_speed();
+	if(index == PARAM_SYS_RESET_MODE) return sysconfig_get_reset_mode();
+	if(index == PARAM_SYS_CURRENT_SONG) return sysconfig_get_current_song();
+	if(index == PARAM_SYS_KEY_MAP) return sysconfig_get_key_map();
+	if(index == PARAM_SYS_REC_MODE) return sysconfig_get_rec_mode();
+	if(index == PARAM_SYS_ARP1_MODE) return sysconfig_get_arp_mode(0);
+	if(index == PARAM_SYS_ARP2_MODE) return sysconfig_get_arp_mode(1);
+	if(index == PARAM_SYS_ARP1_OCTAVES) return sysconfig_get_arp_octaves(0);
+	if(index == PARAM_SYS_ARP2_OCTAVES) return sysconfig_get_arp_octaves(1);
+	if(index == PARAM_SYS_LANE_CC) return sysconfig_get_lane_cc(0);
+	if(index == PARAM_SYS_LANE_CC + 1) return sysconfig_get_lane_cc(1);
+	if(index == PARAM_SYS_ACCENT_GATE) return sysconfig_get_accent_gate();
+	if(index == PARAM_SYS_RAND_SEED) return sysconfig_get_rand_seed();
+	if(index == PARAM_SYS_LAUNCH_MODE) return sysconfig_get_launch_mode();
+	if(index == PARAM_SYS_SWITCH_MODE) return sysconfig_get_switch_mode();
+	if(index == PARAM_SYS_LAUNCH_BAR) return sysconfig_get_launch_bar();
+	if(index == PARAM_SYS_PARAM_CHAN) return sysconfig_get_param_channel();
+	if(index == PARAM_SYS_LANE_STEP) return param_lane_step;
+	if(index >= PARAM_SYS_MIDI_TRACK_CHAN) {
+		return sysconfig_get_midi_channel(index - PARAM_SYS_MIDI_TRACK_CHAN +
+			SONG_NUM_CV_PARTS);
+	}
+	return -1;
+}
+
+// set a system param
+void param_set_system(unsigned char index, unsigned char value) {
+	if(index == PARAM_SYS_CLOCK_DIV) sysconfig_set_clock_div(value);
+	else if(index == PARAM_SYS_MOD1_ASSIGN) sysconfig_set_mod_assign(0, value);
+	else if(index == PARAM_SYS_MOD2_ASSIGN) sysconfig_set_mod_assign(1, value);
+	else if(index == PARAM_SYS_LIVE_AUD) sysconfig_set_live_aud(value);
+	else if(index == PARAM_SYS_MIDI_PT1_CHAN) sysconfig_set_midi_channel(0, value);
+	else if(index == PARAM_SYS_MIDI_PT2_CHAN) sysconfig_set_midi_channel(1, value);
+	else if(index == PARAM_SYS_KEY_TRANSPOSE) sysconfig_set_key_transpose(value);
+	else if(index == PARAM_SYS_KEY_TRIGGER) sysconfig_set_key_trigger(value);
+	else if(index == PARAM_SYS_LCD_CONTRAST) sysconfig_set_lcd_contrast(value);
+	else if(index == PARAM_SYS_CLOCK_SPEED) sysconfig_set_clock_speed(value);
+	else if(index == PARAM_SYS_RESET_MODE) sysconfig_set_reset_mode(value);
+	else if(index == PARAM_SYS_CURRENT_SONG) song_file_load(value);
+	else if(index == PARAM_SYS_KEY_MAP) sysconfig_set_key_map(value);
+	else if(index == PARAM_SYS_REC_MODE) sysconfig_set_rec_mode(value);
+	else if(index == PARAM_SYS_ARP1_MODE) sysconfig_set_arp_mode(0, value);
+	else if(index == PARAM_SYS_ARP2_MODE) sysconfig_set_arp_mode(1, value);
+	else if(index == PARAM_SYS_ARP1_OCTAVES) sysconfig_set_arp_octaves(0, value);
+	else if(index == PARAM_SYS_ARP2_OCTAVES) sysconfig_set_arp_octaves(1, value);
+	else if(index == PARAM_SYS_LANE_CC) sysconfig_set_lane_cc(0, value);
+	else if(index == PARAM_SYS_LANE_CC + 1) sysconfig_set_lane_cc(1, value);
+	else if(index == PARAM_SYS_ACCENT_GATE) sysconfig_set_accent_gate(value);
+	else if(index == PARAM_SYS_RAND_SEED) sysconfig_set_rand_seed(value);
+	else if(index == PARAM_SYS_LAUNCH_MODE) sysconfig_set_launch_mode(value);
+	else if(index == PARAM_SYS_SWITCH_MODE) sysconfig_set_switch_mode(value);
+	else if(index == PARAM_SYS_LAUNCH_BAR) sysconfig_set_launch_bar(value);
+	else if(index == PARAM_SYS_PARAM_CHAN) sysconfig_set_param_channel(value);
+	else if(index == PARAM_SYS_LANE_STEP) param_lane_step = value;
+	else if(index >= PARAM_SYS_MIDI_TRACK_CHAN) {
+		sysconfig_set_midi_channel(index - PARAM_SYS_MIDI_TRACK_CHAN +
+			SONG_NUM_CV_PARTS, value);
+	}
+}
+
+// get a note - the extended note types are moved down into 7 bits
+int param_get_note(unsigned char seq, unsigned char part, unsigned char step) {
+	unsigned char note = song_get_note(seq, part, step);
+	if(note > 127) return note - 128;
+	return note;
+}
+
+// set a note
+void param_set_note(unsigned char seq, unsigned char part, unsigned char step,
+		unsigned char value) {
+	if(value > 124) value += 128;  // extended note types
+	song_set_note(seq, part, step, value);
+}
+
+// refresh things that depend on params after a burst of changes
+void param_flush(void) {
+	param_pending = 0;
+	param_idle = 0;
+	gui_params_updated();
+}
+
+// send a VALUES message
+void param_send_values(unsigned int num, unsigned char count) {
+	int i, val;
+	if(count > PARAM_GET_MAX) count = PARAM_GET_MAX;
+	_midi_tx_sysex_start();
+	_midi_tx_sysex_data(0x00);
+	_midi_tx_sysex_data(0x01);
+	_midi_tx_sysex_data(0x72);
+	_midi_tx_sysex_data(midi_get_device_type());
+	_midi_tx_sysex_data(PARAM_CMD_VALUES);
+	_midi_tx_sysex_data((num >> 7) & 0x7f);
+	_midi_tx_sysex_data(num & 0x7f);
+	_midi_tx_sysex_data(count);
+	for(i = 0; i < count; i ++) {
+		val = param_get((num + i) & 0x3fff);
+		if(val < 0) val = PARAM_NO_VALUE;
+		_midi_tx_sysex_data((val >> 7) & 0x7f);
+		_midi_tx_sysex_data(val & 0x7f);
+	}
+	_midi_tx_sysex_end();
+}
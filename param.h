@@ -0,0 +1,126 @@
+/*
+ * K2579 Step Sequencer - Parameter Access
+ *
+ * Copyright 2011: Kilpatrick Audio
+ * Written by: Andrew Kilpatrick
+ *
+ */
+// parameter numbers - the same as the NRPN number: group (MSB), index (LSB)
+#define PARAM_NUM(group, index) ((((group) & 0x7f) << 7) | ((index) & 0x7f))
+
+// parameter groups
+#define PARAM_GROUP_SYSTEM 0
+#define PARAM_GROUP_SEQ 1  // 1-16 = sequence 1-16
+#define PARAM_GROUP_CC_TARGET 32  // index is the controller
+#define PARAM_GROUP_CC_CHAN 33
+#define PARAM_GROUP_CC_MIN 34
+#define PARAM_GROUP_CC_MAX 35
+#define PARAM_GROUP_CC_CURVE 36
+#define PARAM_GROUP_PART 40  // 40-55 = sequence 1-16 - the MIDI only parts and step lanes
+#define PARAM_GROUP_NOTES 64  // 64-127 = 4 step pages of sequence 1-16
+#define PARAM_NOTES_GROUP(seq, page) (PARAM_GROUP_NOTES + ((seq) << 2) + (page))
+#define PARAM_NOTES_INDEX(part, step) (((part) << 4) | ((step) & 0x0f))
+
+// system parameters
+#define PARAM_SYS_CLOCK_DIV 0
+#define PARAM_SYS_MOD1_ASSIGN 1
+#define PARAM_SYS_MOD2_ASSIGN 2
+#define PARAM_SYS_LIVE_AUD 3
+#define PARAM_SYS_MIDI_PT1_CHAN 4
+#define PARAM_SYS_MIDI_PT2_CHAN 5
+#define PARAM_SYS_KEY_TRANSPOSE 6
+#define PARAM_SYS_KEY_TRIGGER 7
+#define PARAM_SYS_LCD_CONTRAST 8
+#define PARAM_SYS_CLOCK_SPEED 9
+#define PARAM_SYS_RESET_MODE 10
+#define PARAM_SYS_CURRENT_SONG 11  // setting this loads the song
+#define PARAM_SYS_KEY_MAP 12
+#define PARAM_SYS_REC_MODE 13
+#define PARAM_SYS_ARP1_MODE 14
+#define PARAM_SYS_ARP2_MODE 15
+#define PARAM_SYS_ARP1_OCTAVES 16
+#define PARAM_SYS_ARP2_OCTAVES 17
+#define PARAM_SYS_MIDI_TRACK_CHAN 18  // parts 3 and up - one index per part
+#define PARAM_SYS_LANE_CC 24  // 2 lanes - controller 0-119
+#define PARAM_SYS_ACCENT_GATE 26
+#define PARAM_SYS_RAND_SEED 27
+#define PARAM_SYS_LAUNCH_MODE 28
+#define PARAM_SYS_SWITCH_MODE 29
+#define PARAM_SYS_LAUNCH_BAR 30
+#define PARAM_SYS_PARAM_CHAN 31  // 0-15, 16 = off
+#define PARAM_SYS_LANE_STEP 32  // 0-63 - the step the lane params edit - not stored
+
+// sequence parameters - the first index of each
+#define PARAM_SEQ_START 0
+#define PARAM_SEQ_LEN 1
+#define PARAM_SEQ_DIR 2
+#define PARAM_SEQ_LOOP 3
+#define PARAM_SEQ_NEXT 4
+#define PARAM_SEQ_STEPS 5  // 1-4 = 16-64 steps - set this before the start and len
+#define PARAM_SEQ_GATE 8  // 2 parts
+#define PARAM_SEQ_SCALE 10  // 2 parts
+#define PARAM_SEQ_SPAN 12  // 2 parts
+#define PARAM_SEQ_OFFSET 14  // 2 parts - 0-24 = -12 to +12
+#define PARAM_SEQ_STEP_LEN 16  // steps 1-16
+#define PARAM_SEQ_NOTE1 32  // steps 1-16 - 0-48, 125 = rand, 126 = none, 127 = rest
+#define PARAM_SEQ_NOTE2 48  // steps 1-16
+#define PARAM_SEQ_PART_START 64  // 2 parts - 0 = follow, 1-64 = step 1-64
+#define PARAM_SEQ_PART_LEN 66  // 2 parts - 0 = follow, 1-64 = steps
+#define PARAM_SEQ_PART_DIR 68  // 2 parts - 0 = follow, 1-4 = dir 0-3
+#define PARAM_SEQ_PART_DIV 70  // 2 parts - 0 = follow, 1-24 = clocks per step
+#define PARAM_SEQ_STEP_LEN_EXT 72  // steps 17-64
+
+// MIDI only part parameters - the first index of each - parts 3-8
+#define PARAM_PART_GATE 0
+#define PARAM_PART_SCALE 6
+#define PARAM_PART_SPAN 12
+#define PARAM_PART_OFFSET 18  // 0-24 = -12 to +12
+#define PARAM_PART_START 24  // 0 = follow, 1-64 = step 1-64
+#define PARAM_PART_LEN 30  // 0 = follow, 1-64 = steps
+#define PARAM_PART_DIR 36  // 0 = follow, 1-4 = dir 0-3
+#define PARAM_PART_DIV 42  // 0 = follow, 1-24 = clocks per step
+#define PARAM_PART_LANE 64  // parts 1-8 - (part x 5) + SONG_LANE_ type - at the lane step
+
+// parameter scopes
+#define PARAM_SCOPE_SYSTEM 0  // one value
+#define PARAM_SCOPE_SEQ 1  // one value per sequence
+#define PARAM_SCOPE_PART 2  // one value per sequence part
+#define PARAM_SCOPE_STEP 3  // one value per sequence step
+#define PARAM_SCOPE_CC 4  // one value per controller
+
+// SysEx commands - after the F0 00 01 72 <dev type> header
+#define PARAM_CMD_SET 0x78  // [num MSB, num LSB, value MSB, value LSB] ...
+#define PARAM_CMD_GET 0x79  // num MSB, num LSB, count
+#define PARAM_CMD_VALUES 0x7a  // num MSB, num LSB, count, [value MSB, value LSB] ...
+#define PARAM_GET_MAX 32  // most values in a reply
+#define PARAM_NO_VALUE 0x3fff  // reply value for a missing param
+
+// initialize the parameter handler
+void param_init(void);
+
+// run the parameter task - call every 16ms
+void param_task(void);
+
+// get a parameter value - returns -1 if there is no such param
+int param_get(unsigned int num);
+
+// set a parameter value - returns 0 if there is no such param
+unsigned char param_set(unsigned int num, unsigned int value);
+
+// get the scope of a param - returns 255 if there is no such param
+unsigned char param_get_scope(unsigned int num);
+
+// get the highest value of a param
+unsigned int param_get_max(unsigned int num);
+
+// handle NRPN controllers on the param channel - returns 1 if used
+unsigned char param_nrpn(unsigned char controller, unsigned char value);
+
+// start receiving a parameter command
+void param_rx_start(unsigned char cmd);
+
+// receive a parameter command byte
+void param_rx_data(unsigned char data_byte);
+
+// end of a parameter command
+void param_rx_end(void);
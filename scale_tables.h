@@ -1,198 +1,198 @@
-/*
- * Carbon - Scale Processing
- *
- * Copyright 2015: Kilpatrick Audio
- * Written by: Andrew Kilpatrick
- *
- */
-#define SCALE_LEN_MAJOR 29
-#define SCALE_LEN_HAR_MINOR 29
-#define SCALE_LEN_NAT_MINOR 29
-#define SCALE_LEN_WHOLE 25
-#define SCALE_LEN_PENT 21
-#define SCALE_LEN_DIM 32
-
-unsigned char scale_major[] = {
-0	,
-2	,
-4	,
-5	,
-7	,
-9	,
-11	,
-12	,
-14	,
-16	,
-17	,
-19	,
-21	,
-23	,
-24	,
-26	,
-28	,
-29	,
-31	,
-33	,
-35	,
-36	,
-38	,
-40	,
-41	,
-43	,
-45	,
-47	,
-48
-};
-
-unsigned char scale_har_minor[] = {
-0	,
-2	,
-3	,
-5	,
-7	,
-8	,
-11	,
-12	,
-14	,
-15	,
-17	,
-19	,
-20	,
-23	,
-24	,
-26	,
-27	,
-29	,
-31	,
-32	,
-35	,
-36	,
-38	,
-39	,
-41	,
-43	,
-44	,
-47	,
-48
-};
-
-unsigned char scale_nat_minor[] = {
-0	,
-2	,
-3	,
-5	,
-7	,
-8	,
-10	,
-12	,
-14	,
-15	,
-17	,
-19	,
-20	,
-22	,
-24	,
-26	,
-27	,
-29	,
-31	,
-32	,
-34	,
-36	,
-38	,
-39	,
-41	,
-43	,
-44	,
-46	,
-48
-};
-
-unsigned char scale_whole[] = {
-0	,
-2	,
-4	,
-6	,
-8	,
-10	,
-12	,
-14	,
-16	,
-18	,
-20	,
-22	,
-24	,
-26	,
-28	,
-30	,
-32	,
-34	,
-36	,
-38	,
-40	,
-42	,
-44	,
-46	,
-48
-};
-
-unsigned char scale_pent[] = {
-0	,
-2	,
-4	,
-7	,
-9	,
-12	,
-14	,
-16	,
-19	,
-21	,
-24	,
-26	,
-28	,
-31	,
-33	,
-36	,
-38	,
-40	,
-43	,
-45	,
-48
-};
-
-unsigned char scale_dim[] = {
-0	,
-2	,
-3	,
-5	,
-6	,
-8	,
-9	,
-11	,
-12	,
-14	,
-15	,
-17	,
-18	,
-20	,
-21	,
-23	,
-24	,
-26	,
-27	,
-29	,
-30	,
-32	,
-33	,
-35	,
-36	,
-38	,
-39	,
-41	,
-42	,
-44	,
-45	,
-47
-};
-
-
+/*
+ * Carbon - Scale Processing
+ *
+ * Copyright 2015: Kilpatrick Audio
+ * Written by: Andrew Kilpatrick
+ *
+ */
+#define SCALE_LEN_MAJOR 29
+#define SCALE_LEN_HAR_MINOR 29
+#define SCALE_LEN_NAT_MINOR 29
+#define SCALE_LEN_WHOLE 25
+#define SCALE_LEN_PENT 21
+#define SCALE_LEN_DIM 32
+
+unsigned char scale_major[] = {
+0	,
+2	,
+4	,
+5	,
+7	,
+9	,
+11	,
+12	,
+14	,
+16	,
+17	,
+19	,
+21	,
+23	,
+24	,
+26	,
+28	,
+29	,
+31	,
+33	,
+35	,
+36	,
+38	,
+40	,
+41	,
+43	,
+45	,
+47	,
+48
+};
+
+unsigned char scale_har_minor[] = {
+0	,
+2	,
+3	,
+5	,
+7	,
+8	,
+11	,
+12	,
+14	,
+15	,
+17	,
+19	,
+20	,
+23	,
+24	,
+26	,
+27	,
+29	,
+31	,
+32	,
+35	,
+36	,
+38	,
+39	,
+41	,
+43	,
+44	,
+47	,
+48
+};
+
+unsigned char scale_nat_minor[] = {
+0	,
+2	,
+3	,
+5	,
+7	,
+8	,
+10	,
+12	,
+14	,
+15	,
+17	,
+19	,
+20	,
+22	,
+24	,
+26	,
+27	,
+29	,
+31	,
+32	,
+34	,
+36	,
+38	,
+39	,
+41	,
+43	,
+44	,
+46	,
+48
+};
+
+unsigned char scale_whole[] = {
+0	,
+2	,
+4	,
+6	,
+8	,
+10	,
+12	,
+14	,
+16	,
+18	,
+20	,
+22	,
+24	,
+26	,
+28	,
+30	,
+32	,
+34	,
+36	,
+38	,
+40	,
+42	,
+44	,
+46	,
+48
+};
+
+unsigned char scale_pent[] = {
+0	,
+2	,
+4	,
+7	,
+9	,
+12	,
+14	,
+16	,
+19	,
+21	,
+24	,
+26	,
+28	,
+31	,
+33	,
+36	,
+38	,
+40	,
+43	,
+45	,
+48
+};
+
+unsigned char scale_dim[] = {
+0	,
+2	,
+3	,
+5	,
+6	,
+8	,
+9	,
+11	,
+12	,
+14	,
+15	,
+17	,
+18	,
+20	,
+21	,
+23	,
+24	,
+26	,
+27	,
+29	,
+30	,
+32	,
+33	,
+35	,
+36	,
+38	,
+39	,
+41	,
+42	,
+44	,
+45	,
+47
+};
+
+
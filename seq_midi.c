@@ -1,439 +1,614 @@
-/*
- * K2579 Step Sequencer - Sequencer MIDI Handler
- *
- * Copyright 2011: Kilpatrick Audio
- * Written by: Andrew Kilpatrick
- *
- */
-#include "seq_midi.h"
-#include "midi_callbacks.h"
-#include "midi.h"
-#include "sequencer.h"
-#include "song.h"
-#include "clock.h"
-#include "eeprom.h"
-#include "sysconfig.h"
-#include "song_file.h"
-#include "screen_handler.h"
-#include "TimeDelay.h"
-#include "lcd.h"
-
-// device restart
-#define BOOTLOADER_ADDR 0x9FC00000
-
-// debugging / programming via SYSEX
-#define CMD_READ_EEPROM 0x70
-#define CMD_WRITE_EEPROM 0x71
-#define CMD_READBACK_EEPROM 0x72
-
-// channels
-unsigned char pt1_chan;
-unsigned char pt2_chan;
-
-// note state
-char last_trigger_key;
-
-// SYSEX receive handling
-unsigned char sysex_rx_buf[256];
-unsigned char sysex_rx_count;
-
-// initialize the MIDI handler
-void seq_midi_init(void) {
-	pt1_chan = 0;  // channel 1
-	pt2_chan = 1;  // channel 2
-	sysex_rx_count = 0;
-	last_trigger_key = 255;
-}
-
-// get the MIDI channel for a part
-unsigned char seq_midi_get_channel(unsigned char part) {
-	if(part > 1) return 0;
-	if(part == 1) return pt2_chan;
-	return pt1_chan;
-}
-
-// set the MIDI channel for a part
-void seq_midi_set_channel(unsigned char part, unsigned char channel) {
-	if(part > 1) return;
-	if(part == 1) pt2_chan = channel;
-	else pt1_chan = channel;
-}
-
-//
-// SETUP MESSAGES
-//
-// learn the MIDI channel
-void _midi_learn_channel(unsigned char channel) {
-  // not used
-}
-
-//
-// CHANNEL MESSAGES
-//
-// note off - note on with velocity = 0 calls this
-void _midi_rx_note_off(unsigned char channel, 
-		unsigned char note) {
-	unsigned char map;
-	unsigned char trigger;
-	// our channels
-	if(channel == pt1_chan || channel == pt2_chan) {
-		map = sysconfig_get_key_map();
-		trigger = sysconfig_get_key_trigger();
-
-		// handle key map swapping
-		if(sequencer_get_control_override(SYSCONFIG_MOD_KEY_MAP) == 1) {
-			if(map == SYSCONFIG_KEY_MAP_B) map = SYSCONFIG_KEY_MAP_A;
-			else map = SYSCONFIG_KEY_MAP_B;
-		}
-
-		// key map B
-		if(map == SYSCONFIG_KEY_MAP_B) {
-			// key trigger sequence
-			if(note > 47 && note < 64) {
-				if(trigger == SYSCONFIG_KEY_TRIGGER_MOM &&
-						last_trigger_key == (note - 48)) {
-					clock_stop_command();
-					last_trigger_key = 255;
-				}
-			}
-		}
-		// key map A
-		else {
-			// key trigger sequence
-			if(note > 23 && note < 40) {
-				if(trigger == SYSCONFIG_KEY_TRIGGER_MOM &&
-						last_trigger_key == (note - 24)) {
-					clock_stop_command();
-					last_trigger_key = 255;
-				}
-			}
-		}
-	}
-}
-
-// note on - note on with velocity > 0 calls this
-void _midi_rx_note_on(unsigned char channel, 
-		unsigned char note, 
-		unsigned char velocity) {
-	unsigned char map;
-
-	// our channels
-	if(channel == pt1_chan || channel == pt2_chan) {
-		map = sysconfig_get_key_map();
-		// handle key map swapping
-		if(sequencer_get_control_override(SYSCONFIG_MOD_KEY_MAP) == 1) {
-			if(map == SYSCONFIG_KEY_MAP_B) map = SYSCONFIG_KEY_MAP_A;
-			else map = SYSCONFIG_KEY_MAP_B;
-		}
-
-		// key map B
-		if(map == SYSCONFIG_KEY_MAP_B) {
-			// key transpose
-			if(note > 23 && note < 48) {
-				sequencer_key_transpose(note - 36);
-			}
-			// key trigger sequence
-			else if(note > 47 && note < 64) {
-				last_trigger_key = note - 48;
-				sequencer_key_trigger(last_trigger_key);
-			}
-			// key start
-			else if(note == 65) {
-				clock_run_command();
-			}
-			// key stop
-			else if(note == 67) {
-				clock_stop_command();
-			}
-			// key reset
-			else if(note == 69) {
-				clock_reset_input();
-			}
-			// key control restore
-			else if(note == 71) {
-				sequencer_control_restore();
-			}
-		}
-		// key map A
-		else {
-			// key trigger sequence
-			if(note > 23 && note < 40) {
-				last_trigger_key = note - 24;
-				sequencer_key_trigger(last_trigger_key);
-			}
-			// key start
-			else if(note == 41) {
-				clock_run_command();
-			}
-			// key stop
-			else if(note == 43) {
-				clock_stop_command();
-			}
-			// key reset
-			else if(note == 45) {
-				clock_reset_input();
-			}
-			// key control restore
-			else if(note == 47) {
-				sequencer_control_restore();
-			}
-			// key transpose
-			else if(note > 47 && note < 73) {
-				sequencer_key_transpose(note - 60);
-			}
-		}
-	}
-}
-
-// key pressure
-void _midi_rx_key_pressure(unsigned char channel, 
-		unsigned char note,
-		unsigned char pressure) {
-	// echo our channels
-	if(channel == pt1_chan || channel == pt2_chan) {
-		_midi_tx_key_pressure(channel, note, pressure);
-	}
-}
-
-// control change
-void _midi_rx_control_change(unsigned char channel,
-		unsigned char controller,
-		unsigned char value) {
-	// respond on both channels the same
-	if(channel == pt1_chan || channel == pt2_chan) {
-		// controller 1 = key map swap
-		if(controller == 1) {
-			sequencer_control_change(SYSCONFIG_MOD_KEY_MAP, value);
-		}
-		// controllers 20-25 = mod 1-6
-		else if(controller > 19 && controller < 26) {
-			sequencer_control_change(controller - 19, value);
-		}
-		// controller 31 = control restore
-		else if(controller == 31 && value > 63) {
-			sequencer_control_restore();
-		}
-		// controller 64 = mod 7
-		else if(controller == 64) {
-			sequencer_control_change(SYSCONFIG_MOD_SEQ_DIR, value);			
-		}
-		// echo others
-		else if(controller < 120) {
-			_midi_tx_control_change(channel, controller, value);
-		}
-	}
-}
-
-// channel mode - all sounds off
-void _midi_rx_all_sounds_off(unsigned char channel) {
-	// XXX reset the system
-}
-
-// channel mode - reset all controllers
-void _midi_rx_reset_all_controllers(unsigned char channel) {
-	// XXX reset the system
-}
-
-// channel mode - local control
-void _midi_rx_local_control(unsigned char channel, unsigned char value) {
-	// not supported
-}
-
-// channel mode - all notes off
-void _midi_rx_all_notes_off(unsigned char channel) {
-	// XXX reset the system
-}
-
-// channel mode - omni off
-void _midi_rx_omni_off(unsigned char channel) {
-	// not supported
-}
-
-// channel mode - omni on
-void _midi_rx_omni_on(unsigned char channel) {
-	// not supported
-}
-
-// channel mode - mono on
-void _midi_rx_mono_on(unsigned char channel) {
-	// not supported
-}
-
-// channel mode - poly on
-void _midi_rx_poly_on(unsigned char channel) {
-	// not supported
-}
-
-// program change
-void _midi_rx_program_change(unsigned char channel,
-		unsigned char program) {
-	// echo our channels
-	if(channel == pt1_chan || channel == pt2_chan) {
-		_midi_tx_program_change(channel, program);
-	}
-}
-
-// channel pressure
-void _midi_rx_channel_pressure(unsigned char channel,
-		unsigned char pressure) {
-	// echo our channels
-	if(channel == pt1_chan || channel == pt2_chan) {
-		_midi_tx_channel_pressure(channel, pressure);
-	}
-}
-
-// pitch bend
-void _midi_rx_pitch_bend(unsigned char channel,
-		unsigned int bend) {
-	// echo our channels
-	if(channel == pt1_chan || channel == pt2_chan) {
-		_midi_tx_pitch_bend(channel, bend);
-	}
-}
-
-//
-// SYSTEM COMMON MESSAGES
-//
-// song position
-void _midi_rx_song_position(unsigned int pos) {
-	sequencer_midi_song_pos(pos);
-}
-
-// song select
-void _midi_rx_song_select(unsigned char song) {
-	if(song > 7) return;
-	song_file_load(song);
-}
-
-//
-// SYSEX MESSAGES
-//
-// sysex message start
-void _midi_rx_sysex_start(void) {
-	sysex_rx_count = 0;
-}
-
-// sysex message data byte
-void _midi_rx_sysex_data(unsigned char data_byte) {
-	sysex_rx_buf[sysex_rx_count] = data_byte;
-	sysex_rx_count ++;
-}
-
-// sysex message received
-void _midi_rx_sysex_msg(unsigned char data[], unsigned char len) {
-	unsigned char cmd;
-	unsigned char dev_type = midi_get_device_type();
-	if(len < 4) return;
-	// parse header
-	if(data[0] != 0x00) return;  // look for
-	if(data[1] != 0x01) return;  // Kilpatrick Audio
-	if(data[2] != 0x72) return;  // SYSEX ID
-	cmd = data[3];
-	// K2579 commands 
-	if(len >=5 && cmd == dev_type) {
-		// read EEPROM data
-		if((data[4] == CMD_READ_EEPROM) && (len == 13)) {
-			int addr = ((data[5] & 0x0f) << 28) |
-				((data[6] & 0x0f) << 24) |
-				((data[7] & 0x0f) << 20) |
-				((data[8] & 0x0f) << 16) |
-				((data[9] & 0x0f) << 12) |
-				((data[10] & 0x0f) << 8) |
-				((data[11] & 0x0f) << 4) |
-				(data[12] & 0x0f);
-			unsigned char buf[32];
-			int i;
-			eeprom_read_page(addr, buf);
-			// respond
-			_midi_tx_sysex_start();
-			_midi_tx_sysex_data(0x00);
-			_midi_tx_sysex_data(0x01);
-			_midi_tx_sysex_data(0x72);
-			_midi_tx_sysex_data(dev_type);
-			_midi_tx_sysex_data(CMD_READBACK_EEPROM);
-			_midi_tx_sysex_data((addr >> 28) & 0x0f);
-			_midi_tx_sysex_data((addr >> 24) & 0x0f);
-			_midi_tx_sysex_data((addr >> 20) & 0x0f);
-			_midi_tx_sysex_data((addr >> 16) & 0x0f);
-			_midi_tx_sysex_data((addr >> 12) & 0x0f);
-			_midi_tx_sysex_data((addr >> 8) & 0x0f);
-			_midi_tx_sysex_data((addr >> 4) & 0x0f);
-			_midi_tx_sysex_data(addr & 0x0f);
-			for(i = 0; i < 32; i ++) {
-				_midi_tx_sysex_data((buf[i] >> 4) & 0x0f);
-				_midi_tx_sysex_data(buf[i] & 0x0f);
-			}
-			_midi_tx_sysex_end();
-		}
-		// write EEPROM data
-		else if(data[4] == CMD_WRITE_EEPROM && len == (13 + 64)) {
-			int addr = ((data[5] & 0x0f) << 28 |
-				(data[6] & 0x0f) << 24 |
-				(data[7] & 0x0f) << 20 |
-				(data[8] & 0x0f) << 16 |
-				(data[9] & 0x0f) << 12 |
-				(data[10] & 0x0f) << 8 |
-				(data[11] & 0x0f) << 4 |
-				(data[12] & 0x0f));
-			unsigned char buf[32];
-			int inCount = 0;
-			int i;
-			for(i = 0; i < 32; i ++) {
-				buf[i] = (data[13 + inCount] << 4) | (data[13 + inCount + 1] & 0x0f);
-				inCount += 2;
-			}
-			eeprom_write_page(addr, buf);
-		}
-	}
-}
-
-//
-// SYSTEM REALTIME MESSAGES
-//
-// timing tick
-void _midi_rx_timing_tick(void) {
-	clock_midi_tick();
-}
-
-// start song
-void _midi_rx_start_song(void) {
-	clock_midi_start();
-}
-
-// continue song
-void _midi_rx_continue_song(void) {
-	clock_midi_continue();
-}
-
-// stop song
-void _midi_rx_stop_song(void) {
-	clock_midi_stop();
-}
-
-// active sensing
-void _midi_rx_active_sensing(void) {
-	// not supported
-}
-
-// system reset
-void _midi_rx_system_reset(void) {
-	// XXX reset the system
-	_midi_tx_system_reset();
-}
-
-//
-// SPECIAL CALLBACKS
-//
-void _midi_restart_device(void) {
-	int i;
-	lcd_clear_screen();
-	screen_write_popup(1000, " ", "SYSEX RESTART");
-	screen_task();
-	for(i = 0; i < 64; i ++) {
-		lcd_task();
-	}
-	DelayMs(100);
-	void (*fptr)(void);
-	fptr = (void (*)(void))BOOTLOADER_ADDR;
-	fptr();
-}
+/*
+ * K2579 Step Sequencer - Sequencer MIDI Handler
+ *
+ * Copyright 2011: Kilpatrick Audio
+ * Written by: Andrew Kilpatrick
+ *
+ */
+#include <stdio.h>
+#include "seq_midi.h"
+#include "midi_callbacks.h"
+#include "midi.h"
+#include "sequencer.h"
+#include "song.h"
+#include "clock.h"
+#include "eeprom.h"
+#include "sysconfig.h"
+#include "song_file.h"
+#include "sysex_bulk.h"
+#include "param.h"
+#include "mtc.h"
+#include "arp.h"
+#include "screen_handler.h"
+#include "TimeDelay.h"
+#include "lcd.h"
+#include "gui.h"
+
+// device restart
+#define BOOTLOADER_ADDR 0x9FC00000
+
+// debugging / programming via SYSEX
+#define CMD_READ_EEPROM 0x70
+#define CMD_WRITE_EEPROM 0x71
+#define CMD_READBACK_EEPROM 0x72
+
+// song edit history - no data
+#define CMD_UNDO 0x7b
+#define CMD_REDO 0x7c
+
+// channels - the CV part channels are used for control
+unsigned char part_chan[SONG_NUM_PARTS];
+
+// note state
+char last_trigger_key;
+
+// CC learn
+unsigned char learn_target;
+unsigned char learned_cc;
+
+// local functions
+void seq_midi_eeprom_start(unsigned char cmd);
+void seq_midi_eeprom_data(unsigned char data_byte);
+void seq_midi_read_eeprom(void);
+void seq_midi_write_eeprom(void);
+void seq_midi_undo_start(unsigned char cmd);
+void seq_midi_undo_data(unsigned char data_byte);
+void seq_midi_undo_end(void);
+unsigned char seq_midi_arp_key(unsigned char channel, unsigned char note, unsigned char on);
+unsigned char seq_midi_is_ours(unsigned char channel);
+
+// SYSEX receive handling - commands are handled as the bytes arrive
+struct sysex_cmd {
+	unsigned char cmd;
+	void (*start)(unsigned char cmd);
+	void (*data)(unsigned char data_byte);
+	void (*end)(void);
+};
+const struct sysex_cmd sysex_cmds[] = {
+	{CMD_READ_EEPROM, seq_midi_eeprom_start, seq_midi_eeprom_data, seq_midi_read_eeprom},
+	{CMD_WRITE_EEPROM, seq_midi_eeprom_start, seq_midi_eeprom_data, seq_midi_write_eeprom},
+	{BULK_CMD_REQUEST, sysex_bulk_rx_start, sysex_bulk_rx_data, sysex_bulk_rx_end},
+	{BULK_CMD_HEADER, sysex_bulk_rx_start, sysex_bulk_rx_data, sysex_bulk_rx_end},
+	{BULK_CMD_DATA, sysex_bulk_rx_start, sysex_bulk_rx_data, sysex_bulk_rx_end},
+	{BULK_CMD_END, sysex_bulk_rx_start, sysex_bulk_rx_data, sysex_bulk_rx_end},
+	{BULK_CMD_ACK, sysex_bulk_rx_start, sysex_bulk_rx_data, sysex_bulk_rx_end},
+	{PARAM_CMD_SET, param_rx_start, param_rx_data, param_rx_end},
+	{PARAM_CMD_GET, param_rx_start, param_rx_data, param_rx_end},
+	{CMD_UNDO, seq_midi_undo_start, seq_midi_undo_data, seq_midi_undo_end},
+	{CMD_REDO, seq_midi_undo_start, seq_midi_undo_data, seq_midi_undo_end}
+};
+#define SYSEX_NUM_CMDS (sizeof(sysex_cmds) / sizeof(struct sysex_cmd))
+const struct sysex_cmd *sysex_rx_cmd;  // the command being received or NULL
+unsigned char sysex_rx_count;
+
+// undo / redo command being received
+unsigned char undo_rx_cmd;
+
+// EEPROM page access
+int eeprom_rx_addr;
+unsigned char eeprom_rx_buf[32];
+
+// initialize the MIDI handler
+void seq_midi_init(void) {
+	int i;
+	for(i = 0; i < SONG_NUM_PARTS; i ++) {
+		part_chan[i] = i;  // channel 1, 2, ...
+	}
+	sysex_rx_cmd = NULL;
+	sysex_rx_count = 0;
+	last_trigger_key = 255;
+	learn_target = SEQ_MIDI_LEARN_OFF;
+	learned_cc = 0;
+	seq_midi_update_thru();
+}
+
+// get the MIDI channel for a part
+unsigned char seq_midi_get_channel(unsigned char part) {
+	if(part > (SONG_NUM_PARTS - 1)) return 0;
+	return part_chan[part];
+}
+
+// set the MIDI channel for a part
+void seq_midi_set_channel(unsigned char part, unsigned char channel) {
+	if(part > (SONG_NUM_PARTS - 1)) return;
+	part_chan[part] = channel;
+	if(part < SONG_NUM_CV_PARTS) arp_clear(part);  // the keys were held on the old channel
+	seq_midi_update_thru();
+}
+
+// set up the MIDI thru filter for our channels and the CC map
+//
+// - notes and CCs on our channels (the CV part channels) are parsed
+// - CCs on channels used by the CC map and on the NRPN param channel are
+//   parsed, and all CCs while learning
+// - key pressure, program change, channel pressure and pitch bend on
+//   our channels are passed straight through without parsing
+// - notes on the MIDI only part channels are parsed while recording
+// - other channels are dropped
+//
+void seq_midi_update_thru(void) {
+	unsigned int chans = (1 << part_chan[0]) | (1 << part_chan[1]);
+	unsigned int cc_chans = chans | sysconfig_get_cc_channels();
+	unsigned int rec_chans = 0;
+	int i;
+	if(sysconfig_get_param_channel() != SYSCONFIG_PARAM_CHAN_OFF) {
+		cc_chans |= (1 << sysconfig_get_param_channel());
+	}
+	if(learn_target != SEQ_MIDI_LEARN_OFF) cc_chans = 0xffff;
+	// recorded notes are also passed so the player can hear them
+	if(sysconfig_get_key_map() == SYSCONFIG_KEY_MAP_REC) {
+		for(i = 0; i < SONG_NUM_PARTS; i ++) {
+			rec_chans |= (1 << part_chan[i]);
+		}
+		midi_set_thru_filter(MIDI_THRU_NOTE_OFF, rec_chans, rec_chans);
+		midi_set_thru_filter(MIDI_THRU_NOTE_ON, rec_chans, rec_chans);
+	}
+	else {
+		midi_set_thru_filter(MIDI_THRU_NOTE_OFF, 0, chans);
+		midi_set_thru_filter(MIDI_THRU_NOTE_ON, 0, chans);
+	}
+	midi_set_thru_filter(MIDI_THRU_KEY_PRESSURE, chans, 0);
+	midi_set_thru_filter(MIDI_THRU_CONTROL_CHANGE, 0, cc_chans);
+	midi_set_thru_filter(MIDI_THRU_PROG_CHANGE, chans, 0);
+	midi_set_thru_filter(MIDI_THRU_CHAN_PRESSURE, chans, 0);
+	midi_set_thru_filter(MIDI_THRU_PITCH_BEND, chans, 0);
+}
+
+// learn a CC for a CC map target - SEQ_MIDI_LEARN_OFF to cancel
+void seq_midi_learn_cc(unsigned char target) {
+	if(target > SYSCONFIG_CC_MAX_TARGET) target = SEQ_MIDI_LEARN_OFF;
+	learn_target = target;
+	midi_set_learn_mode(target != SEQ_MIDI_LEARN_OFF);
+	seq_midi_update_thru();
+}
+
+// get the CC map target being learned or SEQ_MIDI_LEARN_OFF
+unsigned char seq_midi_get_learn_cc(void) {
+	return learn_target;
+}
+
+// get the last CC learned
+unsigned char seq_midi_get_learned_cc(void) {
+	return learned_cc;
+}
+
+// check if a channel is one of our control channels
+unsigned char seq_midi_is_ours(unsigned char channel) {
+	return (channel == part_chan[0] || channel == part_chan[1]);
+}
+
+//
+// SETUP MESSAGES
+//
+// learn a controller for the CC map
+void _midi_learn_control(unsigned char channel, unsigned char controller) {
+	if(learn_target == SEQ_MIDI_LEARN_OFF) return;
+	// the part channels are stored as either part so they follow changes
+	if(seq_midi_is_ours(channel)) {
+		sysconfig_set_cc_map(controller, learn_target, SYSCONFIG_CC_CHAN_PARTS);
+	}
+	else {
+		sysconfig_set_cc_map(controller, learn_target, channel);
+	}
+	learned_cc = controller;
+	learn_target = SEQ_MIDI_LEARN_OFF;
+	seq_midi_update_thru();
+	gui_cc_learned();
+}
+
+//
+// CHANNEL MESSAGES
+//
+// note off - note on with velocity = 0 calls this
+void _midi_rx_note_off(unsigned char channel, 
+		unsigned char note) {
+	unsigned char map;
+	unsigned char trigger;
+	// our channels
+	if(seq_midi_is_ours(channel)) {
+		map = sysconfig_get_key_map();
+		trigger = sysconfig_get_key_trigger();
+		// recording ignores note off
+		if(map == SYSCONFIG_KEY_MAP_REC) return;
+		// release an arpeggiator key
+		if(seq_midi_arp_key(channel, note, 0)) return;
+
+		// handle key map swapping
+		if(sequencer_get_control_override(SYSCONFIG_MOD_KEY_MAP) == 1) {
+			if(map == SYSCONFIG_KEY_MAP_B) map = SYSCONFIG_KEY_MAP_A;
+			else map = SYSCONFIG_KEY_MAP_B;
+		}
+
+		// key map B
+		if(map == SYSCONFIG_KEY_MAP_B) {
+			// key trigger sequence
+			if(note > 47 && note < 64) {
+				if(trigger == SYSCONFIG_KEY_TRIGGER_MOM &&
+						last_trigger_key == (note - 48)) {
+					clock_stop_command();
+					last_trigger_key = 255;
+				}
+			}
+		}
+		// key map A
+		else {
+			// key trigger sequence
+			if(note > 23 && note < 40) {
+				if(trigger == SYSCONFIG_KEY_TRIGGER_MOM &&
+						last_trigger_key == (note - 24)) {
+					clock_stop_command();
+					last_trigger_key = 255;
+				}
+			}
+		}
+	}
+}
+
+// note on - note on with velocity > 0 calls this
+void _midi_rx_note_on(unsigned char channel, 
+		unsigned char note, 
+		unsigned char velocity) {
+	unsigned char map, part;
+
+	// record the note into the parts on this channel
+	map = sysconfig_get_key_map();
+	if(map == SYSCONFIG_KEY_MAP_REC) {
+		for(part = 0; part < SONG_NUM_PARTS; part ++) {
+			if(channel == part_chan[part]) sequencer_record_note(part, note);
+		}
+		return;
+	}
+
+	// our channels
+	if(seq_midi_is_ours(channel)) {
+		// hold an arpeggiator key
+		if(seq_midi_arp_key(channel, note, 1)) return;
+		// handle key map swapping
+		if(sequencer_get_control_override(SYSCONFIG_MOD_KEY_MAP) == 1) {
+			if(map == SYSCONFIG_KEY_MAP_B) map = SYSCONFIG_KEY_MAP_A;
+			else map = SYSCONFIG_KEY_MAP_B;
+		}
+
+		// key map B
+		if(map == SYSCONFIG_KEY_MAP_B) {
+			// key transpose
+			if(note > 23 && note < 48) {
+				sequencer_key_transpose(note - 36);
+			}
+			// key trigger sequence
+			else if(note > 47 && note < 64) {
+				last_trigger_key = note - 48;
+				sequencer_key_trigger(last_trigger_key);
+			}
+			// key start
+			else if(note == 65) {
+				clock_run_command();
+			}
+			// key stop
+			else if(note == 67) {
+				clock_stop_command();
+			}
+			// key reset
+			else if(note == 69) {
+				clock_reset_input();
+			}
+			// key control restore
+			else if(note == 71) {
+				sequencer_control_restore();
+			}
+		}
+		// key map A
+		else {
+			// key trigger sequence
+			if(note > 23 && note < 40) {
+				last_trigger_key = note - 24;
+				sequencer_key_trigger(last_trigger_key);
+			}
+			// key start
+			else if(note == 41) {
+				clock_run_command();
+			}
+			// key stop
+			else if(note == 43) {
+				clock_stop_command();
+			}
+			// key reset
+			else if(note == 45) {
+				clock_reset_input();
+			}
+			// key control restore
+			else if(note == 47) {
+				sequencer_control_restore();
+			}
+			// key transpose
+			else if(note > 47 && note < 73) {
+				sequencer_key_transpose(note - 60);
+			}
+		}
+	}
+}
+
+// key pressure
+void _midi_rx_key_pressure(unsigned char channel, 
+		unsigned char note,
+		unsigned char pressure) {
+	// passed by the thru filter
+}
+
+// control change
+void _midi_rx_control_change(unsigned char channel,
+		unsigned char controller,
+		unsigned char value) {
+	unsigned char target = sysconfig_get_cc_target(controller);
+	unsigned char map_chan = sysconfig_get_cc_channel(controller);
+	unsigned char ours = seq_midi_is_ours(channel);
+
+	// NRPN param access
+	if(channel == sysconfig_get_param_channel() && param_nrpn(controller, value)) return;
+
+	// mapped controllers
+	if(target != SYSCONFIG_CC_NONE &&
+			(map_chan == channel || (map_chan == SYSCONFIG_CC_CHAN_PARTS && ours))) {
+		value = sysconfig_get_cc_value(controller, value);
+		if(target == SYSCONFIG_CC_RESTORE) {
+			if(value > 63) sequencer_control_restore();
+		}
+		else if(target != SYSCONFIG_CC_IGNORE) {
+			sequencer_control_change(target, value);
+		}
+	}
+	// echo others on our channels
+	else if(ours) {
+		_midi_tx_control_change(channel, controller, value);
+	}
+}
+
+// channel mode - all sounds off
+void _midi_rx_all_sounds_off(unsigned char channel) {
+	// XXX reset the system
+}
+
+// channel mode - reset all controllers
+void _midi_rx_reset_all_controllers(unsigned char channel) {
+	// XXX reset the system
+}
+
+// channel mode - local control
+void _midi_rx_local_control(unsigned char channel, unsigned char value) {
+	// not supported
+}
+
+// channel mode - all notes off
+void _midi_rx_all_notes_off(unsigned char channel) {
+	// XXX reset the system
+}
+
+// channel mode - omni off
+void _midi_rx_omni_off(unsigned char channel) {
+	// not supported
+}
+
+// channel mode - omni on
+void _midi_rx_omni_on(unsigned char channel) {
+	// not supported
+}
+
+// channel mode - mono on
+void _midi_rx_mono_on(unsigned char channel) {
+	// not supported
+}
+
+// channel mode - poly on
+void _midi_rx_poly_on(unsigned char channel) {
+	// not supported
+}
+
+// program change
+void _midi_rx_program_change(unsigned char channel,
+		unsigned char program) {
+	// passed by the thru filter
+}
+
+// channel pressure
+void _midi_rx_channel_pressure(unsigned char channel,
+		unsigned char pressure) {
+	// passed by the thru filter
+}
+
+// pitch bend
+void _midi_rx_pitch_bend(unsigned char channel,
+		unsigned int bend) {
+	// passed by the thru filter
+}
+
+//
+// SYSTEM COMMON MESSAGES
+//
+// MTC quarter frame
+void _midi_rx_mtc_qframe(unsigned char data) {
+	mtc_qframe(data);
+}
+
+// song position
+void _midi_rx_song_position(unsigned int pos) {
+	sequencer_midi_song_pos(pos);
+}
+
+// song select
+void _midi_rx_song_select(unsigned char song) {
+	if(song > 7) return;
+	song_file_load(song);
+}
+
+//
+// SYSEX MESSAGES
+//
+// sysex command start
+void _midi_rx_sysex_cmd_start(unsigned char cmd) {
+	int i;
+	sysex_rx_cmd = NULL;
+	for(i = 0; i < SYSEX_NUM_CMDS; i ++) {
+		if(sysex_cmds[i].cmd == cmd) {
+			sysex_rx_cmd = &sysex_cmds[i];
+			sysex_rx_cmd->start(cmd);
+			return;
+		}
+	}
+}
+
+// sysex command data byte
+void _midi_rx_sysex_cmd_data(unsigned char data_byte) {
+	if(sysex_rx_cmd == NULL) return;
+	sysex_rx_cmd->data(data_byte);
+}
+
+// sysex command end
+void _midi_rx_sysex_cmd_end(unsigned char complete) {
+	if(sysex_rx_cmd == NULL) return;
+	if(complete) sysex_rx_cmd->end();
+	sysex_rx_cmd = NULL;
+}
+
+//
+// SYSTEM REALTIME MESSAGES
+//
+// timing tick
+void _midi_rx_timing_tick(void) {
+	clock_midi_tick();
+}
+
+// start song
+void _midi_rx_start_song(void) {
+	clock_midi_start();
+}
+
+// continue song
+void _midi_rx_continue_song(void) {
+	clock_midi_continue();
+}
+
+// stop song
+void _midi_rx_stop_song(void) {
+	clock_midi_stop();
+}
+
+// active sensing
+void _midi_rx_active_sensing(void) {
+	// not supported
+}
+
+// system reset
+void _midi_rx_system_reset(void) {
+	// XXX reset the system
+	_midi_tx_system_reset();
+}
+
+//
+// SPECIAL CALLBACKS
+//
+void _midi_restart_device(void) {
+	int i;
+	lcd_clear_screen();
+	screen_write_popup(1000, " ", "SYSEX RESTART");
+	screen_task();
+	for(i = 0; i < 64; i ++) {
+		lcd_task();
+	}
+	DelayMs(100);
+	void (*fptr)(void);
+	fptr = (void (*)(void))BOOTLOADER_ADDR;
+	fptr();
+}
+
+//
+// LOCAL FUNCTIONS
+//
+// start an EEPROM page command
+void seq_midi_eeprom_start(unsigned char cmd) {
+	sysex_rx_count = 0;
+	eeprom_rx_addr = 0;
+}
+
+// receive an EEPROM page command byte - 8 address nibbles then data nibbles
+void seq_midi_eeprom_data(unsigned char data_byte) {
+	if(sysex_rx_count < 8) {
+		eeprom_rx_addr = (eeprom_rx_addr << 4) | (data_byte & 0x0f);
+	}
+	else if(sysex_rx_count < (8 + 64)) {
+		if(sysex_rx_count & 0x01) {
+			eeprom_rx_buf[(sysex_rx_count - 8) >> 1] |= (data_byte & 0x0f);
+		}
+		else {
+			eeprom_rx_buf[(sysex_rx_count - 8) >> 1] = data_byte << 4;
+		}
+	}
+	if(sysex_rx_count < 255) sysex_rx_count ++;
+}
+
+// read EEPROM data
+void seq_midi_read_eeprom(void) {
+	unsigned char dev_type = midi_get_device_type();
+	int addr = eeprom_rx_addr;
+	unsigned char buf[32];
+	int i;
+	if(sysex_rx_count != 8) return;
+	eeprom_read_page(addr, buf);
+	// respond
+	_midi_tx_sysex_start();
+	_midi_tx_sysex_data(0x00);
+	_midi_tx_sysex_data(0x01);
+	_midi_tx_sysex_data(0x72);
+	_midi_tx_sysex_data(dev_type);
+	_midi_tx_sysex_data(CMD_READBACK_EEPROM);
+	_midi_tx_sysex_data((addr >> 28) & 0x0f);
+	_midi_tx_sysex_data((addr >> 24) & 0x0f);
+	_midi_tx_sysex_data((addr >> 20) & 0x0f);
+	_midi_tx_sysex_data((addr >> 16) & 0x0f);
+	_midi_tx_sysex_data((addr >> 12) & 0x0f);
+	_midi_tx_sysex_data((addr >> 8) & 0x0f);
+	_midi_tx_sysex_data((addr >> 4) & 0x0f);
+	_midi_tx_sysex_data(addr & 0x0f);
+	for(i = 0; i < 32; i ++) {
+		_midi_tx_sysex_data((buf[i] >> 4) & 0x0f);
+		_midi_tx_sysex_data(buf[i] & 0x0f);
+	}
+	_midi_tx_sysex_end();
+}
+
+// write EEPROM data
+void seq_midi_write_eeprom(void) {
+	if(sysex_rx_count != (8 + 64)) return;
+	eeprom_write_page(eeprom_rx_addr, eeprom_rx_buf);
+}
+
+// start an undo / redo command
+void seq_midi_undo_start(unsigned char cmd) {
+	undo_rx_cmd = cmd;
+	sysex_rx_count = 0;
+}
+
+// receive an undo / redo command byte - there should be none
+void seq_midi_undo_data(unsigned char data_byte) {
+	if(sysex_rx_count < 255) sysex_rx_count ++;
+}
+
+// undo or redo the last song edit
+void seq_midi_undo_end(void) {
+	if(sysex_rx_count != 0) return;
+	if(undo_rx_cmd == CMD_UNDO) song_undo();
+	else song_redo();
+	gui_params_updated();
+}
+
+// pass a key to the arpeggiator parts on a channel - returns 1 if one took it
+unsigned char seq_midi_arp_key(unsigned char channel, unsigned char note, unsigned char on) {
+	unsigned char part, used = 0;
+	for(part = 0; part < SONG_NUM_CV_PARTS; part ++) {
+		if(channel != seq_midi_get_channel(part)) continue;
+		if(sysconfig_get_arp_mode(part) == ARP_OFF) continue;
+		if(on) arp_note_on(part, note);
+		else arp_note_off(part, note);
+		used = 1;
+	}
+	return used;
+}
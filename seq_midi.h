@@ -1,17 +1,30 @@
-/*
- * K2579 Step Sequencer - Sequencer MIDI Handler
- *
- * Copyright 2011: Kilpatrick Audio
- * Written by: Andrew Kilpatrick
- *
- */
-// initialize the MIDI handler
-void seq_midi_init(void);
-
-// get the MIDI channel for a part
-unsigned char seq_midi_get_channel(unsigned char part);
-
-// set the MIDI channel for a part
-void seq_midi_set_channel(unsigned char part, unsigned char channel);
-
-
+/*
+ * K2579 Step Sequencer - Sequencer MIDI Handler
+ *
+ * Copyright 2011: Kilpatrick Audio
+ * Written by: Andrew Kilpatrick
+ *
+ */
+// initialize the MIDI handler
+void seq_midi_init(void);
+
+// get the MIDI channel for a part
+unsigned char seq_midi_get_channel(unsigned char part);
+
+// set the MIDI channel for a part
+void seq_midi_set_channel(unsigned char part, unsigned char channel);
+
+// set up the MIDI thru filter for our channels and the CC map
+void seq_midi_update_thru(void);
+
+// learn a CC for a CC map target - SEQ_MIDI_LEARN_OFF to cancel
+#define SEQ_MIDI_LEARN_OFF 255
+void seq_midi_learn_cc(unsigned char target);
+
+// get the CC map target being learned or SEQ_MIDI_LEARN_OFF
+unsigned char seq_midi_get_learn_cc(void);
+
+// get the last CC learned
+unsigned char seq_midi_get_learned_cc(void);
+
+
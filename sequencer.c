@@ -1,675 +1,1650 @@
-/*
- * K2579 Step Sequencer - Sequencer Core
- *
- * Copyright 2011: Kilpatrick Audio
- * Written by: Andrew Kilpatrick
- *
- *  - clock divide behaviour:
- *    - all song position, gate and clock functions are based on 24ppq
- *    - steps are taken based on the clock divider
- *
- */
-#include <plib.h>
-#include <stdlib.h>
-#include <stdio.h>
-#include "sequencer.h"
-#include "song.h"
-#include "midi.h"
-#include "cv_output.h"
-#include "analog_input.h"
-#include "clock.h"
-#include "sysconfig.h"
-#include "gui.h"
-#include "seq_midi.h"
-#include "scale.h"
-#include "panel.h"
-
-#define STEP_INVALID 127
-
-// clock control
-#define NOTE_KILL_TIME_RUN 39063		// ~10s at 256us per count
-#define NOTE_KILL_TIME_STOP 796 		// 0.500ms at 256us per count
-#define MOD_LED_TIMEOUT 2				// 32ms
-unsigned int clock_tick_count;			// clock tick count
-unsigned char clock_div_count;			// the current clock divide counter
-int note_kill_timeout;					// the note timeout counter - for stopped clock
-
-// sequencer internal
-#define MIDI_NOTE_OFFSET 24
-unsigned char next_cued_seq;			// the next seq to play or 255 if invalid
-// these are used for display because the step is updated after each step is started
-unsigned char current_seq_playing;		// the current sequence playing now
-unsigned char current_step_index_playing;	// the current step index playing now
-// current playback variables
-unsigned char current_seq;				// the currently playing sequence
-unsigned char current_loop_count;		// the number of loops taken
-char current_step_count;				// current step count based on the dir and length - counts from 0 to len
-unsigned char current_pingpong;			// the current ping pong count
-unsigned char current_note[2];			// current note or 255
-unsigned char gate_time_count[2];		// the current gate time counted
-// control overrides
-unsigned char control_start_override;	// 0-15 start override or 255 if disabled
-unsigned char control_len_override;		// 0-15 length override or 255 if disabled
-unsigned char control_gate_override[2];	// 1-48 length override or 255 disabled
-unsigned char control_dir_override;		// 1 = override or 255 if disabled
-char control_offset_override[2];  		// -12 to +12 overrides the offset
-unsigned char control_run_override;		// 1 = run stopped or 255 if disabled
-unsigned char control_key_map_override;  // 1 = swapped, 255 = normal
-
-// local functions
-// start a note
-void sequencer_start_note(unsigned char part, unsigned char note);
-// stop a note
-void sequencer_stop_note(unsigned char part);
-// the clock has changed
-void sequencer_clock_changed(void);
-// advance the sequencer 1 step
-void sequencer_advance_step(void);
-// the end of a loop is reached - figure out what to do next
-void sequencer_loop_end(unsigned char len, unsigned char dir);
-// compute and return the current step based on dir, len, etc.
-char sequencer_compute_current_step(void);
-// reset song position
-void sequencer_reset_song_pos(void);
-
-// initialize the sequencer
-void sequencer_init(void) {
-	// clock control
-	clock_tick_count = 0;
-	note_kill_timeout = 0;
-	// sequencer internal
-	sequencer_reset_song_pos();
-	sequencer_control_restore();
-}
-
-// run the sequencer task every 256us
-void sequencer_task(void) {
-	// note kill
-	if(note_kill_timeout) {
-		note_kill_timeout --;
-		if(note_kill_timeout == 0) {
-			sequencer_stop_note(0);
-			sequencer_stop_note(1);
-		}
-	}
-}
-
-// start a note
-void sequencer_start_note(unsigned char part, unsigned char note) {
-	unsigned char not;
-	if(part > 1) return;
-	if(control_offset_override[part]) {
-		not = note + 12 + control_offset_override[part];  // 12-60 normal range
-	}
-	else {
-		not = note + 12 + song_get_offset(current_seq, part);  // 12-60 normal range
-	}
-	if(not < 12 || not > 115) return;
-	// send MIDI note
-	current_note[part] = not;
-	gate_time_count[part] = 0;
-	_midi_tx_note_on(seq_midi_get_channel(part), current_note[part] + MIDI_NOTE_OFFSET, 100);
-	// control analog output
-	cv_output_note_on(part, current_note[part]);
-	// reset the note timeout
-	if(clock_get_song_playing()) note_kill_timeout = NOTE_KILL_TIME_RUN;
-	else note_kill_timeout = NOTE_KILL_TIME_STOP;
-}
-
-// stop a note
-void sequencer_stop_note(unsigned char part) {
-	if(part > 1) return;
-	if(current_note[part] == 255) return;
-	// send MIDI note
-	_midi_tx_note_off(seq_midi_get_channel(part), current_note[part] + MIDI_NOTE_OFFSET);
-	current_note[part] = 255;
-	// control analog output
-	cv_output_note_off(part);
-}
-
-// the clock has changed
-void sequencer_clock_changed(void) {
-	int i;
-	unsigned char gate;
-
-	// gate time
-	for(i = 0; i < 2; i ++) {
-		if(current_note[i]) {
-			gate_time_count[i] ++;
-			gate = song_get_gate(current_seq, i);
-			if(control_gate_override[i] != 255) gate = control_gate_override[i];
-			if(gate_time_count[i] >= gate) {
-				sequencer_stop_note(i);
-			}
-		}
-	}
-
-	// next step
-	if(clock_div_count == 0) {
-		int note;
-		char step;
-
-		// get the current step based on the start, len and random
-		step = sequencer_compute_current_step();
-
-		// control each note
-		for(i = 0; i < 2; i ++) {
-			note = song_get_note(current_seq, i, step);
-			if(note == SONG_STEP_RAND) {
-				note = song_get_rand_note();
-			}
-			note = scale_span_adjust(note, song_get_span(current_seq, i));
-			note = scale_quantize(note, song_get_scale(current_seq, i));
-			if(note == SONG_STEP_REST) {
-				sequencer_stop_note(i);
-			}
-			else if(note == SONG_STEP_NONE) {
-				// do nothing
-			}
-			else {
-				sequencer_stop_note(i);
-				sequencer_start_note(i, note);
-			}
-		}
-
-		// update the display positions based on the step just played
-		current_seq_playing = current_seq;
-		current_step_index_playing = step;
-		gui_playback_updated();
-
-		// advance the sequencer for the next step
-		sequencer_advance_step();
-	}
-	clock_div_count ++;
-	// step time override
-	unsigned char step_len = song_get_step_len(current_seq, current_step_index_playing);
-	// a step len of >0 means use it for the clock div count
-	if(step_len) {
-		if(clock_div_count >= step_len) {
-			clock_div_count = 0;
-		}
-	}
-	// otherwise use the master clock div
-	else if(clock_div_count >= sysconfig_get_clock_div()) {
-		clock_div_count = 0;
-	}
-	note_kill_timeout = NOTE_KILL_TIME_RUN;
-}
-
-// advance the sequencer 1 step
-void sequencer_advance_step(void) {
-	// length
-	unsigned char len = song_get_seq_len(current_seq);
-	if(control_len_override != 255) {
-		len = control_len_override;
-	}
-
-	// direction
-	unsigned char dir = song_get_seq_dir(current_seq);
-	if(control_dir_override == 1) {
-		// flip directions for forward / backward
-		if(dir == SONG_DIR_FWD) dir = SONG_DIR_BACK;
-		else if(dir == SONG_DIR_BACK) dir = SONG_DIR_FWD;
-	}	
-
-	// the current step has not yet been initialized
-	if(current_step_count == STEP_INVALID) {
-		sequencer_loop_end(len, dir);
-		return;
-	}
-
-	// pingpong
-	if(dir == SONG_DIR_PONG) {
-		// ponging (backwards)
-		if(current_pingpong & 0x01) {
-			current_step_count --;
-			// start is reached
-			if(current_step_count <= 0) {
-				current_step_count = 0;
-				current_pingpong = 0;
-				sequencer_loop_end(len, dir);
-			}
-		}
-		// pinging (forwards)
-		else {
-			current_step_count ++;
-			// len is reached
-			if(current_step_count >= len - 1) {
-				current_step_count = len - 1;
-				current_pingpong = 1;
-				sequencer_loop_end(len, dir);
-			}
-		}
-	}
-	// go forwards / randomly
-	else if(dir == SONG_DIR_FWD || dir == SONG_DIR_RAND) {
-		current_step_count ++;
-		// len is reached
-		if(current_step_count > (len - 1)) {
-			current_step_count = 0;
-			sequencer_loop_end(len, dir);
-		}
-	}
-	// go backwards
-	else if(dir == SONG_DIR_BACK) {
-		current_step_count --;
-		// start is reached
-		if(current_step_count < 0) {
-			current_step_count = len - 1;
-			sequencer_loop_end(len, dir);
-		}
-	}
-}
-
-// the end of a loop is reached - figure out what to do next
-void sequencer_loop_end(unsigned char len, unsigned char dir) {
-	// step is invalid from the reset - cause sequence to reload
-	if(current_step_count == STEP_INVALID) {
-		current_seq = 254;
-	}
-	// we've reached a loop end
-	else {
-		current_loop_count ++;
-		// number of loops is exceeded
-		if(current_loop_count > song_get_seq_loop(current_seq) && next_cued_seq == 255) {
-			next_cued_seq = song_get_seq_next(current_seq);
-		}
-	}
-
-	// if the cued seq is not the one we're on
-	if((next_cued_seq != 255) & (next_cued_seq != current_seq)) {
-		current_seq = next_cued_seq;
-		current_pingpong = 0;
-		current_loop_count = 0;
-		
-		// length
-		unsigned char new_len = song_get_seq_len(current_seq);
-		if(control_len_override != 255) {
-			new_len = control_len_override;
-		}
-
-		// direction
-		unsigned char new_dir = song_get_seq_dir(current_seq);
-		if(control_dir_override == 1) {
-			// flip directions for forward / backward
-			if(new_dir == SONG_DIR_FWD) new_dir = SONG_DIR_BACK;
-			else if(new_dir == SONG_DIR_BACK) new_dir = SONG_DIR_FWD;
-		}
-		// for backwards we start on the last step
-		if(new_dir == SONG_DIR_BACK) {
-			current_step_count = new_len - 1;
-		}
-		// for forwards we start on step 0
-		else {
-			current_step_count = 0;
-		}
-	}
-	next_cued_seq = 255;
-}
-
-// compute and return the current step based on dir, len, etc.
-char sequencer_compute_current_step(void) {
-	char temp;
-	// start
-	unsigned char new_start = song_get_seq_start(current_seq);
-	if(control_start_override != 255) {
-		new_start = control_start_override;
-	}
-
-	// go randomly
-	if(song_get_seq_dir(current_seq) == SONG_DIR_RAND) {
-		// length
-		unsigned char new_len = song_get_seq_len(current_seq);
-		if(control_len_override != 255) {
-			new_len = control_len_override;
-		}
-		temp = ((rand() >> 4) % new_len) + new_start;
-	}
-	// go sequentially
-	else {
-		temp = current_step_count + new_start;
-	}
-
-	// clamp the step index range because it wraps around for start/len offsets
-	if(temp > (SONG_NUM_STEPS - 1)) temp -= SONG_NUM_STEPS;
-	else if(temp < 0) temp += SONG_NUM_STEPS;
-
-	return temp;
-}
-
-// reset song position
-void sequencer_reset_song_pos(void) {
-	clock_tick_count = 0;  // reset the song position
-	clock_div_count = 0;
-	// reset the sequence only
-	if(sysconfig_get_reset_mode() == SYSCONFIG_RESET_MODE_SEQ) {
-		next_cued_seq = current_seq;
-	}
-	// reset the entire song
-	else {
-		next_cued_seq = 0;  // next cued sequence is 0
-	}
-	current_seq_playing = next_cued_seq;
-	current_step_count = STEP_INVALID;  // invalidate the current position
-	current_loop_count = 0;
-	current_pingpong = 0;
-	sequencer_advance_step();
-	current_step_index_playing = sequencer_compute_current_step();
-	current_note[0] = 255;  // disabled
-	current_note[1] = 255;  // disabled
-	gate_time_count[0] = 0;
-	gate_time_count[1] = 0;
-	gui_playback_updated();
-}
-
-//
-// MIDI / analog clock handlers
-//
-// set song position
-void sequencer_midi_song_pos(unsigned int pos) {
-	unsigned char clock_div = sysconfig_get_clock_div();
-	_midi_tx_song_position(pos);  // send song position pointer
-
-	// calculate the current position
-	sequencer_reset_song_pos();  // reset the song
-	clock_tick_count = pos * 6;  // calculate the desired clock tick offset
-	unsigned int advance_tick_count = 0;
-	unsigned char step_len = 0;
-	unsigned char step = 0;
-	while(1) {
-		// get the current step based on the start, len and random
-		step = sequencer_compute_current_step();
-		step_len = song_get_step_len(current_seq, step);
-		// step length is default (clock_div)
-		if(step_len == 0) {
-			step_len = clock_div;
-		}
-		// if we're past the SPP then break
-		if(advance_tick_count + step_len > clock_tick_count) break;
-		// add the step length
-		advance_tick_count += step_len;
-		sequencer_advance_step();  // move to the next step
-		ClearWDT();
-	}
-	// deal with remainder
-	clock_div_count = clock_tick_count - advance_tick_count;
-	current_seq_playing = current_seq;
-	current_step_index_playing = sequencer_compute_current_step();
-	gui_playback_updated();
-}
-
-//
-// MIDI/analog control handlers
-//
-// clock pulse was received
-void sequencer_clock_tick(void) {
-	if(control_run_override == 1) return;
-	sequencer_clock_changed(); 
-	clock_tick_count ++;
-}
-
-// start song at beginning
-void sequencer_clock_start(void) {
-	sequencer_stop_note(0);
-	sequencer_stop_note(1);
-	sequencer_reset_song_pos();
-}
-
-// stop song
-void sequencer_clock_stop(void) {
-	sequencer_stop_note(0);
-	sequencer_stop_note(1);
-	_midi_tx_control_change(seq_midi_get_channel(0), 123, 0);
-	_midi_tx_control_change(seq_midi_get_channel(1), 123, 0);
-}
-
-// get the current clock div count
-unsigned char sequencer_get_clock_div_count(void) {
-	return clock_div_count;
-}
-
-//
-// external control of sequence
-//
-// MIDI key trigger
-void sequencer_key_trigger(unsigned char seq) {
-	if(seq > SONG_NUM_SEQ) return;
-	sequencer_set_next_seq(seq);
-	clock_run_command();  // make sure we start if we're stopped
-}
-
-// MIDI key transpose
-void sequencer_key_transpose(char transpose) {
-	unsigned char assign = sysconfig_get_key_transpose();
-	if(transpose < -12 || transpose > 12) return;
-
-	if(assign == SYSCONFIG_KEY_TRANSPOSE12) {
-		control_offset_override[0] = transpose;
-		control_offset_override[1] = transpose;
-	}
-	else if(assign == SYSCONFIG_KEY_TRANSPOSE1) {
-		control_offset_override[0] = transpose;
-	}
-	else if(assign == SYSCONFIG_KEY_TRANSPOSE2) {
-		control_offset_override[1] = transpose;
-	}
-}
-
-// MIDI/analog control change was received
-// send values from 0-127 to here
-void sequencer_control_change(unsigned char mod, unsigned char value) {
-	if(value > 127) return;
-
-	// next sequence
-	if(mod == SYSCONFIG_MOD_NEXT_SEQ) {
-		sequencer_set_next_seq(value >> 3);
-	}
-	// sequence start
-	else if(mod == SYSCONFIG_MOD_SEQ_START) {
-		control_start_override = (value >> 3);
-	}
-	// sequence len
-	else if(mod == SYSCONFIG_MOD_SEQ_LEN) {
-		control_len_override = (value >> 3) + 1;
-	}
-	// sequence run/stop
-	else if(mod == SYSCONFIG_MOD_RUN_STOP) {
-		// stop
-		if(value < 64) {
-			if(control_run_override == 255) {
-				clock_stop_command();
-				control_run_override = 1;
-			}
-		}
-		else {
-			if(control_run_override == 1) {
-				clock_run_command();
-				control_run_override = 255;
-			}
-		}
-	}
-	// gate 1 length
-	else if(mod == SYSCONFIG_MOD_GATE1) {
-		control_gate_override[0] = (value >> 2) + 1;
-	}
-	// gate 2 length
-	else if(mod == SYSCONFIG_MOD_GATE2) {
-		control_gate_override[1] = (value >> 2) + 1;
-	}
-	// dir
-	else if(mod == SYSCONFIG_MOD_SEQ_DIR) {
-		if(value < 64) control_dir_override = 255;
-		else control_dir_override = 1;
-	}
-	// key map - this is special and not part of the normal group
-	else if(mod == SYSCONFIG_MOD_KEY_MAP) {
-		if(value < 64) control_key_map_override = 255;
-		else control_key_map_override = 1;
-	}
-	// not recognized mod
-	else {
-		return;
-	}
-
-	// blink the mod led
-	panel_set_mod_led(MOD_LED_TIMEOUT);
-
-	// send event about the updated status
-	gui_control_override_updated();
-}
-
-// get a control override value
-// returns values in the local range
-unsigned char sequencer_get_control_override(unsigned char mod) {
-	// next sequence
-	if(mod == SYSCONFIG_MOD_NEXT_SEQ) { 
-		// not supported
-	}
-	// sequence start
-	else if(mod == SYSCONFIG_MOD_SEQ_START) {
-		if(control_start_override != 255) {
-			return control_start_override;
-		}
-	}
-	// sequence len
-	else if(mod == SYSCONFIG_MOD_SEQ_LEN) {
-		if(control_len_override != 255) {
-			return control_len_override;
-		}
-	}
-	// sequence run/stop
-	else if(mod == SYSCONFIG_MOD_RUN_STOP) {
-		if(control_run_override != 255) {
-			return 0;
-		}
-	}
-	// gate 1 length
-	else if(mod == SYSCONFIG_MOD_GATE1) {
-		if(control_gate_override[0]) {
-			return control_gate_override[0];
-		}
-	}
-	// gate 2 length
-	else if(mod == SYSCONFIG_MOD_GATE2) {
-		if(control_gate_override[1]) {
-			return control_gate_override[1];
-		}
-	}
-	// dir
-	else if(mod == SYSCONFIG_MOD_SEQ_DIR) {
-		if(control_dir_override != 255) {
-			return control_dir_override;
-		}
-	}
-	// keymap
-	else if(mod == SYSCONFIG_MOD_KEY_MAP) {
-		if(control_key_map_override != 255) {
-			return control_key_map_override;
-		}
-	}
-	return 255;
-}
-
-// restore the current CC / key overrides to the default value
-void sequencer_control_restore(void) {
-	control_start_override = 255;  // disabled
-	control_len_override = 255;  // disabled
-	control_gate_override[0] = 255;  // disabled
-	control_gate_override[1] = 255;  // disabled
-	control_dir_override = 255;  // disabled
-	control_offset_override[0] = 0;  // disabled
-	control_offset_override[1] = 0;  // disabled
-	control_run_override = 255;  // disabled
-	control_key_map_override = 255;  // disabled
-	gui_control_override_updated();
-}
-
-// restore the run/stop override to panel control
-void sequencer_control_run_stop_restore(void) {
-	control_run_override = 255;  // disabled
-	gui_control_override_updated();
-}
-
-// get the current sequence
-unsigned char sequencer_get_current_seq(void) {
-	return current_seq_playing;
-}
-
-// set the current sequence
-void sequencer_set_next_seq(unsigned char seq) {
-	if(seq > (SONG_NUM_SEQ - 1)) return;
-
-	// if the song is playing, don't interrupt the current loop pass
-	if(clock_get_song_playing()) {
-		next_cued_seq = seq;  // cue up for the next pass
-	}
-	// otherwise reset everything and set it immediately
-	else {
-		sequencer_reset_song_pos();
-		// if we have to force another sequence to change
-		if(seq != current_seq) {
-			next_cued_seq = seq;
-			current_step_count = STEP_INVALID;  // invalidate the current position
-			sequencer_advance_step();
-		}
-		// force correct display
-		current_seq_playing = current_seq;
-		current_step_index_playing = sequencer_compute_current_step();
-		gui_playback_updated();
-	}
-}
-
-// get the current sequence step index
-unsigned char sequencer_get_current_step_index(void) {
-	return current_step_index_playing;
-}
-
-// set a note for preview
-void sequencer_play_audition_note(unsigned char part, unsigned char note) {
-	if(part > 1) return;
-	sequencer_stop_note(part);
-	sequencer_start_note(part, note);
-}
-
-// calibrate the CV outputs
-void sequencer_cv_cal_start(void) {
-	clock_stop_command();
-}
-
-// set a CV calibration voltage
-void sequencer_cv_set_cal(unsigned char part, char octave) {
-	unsigned char note;
-	if(part > 1) return;
-	if(octave > 6) return;
-	note = octave * 12;
-
-	// don't multi-trigger
-	if(current_note[part] == note) return;
-
-	// turn off notes if already playing
-	if(current_note[part] != 255) {
-		_midi_tx_note_off(seq_midi_get_channel(part), current_note[part] + MIDI_NOTE_OFFSET);
-		current_note[part] = 255;
-	}
-
-	// send MIDI note
-	current_note[part] = note;
-	gate_time_count[part] = 0;
-	_midi_tx_note_on(seq_midi_get_channel(part), current_note[part] + MIDI_NOTE_OFFSET, 100);
-	// control analog output
-	cv_output_note_on(part, current_note[part]);
-	// reset the note timeout
-	if(clock_get_song_playing()) note_kill_timeout = NOTE_KILL_TIME_RUN;
-	else note_kill_timeout = NOTE_KILL_TIME_STOP;	
-}
-
-
-// song is loaded - need to reset the start position
-void sequencer_new_song_loaded(void) {
-	// clock control
-	clock_tick_count = 0;
-	note_kill_timeout = 0;
-	// sequencer internal
-	sequencer_reset_song_pos();
-	sequencer_control_restore();
-}
+/*
+ * K2579 Step Sequencer - Sequencer Core
+ *
+ * Copyright 2011: Kilpatrick Audio
+ * Written by: Andrew Kilpatrick
+ *
+ *  - clock divide behaviour:
+ *    - all song position, gate and clock functions are based on 24ppq
+ *    - steps are taken based on the clock divider
+ *
+ */
+#include <plib.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include "sequencer.h"
+#include "song.h"
+#include "midi.h"
+#include "cv_output.h"
+#include "analog_input.h"
+#include "clock.h"
+#include "sysconfig.h"
+#include "gui.h"
+#include "seq_midi.h"
+#include "scale.h"
+#include "panel.h"
+#include "arp.h"
+
+#define STEP_INVALID 127
+
+// clock control
+#define NOTE_KILL_TIME_RUN 39063		// ~10s at 256us per count
+#define NOTE_KILL_TIME_STOP 796 		// 0.500ms at 256us per count
+#define MOD_LED_TIMEOUT 2				// 32ms
+unsigned int clock_tick_count;			// clock tick count
+int note_kill_timeout;					// the note timeout counter - for stopped clock
+
+// sequencer internal
+#define MIDI_NOTE_OFFSET 24
+#define NOTE_VEL 100							// velocity of steps without a velocity lane
+#define NOTE_ACCENT_VEL 127					// velocity of accented steps
+#define LEAD_PART 0							// this part changes the sequences
+unsigned char next_cued_seq;			// the next seq to play or 255 if invalid
+// this is used for display because the step is updated after each step is started
+unsigned char current_seq_playing;		// the current sequence playing now
+// current playback variables
+unsigned char current_seq;				// the currently playing sequence
+unsigned char current_note[SONG_NUM_PARTS];		// current note or 255
+unsigned char gate_time_count[SONG_NUM_PARTS];	// the current gate time counted
+unsigned char note_accent[SONG_NUM_PARTS];		// the current note is accented
+unsigned char lane_cc_sent[SONG_NUM_PARTS][2];	// last CC lane values sent or 255
+// each part steps through the sequence on its own so the parts can have
+// different lengths and clock divides - the lead part changes sequences
+// and the other parts start the new sequence with the lead's first step
+typedef struct {
+	unsigned char seq;					// the sequence this part steps through
+	unsigned char seq_playing;			// the sequence of the step playing now
+	unsigned char step_playing;			// the step index playing now
+	unsigned char div_count;			// the clock divide counter
+	char step_count;					// step count based on the dir and length - counts from 0 to len
+	unsigned char pingpong;				// the current ping pong count
+	unsigned char loop_count;			// the number of loops taken
+} track;
+track tracks[SONG_NUM_PARTS];
+// control overrides
+unsigned char control_start_override;	// 0-15 start override in 16ths of the seq or 255 if disabled
+unsigned char control_len_override;		// 1-16 length override in 16ths of the seq or 255 if disabled
+unsigned char control_gate_override[2];	// 1-48 length override or 255 disabled
+unsigned char control_dir_override;		// 1 = override or 255 if disabled
+char control_offset_override[2];  		// -12 to +12 overrides the offset
+unsigned char control_run_override;		// 1 = run stopped or 255 if disabled
+unsigned char control_key_map_override;  // 1 = swapped, 255 = normal
+unsigned char control_fill_override;	// 1 = fill or 255 if disabled
+
+// step conditions - worked out for each part at the start of each pass
+// of the loop so that playing a step only tests a bit
+unsigned long long cond_mask[SONG_NUM_PARTS];	// steps that pass their condition
+unsigned long long fill_mask[SONG_NUM_PARTS];	// steps that only play with fill
+unsigned long long nofill_mask[SONG_NUM_PARTS];	// steps that only play without fill
+unsigned long long play_mask[SONG_NUM_PARTS];	// steps that play in this pass
+unsigned char lead_looped;				// the lead part started a pass on this tick
+unsigned int rand_state;				// seeded random generator
+
+// step recording - notes are queued by the MIDI handler and written into
+// the song from the task so that recording never holds up the clock
+#define REC_FIFO_SIZE 16
+#define REC_FIFO_MASK 0x0f
+unsigned char rec_fifo[REC_FIFO_SIZE][4];  // seq, part, step, note
+unsigned char rec_in_pos;
+unsigned char rec_out_pos;
+unsigned char rec_armed;				// parts that have recorded since the start
+unsigned long long rec_hit[SONG_NUM_PARTS];	// steps recorded in this pass of each part
+
+// seq cues - cues are queued in order and the first one starts on a tick
+// worked out when it reaches the front so the clock only has to compare
+#define CUE_FIFO_SIZE 8
+#define CUE_FIFO_MASK 0x07
+#define CUE_NONE 0xffffffff					// no cues queued
+#define CUE_LOOP_END 0xfffffffe				// start at the end of the lead's loop
+#define BEAT_TICKS 24						// clock ticks per beat
+unsigned char cue_fifo[CUE_FIFO_SIZE];
+unsigned char cue_in_pos;
+unsigned char cue_out_pos;
+unsigned int cue_deadline;				// the tick the first cue starts on
+
+// song arrangement - part 1 plays the arrangement entries in turn and
+// arr_tick holds the tick each entry starts on so that seeking and the
+// progress display don't have to follow the song from the start
+#define ARR_OFF 255
+unsigned char arr_entry;				// the entry playing or ARR_OFF
+char arr_transpose;						// the transpose of the entry playing
+unsigned char arr_restart;				// all parts restart on part 1's next step
+unsigned int arr_tick[SONG_ARR_LEN + 1];	// the start tick of each entry then the end
+
+// locate - the song is walked to a new position a few steps per task
+// pass so that a long locate doesn't hold up the timer interrupt
+#define LOCATE_STEP_BUDGET 16					// part steps walked per task pass
+#define LOCATE_NO_BUDGET 0xffffffff
+#define LOCATE_NO_TICK 0xffffffff
+unsigned char locate_active;				// the song is being walked to clock_tick_count
+unsigned int locate_tick[SONG_NUM_PARTS];	// the tick the step of each part starts on
+unsigned char locate_len[SONG_NUM_PARTS];	// the length of that step - 0 until it is taken
+unsigned char locate_done[SONG_NUM_PARTS];	// the step holds the position
+unsigned char locate_follow[SONG_NUM_PARTS];	// the part is locked to part 1 - not walked
+unsigned char locate_num_done;
+unsigned char locate_seq;					// the seq part 1 is walking
+unsigned int locate_seq_tick[SONG_NUM_SEQ];	// the tick part 1 last started each seq on
+unsigned int locate_pass_tick;				// the tick part 1 last started a pass on
+unsigned char locate_pass_loops;			// the loop count of part 1 then
+
+// event scheduler - ratchets and nudged steps are queued on a wheel of
+// slots 1/8 of a clock tick apart so that an event costs the same to
+// queue and to play no matter how many others are waiting
+#define SCHED_SUBTICKS 8						// slots per clock tick
+#define SCHED_SLOTS 256						// 32 ticks - longer than the longest step
+#define SCHED_SIZE 128						// events queued at once
+#define SCHED_NONE 255
+#define SCHED_PERIOD_DEFAULT 81				// 120 BPM in task passes
+#define SCHED_PERIOD_MAX 512				// slower than 20 BPM - the clock was stopped
+#define EV_STEP_EARLY 0						// play a step before its tick - seq, step
+#define EV_STEP_LATE 1						// play a step after its tick - seq, step
+#define EV_NOTE_ON 2						// ratchet hit - note, vel
+#define EV_NOTE_OFF 3						// gap before a ratchet hit
+typedef struct {
+	unsigned char next;					// the next event in the slot or the free list
+	unsigned char type;
+	unsigned char part;
+	unsigned char gen;					// the part gen when queued - old events are dropped
+	unsigned char a;
+	unsigned char b;
+} sched_event;
+sched_event sched_events[SCHED_SIZE];
+unsigned char sched_slot[SCHED_SLOTS];	// the first event of each slot
+unsigned char sched_free;				// the first free event
+unsigned char sched_now;				// the current slot - wraps with the wheel
+unsigned char sched_sub;				// the slot within the current tick
+unsigned int sched_passes;				// task passes since the last tick
+unsigned int tick_period;				// task passes between the last two ticks
+unsigned char part_gen[SONG_NUM_PARTS];	// counts the steps played by each part
+unsigned char note_early[SONG_NUM_PARTS];	// the note started before its tick
+unsigned char early_seq[SONG_NUM_PARTS];	// the step started before its tick or 255
+unsigned char early_step[SONG_NUM_PARTS];
+
+// local functions
+// start a note
+void sequencer_start_note(unsigned char part, unsigned char note, unsigned char vel);
+// stop a note
+void sequencer_stop_note(unsigned char part);
+// stop the notes of all parts
+void sequencer_stop_all_notes(void);
+// the clock has changed
+void sequencer_clock_changed(void);
+// play the current step of a part on its tick
+void sequencer_trigger_step(unsigned char part, unsigned char seq, unsigned char step);
+// start the steps with a negative nudge before their tick
+void sequencer_early_steps(void);
+// play the current step of a part
+void sequencer_play_step(unsigned char part, unsigned char seq, unsigned char step);
+// clear the scheduler
+void sequencer_sched_clear(void);
+// queue an event a number of slots from now
+void sequencer_sched_event(unsigned char delay, unsigned char type, unsigned char part,
+	unsigned char a, unsigned char b);
+// move to the next slot and play its events
+void sequencer_sched_next(void);
+// advance a part 1 step
+void sequencer_advance_step(unsigned char part);
+// the end of a loop is reached - figure out what to do next
+void sequencer_loop_end(unsigned char part, unsigned char len, unsigned char dir);
+// clear the seq cues
+void sequencer_cue_clear(void);
+// take the first seq cue off the queue
+unsigned char sequencer_cue_pop(void);
+// work out when the first seq cue starts
+void sequencer_cue_deadline(unsigned int now);
+// start the first seq cue on its tick
+void sequencer_cue_launch(void);
+// move a part to a new seq for a cue
+void sequencer_cue_switch(unsigned char part, unsigned char seq, unsigned char mode);
+// work out which steps of a part play in this pass of the loop
+void sequencer_eval_conds(unsigned char part);
+// work out the start tick of each arrangement entry
+void sequencer_arr_update(void);
+// get the clock ticks of a pass of part 1 through a seq
+unsigned int sequencer_arr_pass_ticks(unsigned char seq, unsigned char down);
+// apply the fill state to the steps that play in this pass
+void sequencer_apply_fill(unsigned char part);
+// compute and return the current step of a part based on dir, len, etc.
+char sequencer_compute_step(unsigned char part);
+// restart a part with the lead part's sequence
+void sequencer_sync_part(unsigned char part);
+// check if a part steps together with the lead part in its sequence
+unsigned char sequencer_part_locked(unsigned char part);
+// get the start, length, dir and step length of a part
+unsigned char sequencer_part_start(unsigned char part);
+unsigned char sequencer_part_len(unsigned char part);
+unsigned char sequencer_part_dir(unsigned char part);
+unsigned char sequencer_part_step_len(unsigned char part, unsigned char seq, unsigned char step);
+// reset song position
+void sequencer_reset_song_pos(void);
+// walk a locate - budget is the most part steps to take
+void sequencer_locate_walk(unsigned int budget);
+// skip the passes of part 1 that fit before the locate position
+void sequencer_locate_pass(void);
+
+// initialize the sequencer
+void sequencer_init(void) {
+	// clock control
+	clock_tick_count = 0;
+	note_kill_timeout = 0;
+	// step recording
+	rec_in_pos = 0;
+	rec_out_pos = 0;
+	rec_armed = 0;
+	// seq cues
+	cue_in_pos = 0;
+	cue_out_pos = 0;
+	// scheduler
+	sched_passes = 0;
+	tick_period = SCHED_PERIOD_DEFAULT;
+	// sequencer internal
+	sequencer_reset_song_pos();
+	sequencer_control_restore();
+}
+
+// run the sequencer task every 256us
+void sequencer_task(void) {
+	// note kill
+	if(note_kill_timeout) {
+		note_kill_timeout --;
+		if(note_kill_timeout == 0) {
+			sequencer_stop_all_notes();
+		}
+	}
+	// write one recorded note per pass
+	if(rec_out_pos != rec_in_pos) {
+		song_set_note(rec_fifo[rec_out_pos][0], rec_fifo[rec_out_pos][1],
+			rec_fifo[rec_out_pos][2], rec_fifo[rec_out_pos][3]);
+		rec_out_pos = (rec_out_pos + 1) & REC_FIFO_MASK;
+	}
+	// walk a locate
+	if(locate_active) sequencer_locate_walk(LOCATE_STEP_BUDGET);
+	// play the slots between the clock ticks
+	if(sched_passes < SCHED_PERIOD_MAX) sched_passes ++;
+	while(sched_sub < (SCHED_SUBTICKS - 1) &&
+			(sched_passes * SCHED_SUBTICKS) >= (tick_period * (sched_sub + 1))) {
+		sequencer_sched_next();
+	}
+}
+
+// start a note - vel is a SONG_LANE_VEL value
+void sequencer_start_note(unsigned char part, unsigned char note, unsigned char vel) {
+	unsigned char not;
+	if(part > (SONG_NUM_PARTS - 1)) return;
+	if(part < SONG_NUM_CV_PARTS && control_offset_override[part]) {
+		not = note + 12 + control_offset_override[part] + arr_transpose;  // 12-60 normal range
+	}
+	else {
+		not = note + 12 + song_get_offset(current_seq, part) + arr_transpose;  // 12-60 normal range
+	}
+	if(not < 12 || not > 115) return;
+	// send MIDI note
+	current_note[part] = not;
+	gate_time_count[part] = 0;
+	note_accent[part] = vel & SONG_LANE_ACCENT;
+	if(note_accent[part]) vel = NOTE_ACCENT_VEL;
+	else if(vel == 0) vel = NOTE_VEL;
+	_midi_tx_note_on(seq_midi_get_channel(part), current_note[part] + MIDI_NOTE_OFFSET, vel);
+	// control analog output
+	if(part < SONG_NUM_CV_PARTS) cv_output_note_on(part, current_note[part]);
+	// reset the note timeout
+	if(clock_get_song_playing()) note_kill_timeout = NOTE_KILL_TIME_RUN;
+	else note_kill_timeout = NOTE_KILL_TIME_STOP;
+}
+
+// stop a note
+void sequencer_stop_note(unsigned char part) {
+	if(part > (SONG_NUM_PARTS - 1)) return;
+	if(current_note[part] == 255) return;
+	// send MIDI note
+	_midi_tx_note_off(seq_midi_get_channel(part), current_note[part] + MIDI_NOTE_OFFSET);
+	current_note[part] = 255;
+	// control analog output
+	if(part < SONG_NUM_CV_PARTS) cv_output_note_off(part);
+}
+
+// stop the notes of all parts
+void sequencer_stop_all_notes(void) {
+	int i;
+	for(i = 0; i < SONG_NUM_PARTS; i ++) {
+		sequencer_stop_note(i);
+	}
+}
+
+// the clock has changed
+void sequencer_clock_changed(void) {
+	int i;
+	unsigned char gate, seq, step, stepped, restart;
+
+	// the first cue starts on this tick
+	if(clock_tick_count >= cue_deadline) sequencer_cue_launch();
+
+	// gate time
+	for(i = 0; i < SONG_NUM_PARTS; i ++) {
+		// notes started before the tick count from this tick
+		if(note_early[i]) {
+			note_early[i] = 0;
+			continue;
+		}
+		if(current_note[i]) {
+			gate_time_count[i] ++;
+			gate = song_get_gate(current_seq, i);
+			if(i < SONG_NUM_CV_PARTS && control_gate_override[i] != 255) {
+				gate = control_gate_override[i];
+			}
+			// accented steps can play longer on the CV outputs
+			if(i < SONG_NUM_CV_PARTS && note_accent[i]) {
+				gate += sysconfig_get_accent_gate();
+			}
+			if(gate_time_count[i] >= gate) {
+				sequencer_stop_note(i);
+			}
+		}
+	}
+
+	// step each part - part 1 leads
+	stepped = 0;
+	restart = 0;
+	lead_looped = 0;
+	for(i = 0; i < SONG_NUM_PARTS; i ++) {
+		if(i != LEAD_PART) {
+			// parts step with part 1 if they use the same settings
+			if(sequencer_part_locked(i)) {
+				if(stepped) {
+					sequencer_trigger_step(i, tracks[LEAD_PART].seq_playing,
+						tracks[LEAD_PART].step_playing);
+				}
+				tracks[i] = tracks[LEAD_PART];
+				// a new pass has its own conditions
+				if(lead_looped) sequencer_eval_conds(i);
+				continue;
+			}
+			// part 1 has started a new sequence or arrangement entry
+			if(stepped && (restart || tracks[i].seq != tracks[LEAD_PART].seq_playing)) {
+				sequencer_sync_part(i);
+			}
+		}
+
+		// next step
+		if(tracks[i].div_count == 0) {
+			if(i == LEAD_PART) {
+				stepped = 1;
+				// a new arrangement entry starts with this step
+				if(arr_restart) {
+					restart = 1;
+					arr_restart = 0;
+					arr_transpose = song_get_arr_transpose(arr_entry);
+				}
+				// stop replacing when recording is turned off
+				if(sysconfig_get_key_map() != SYSCONFIG_KEY_MAP_REC ||
+						sysconfig_get_rec_mode() != SYSCONFIG_REC_REPLACE) {
+					rec_armed = 0;
+				}
+			}
+
+			// get the current step based on the start, len and random
+			seq = tracks[i].seq;
+			step = sequencer_compute_step(i);
+			sequencer_trigger_step(i, seq, step);
+
+			// update the display positions based on the step just played
+			tracks[i].seq_playing = seq;
+			tracks[i].step_playing = step;
+			if(i == LEAD_PART) {
+				current_seq_playing = seq;
+				gui_playback_updated();
+			}
+
+			// advance the part for the next step
+			sequencer_advance_step(i);
+		}
+		tracks[i].div_count ++;
+		if(tracks[i].div_count >= sequencer_part_step_len(i,
+				tracks[i].seq_playing, tracks[i].step_playing)) {
+			tracks[i].div_count = 0;
+		}
+	}
+	sequencer_early_steps();
+	note_kill_timeout = NOTE_KILL_TIME_RUN;
+}
+
+// play the current step of a part on its tick
+void sequencer_trigger_step(unsigned char part, unsigned char seq, unsigned char step) {
+	char nudge;
+	// the step was already started before the tick
+	if(early_seq[part] == seq && early_step[part] == step) {
+		early_seq[part] = 255;
+		return;
+	}
+	early_seq[part] = 255;
+	nudge = song_get_nudge(seq, part, step);
+	if(nudge > 0) sequencer_sched_event(nudge, EV_STEP_LATE, part, seq, step);
+	else sequencer_play_step(part, seq, step);
+}
+
+// start the steps with a negative nudge before their tick
+// - the next step is only known in advance for the sequential dirs and
+//   when the lead part is not about to change sequences
+void sequencer_early_steps(void) {
+	int i;
+	unsigned char seq, step;
+	char nudge;
+	for(i = 0; i < SONG_NUM_PARTS; i ++) {
+		early_seq[i] = 255;
+		if(tracks[i].div_count != 0) continue;  // not stepping on the next tick
+		if(tracks[i].step_count == STEP_INVALID) continue;
+		if(clock_tick_count + 1 >= cue_deadline) continue;  // a cue starts on the next tick
+		if(arr_restart) continue;  // an arrangement entry starts on the next step
+		seq = tracks[i].seq;
+		if(seq != tracks[LEAD_PART].seq_playing) continue;
+		if(tracks[LEAD_PART].seq != tracks[LEAD_PART].seq_playing) continue;
+		if(sequencer_part_dir(i) == SONG_DIR_RAND) continue;
+		step = sequencer_compute_step(i);
+		nudge = song_get_nudge(seq, i, step);
+		if(nudge >= 0) continue;
+		early_seq[i] = seq;
+		early_step[i] = step;
+		sequencer_sched_event(SCHED_SUBTICKS + nudge, EV_STEP_EARLY, i, seq, step);
+	}
+}
+
+// play the current step of a part
+void sequencer_play_step(unsigned char part, unsigned char seq, unsigned char step) {
+	int note, i;
+	unsigned char value, vel, ratchet;
+	unsigned int span, hit, gap;
+	part_gen[part] ++;  // drop the ratchets left from the last step
+	// replace recording - a step reached without a note is cleared
+	if(rec_armed & (1 << part)) {
+		if(!(rec_hit[part] & (1ULL << step))) {
+			song_set_note(seq, part, step, SONG_STEP_REST);
+		}
+		rec_hit[part] &= ~(1ULL << step);
+	}
+	// arpeggiator parts play the held keys instead of the steps
+	if(sysconfig_get_arp_mode(part) != ARP_OFF) {
+		note = arp_next(part, sysconfig_get_arp_mode(part), sysconfig_get_arp_octaves(part));
+		if(note == ARP_NO_NOTE) note = SONG_STEP_REST;
+		else {
+			note -= MIDI_NOTE_OFFSET + 12;
+			while(note < 0) note += 12;
+			while(note > 48) note -= 12;
+		}
+	}
+	else note = song_get_note(seq, part, step);
+	if(note == SONG_STEP_RAND) {
+		note = (sequencer_rand() & 0x3f) % 48;
+	}
+	note = scale_span_adjust(note, song_get_span(seq, part));
+	note = scale_quantize(note, song_get_scale(seq, part));
+	// CC lanes - only changes are sent
+	for(i = 0; i < 2; i ++) {
+		value = song_get_lane(seq, part, SONG_LANE_CC1 + i, step);
+		if(value != SONG_LANE_HOLD && value != lane_cc_sent[part][i]) {
+			_midi_tx_control_change(seq_midi_get_channel(part),
+				sysconfig_get_lane_cc(i), value);
+			lane_cc_sent[part][i] = value;
+		}
+	}
+	// a step that doesn't pass its condition holds the last note
+	if(!(play_mask[part] & (1ULL << step))) note = SONG_STEP_NONE;
+	if(note == SONG_STEP_REST) {
+		sequencer_stop_note(part);
+	}
+	else if(note == SONG_STEP_NONE) {
+		// do nothing
+	}
+	else {
+		sequencer_stop_note(part);
+		vel = song_get_lane(seq, part, SONG_LANE_VEL, step);
+		sequencer_start_note(part, note, vel);
+		// ratchets - the other hits are spread evenly through the step
+		ratchet = song_get_ratchet(seq, part, step);
+		if(ratchet > 1) {
+			span = sequencer_part_step_len(part, seq, step) * SCHED_SUBTICKS;
+			if(span > (SCHED_SLOTS - 1)) span = SCHED_SLOTS - 1;
+			gap = span / (ratchet * 2);
+			for(i = 1; i < ratchet; i ++) {
+				hit = (span * i) / ratchet;
+				if(hit == 0) continue;
+				if(gap) sequencer_sched_event(hit - gap, EV_NOTE_OFF, part, 0, 0);
+				sequencer_sched_event(hit, EV_NOTE_ON, part, note, vel);
+			}
+		}
+	}
+}
+
+// clear the scheduler
+void sequencer_sched_clear(void) {
+	int i;
+	for(i = 0; i < SCHED_SLOTS; i ++) {
+		sched_slot[i] = SCHED_NONE;
+	}
+	for(i = 0; i < SCHED_SIZE; i ++) {
+		sched_events[i].next = i + 1;
+	}
+	sched_events[SCHED_SIZE - 1].next = SCHED_NONE;
+	sched_free = 0;
+	sched_now = 0;
+	sched_sub = 0;
+	for(i = 0; i < SONG_NUM_PARTS; i ++) {
+		note_early[i] = 0;
+		early_seq[i] = 255;
+	}
+}
+
+// queue an event a number of slots from now
+// - the event is dropped if the scheduler is full
+void sequencer_sched_event(unsigned char delay, unsigned char type, unsigned char part,
+		unsigned char a, unsigned char b) {
+	unsigned char ev, slot;
+	if(sched_free == SCHED_NONE) return;
+	ev = sched_free;
+	sched_free = sched_events[ev].next;
+	sched_events[ev].type = type;
+	sched_events[ev].part = part;
+	sched_events[ev].gen = part_gen[part];
+	sched_events[ev].a = a;
+	sched_events[ev].b = b;
+	slot = (sched_now + delay) & (SCHED_SLOTS - 1);
+	sched_events[ev].next = sched_slot[slot];
+	sched_slot[slot] = ev;
+}
+
+// move to the next slot and play its events
+void sequencer_sched_next(void) {
+	unsigned char ev, next, part;
+	sched_now = (sched_now + 1) & (SCHED_SLOTS - 1);
+	if(sched_sub < (SCHED_SUBTICKS - 1)) sched_sub ++;
+	else sched_sub = 0;
+	ev = sched_slot[sched_now];
+	sched_slot[sched_now] = SCHED_NONE;
+	while(ev != SCHED_NONE) {
+		next = sched_events[ev].next;
+		part = sched_events[ev].part;
+		if(sched_events[ev].gen == part_gen[part]) {
+			if(sched_events[ev].type == EV_STEP_EARLY) {
+				sequencer_play_step(part, sched_events[ev].a, sched_events[ev].b);
+				note_early[part] = 1;
+			}
+			else if(sched_events[ev].type == EV_STEP_LATE) {
+				sequencer_play_step(part, sched_events[ev].a, sched_events[ev].b);
+			}
+			else if(sched_events[ev].type == EV_NOTE_ON) {
+				sequencer_stop_note(part);
+				sequencer_start_note(part, sched_events[ev].a, sched_events[ev].b);
+			}
+			else if(sched_events[ev].type == EV_NOTE_OFF) {
+				sequencer_stop_note(part);
+			}
+		}
+		// back to the free list
+		sched_events[ev].next = sched_free;
+		sched_free = ev;
+		ev = next;
+	}
+}
+
+// advance a part 1 step
+void sequencer_advance_step(unsigned char part) {
+	track *t = &tracks[part];
+	unsigned char len = sequencer_part_len(part);
+	unsigned char dir = sequencer_part_dir(part);
+
+	// the current step has not yet been initialized
+	if(t->step_count == STEP_INVALID) {
+		sequencer_loop_end(part, len, dir);
+		return;
+	}
+
+	// pingpong
+	if(dir == SONG_DIR_PONG) {
+		// ponging (backwards)
+		if(t->pingpong & 0x01) {
+			t->step_count --;
+			// start is reached
+			if(t->step_count <= 0) {
+				t->step_count = 0;
+				t->pingpong = 0;
+				sequencer_loop_end(part, len, dir);
+			}
+		}
+		// pinging (forwards)
+		else {
+			t->step_count ++;
+			// len is reached
+			if(t->step_count >= len - 1) {
+				t->step_count = len - 1;
+				t->pingpong = 1;
+				sequencer_loop_end(part, len, dir);
+			}
+		}
+	}
+	// go forwards / randomly
+	else if(dir == SONG_DIR_FWD || dir == SONG_DIR_RAND) {
+		t->step_count ++;
+		// len is reached
+		if(t->step_count > (len - 1)) {
+			t->step_count = 0;
+			sequencer_loop_end(part, len, dir);
+		}
+	}
+	// go backwards
+	else if(dir == SONG_DIR_BACK) {
+		t->step_count --;
+		// start is reached
+		if(t->step_count < 0) {
+			t->step_count = len - 1;
+			sequencer_loop_end(part, len, dir);
+		}
+	}
+}
+
+// the end of a loop is reached - figure out what to do next
+void sequencer_loop_end(unsigned char part, unsigned char len, unsigned char dir) {
+	track *t = &tracks[part];
+
+	// the other parts just loop - they are started again when part 1
+	// changes sequence
+	if(part != LEAD_PART) {
+		if(t->step_count == STEP_INVALID) {
+			t->pingpong = 0;
+			t->loop_count = 0;
+			// for backwards we start on the last step
+			if(dir == SONG_DIR_BACK) t->step_count = len - 1;
+			// for forwards we start on step 0
+			else t->step_count = 0;
+		}
+		else if(t->loop_count < 255) t->loop_count ++;
+		sequencer_eval_conds(part);
+		return;
+	}
+	lead_looped = 1;
+
+	// step is invalid from the reset - cause sequence to reload
+	if(t->step_count == STEP_INVALID) {
+		current_seq = 254;
+	}
+	// we've reached a loop end
+	else {
+		t->loop_count ++;
+		// cues wait for the end of the loop
+		if(next_cued_seq == 255 && cue_deadline == CUE_LOOP_END) {
+			next_cued_seq = sequencer_cue_pop();
+		}
+		// a cue leaves the arrangement
+		if(next_cued_seq != 255) {
+			arr_entry = ARR_OFF;
+			arr_transpose = 0;
+		}
+		// the entry has been repeated - restart part 1 with the next entry
+		// even if it plays the same seq
+		else if(arr_entry != ARR_OFF) {
+			if(t->loop_count >= song_get_arr_repeat(arr_entry)) {
+				arr_entry ++;
+				if(arr_entry >= song_get_arr_len()) arr_entry = 0;
+				next_cued_seq = song_get_arr_seq(arr_entry);
+				current_seq = 254;
+				arr_restart = 1;
+				// the arrangement was cleared while playing
+				if(song_get_arr_len() == 0) {
+					next_cued_seq = 255;
+					arr_entry = ARR_OFF;
+				}
+			}
+		}
+		// number of loops is exceeded
+		else if(t->loop_count > song_get_seq_loop(current_seq)) {
+			next_cued_seq = song_get_seq_next(current_seq);
+		}
+	}
+
+	// if the cued seq is not the one we're on
+	if((next_cued_seq != 255) & (next_cued_seq != current_seq)) {
+		current_seq = next_cued_seq;
+		t->seq = current_seq;
+		t->pingpong = 0;
+		t->loop_count = 0;
+
+		// length and direction of the new sequence
+		unsigned char new_len = sequencer_part_len(part);
+		unsigned char new_dir = sequencer_part_dir(part);
+
+		// for backwards we start on the last step
+		if(new_dir == SONG_DIR_BACK) {
+			t->step_count = new_len - 1;
+		}
+		// for forwards we start on step 0
+		else {
+			t->step_count = 0;
+		}
+	}
+	next_cued_seq = 255;
+	sequencer_eval_conds(part);
+}
+
+// clear the seq cues
+void sequencer_cue_clear(void) {
+	cue_out_pos = cue_in_pos;
+	cue_deadline = CUE_NONE;
+}
+
+// take the first seq cue off the queue
+unsigned char sequencer_cue_pop(void) {
+	unsigned char seq = cue_fifo[cue_out_pos];
+	cue_out_pos = (cue_out_pos + 1) & CUE_FIFO_MASK;
+	// the next cue can't start before the next tick
+	sequencer_cue_deadline(clock_tick_count + 1);
+	return seq;
+}
+
+// work out when the first seq cue starts
+// - now is the first tick it can start on
+void sequencer_cue_deadline(unsigned int now) {
+	unsigned char mode = sysconfig_get_launch_mode();
+	unsigned int quantum;
+	if(cue_out_pos == cue_in_pos) {
+		cue_deadline = CUE_NONE;
+		return;
+	}
+	if(mode == SYSCONFIG_LAUNCH_LOOP) {
+		cue_deadline = CUE_LOOP_END;
+		return;
+	}
+	// round up to the next beat or bar - bars are counted in master clock steps
+	if(mode == SYSCONFIG_LAUNCH_BEAT) quantum = BEAT_TICKS;
+	else if(mode == SYSCONFIG_LAUNCH_BAR) {
+		quantum = sysconfig_get_launch_bar() * sysconfig_get_clock_div();
+	}
+	else quantum = 1;
+	cue_deadline = ((now + quantum - 1) / quantum) * quantum;
+}
+
+// start the first seq cue on its tick
+void sequencer_cue_launch(void) {
+	int i;
+	unsigned char seq, mode;
+	seq = sequencer_cue_pop();
+	mode = sysconfig_get_switch_mode();
+	current_seq = seq;
+	next_cued_seq = 255;
+	arr_entry = ARR_OFF;
+	arr_transpose = 0;
+	// every part moves now so the other parts don't wait for part 1 to step
+	for(i = 0; i < SONG_NUM_PARTS; i ++) {
+		sequencer_cue_switch(i, seq, mode);
+	}
+}
+
+// move a part to a new seq for a cue
+void sequencer_cue_switch(unsigned char part, unsigned char seq, unsigned char mode) {
+	track *t = &tracks[part];
+	unsigned char len, dir, div;
+	unsigned int pos;
+	t->seq = seq;
+	t->loop_count = 0;
+	t->pingpong = 0;
+	len = sequencer_part_len(part);
+	dir = sequencer_part_dir(part);
+	// legato keeps the step index and the time through the step
+	if(mode == SYSCONFIG_SWITCH_LEGATO && t->step_count != STEP_INVALID) {
+		t->step_count %= len;
+	}
+	else {
+		pos = 0;
+		t->div_count = 0;
+		// phase puts the part where it would be if it had played the
+		// new seq since the start of the song
+		if(mode == SYSCONFIG_SWITCH_PHASE) {
+			div = song_get_part_div(seq, part);
+			if(div == SONG_PART_FOLLOW) div = sysconfig_get_clock_div();
+			t->div_count = clock_tick_count % div;
+			pos = clock_tick_count / div;
+			// part way through a step - the next step is the one after it
+			if(t->div_count) pos ++;
+			pos %= len;
+		}
+		// for backwards we count from the last step
+		if(dir == SONG_DIR_BACK) t->step_count = len - 1 - pos;
+		else t->step_count = pos;
+	}
+	sequencer_eval_conds(part);
+}
+
+// work out the start tick of each arrangement entry
+//
+// - the passes of each seq are only added up once
+// - the control overrides are not counted
+//
+void sequencer_arr_update(void) {
+	unsigned int pass[SONG_NUM_SEQ][2];
+	unsigned char seq, repeat;
+	int i;
+	for(i = 0; i < SONG_NUM_SEQ; i ++) {
+		pass[i][0] = 0;
+	}
+	arr_tick[0] = 0;
+	for(i = 0; i < song_get_arr_len(); i ++) {
+		seq = song_get_arr_seq(i);
+		repeat = song_get_arr_repeat(i);
+		if(pass[seq][0] == 0) {
+			pass[seq][0] = sequencer_arr_pass_ticks(seq, 0);
+			pass[seq][1] = sequencer_arr_pass_ticks(seq, 1);
+		}
+		// pong passes go up and down in turn
+		arr_tick[i + 1] = arr_tick[i] + (((repeat + 1) >> 1) * pass[seq][0]) +
+			((repeat >> 1) * pass[seq][1]);
+	}
+}
+
+// get the clock ticks of a pass of part 1 through a seq
+//
+// - pong passes leave out the step they turn on - down passes start
+//   one step later
+// - random passes are counted as if each step played once
+//
+unsigned int sequencer_arr_pass_ticks(unsigned char seq, unsigned char down) {
+	unsigned char start, len, dir, steps, first, count;
+	unsigned int ticks = 0;
+	int i;
+	start = song_get_part_start(seq, LEAD_PART);
+	if(start == SONG_PART_FOLLOW) start = song_get_seq_start(seq);
+	len = song_get_part_len(seq, LEAD_PART);
+	if(len == SONG_PART_FOLLOW) len = song_get_seq_len(seq);
+	dir = song_get_part_dir(seq, LEAD_PART);
+	if(dir == SONG_PART_FOLLOW) dir = song_get_seq_dir(seq);
+	steps = song_get_seq_steps(seq);
+	first = 0;
+	count = len;
+	if(dir == SONG_DIR_PONG && len > 1) {
+		count = len - 1;
+		if(down) first = 1;
+	}
+	for(i = 0; i < count; i ++) {
+		ticks += sequencer_part_step_len(LEAD_PART, seq, (start + first + i) % steps);
+	}
+	return ticks;
+}
+
+// work out which steps of a part play in this pass of the loop
+void sequencer_eval_conds(unsigned char part) {
+	track *t = &tracks[part];
+	unsigned char i, cond, of;
+	unsigned long long bit;
+	cond_mask[part] = ~0ULL;
+	fill_mask[part] = 0;
+	nofill_mask[part] = 0;
+	if(song_has_conds(t->seq, part)) {
+		for(i = 0; i < song_get_seq_steps(t->seq); i ++) {
+			cond = song_get_cond(t->seq, part, i);
+			if(cond == SONG_COND_ALWAYS) continue;
+			bit = 1ULL << i;
+			if(cond & SONG_COND_RATIO) {
+				of = ((cond >> 3) & 0x07) + 1;
+				if((t->loop_count % of) != (cond & 0x07)) cond_mask[part] &= ~bit;
+			}
+			else if(cond <= SONG_COND_MAX_PROB) {
+				if((sequencer_rand() % 100) >= cond) cond_mask[part] &= ~bit;
+			}
+			else if(cond == SONG_COND_FIRST) {
+				if(t->loop_count != 0) cond_mask[part] &= ~bit;
+			}
+			else if(cond == SONG_COND_NOT_FIRST) {
+				if(t->loop_count == 0) cond_mask[part] &= ~bit;
+			}
+			else if(cond == SONG_COND_FILL) fill_mask[part] |= bit;
+			else if(cond == SONG_COND_NOT_FILL) nofill_mask[part] |= bit;
+		}
+	}
+	sequencer_apply_fill(part);
+}
+
+// apply the fill state to the steps that play in this pass
+void sequencer_apply_fill(unsigned char part) {
+	if(control_fill_override == 1) play_mask[part] = cond_mask[part] & ~nofill_mask[part];
+	else play_mask[part] = cond_mask[part] & ~fill_mask[part];
+}
+
+// get a random number from the seeded generator - xorshift
+unsigned int sequencer_rand(void) {
+	rand_state ^= rand_state << 13;
+	rand_state ^= rand_state >> 17;
+	rand_state ^= rand_state << 5;
+	return rand_state;
+}
+
+// compute and return the current step of a part based on dir, len, etc.
+char sequencer_compute_step(unsigned char part) {
+	char temp;
+	unsigned char start = sequencer_part_start(part);
+	char steps = song_get_seq_steps(tracks[part].seq);
+
+	// go randomly
+	if(sequencer_part_dir(part) == SONG_DIR_RAND) {
+		temp = ((sequencer_rand() >> 4) % sequencer_part_len(part)) + start;
+	}
+	// go sequentially
+	else {
+		temp = tracks[part].step_count + start;
+	}
+
+	// clamp the step index range because it wraps around for start/len offsets
+	// - the seq can be made shorter while it plays
+	while(temp > (steps - 1)) temp -= steps;
+	while(temp < 0) temp += steps;
+
+	return temp;
+}
+
+// restart a part with the sequence part 1 is playing
+void sequencer_sync_part(unsigned char part) {
+	tracks[part].seq = tracks[LEAD_PART].seq_playing;
+	tracks[part].div_count = 0;
+	tracks[part].step_count = STEP_INVALID;
+	sequencer_advance_step(part);
+}
+
+// check if a part steps together with part 1 in the sequence part 1 is playing
+unsigned char sequencer_part_locked(unsigned char part) {
+	unsigned char seq = tracks[LEAD_PART].seq_playing;
+	if(song_get_part_start(seq, LEAD_PART) != song_get_part_start(seq, part)) return 0;
+	if(song_get_part_len(seq, LEAD_PART) != song_get_part_len(seq, part)) return 0;
+	if(song_get_part_dir(seq, LEAD_PART) != song_get_part_dir(seq, part)) return 0;
+	if(song_get_part_div(seq, LEAD_PART) != song_get_part_div(seq, part)) return 0;
+	return 1;
+}
+
+// get the start of a part
+unsigned char sequencer_part_start(unsigned char part) {
+	unsigned char start;
+	if(control_start_override != 255) {
+		return (control_start_override * song_get_seq_steps(tracks[part].seq)) >> 4;
+	}
+	start = song_get_part_start(tracks[part].seq, part);
+	if(start == SONG_PART_FOLLOW) start = song_get_seq_start(tracks[part].seq);
+	return start;
+}
+
+// get the length of a part
+unsigned char sequencer_part_len(unsigned char part) {
+	unsigned char len;
+	if(control_len_override != 255) {
+		return (control_len_override * song_get_seq_steps(tracks[part].seq)) >> 4;
+	}
+	len = song_get_part_len(tracks[part].seq, part);
+	if(len == SONG_PART_FOLLOW) len = song_get_seq_len(tracks[part].seq);
+	return len;
+}
+
+// get the direction of a part
+unsigned char sequencer_part_dir(unsigned char part) {
+	unsigned char dir = song_get_part_dir(tracks[part].seq, part);
+	if(dir == SONG_PART_FOLLOW) dir = song_get_seq_dir(tracks[part].seq);
+	if(control_dir_override == 1) {
+		// flip directions for forward / backward
+		if(dir == SONG_DIR_FWD) dir = SONG_DIR_BACK;
+		else if(dir == SONG_DIR_BACK) dir = SONG_DIR_FWD;
+	}
+	return dir;
+}
+
+// get the length of a step of a part in clock ticks
+unsigned char sequencer_part_step_len(unsigned char part, unsigned char seq, unsigned char step) {
+	unsigned char len = song_get_step_len(seq, step);
+	// a step len of >0 overrides the clock divide
+	if(len) return len;
+	// otherwise use the part or the master clock div
+	len = song_get_part_div(seq, part);
+	if(len != SONG_PART_FOLLOW) return len;
+	return sysconfig_get_clock_div();
+}
+
+// reset song position
+void sequencer_reset_song_pos(void) {
+	int i;
+	clock_tick_count = 0;  // reset the song position
+	locate_active = 0;  // drop a locate being walked
+	sequencer_sched_clear();  // drop the queued ratchets and nudged steps
+	sequencer_cue_clear();  // drop the queued seq cues
+	// a seed plays the same random steps each time
+	if(sysconfig_get_rand_seed() || rand_state == 0) {
+		rand_state = 0x9e3779b9 ^ sysconfig_get_rand_seed();
+	}
+	// reset the sequence only
+	if(sysconfig_get_reset_mode() == SYSCONFIG_RESET_MODE_SEQ) {
+		next_cued_seq = current_seq;
+	}
+	// reset the entire song
+	else {
+		next_cued_seq = 0;  // next cued sequence is 0
+	}
+	// the arrangement plays from the start of the song
+	arr_entry = ARR_OFF;
+	arr_transpose = 0;
+	arr_restart = 0;
+	if(song_get_arr_len() && sysconfig_get_reset_mode() != SYSCONFIG_RESET_MODE_SEQ) {
+		sequencer_arr_update();
+		arr_entry = 0;
+		arr_transpose = song_get_arr_transpose(0);
+		next_cued_seq = song_get_arr_seq(0);
+	}
+	current_seq_playing = next_cued_seq;
+	tracks[LEAD_PART].div_count = 0;
+	tracks[LEAD_PART].step_count = STEP_INVALID;  // invalidate the current position
+	tracks[LEAD_PART].loop_count = 0;
+	tracks[LEAD_PART].pingpong = 0;
+	sequencer_advance_step(LEAD_PART);
+	for(i = 0; i < SONG_NUM_PARTS; i ++) {
+		if(i != LEAD_PART) sequencer_sync_part(i);
+		tracks[i].seq_playing = current_seq;
+		tracks[i].step_playing = sequencer_compute_step(i);
+		current_note[i] = 255;  // disabled
+		gate_time_count[i] = 0;
+		lane_cc_sent[i][0] = 255;  // send the first CC lane values
+		lane_cc_sent[i][1] = 255;
+	}
+	arp_reset(0);
+	arp_reset(1);
+	gui_playback_updated();
+}
+
+//
+// MIDI / analog clock handlers
+//
+// set song position
+void sequencer_midi_song_pos(unsigned int pos) {
+	_midi_tx_song_position(pos);  // send song position pointer
+	sequencer_locate(pos);
+	sequencer_locate_walk(LOCATE_NO_BUDGET);
+}
+
+// start walking the song to a position in 16th notes
+//
+// - all parts are stepped through the song in time order so that the
+//   other parts are started with each new sequence at the same tick as
+//   they are when playing
+// - parts locked to part 1 are not walked - they are set from part 1
+//   when the walk is done
+// - songs with an arrangement start at the entry holding the position
+//   and loop when the end of the arrangement is passed
+// - songs without one skip whole turns of the sequence chain once part 1
+//   comes back to a sequence it has started before, and whole passes of
+//   a sequence that repeats forever when all the parts are locked
+// - the walk is done a few steps per task pass - the song doesn't play
+//   until it is done
+//
+void sequencer_locate(unsigned int pos) {
+	unsigned int start, tick;
+	int i;
+	sequencer_reset_song_pos();  // reset the song
+	clock_tick_count = pos * 6;  // calculate the desired clock tick offset
+	start = 0;
+	if(arr_entry != ARR_OFF && arr_tick[song_get_arr_len()]) {
+		tick = clock_tick_count % arr_tick[song_get_arr_len()];
+		while(arr_tick[arr_entry + 1] <= tick) arr_entry ++;
+		start = clock_tick_count - (tick - arr_tick[arr_entry]);
+		arr_transpose = song_get_arr_transpose(arr_entry);
+		// restart all parts on the entry
+		next_cued_seq = song_get_arr_seq(arr_entry);
+		tracks[LEAD_PART].step_count = STEP_INVALID;
+		sequencer_advance_step(LEAD_PART);
+		tracks[LEAD_PART].seq_playing = current_seq;
+		for(i = 0; i < SONG_NUM_PARTS; i ++) {
+			if(i != LEAD_PART) sequencer_sync_part(i);
+		}
+	}
+	locate_num_done = 0;
+	for(i = 0; i < SONG_NUM_PARTS; i ++) {
+		locate_tick[i] = start;
+		locate_len[i] = 0;
+		locate_done[i] = 0;
+		locate_follow[i] = (i != LEAD_PART && sequencer_part_locked(i));
+		if(locate_follow[i]) {
+			locate_done[i] = 1;
+			locate_num_done ++;
+		}
+	}
+	for(i = 0; i < SONG_NUM_SEQ; i ++) {
+		locate_seq_tick[i] = LOCATE_NO_TICK;
+	}
+	locate_seq = tracks[LEAD_PART].seq;
+	locate_seq_tick[locate_seq] = start;
+	locate_pass_tick = LOCATE_NO_TICK;
+	locate_active = 1;
+}
+
+// move a locate that is being walked on to a later position
+void sequencer_locate_update(unsigned int pos) {
+	int i;
+	if(!locate_active || (pos * 6) <= clock_tick_count) return;
+	clock_tick_count = pos * 6;
+	// parts whose step no longer holds the position carry on
+	for(i = 0; i < SONG_NUM_PARTS; i ++) {
+		if(locate_done[i] && !locate_follow[i] &&
+				(locate_tick[i] + locate_len[i]) <= clock_tick_count) {
+			locate_done[i] = 0;
+			locate_num_done --;
+		}
+	}
+}
+
+// check if a locate is being walked
+unsigned char sequencer_locating(void) {
+	return locate_active;
+}
+
+// walk a locate - budget is the most part steps to take
+void sequencer_locate_walk(unsigned int budget) {
+	unsigned char seq, step, restart;
+	unsigned int period, skip;
+	int i, j;
+	while(locate_num_done < SONG_NUM_PARTS) {
+		if(budget == 0) return;
+		budget --;
+		// the part with the earliest step goes next - part 1 goes first
+		// if several parts step at once
+		i = -1;
+		for(j = 0; j < SONG_NUM_PARTS; j ++) {
+			if(locate_done[j]) continue;
+			if(i == -1 || locate_tick[j] < locate_tick[i]) i = j;
+		}
+		// get the current step based on the start, len and random
+		if(locate_len[i] == 0) {
+			// the other parts start each new sequence or arrangement entry with part 1
+			if(i == LEAD_PART) {
+				restart = arr_restart;
+				arr_restart = 0;
+				if(restart) arr_transpose = song_get_arr_transpose(arr_entry);
+				for(j = 0; j < SONG_NUM_PARTS; j ++) {
+					if(j == LEAD_PART || (!restart && tracks[j].seq == tracks[LEAD_PART].seq)) continue;
+					tracks[LEAD_PART].seq_playing = tracks[LEAD_PART].seq;
+					sequencer_sync_part(j);
+					locate_tick[j] = locate_tick[LEAD_PART];
+					locate_len[j] = 0;
+					if(locate_done[j]) locate_num_done --;
+					locate_done[j] = 0;
+					locate_follow[j] = sequencer_part_locked(j);
+					if(locate_follow[j]) {
+						locate_done[j] = 1;
+						locate_num_done ++;
+					}
+				}
+				// the song is back at a sequence it started before - skip
+				// the whole turns of the chain that fit before the position
+				seq = tracks[LEAD_PART].seq;
+				if(arr_entry == ARR_OFF && seq != locate_seq) {
+					if(locate_seq_tick[seq] != LOCATE_NO_TICK) {
+						period = locate_tick[LEAD_PART] - locate_seq_tick[seq];
+						skip = ((clock_tick_count - locate_tick[LEAD_PART]) / period) * period;
+						for(j = 0; j < SONG_NUM_PARTS; j ++) {
+							locate_tick[j] += skip;
+						}
+						for(j = 0; j < SONG_NUM_SEQ; j ++) {
+							locate_seq_tick[j] = LOCATE_NO_TICK;
+						}
+					}
+					locate_seq_tick[seq] = locate_tick[LEAD_PART];
+					locate_seq = seq;
+					locate_pass_tick = LOCATE_NO_TICK;
+				}
+			}
+			seq = tracks[i].seq;
+			step = sequencer_compute_step(i);
+			locate_len[i] = sequencer_part_step_len(i, seq, step);
+			tracks[i].seq_playing = seq;
+			tracks[i].step_playing = step;
+		}
+		// this step holds the position
+		if(locate_tick[i] + locate_len[i] > clock_tick_count) {
+			locate_done[i] = 1;
+			locate_num_done ++;
+		}
+		// add the step length
+		else {
+			locate_tick[i] += locate_len[i];
+			locate_len[i] = 0;
+			lead_looped = 0;
+			sequencer_advance_step(i);  // move to the next step
+			if(i == LEAD_PART && lead_looped) sequencer_locate_pass();
+		}
+		ClearWDT();
+	}
+	// start the parts part way through the steps holding the position
+	locate_active = 0;
+	for(i = 0; i < SONG_NUM_PARTS; i ++) {
+		if(locate_follow[i]) continue;
+		tracks[i].div_count = clock_tick_count - locate_tick[i];
+		// the step has already started so it won't be played again
+		if(tracks[i].div_count) sequencer_advance_step(i);
+	}
+	for(i = 0; i < SONG_NUM_PARTS; i ++) {
+		if(i != LEAD_PART && sequencer_part_locked(i)) {
+			tracks[i] = tracks[LEAD_PART];
+			sequencer_eval_conds(i);
+		}
+	}
+	current_seq_playing = tracks[LEAD_PART].seq_playing;
+	gui_playback_updated();
+}
+
+// skip the passes of part 1 that fit before the locate position
+// - only when part 1 steps in order through a seq that repeats forever
+//   and the other parts are locked to it so that every pass takes the
+//   same time
+void sequencer_locate_pass(void) {
+	track *t = &tracks[LEAD_PART];
+	unsigned int period, passes;
+	int i;
+	if(arr_entry != ARR_OFF || t->seq != locate_seq || t->pingpong) return;
+	if(song_get_seq_next(t->seq) != t->seq) return;
+	if(sequencer_part_dir(LEAD_PART) == SONG_DIR_RAND) return;
+	for(i = 0; i < SONG_NUM_PARTS; i ++) {
+		if(i != LEAD_PART && !locate_follow[i]) return;
+	}
+	// wait for a second pass to measure it
+	if(locate_pass_tick == LOCATE_NO_TICK) {
+		locate_pass_tick = locate_tick[LEAD_PART];
+		locate_pass_loops = t->loop_count;
+		return;
+	}
+	period = locate_tick[LEAD_PART] - locate_pass_tick;
+	passes = (clock_tick_count - locate_tick[LEAD_PART]) / period;
+	locate_tick[LEAD_PART] += passes * period;
+	t->loop_count += passes * (unsigned char)(t->loop_count - locate_pass_loops);
+	locate_pass_tick = LOCATE_NO_TICK;
+	if(passes) sequencer_eval_conds(LEAD_PART);
+}
+
+//
+// MIDI/analog control handlers
+//
+// clock pulse was received
+void sequencer_clock_tick(void) {
+	if(control_run_override == 1 || locate_active) return;
+	// play the slots left in the last tick and measure the tick period
+	while(sched_sub < (SCHED_SUBTICKS - 1)) sequencer_sched_next();
+	if(sched_passes < SCHED_PERIOD_MAX) tick_period = sched_passes;
+	sched_passes = 0;
+	sequencer_sched_next();
+	sequencer_clock_changed(); 
+	clock_tick_count ++;
+}
+
+// start song at beginning
+void sequencer_clock_start(void) {
+	sequencer_stop_all_notes();
+	sequencer_reset_song_pos();
+}
+
+// stop song
+void sequencer_clock_stop(void) {
+	int i;
+	sequencer_sched_clear();
+	sequencer_stop_all_notes();
+	for(i = 0; i < SONG_NUM_PARTS; i ++) {
+		_midi_tx_control_change(seq_midi_get_channel(i), 123, 0);
+	}
+	rec_armed = 0;
+}
+
+// get the current clock div count
+unsigned char sequencer_get_clock_div_count(void) {
+	return tracks[0].div_count;
+}
+
+// get the clock ticks since the start of the song
+unsigned int sequencer_get_clock_tick_count(void) {
+	return clock_tick_count;
+}
+
+//
+// external control of sequence
+//
+// record a MIDI note into a part of the playing sequence
+void sequencer_record_note(unsigned char part, unsigned char note) {
+	unsigned char seq, step, step_len, elapsed;
+	int value;
+	if(part > (SONG_NUM_PARTS - 1)) return;
+	if(!clock_get_song_playing()) return;
+	if(((rec_in_pos + 1) & REC_FIFO_MASK) == rec_out_pos) return;  // full
+
+	// replace mode starts clearing from the first note recorded
+	if(sysconfig_get_rec_mode() == SYSCONFIG_REC_REPLACE &&
+			!(rec_armed & (1 << part))) {
+		rec_hit[part] = 0;
+		rec_armed |= (1 << part);
+	}
+
+	// quantize to the nearest step - the next step has already been
+	// computed so it is only known in advance for the sequential dirs
+	step_len = sequencer_part_step_len(part, tracks[part].seq_playing,
+		tracks[part].step_playing);
+	if(tracks[part].div_count) elapsed = tracks[part].div_count - 1;
+	else elapsed = step_len - 1;
+	if((elapsed << 1) < step_len || tracks[part].step_count == STEP_INVALID ||
+			sequencer_part_dir(part) == SONG_DIR_RAND) {
+		seq = tracks[part].seq_playing;
+		step = tracks[part].step_playing;
+	}
+	else {
+		seq = tracks[part].seq;
+		step = sequencer_compute_step(part);
+		rec_hit[part] |= (1ULL << step);  // don't clear it when it starts
+	}
+
+	// convert the MIDI note to a raw step note - the span is applied on playback
+	value = note - MIDI_NOTE_OFFSET - 12;
+	if(part < SONG_NUM_CV_PARTS && control_offset_override[part]) {
+		value -= control_offset_override[part];
+	}
+	else value -= song_get_offset(seq, part);
+	while(value < 0) value += 12;
+	while(value > 48) value -= 12;
+
+	rec_fifo[rec_in_pos][0] = seq;
+	rec_fifo[rec_in_pos][1] = part;
+	rec_fifo[rec_in_pos][2] = step;
+	rec_fifo[rec_in_pos][3] = value;
+	rec_in_pos = (rec_in_pos + 1) & REC_FIFO_MASK;
+}
+
+// MIDI key trigger
+void sequencer_key_trigger(unsigned char seq) {
+	if(seq > SONG_NUM_SEQ) return;
+	sequencer_set_next_seq(seq);
+	clock_run_command();  // make sure we start if we're stopped
+}
+
+// MIDI key transpose
+void sequencer_key_transpose(char transpose) {
+	unsigned char assign = sysconfig_get_key_transpose();
+	if(transpose < -12 || transpose > 12) return;
+
+	if(assign == SYSCONFIG_KEY_TRANSPOSE12) {
+		control_offset_override[0] = transpose;
+		control_offset_override[1] = transpose;
+	}
+	else if(assign == SYSCONFIG_KEY_TRANSPOSE1) {
+		control_offset_override[0] = transpose;
+	}
+	else if(assign == SYSCONFIG_KEY_TRANSPOSE2) {
+		control_offset_override[1] = transpose;
+	}
+}
+
+// MIDI/analog control change was received
+// send values from 0-127 to here
+void sequencer_control_change(unsigned char mod, unsigned char value) {
+	int i;
+	if(value > 127) return;
+
+	// next sequence
+	if(mod == SYSCONFIG_MOD_NEXT_SEQ) {
+		sequencer_set_next_seq(value >> 3);
+	}
+	// sequence start
+	else if(mod == SYSCONFIG_MOD_SEQ_START) {
+		control_start_override = (value >> 3);
+	}
+	// sequence len
+	else if(mod == SYSCONFIG_MOD_SEQ_LEN) {
+		control_len_override = (value >> 3) + 1;
+	}
+	// sequence run/stop
+	else if(mod == SYSCONFIG_MOD_RUN_STOP) {
+		// stop
+		if(value < 64) {
+			if(control_run_override == 255) {
+				clock_stop_command();
+				control_run_override = 1;
+			}
+		}
+		else {
+			if(control_run_override == 1) {
+				clock_run_command();
+				control_run_override = 255;
+			}
+		}
+	}
+	// gate 1 length
+	else if(mod == SYSCONFIG_MOD_GATE1) {
+		control_gate_override[0] = (value >> 2) + 1;
+	}
+	// gate 2 length
+	else if(mod == SYSCONFIG_MOD_GATE2) {
+		control_gate_override[1] = (value >> 2) + 1;
+	}
+	// dir
+	else if(mod == SYSCONFIG_MOD_SEQ_DIR) {
+		if(value < 64) control_dir_override = 255;
+		else control_dir_override = 1;
+	}
+	// key map - this is special and not part of the normal group
+	else if(mod == SYSCONFIG_MOD_KEY_MAP) {
+		if(value < 64) control_key_map_override = 255;
+		else control_key_map_override = 1;
+	}
+	// fill
+	else if(mod == SYSCONFIG_MOD_FILL) {
+		if(value < 64) control_fill_override = 255;
+		else control_fill_override = 1;
+		for(i = 0; i < SONG_NUM_PARTS; i ++) {
+			sequencer_apply_fill(i);
+		}
+	}
+	// not recognized mod
+	else {
+		return;
+	}
+
+	// blink the mod led
+	panel_set_mod_led(MOD_LED_TIMEOUT);
+
+	// send event about the updated status
+	gui_control_override_updated();
+}
+
+// get a control override value
+// returns values in the local range
+unsigned char sequencer_get_control_override(unsigned char mod) {
+	// next sequence
+	if(mod == SYSCONFIG_MOD_NEXT_SEQ) { 
+		// not supported
+	}
+	// sequence start
+	else if(mod == SYSCONFIG_MOD_SEQ_START) {
+		if(control_start_override != 255) {
+			return control_start_override;
+		}
+	}
+	// sequence len
+	else if(mod == SYSCONFIG_MOD_SEQ_LEN) {
+		if(control_len_override != 255) {
+			return control_len_override;
+		}
+	}
+	// sequence run/stop
+	else if(mod == SYSCONFIG_MOD_RUN_STOP) {
+		if(control_run_override != 255) {
+			return 0;
+		}
+	}
+	// gate 1 length
+	else if(mod == SYSCONFIG_MOD_GATE1) {
+		if(control_gate_override[0]) {
+			return control_gate_override[0];
+		}
+	}
+	// gate 2 length
+	else if(mod == SYSCONFIG_MOD_GATE2) {
+		if(control_gate_override[1]) {
+			return control_gate_override[1];
+		}
+	}
+	// dir
+	else if(mod == SYSCONFIG_MOD_SEQ_DIR) {
+		if(control_dir_override != 255) {
+			return control_dir_override;
+		}
+	}
+	// keymap
+	else if(mod == SYSCONFIG_MOD_KEY_MAP) {
+		if(control_key_map_override != 255) {
+			return control_key_map_override;
+		}
+	}
+	// fill
+	else if(mod == SYSCONFIG_MOD_FILL) {
+		if(control_fill_override != 255) {
+			return control_fill_override;
+		}
+	}
+	return 255;
+}
+
+// restore the current CC / key overrides to the default value
+void sequencer_control_restore(void) {
+	int i;
+	control_start_override = 255;  // disabled
+	control_len_override = 255;  // disabled
+	control_gate_override[0] = 255;  // disabled
+	control_gate_override[1] = 255;  // disabled
+	control_dir_override = 255;  // disabled
+	control_offset_override[0] = 0;  // disabled
+	control_offset_override[1] = 0;  // disabled
+	control_run_override = 255;  // disabled
+	control_key_map_override = 255;  // disabled
+	control_fill_override = 255;  // disabled
+	for(i = 0; i < SONG_NUM_PARTS; i ++) {
+		sequencer_apply_fill(i);
+	}
+	gui_control_override_updated();
+}
+
+// restore the run/stop override to panel control
+void sequencer_control_run_stop_restore(void) {
+	control_run_override = 255;  // disabled
+	gui_control_override_updated();
+}
+
+// get the current sequence
+unsigned char sequencer_get_current_seq(void) {
+	return current_seq_playing;
+}
+
+// get the arrangement entry playing - 255 if the arrangement is not playing
+unsigned char sequencer_get_arr_entry(void) {
+	return arr_entry;
+}
+
+// get how far through the arrangement the song is - 0-99 percent
+unsigned char sequencer_get_arr_progress(void) {
+	unsigned int len;
+	if(arr_entry == ARR_OFF) return 0;
+	len = arr_tick[song_get_arr_len()];
+	if(len == 0) return 0;
+	return ((clock_tick_count % len) * 100) / len;
+}
+
+// set the current sequence
+void sequencer_set_next_seq(unsigned char seq) {
+	int i;
+	unsigned char next;
+	if(seq > (SONG_NUM_SEQ - 1)) return;
+
+	// if the song is playing, queue it to start when the launch mode says
+	if(clock_get_song_playing()) {
+		next = (cue_in_pos + 1) & CUE_FIFO_MASK;
+		// the queue is full - the newest cue is replaced
+		if(next == cue_out_pos) {
+			cue_fifo[(cue_in_pos - 1) & CUE_FIFO_MASK] = seq;
+			return;
+		}
+		cue_fifo[cue_in_pos] = seq;
+		cue_in_pos = next;
+		// the first cue needs a start tick
+		if(cue_deadline == CUE_NONE) sequencer_cue_deadline(clock_tick_count);
+	}
+	// otherwise reset everything and set it immediately
+	else {
+		sequencer_reset_song_pos();
+		// if we have to force another sequence to change
+		if(seq != current_seq) {
+			next_cued_seq = seq;
+			arr_entry = ARR_OFF;  // leave the arrangement
+			arr_transpose = 0;
+			tracks[LEAD_PART].step_count = STEP_INVALID;  // invalidate the current position
+			sequencer_advance_step(LEAD_PART);
+			tracks[LEAD_PART].seq_playing = current_seq;
+			for(i = 0; i < SONG_NUM_PARTS; i ++) {
+				if(i != LEAD_PART) sequencer_sync_part(i);
+			}
+		}
+		// force correct display
+		current_seq_playing = current_seq;
+		for(i = 0; i < SONG_NUM_PARTS; i ++) {
+			tracks[i].seq_playing = current_seq;
+			tracks[i].step_playing = sequencer_compute_step(i);
+		}
+		gui_playback_updated();
+	}
+}
+
+// get the current sequence step index
+unsigned char sequencer_get_current_step_index(void) {
+	return tracks[0].step_playing;
+}
+
+// set a note for preview
+void sequencer_play_audition_note(unsigned char part, unsigned char note) {
+	if(part > (SONG_NUM_PARTS - 1)) return;
+	sequencer_stop_note(part);
+	sequencer_start_note(part, note, 0);
+}
+
+// calibrate the CV outputs
+void sequencer_cv_cal_start(void) {
+	clock_stop_command();
+}
+
+// set a CV calibration voltage
+void sequencer_cv_set_cal(unsigned char part, char octave) {
+	unsigned char note;
+	if(part > (SONG_NUM_CV_PARTS - 1)) return;
+	if(octave > 6) return;
+	note = octave * 12;
+
+	// don't multi-trigger
+	if(current_note[part] == note) return;
+
+	// turn off notes if already playing
+	if(current_note[part] != 255) {
+		_midi_tx_note_off(seq_midi_get_channel(part), current_note[part] + MIDI_NOTE_OFFSET);
+		current_note[part] = 255;
+	}
+
+	// send MIDI note
+	current_note[part] = note;
+	gate_time_count[part] = 0;
+	_midi_tx_note_on(seq_midi_get_channel(part), current_note[part] + MIDI_NOTE_OFFSET, NOTE_VEL);
+	// control analog output
+	cv_output_note_on(part, current_note[part]);
+	// reset the note timeout
+	if(clock_get_song_playing()) note_kill_timeout = NOTE_KILL_TIME_RUN;
+	else note_kill_timeout = NOTE_KILL_TIME_STOP;	
+}
+
+
+// song is loaded - need to reset the start position
+void sequencer_new_song_loaded(void) {
+	// clock control
+	clock_tick_count = 0;
+	note_kill_timeout = 0;
+	// step recording
+	rec_in_pos = 0;
+	rec_out_pos = 0;
+	rec_armed = 0;
+	// sequencer internal
+	sequencer_reset_song_pos();
+	sequencer_control_restore();
+}
@@ -1,380 +1,2092 @@
-/*
- * K2579 Step Sequencer - Song
- *
- * Copyright 2011: Kilpatrick Audio
- * Written by: Andrew Kilpatrick
- *
- */
-#include <stdlib.h>
-#include "song.h"
-#include "scale.h"
-#include "midi.h"
-
-#define PADDING1_LEN 16
-#define PADDING2_LEN 19
-#define PADDING3_LEN 30
-
-// sequence structure
-typedef struct {
-	// page 0 - 32 bytes
-	unsigned char notes[2][SONG_NUM_STEPS];  // notes
-	// page 1 - 32 bytes
-	unsigned char step_len[SONG_NUM_STEPS];  // step lengths
-	unsigned char padding1[PADDING1_LEN];  // page 1 padding
-	// page 2 - 32 bytes	
-	unsigned char start;  // 0-15 = start position
-	unsigned char len;  // 1-16 = length 1-16
-	unsigned char dir;  // 0-3 = direction types
-	unsigned char loop;  // 0-15 = number of loop times
-	unsigned char next;  // 0-15 = next sequence to play
-	unsigned char gate1;  // 1-48 = clock pulses (not divided)
-	unsigned char scale1;  // 0-5 = scale types
-	unsigned char span1;  // 1-4 = 1-4 octaves
-	char offset1;  // -12 to +12 = -12 to +12 semitones
-	unsigned char gate2;  // 1-48 = clock pulses (not divided)
-	unsigned char scale2;  // 0-5 = scale types
-	unsigned char span2;  // 1-4 = 1-4 octaves
-	char offset2;  // -12 to +12 = -12 to +12 semitones
-	unsigned char padding2[PADDING2_LEN];  // page 2 padding
-	// page 3 - 32 bytes
-	unsigned char padding3[PADDING3_LEN];  // page 3 padding
-	unsigned char version;  // the version number of the sequence data
-	unsigned char configured;  // the configuration mark byte
-} sequence;
-
-sequence seqs[SONG_NUM_SEQ];
-
-// intialize the song
-void song_init(void) {
-	song_clear_song();
-}
-
-// load a buffer into a sequence
-void song_load_seq_buf(unsigned char seq, unsigned char buf[]) {
-	int i;
-	if(seq > 15) return;
-	char *p = (char *)&seqs[seq];
-	for(i = 0; i < 128; i ++) {
-		*(p + i) = buf[i];
-	}
-}
-
-// save a buffer from a sequence
-void song_save_seq_buf(unsigned char seq, unsigned char buf[]) {
-	int i;
-	if(seq > 15) return;
-	char *p = (char *)&seqs[seq];
-	for(i = 0; i < 128; i ++) {
-		buf[i] = *(p + i);
-	}
-}
-
-// clear the song
-void song_clear_song(void) {
-	int i;
-	for(i = 0; i < SONG_NUM_SEQ; i++) {
-		song_clear_seq(i);
-	}
-}
-
-// clear a sequence
-void song_clear_seq(unsigned char seq) {
-	if(seq > (SONG_NUM_SEQ - 1)) return;
-	int i;
-	seqs[seq].start = 0;  // start at pos 1
-	seqs[seq].len = SONG_NUM_STEPS;  // 16 steps
-	seqs[seq].dir = SONG_DIR_FWD;  // forward
-	seqs[seq].loop = 0;  // loop 0 times
-	seqs[seq].next = seq;  // play this again
-	seqs[seq].gate1 = 5;  // just less than 16th note at 24ppq
-	seqs[seq].scale1 = SCALE_CHROMATIC;  // chromatic
-	seqs[seq].span1 = 4;  // 4 octaves
-	seqs[seq].offset1 = 0;  // normal offset
-	seqs[seq].gate2 = 5;  // 16th note at 24ppq
-	seqs[seq].scale2 = SCALE_CHROMATIC;  // chromatic
-	seqs[seq].span2 = 4;  // 4 octaves
-	seqs[seq].offset2 = 0;  // normal offset
-	// step 1 plays a low note
-	seqs[seq].notes[0][0] = 0;  // base note
-	seqs[seq].notes[1][0] = 0;  // base note
-	seqs[seq].step_len[0] = 0;  // default
-	// steps 2-16 are rests
-	for(i = 1; i < SONG_NUM_STEPS; i ++) {
-		seqs[seq].notes[0][i] = SONG_STEP_REST;  // rest
-		seqs[seq].notes[1][i] = SONG_STEP_REST;  // rest
-		seqs[seq].step_len[i] = 0;  // default
-	}
-	// padding
-	for(i = 0; i < PADDING1_LEN; i ++) {
-		seqs[seq].padding1[i] = 0xe1;
-	}
-	for(i = 0; i < PADDING2_LEN; i ++) {
-		seqs[seq].padding2[i] = 0xe2;
-	}
-	for(i = 0; i < PADDING3_LEN; i ++) {
-		seqs[seq].padding3[i] = 0xe3;
-	}
-	seqs[seq].version = SONG_VERSION;
-	seqs[seq].configured = SONG_CONFIGURE_MARK;
-}
-
-// copy a sequence
-void song_copy_seq(unsigned char dest, unsigned char src) {	
-	int i;
-	if(src > (SONG_NUM_SEQ - 1)) return;
-	if(dest > (SONG_NUM_SEQ - 1)) return;
-	seqs[dest].start = seqs[src].start;
-	seqs[dest].len = seqs[src].len;
-	seqs[dest].dir = seqs[src].dir;
-	seqs[dest].loop = seqs[src].loop;
-	seqs[dest].next = seqs[src].next;
-	seqs[dest].gate1 = seqs[src].gate1;
-	seqs[dest].scale1 = seqs[src].scale1;
-	seqs[dest].span1 = seqs[src].span1;
-	seqs[dest].offset1 = seqs[src].offset1;
-	seqs[dest].gate2 = seqs[src].gate2;
-	seqs[dest].scale2 = seqs[src].scale2;
-	seqs[dest].span2 = seqs[src].span2;
-	seqs[dest].offset2 = seqs[src].offset1;
-	for(i = 0; i < SONG_NUM_STEPS; i ++) {
-		seqs[dest].notes[0][i] = seqs[src].notes[0][i];
-		seqs[dest].notes[1][i] = seqs[src].notes[1][i];
-	}
-}
-
-// get the seq start
-unsigned char song_get_seq_start(unsigned char seq) {
-	if(seq > (SONG_NUM_STEPS - 1)) return 0;
-	return seqs[seq].start;
-}
-
-// set the seq start
-void song_set_seq_start(unsigned char seq, unsigned char start) {
-	if(seq > (SONG_NUM_SEQ - 1)) return;
-	if(start > (SONG_NUM_STEPS - 1)) seqs[seq].start = (SONG_NUM_STEPS - 1);
-	else seqs[seq].start = start;
-}
-
-// get the seq len
-unsigned char song_get_seq_len(unsigned char seq) {
-	if(seq > (SONG_NUM_SEQ - 1)) return 0;
-	return seqs[seq].len;
-}
-
-// set the seq len
-void song_set_seq_len(unsigned char seq, unsigned char len) {
-	if(seq > (SONG_NUM_SEQ - 1)) return;
-	if(len > SONG_NUM_STEPS) seqs[seq].len = SONG_NUM_STEPS;
-	else seqs[seq].len = len;
-}
-
-// get a step length
-unsigned char song_get_step_len(unsigned char seq, unsigned char step) {
-	if(seq > (SONG_NUM_SEQ - 1)) return 0;
-	if(step > (SONG_NUM_STEPS - 1)) return 0;
-	return seqs[seq].step_len[step];
-}
-
-// set a step length
-void song_set_step_len(unsigned char seq, unsigned char step, unsigned char len) {
-	if(seq > (SONG_NUM_SEQ - 1)) return;
-	if(step > (SONG_NUM_STEPS - 1)) return;
-	if(len > 31) seqs[seq].step_len[step] = 31;
-	seqs[seq].step_len[step] = len;
-}
-
-// get the seq dir
-unsigned char song_get_seq_dir(unsigned char seq) {
-	if(seq > (SONG_NUM_SEQ - 1)) return 0;
-	return seqs[seq].dir;
-}
-
-// set the seq dir
-void song_set_seq_dir(unsigned char seq, unsigned char dir) {
-	if(seq > (SONG_NUM_SEQ - 1)) return;
-	if(dir > SONG_MAX_DIR) seqs[seq].dir = SONG_MAX_DIR;
-	else seqs[seq].dir = dir;
-}
-
-// get the seq loop
-unsigned char song_get_seq_loop(unsigned char seq) {
-	if(seq > (SONG_NUM_SEQ - 1)) return 0;
-	return seqs[seq].loop;
-}
-
-// set the seq loop
-void song_set_seq_loop(unsigned char seq, unsigned char loop) {
-	if(seq > (SONG_NUM_SEQ - 1)) return;
-	if(loop > SONG_MAX_LOOPS) seqs[seq].loop = SONG_MAX_LOOPS;
-	else seqs[seq].loop = loop;
-}
-
-// get the seq next
-unsigned char song_get_seq_next(unsigned char seq) {
-	if(seq > (SONG_NUM_SEQ - 1)) return 0;
-	return seqs[seq].next;
-}
-
-// set the seq next
-void song_set_seq_next(unsigned char seq, unsigned char next) {
-	if(seq > (SONG_NUM_SEQ - 1)) return;
-	if(next > SONG_NUM_SEQ - 1) seqs[seq].next = SONG_NUM_SEQ - 1;
-	else seqs[seq].next = next;
-}
-
-// get a seq note
-unsigned char song_get_note(unsigned char seq, unsigned char part, unsigned char step) {
-	if(seq > (SONG_NUM_SEQ - 1)) return 0;
-	if(part > 1) return 0;
-	if(step > (SONG_NUM_STEPS - 1)) return 0;
-	return seqs[seq].notes[part][step];
-}
-
-// set a seq note
-//
-// - note range should be 0-63 = 0-48 (notes) and 254-255 (extended note types)
-// - notes saved with their raw values
-// - prescale the value based on the span - for input control
-//
-void song_set_note(unsigned char seq, unsigned char part, unsigned char step, unsigned char note) {
-	if(seq > (SONG_NUM_SEQ - 1)) return;
-	if(part > 1) return;
-	if(step > (SONG_NUM_STEPS - 1)) return;
-	if(note < 49) seqs[seq].notes[part][step] = note;
-	else if(note == SONG_STEP_RAND) seqs[seq].notes[part][step] = SONG_STEP_RAND;
-	else if(note == SONG_STEP_NONE) seqs[seq].notes[part][step] = SONG_STEP_NONE;
-	else if(note == SONG_STEP_REST) seqs[seq].notes[part][step] = SONG_STEP_REST;
-}
-
-// get the seq gate
-unsigned char song_get_gate(unsigned char seq, unsigned char part) {
-	if(seq > (SONG_NUM_SEQ - 1)) return 0;
-	if(part > 1) return 0;
-	if(part == 1) return seqs[seq].gate2;
-	return seqs[seq].gate1;
-}
-
-// set the seq gate
-void song_set_gate(unsigned char seq, unsigned char part, unsigned char gate) {
-	unsigned char gat = gate;
-	if(gat > 48) gat = 48;
-	else if(gat < 1) gat = 1;
-	if(seq > (SONG_NUM_SEQ - 1)) return;
-	if(part > 1) return;
-	if(part == 1) seqs[seq].gate2 = gat;
-	else seqs[seq].gate1 = gat;
-}
-
-// set the seq scale
-unsigned char song_get_scale(unsigned char seq, unsigned char part) {
-	if(seq > (SONG_NUM_SEQ - 1)) return 0;
-	if(part > 1) return 0;
-	if(part == 1) return seqs[seq].scale2;
-	return seqs[seq].scale1;
-}
-
-// get the seq scale
-void song_set_scale(unsigned char seq, unsigned char part, unsigned char scale) {
-	unsigned char scl = scale;
-	if(scl > 7) scl = 7;
-	if(seq > (SONG_NUM_SEQ - 1)) return;
-	if(part > 1) return;
-	if(part == 1) seqs[seq].scale2 = scl;
-	else seqs[seq].scale1 = scl;
-}
-
-// get the seq span
-unsigned char song_get_span(unsigned char seq, unsigned char part) {
-	if(seq > (SONG_NUM_SEQ - 1)) return 0;
-	if(part > 1) return 0;
-	if(part == 1) return seqs[seq].span2;
-	return seqs[seq].span1;
-}
-
-// set the seq span
-void song_set_span(unsigned char seq, unsigned char part, unsigned char span) {
-	unsigned char spn = span;
-	if(spn < 1) spn = 1;
-	else if(spn > 4) spn = 4;
-	if(seq > (SONG_NUM_SEQ - 1)) return;
-	if(part > 1) return;
-	if(part == 1) seqs[seq].span2 = spn;
-	else seqs[seq].span1 = spn;
-}
-
-// get the seq offset
-char song_get_offset(unsigned char seq, unsigned char part) {
-	if(seq > (SONG_NUM_SEQ - 1)) return 0;
-	if(part > 1) return 0;
-	if(part == 1) return seqs[seq].offset2;
-	return seqs[seq].offset1;
-}
-
-// set the seq offset
-void song_set_offset(unsigned char seq, unsigned char part, char offset) {
-	char offst = offset;
-	if(offst < -12) offst = -12;
-	else if(offst > 12) offst = 12;
-	if(seq > (SONG_NUM_SEQ - 1)) return;
-	if(part > 1) return;
-	if(part == 1) seqs[seq].offset2 = offst;
-	else seqs[seq].offset1 = offst;
-}
-
-// copy a part to the other part in the same seq
-void song_part_copy(unsigned char seq, unsigned char part) {
-	int i;
-	if(part > 1) return;
-	for(i = 0; i < SONG_NUM_STEPS; i ++) {
-		seqs[seq].notes[(part + 1) & 0x01][i] = seqs[seq].notes[part][i];
-	}
-}
-
-// invert the intervals in the selected part
-void song_part_invert(unsigned char seq, unsigned char part) {
-	if(part > 1) return;
-	int i;
-	for(i = 0; i < SONG_NUM_STEPS; i ++) {
-		if(seqs[seq].notes[part][i] < 49) {
-			seqs[seq].notes[part][i] = 48 - seqs[seq].notes[part][i];
-		}	
-	}	
-}
-
-// retrograde the selected part
-void song_part_retrograde(unsigned char seq, unsigned char part) {
-	if(part > 1) return;
-	int i, j;
-	unsigned char temp;
-	j = SONG_NUM_STEPS - 1;
-	for(i = 0; i < (SONG_NUM_STEPS >> 1); i ++) {
-		temp = seqs[seq].notes[part][i];
-		seqs[seq].notes[part][i] = seqs[seq].notes[part][j];
-		seqs[seq].notes[part][j] = temp;
-		j --;
-	}	
-}
-
-// randomize a part
-void song_part_randomize(unsigned char seq, unsigned char part) {
-	if(part > 1) return;
-	int i;
-	for(i = 0; i < SONG_NUM_STEPS; i ++) {
-		song_set_note(seq, part, i, rand() & 0x3f);
-	}
-}
-
-// clear the selected part
-void song_part_clear(unsigned char seq, unsigned char part) {
-	if(part > 1) return;
-	int i;
-	for(i = 0; i < SONG_NUM_STEPS; i ++) {
-		seqs[seq].notes[part][i] = SONG_STEP_REST;  // rest
-	}
-}
-
-// get a random note - used for RAND note type
-unsigned char song_get_rand_note(void) {
-	return (rand() & 0x3f) % 48;
-}
-
+/*
+ * K2579 Step Sequencer - Song
+ *
+ * Copyright 2011: Kilpatrick Audio
+ * Written by: Andrew Kilpatrick
+ *
+ */
+#include <stdlib.h>
+#include "song.h"
+#include "scale.h"
+#include "midi.h"
+
+#define PADDING1_LEN 16
+#define PADDING2_LEN 10
+#define PADDING3_LEN 30
+
+// sequence structure
+typedef struct {
+	// page 0 - 32 bytes
+	unsigned char notes[2][SONG_PAGE_STEPS];  // notes of steps 1-16
+	// page 1 - 32 bytes
+	unsigned char step_len[SONG_PAGE_STEPS];  // step lengths of steps 1-16
+	unsigned char padding1[PADDING1_LEN];  // page 1 padding
+	// page 2 - 32 bytes	
+	unsigned char start;  // 0-63 = start position
+	unsigned char len;  // 1-64 = length 1-64
+	unsigned char dir;  // 0-3 = direction types
+	unsigned char loop;  // 0-15 = number of loop times
+	unsigned char next;  // 0-15 = next sequence to play
+	unsigned char gate1;  // 1-48 = clock pulses (not divided)
+	unsigned char scale1;  // 0-5 = scale types
+	unsigned char span1;  // 1-4 = 1-4 octaves
+	char offset1;  // -12 to +12 = -12 to +12 semitones
+	unsigned char gate2;  // 1-48 = clock pulses (not divided)
+	unsigned char scale2;  // 0-5 = scale types
+	unsigned char span2;  // 1-4 = 1-4 octaves
+	char offset2;  // -12 to +12 = -12 to +12 semitones
+	unsigned char part_start[2];  // 0-63 or SONG_PART_FOLLOW
+	unsigned char part_len[2];  // 1-64 or SONG_PART_FOLLOW
+	unsigned char part_dir[2];  // 0-3 or SONG_PART_FOLLOW
+	unsigned char part_div[2];  // 1-24 clock pulses or SONG_PART_FOLLOW
+	unsigned char pages;  // 1-4 = 16-64 steps
+	unsigned char padding2[PADDING2_LEN];  // page 2 padding
+	// page 3 - 32 bytes
+	unsigned char padding3[PADDING3_LEN];  // page 3 padding
+	unsigned char version;  // the version number of the sequence data
+	unsigned char configured;  // the configuration mark byte
+} sequence;
+
+sequence seqs[SONG_NUM_SEQ];
+
+// MIDI only parts - kept apart from the sequence pages so that parts 1
+// and 2 keep the version 1 layout used for migration
+//  - each setting is an array over the parts
+#define SONG_NUM_MIDI_PARTS (SONG_NUM_PARTS - SONG_NUM_CV_PARTS)
+#define MIDI_PART(part) ((part) - SONG_NUM_CV_PARTS)
+typedef struct {
+	unsigned char notes[SONG_NUM_MIDI_PARTS][SONG_PAGE_STEPS];  // notes of steps 1-16
+	unsigned char gate[SONG_NUM_MIDI_PARTS];  // 1-48 = clock pulses (not divided)
+	unsigned char scale[SONG_NUM_MIDI_PARTS];  // 0-7 = scale types
+	unsigned char span[SONG_NUM_MIDI_PARTS];  // 1-4 = 1-4 octaves
+	char offset[SONG_NUM_MIDI_PARTS];  // -12 to +12 = -12 to +12 semitones
+	unsigned char part_start[SONG_NUM_MIDI_PARTS];  // 0-63 or SONG_PART_FOLLOW
+	unsigned char part_len[SONG_NUM_MIDI_PARTS];  // 1-64 or SONG_PART_FOLLOW
+	unsigned char part_dir[SONG_NUM_MIDI_PARTS];  // 0-3 or SONG_PART_FOLLOW
+	unsigned char part_div[SONG_NUM_MIDI_PARTS];  // 1-24 clock pulses or SONG_PART_FOLLOW
+} midi_parts;
+midi_parts mparts[SONG_NUM_SEQ];
+
+// step pages after the first - sequences take pages from the pool as they
+// are made longer so the short sequences don't use any
+typedef struct {
+	unsigned char notes[SONG_NUM_PARTS][SONG_PAGE_STEPS];  // notes
+	unsigned char step_len[SONG_PAGE_STEPS];  // step lengths
+} step_page;
+step_page ext_pages[SONG_NUM_EXT_PAGES];
+unsigned char page_map[SONG_NUM_SEQ][SONG_NUM_STEP_PAGES - 1];  // pool page of pages 1-3
+unsigned char page_owner[SONG_NUM_EXT_PAGES];  // the seq using each pool page
+#define PAGE_FREE 255
+
+// step lanes - lanes are taken from the pool when a step is first given
+// a value and go back when all of their steps are the default again
+typedef struct {
+	unsigned char seq;  // the seq using the lane or LANE_FREE
+	unsigned char part;
+	unsigned char type;  // SONG_LANE_ type
+	unsigned char val[SONG_NUM_STEPS];
+} step_lane;
+step_lane lanes[SONG_NUM_LANES];
+#define LANE_FREE 255
+#define LANE_NONE 255
+
+// song arrangement
+typedef struct {
+	unsigned char seq;  // 0-15
+	unsigned char repeat;  // 1-16 = times through the seq
+	char transpose;  // -12 to +12 semitones
+} arr_entry;
+arr_entry arr[SONG_ARR_LEN];
+unsigned char arr_len;  // 0 = the seqs follow their next settings
+
+// undo journal - a ring of edit records
+//  - a record holds the old and new value of a run of steps (or bytes)
+//    that all had the same old value and were given the same new value
+//  - if the old or the new values of a run change from step to step the
+//    record holds a list of them in the data records that follow it - if
+//    both change the list holds old, new pairs
+//  - the records of an edit share a group and are undone together
+//  - the oldest edits are dropped to make room for new ones
+typedef struct {
+	unsigned char group;  // the edit the record is part of
+	unsigned char field;  // JRNL_ type | JRNL_OLD_LIST or JRNL_NEW_LIST - or JRNL_DATA
+	// a data record holds JRNL_DATA_VALS list values from here
+	unsigned char seq;
+	unsigned char part;  // part | lane type << 4 for JRNL_LANE
+	unsigned char step;  // first step - or the byte offset for JRNL_SEQ and JRNL_MPARTS
+	unsigned char count;  // steps in the run
+	unsigned char old_val;
+	unsigned char new_val;
+} jrnl_rec;
+jrnl_rec jrnl[SONG_JOURNAL_LEN];
+unsigned char jrnl_pos;  // the next record - the records before it can be undone
+unsigned char jrnl_undo;  // the number of records that can be undone
+unsigned char jrnl_redo;  // the number of records from jrnl_pos that can be redone
+unsigned char jrnl_group;  // the group of the current edit
+unsigned char jrnl_hdr;  // the last record of the current edit that is not data
+unsigned char jrnl_open;  // song_journal_start depth - edits made while open are grouped
+unsigned char jrnl_new;  // the next record starts a new group
+unsigned char jrnl_single;  // the last edit is a single value that can be replaced
+unsigned char jrnl_lost;  // the current edit did not fit in the journal
+unsigned char jrnl_off;  // edits are not recorded while this is set
+#define JRNL_NOTE 0  // step notes
+#define JRNL_STEP_LEN 1  // step lengths
+#define JRNL_LANE 2  // step lane values
+#define JRNL_SEQ 3  // bytes of the sequence structure
+#define JRNL_MPARTS 4  // bytes of the MIDI only parts structure
+#define JRNL_PAGES 5  // number of step pages
+#define JRNL_DATA 0x3f  // list values of the record before
+#define JRNL_TYPE 0x3f
+#define JRNL_OLD_LIST 0x80  // the old values are listed
+#define JRNL_NEW_LIST 0x40  // the new values are listed
+#define JRNL_DATA_VALS 6
+#define JRNL_PREV(pos) (((pos) + SONG_JOURNAL_LEN - 1) % SONG_JOURNAL_LEN)
+#define JRNL_NEXT(pos) (((pos) + 1) % SONG_JOURNAL_LEN)
+// a list value of the record at pos
+#define JRNL_VAL(pos, i) ((unsigned char *)&jrnl[((pos) + 1 + ((i) / JRNL_DATA_VALS)) % \
+	SONG_JOURNAL_LEN])[2 + ((i) % JRNL_DATA_VALS)]
+
+unsigned int song_dirty;  // sequences changed since the last load / save
+#define SONG_DIRTY(seq) song_dirty |= (1 << (seq))
+
+// packed sequence record - holds the first step page
+//  0 - record length including this byte
+//  1 - flags - PACK_FLAG_PARTS, PACK_FLAG_TRACKS, PACK_FLAG_STEPS
+//  2 - start << 4 | (len - 1)
+//  3 - dir << 4 | loop
+//  4 - next
+//  5-6 - part 1: gate | scale << 6 | (span - 1) << 9 | (offset + 12) << 11
+//  7-8 - part 2: gate | scale << 6 | (span - 1) << 9 | (offset + 12) << 11
+//  9-n - RLE coded step values: part 1 notes, part 2 notes, step lengths
+//
+// if PACK_FLAG_STEPS is set the sequence is longer than 16 steps and one
+// more byte follows the header:
+//  9 - (pages - 1) | (start >> 4) << 2 | ((len - 1) >> 4) << 4
+//  - the part overrides then have a third byte: (start >> 4) | ((len - 1) >> 4) << 2
+//
+// if PACK_FLAG_PARTS is set the part overrides come before the step values:
+//  9 - override mask: start, len, dir, div of part 1 in bits 0-3, part 2 in 4-7
+//  10-11 - part 1: start << 4 | (len - 1), dir << 5 | div
+//  12-13 - part 2: start << 4 | (len - 1), dir << 5 | div
+//
+// if PACK_FLAG_TRACKS is set the MIDI only parts follow the step values:
+//  0 - mask of the parts stored - part 3 in bit 0 - silent parts are left out
+//  then for each part stored:
+//  0-1 - gate | scale << 6 | (span - 1) << 9 | (offset + 12) << 11
+//  2 - override mask: start, len, dir, div in bits 0-3
+//  3-4 - only if there are overrides: start << 4 | (len - 1), dir << 5 | div
+//  5-n - RLE coded notes
+//
+// packed step page record - one for each page after the first
+//  0 - record length including this byte
+//  1 - page - 1-3
+//  2-n - RLE coded step values: the notes of each part, step lengths
+//
+// packed lane record - one for each lane used by the seq
+//  0 - record length including this byte
+//  1 - SONG_LANE_RECORD | part << 2 | lane type bits 0-1 | lane type bit 2 << 5
+//  2-n - the changes: step, value - each step has the value of the last
+//    change at or before it and the steps before the first are the default
+//
+// packed arrangement - 2 bytes for each entry
+//  0 - seq | (repeat - 1) << 4
+//  1 - transpose + 12
+//
+// RLE step value coding:
+//  - 0x00-0x3f = a single step value
+//  - 0x40-0xff = a run of (byte - 0x3e) steps of the value in the next byte
+//
+#define PACK_HEADER_LEN 9
+#define PACK_PARTS_LEN(ext) (1 + (PACK_OVR_LEN(ext) * 2))
+#define PACK_OVR_LEN(ext) (2 + (ext))
+#define PACK_FLAG_PARTS 0x01
+#define PACK_FLAG_TRACKS 0x02
+#define PACK_FLAG_STEPS 0x04
+#define PACK_NUM_CODES (SONG_PAGE_STEPS * 3)
+#define PACK_PAGE_HEADER_LEN 2
+#define PACK_PAGE_CODES ((SONG_NUM_PARTS + 1) * SONG_PAGE_STEPS)
+#define PACK_RUN 0x40
+#define PACK_CODE_RAND 0x3d
+#define PACK_CODE_NONE 0x3e
+#define PACK_CODE_REST 0x3f
+
+// local functions
+unsigned char song_pack_code(unsigned char seq, unsigned char index);
+unsigned char song_pack_page_code(step_page *pg, unsigned int index);
+unsigned int song_pack_part(unsigned char gate, unsigned char scale,
+	unsigned char span, char offset);
+unsigned char song_pack_overrides(unsigned char seq, unsigned char buf[],
+	unsigned char ext);
+void song_unpack_overrides(unsigned char seq, unsigned char buf[], unsigned char ext);
+unsigned char song_pack_part_overrides(unsigned char seq, unsigned char part,
+	unsigned char buf[], unsigned char ext);
+void song_unpack_part_overrides(unsigned char seq, unsigned char part,
+	unsigned char mask, unsigned char buf[], unsigned char ext);
+unsigned char song_pack_tracks(unsigned char seq, unsigned char buf[], unsigned char ext);
+unsigned char song_unpack_tracks(unsigned char seq, unsigned char buf[],
+	unsigned char pos, unsigned char store, unsigned char ext);
+unsigned char song_pack_note_code(unsigned char note);
+unsigned char song_unpack_note_code(unsigned char code);
+unsigned char *song_part_notes(unsigned char seq, unsigned char part);
+unsigned char *song_step_note(unsigned char seq, unsigned char part, unsigned char step);
+unsigned char *song_step_len(unsigned char seq, unsigned char step);
+void song_free_pages(unsigned char seq);
+unsigned char song_find_lane(unsigned char seq, unsigned char part, unsigned char lane);
+unsigned char song_lane_default(unsigned char lane);
+void song_free_lanes(unsigned char seq);
+unsigned char song_cond_valid(unsigned char cond);
+void song_part_read(unsigned char seq, unsigned char part, unsigned char buf[]);
+void song_part_write(unsigned char seq, unsigned char part, unsigned char buf[]);
+void song_part_gates(unsigned char seq, unsigned char part, unsigned char buf[]);
+void song_write_byte(unsigned char seq, unsigned char *p, unsigned char val);
+void song_journal_start(void);
+void song_journal_end(void);
+void song_journal_add(unsigned char seq, unsigned char part, unsigned char field,
+	unsigned char step, unsigned char old_val, unsigned char new_val);
+unsigned char song_journal_rec(void);
+void song_journal_apply(unsigned char pos, unsigned char old);
+void song_journal_steps(unsigned char seq, unsigned char from, unsigned char clear);
+void song_journal_seq(unsigned char seq, unsigned char clear);
+void song_journal_lane(unsigned char lane, unsigned char clear);
+void song_journal_struct(unsigned char seq, sequence *old_seq, midi_parts *old_mparts);
+
+// intialize the song
+void song_init(void) {
+	int i, j;
+	for(i = 0; i < SONG_NUM_EXT_PAGES; i ++) {
+		page_owner[i] = PAGE_FREE;
+	}
+	for(i = 0; i < SONG_NUM_SEQ; i ++) {
+		for(j = 0; j < (SONG_NUM_STEP_PAGES - 1); j ++) {
+			page_map[i][j] = PAGE_FREE;
+		}
+	}
+	for(i = 0; i < SONG_NUM_LANES; i ++) {
+		lanes[i].seq = LANE_FREE;
+	}
+	jrnl_open = 0;
+	jrnl_off = 0;
+	song_clear_song();
+}
+
+// get the mask of sequences changed since the song was last loaded or saved
+unsigned int song_get_dirty(void) {
+	return song_dirty;
+}
+
+// clear sequences from the changed mask
+void song_clear_dirty(unsigned int mask) {
+	song_dirty &= ~mask;
+}
+
+// load a buffer into a sequence
+void song_load_seq_buf(unsigned char seq, unsigned char buf[]) {
+	int i;
+	if(seq > 15) return;
+	song_clear_seq(seq);  // version 1 sequences have no MIDI only parts
+	char *p = (char *)&seqs[seq];
+	for(i = 0; i < 128; i ++) {
+		*(p + i) = buf[i];
+	}
+	seqs[seq].pages = 1;  // version 1 sequences have 16 steps
+}
+
+// save a buffer from a sequence
+void song_save_seq_buf(unsigned char seq, unsigned char buf[]) {
+	int i;
+	if(seq > 15) return;
+	char *p = (char *)&seqs[seq];
+	for(i = 0; i < 128; i ++) {
+		buf[i] = *(p + i);
+	}
+}
+
+// pack a sequence into a compact record - returns the record length
+unsigned char song_pack_seq(unsigned char seq, unsigned char buf[]) {
+	unsigned char pos, code, run, used, ext;
+	unsigned char start, len, dir, loop, next, steps;
+	unsigned int part;
+	int i;
+	if(seq > (SONG_NUM_SEQ - 1)) return 0;
+
+	// sequence settings
+	steps = song_get_seq_steps(seq);
+	start = seqs[seq].start;
+	if(start > (steps - 1)) start = steps - 1;
+	len = seqs[seq].len;
+	if(len < 1) len = 1;
+	else if(len > steps) len = steps;
+	dir = seqs[seq].dir;
+	if(dir > SONG_MAX_DIR) dir = SONG_MAX_DIR;
+	loop = seqs[seq].loop;
+	if(loop > SONG_MAX_LOOPS) loop = SONG_MAX_LOOPS;
+	next = seqs[seq].next;
+	if(next > (SONG_NUM_SEQ - 1)) next = SONG_NUM_SEQ - 1;
+	buf[1] = 0;
+	buf[2] = ((start & 0x0f) << 4) | ((len - 1) & 0x0f);
+	buf[3] = (dir << 4) | loop;
+	buf[4] = next;
+
+	// part settings
+	part = song_pack_part(seqs[seq].gate1, seqs[seq].scale1,
+		seqs[seq].span1, seqs[seq].offset1);
+	buf[5] = part & 0xff;
+	buf[6] = (part >> 8) & 0xff;
+	part = song_pack_part(seqs[seq].gate2, seqs[seq].scale2,
+		seqs[seq].span2, seqs[seq].offset2);
+	buf[7] = part & 0xff;
+	buf[8] = (part >> 8) & 0xff;
+
+	// sequences longer than 16 steps - 16 step sequences are packed as before
+	pos = PACK_HEADER_LEN;
+	ext = 0;
+	if(steps > SONG_PAGE_STEPS) {
+		buf[1] |= PACK_FLAG_STEPS;
+		buf[pos ++] = ((steps / SONG_PAGE_STEPS) - 1) | ((start >> 4) << 2) |
+			(((len - 1) >> 4) << 4);
+		ext = 1;
+	}
+
+	// part overrides - only stored if they are used
+	if(song_pack_overrides(seq, buf + pos, ext)) {
+		buf[1] |= PACK_FLAG_PARTS;
+		pos += PACK_PARTS_LEN(ext);
+	}
+
+	// step values - runs of rests are very common
+	i = 0;
+	while(i < PACK_NUM_CODES) {
+		code = song_pack_code(seq, i);
+		run = 1;
+		while((i + run) < PACK_NUM_CODES && song_pack_code(seq, i + run) == code) {
+			run ++;
+		}
+		if(run > 1) {
+			buf[pos ++] = PACK_RUN + (run - 2);
+		}
+		buf[pos ++] = code;
+		i += run;
+	}
+
+	// MIDI only parts - only stored if they are used
+	used = song_pack_tracks(seq, buf + pos, ext);
+	if(used) {
+		buf[1] |= PACK_FLAG_TRACKS;
+		pos += used;
+	}
+	buf[0] = pos;
+	return pos;
+}
+
+// unpack a compact record into a sequence - returns 1 if the record was valid
+unsigned char song_unpack_seq(unsigned char seq, unsigned char buf[], unsigned char len) {
+	unsigned char codes[PACK_NUM_CODES];
+	unsigned char pos, code, run, tracks_pos, parts_pos, ext;
+	unsigned char start, seq_len, pages;
+	unsigned int part1, part2;
+	int i, j;
+	if(seq > (SONG_NUM_SEQ - 1)) return 0;
+	if(buf[0] < PACK_HEADER_LEN || buf[0] > len) return 0;
+	if(buf[1] & ~(PACK_FLAG_PARTS | PACK_FLAG_TRACKS | PACK_FLAG_STEPS)) return 0;  // unsupported flags
+	if((buf[3] >> 4) > SONG_MAX_DIR) return 0;
+	if(buf[4] > (SONG_NUM_SEQ - 1)) return 0;
+	part1 = buf[5] | (buf[6] << 8);
+	part2 = buf[7] | (buf[8] << 8);
+	for(i = 0; i < 2; i ++) {
+		unsigned int part = i ? part2 : part1;
+		if((part & 0x3f) < 1 || (part & 0x3f) > 48) return 0;
+		if(((part >> 11) & 0x1f) > 24) return 0;
+	}
+
+	// sequences longer than 16 steps
+	pos = PACK_HEADER_LEN;
+	ext = 0;
+	pages = 1;
+	start = buf[2] >> 4;
+	seq_len = (buf[2] & 0x0f) + 1;
+	if(buf[1] & PACK_FLAG_STEPS) {
+		if(buf[0] < (PACK_HEADER_LEN + 1)) return 0;
+		if(buf[pos] & 0xc0) return 0;
+		pages = (buf[pos] & 0x03) + 1;
+		start |= ((buf[pos] >> 2) & 0x03) << 4;
+		seq_len += ((buf[pos] >> 4) & 0x03) << 4;
+		ext = 1;
+		pos ++;
+	}
+	parts_pos = pos;
+	if(buf[1] & PACK_FLAG_PARTS) {
+		if(buf[0] < (pos + PACK_PARTS_LEN(ext))) return 0;
+		pos += PACK_PARTS_LEN(ext);
+	}
+
+	// step values
+	i = 0;
+	while(i < PACK_NUM_CODES) {
+		if(pos >= buf[0]) return 0;
+		code = buf[pos ++];
+		run = 1;
+		if(code >= PACK_RUN) {
+			if(pos >= buf[0]) return 0;
+			run = (code - PACK_RUN) + 2;
+			code = buf[pos ++];
+		}
+		if(code >= PACK_RUN) return 0;
+		if((i + run) > PACK_NUM_CODES) return 0;
+		for(j = 0; j < run; j ++) {
+			// notes
+			if(i < (SONG_PAGE_STEPS * 2)) {
+				if(code > 48 && code < PACK_CODE_RAND) return 0;
+			}
+			// step lengths
+			else if(code > 31) return 0;
+			codes[i ++] = code;
+		}
+	}
+	// MIDI only parts are checked before anything is stored
+	tracks_pos = pos;
+	if(buf[1] & PACK_FLAG_TRACKS) pos = song_unpack_tracks(seq, buf, pos, 0, ext);
+	if(pos == 0 || pos != buf[0]) return 0;
+
+	// the record is good - store it
+	song_clear_seq(seq);
+	song_set_seq_pages(seq, pages);  // the range is clamped if the pool is short
+	song_set_seq_start(seq, start);
+	song_set_seq_len(seq, seq_len);
+	seqs[seq].dir = buf[3] >> 4;
+	seqs[seq].loop = buf[3] & 0x0f;
+	seqs[seq].next = buf[4];
+	seqs[seq].gate1 = part1 & 0x3f;
+	seqs[seq].scale1 = (part1 >> 6) & 0x07;
+	seqs[seq].span1 = ((part1 >> 9) & 0x03) + 1;
+	seqs[seq].offset1 = (char)((part1 >> 11) & 0x1f) - 12;
+	seqs[seq].gate2 = part2 & 0x3f;
+	seqs[seq].scale2 = (part2 >> 6) & 0x07;
+	seqs[seq].span2 = ((part2 >> 9) & 0x03) + 1;
+	seqs[seq].offset2 = (char)((part2 >> 11) & 0x1f) - 12;
+	for(i = 0; i < SONG_PAGE_STEPS; i ++) {
+		for(j = 0; j < 2; j ++) {
+			seqs[seq].notes[j][i] = song_unpack_note_code(codes[(j * SONG_PAGE_STEPS) + i]);
+		}
+		seqs[seq].step_len[i] = codes[(SONG_PAGE_STEPS * 2) + i];
+	}
+	if(buf[1] & PACK_FLAG_PARTS) song_unpack_overrides(seq, buf + parts_pos, ext);
+	if(buf[1] & PACK_FLAG_TRACKS) song_unpack_tracks(seq, buf, tracks_pos, 1, ext);
+	return 1;
+}
+
+// pack a step page after the first into a compact record - returns the
+// record length or 0 if the seq doesn't have the page
+unsigned char song_pack_page(unsigned char seq, unsigned char page, unsigned char buf[]) {
+	unsigned char pos, code, run;
+	step_page *pg;
+	int i;
+	if(seq > (SONG_NUM_SEQ - 1)) return 0;
+	if(page < 1 || page > ((song_get_seq_steps(seq) / SONG_PAGE_STEPS) - 1)) return 0;
+	pg = &ext_pages[page_map[seq][page - 1]];
+	buf[1] = page;
+	pos = PACK_PAGE_HEADER_LEN;
+	i = 0;
+	while(i < PACK_PAGE_CODES) {
+		code = song_pack_page_code(pg, i);
+		run = 1;
+		while((i + run) < PACK_PAGE_CODES && song_pack_page_code(pg, i + run) == code) {
+			run ++;
+		}
+		if(run > 1) {
+			buf[pos ++] = PACK_RUN + (run - 2);
+		}
+		buf[pos ++] = code;
+		i += run;
+	}
+	buf[0] = pos;
+	return pos;
+}
+
+// unpack a step page record into a sequence - returns 1 if the record was valid
+//
+// - pages past the end of the seq are checked but not stored
+//
+unsigned char song_unpack_page(unsigned char seq, unsigned char buf[], unsigned char len) {
+	unsigned char codes[PACK_PAGE_CODES];
+	unsigned char pos, code, run, page;
+	step_page *pg;
+	int i, j;
+	if(seq > (SONG_NUM_SEQ - 1)) return 0;
+	if(buf[0] < PACK_PAGE_HEADER_LEN || buf[0] > len) return 0;
+	page = buf[1];
+	if(page < 1 || page > (SONG_NUM_STEP_PAGES - 1)) return 0;
+	pos = PACK_PAGE_HEADER_LEN;
+	i = 0;
+	while(i < PACK_PAGE_CODES) {
+		if(pos >= buf[0]) return 0;
+		code = buf[pos ++];
+		run = 1;
+		if(code >= PACK_RUN) {
+			if(pos >= buf[0]) return 0;
+			run = (code - PACK_RUN) + 2;
+			code = buf[pos ++];
+		}
+		if(code >= PACK_RUN) return 0;
+		if((i + run) > PACK_PAGE_CODES) return 0;
+		for(j = 0; j < run; j ++) {
+			// notes
+			if(i < (SONG_NUM_PARTS * SONG_PAGE_STEPS)) {
+				if(code > 48 && code < PACK_CODE_RAND) return 0;
+			}
+			// step lengths
+			else if(code > 31) return 0;
+			codes[i ++] = code;
+		}
+	}
+	if(pos != buf[0]) return 0;
+
+	// the record is good - store it
+	if(page > ((song_get_seq_steps(seq) / SONG_PAGE_STEPS) - 1)) return 1;
+	pg = &ext_pages[page_map[seq][page - 1]];
+	for(i = 0; i < SONG_PAGE_STEPS; i ++) {
+		for(j = 0; j < SONG_NUM_PARTS; j ++) {
+			pg->notes[j][i] = song_unpack_note_code(codes[(j * SONG_PAGE_STEPS) + i]);
+		}
+		pg->step_len[i] = codes[(SONG_NUM_PARTS * SONG_PAGE_STEPS) + i];
+	}
+	SONG_DIRTY(seq);
+	return 1;
+}
+
+// pack the step lanes of a sequence - returns the length of the lane records
+unsigned int song_pack_lanes(unsigned char seq, unsigned char buf[]) {
+	unsigned int pos = 0;
+	unsigned char len, prev;
+	int i, j;
+	if(seq > (SONG_NUM_SEQ - 1)) return 0;
+	for(i = 0; i < SONG_NUM_LANES; i ++) {
+		if(lanes[i].seq != seq) continue;
+		buf[pos + 1] = SONG_LANE_RECORD | (lanes[i].part << 2) | (lanes[i].type & 0x03) |
+			((lanes[i].type & 0x04) << 3);
+		len = 2;
+		// only the changes are stored
+		prev = song_lane_default(lanes[i].type);
+		for(j = 0; j < SONG_NUM_STEPS; j ++) {
+			if(lanes[i].val[j] == prev) continue;
+			prev = lanes[i].val[j];
+			buf[pos + len] = j;
+			buf[pos + len + 1] = prev;
+			len += 2;
+		}
+		buf[pos] = len;
+		pos += len;
+	}
+	return pos;
+}
+
+// get the most bytes the records of a sequence can pack into
+unsigned int song_packed_seq_max(unsigned char seq) {
+	unsigned int len = SONG_PACKED_SEQ_MAX;
+	int i;
+	if(seq > (SONG_NUM_SEQ - 1)) return 0;
+	len += ((song_get_seq_steps(seq) / SONG_PAGE_STEPS) - 1) * SONG_PACKED_PAGE_MAX;
+	for(i = 0; i < SONG_NUM_LANES; i ++) {
+		if(lanes[i].seq == seq) len += SONG_PACKED_LANE_MAX;
+	}
+	return len;
+}
+
+// unpack a lane record into a sequence - returns 1 if the record was valid
+//
+// - lanes of parts that this build doesn't have are checked but not stored
+//
+unsigned char song_unpack_lane(unsigned char seq, unsigned char buf[], unsigned char len) {
+	unsigned char part, lane, value;
+	int i, step;
+	if(seq > (SONG_NUM_SEQ - 1)) return 0;
+	if(buf[0] < 2 || buf[0] > len || (buf[0] & 0x01)) return 0;
+	if((buf[1] & 0xc0) != SONG_LANE_RECORD) return 0;
+	part = (buf[1] >> 2) & 0x07;
+	lane = (buf[1] & 0x03) | ((buf[1] >> 3) & 0x04);
+	if(lane > (SONG_NUM_LANE_TYPES - 1)) return 0;
+	// steps must be in order
+	for(i = 2; i < buf[0]; i += 2) {
+		if(buf[i] > (SONG_NUM_STEPS - 1)) return 0;
+		if(i > 2 && buf[i] <= buf[i - 2]) return 0;
+		if((lane == SONG_LANE_CC1 || lane == SONG_LANE_CC2) && buf[i + 1] > 127 &&
+			buf[i + 1] != SONG_LANE_HOLD) return 0;
+		if(lane == SONG_LANE_COND && !song_cond_valid(buf[i + 1])) return 0;
+	}
+
+	// the record is good - store it
+	if(part > (SONG_NUM_PARTS - 1)) return 1;
+	song_clear_lane(seq, part, lane);
+	value = song_lane_default(lane);
+	i = 2;
+	for(step = 0; step < SONG_NUM_STEPS; step ++) {
+		if(i < buf[0] && buf[i] == step) {
+			value = buf[i + 1];
+			i += 2;
+		}
+		song_set_lane(seq, part, lane, step, value);
+	}
+	return 1;
+}
+
+// pack the arrangement - returns the length
+unsigned char song_pack_arr(unsigned char buf[]) {
+	int i;
+	for(i = 0; i < arr_len; i ++) {
+		buf[i << 1] = arr[i].seq | ((arr[i].repeat - 1) << 4);
+		buf[(i << 1) + 1] = arr[i].transpose + SONG_ARR_MAX_TRANSPOSE;
+	}
+	return arr_len << 1;
+}
+
+// unpack an arrangement of a number of entries - returns 1 if it was valid
+unsigned char song_unpack_arr(unsigned char buf[], unsigned char entries) {
+	int i;
+	if(entries > SONG_ARR_LEN) return 0;
+	for(i = 0; i < entries; i ++) {
+		if(buf[(i << 1) + 1] > (SONG_ARR_MAX_TRANSPOSE * 2)) return 0;
+	}
+	for(i = 0; i < entries; i ++) {
+		arr[i].seq = buf[i << 1] & 0x0f;
+		arr[i].repeat = (buf[i << 1] >> 4) + 1;
+		arr[i].transpose = buf[(i << 1) + 1] - SONG_ARR_MAX_TRANSPOSE;
+	}
+	arr_len = entries;
+	return 1;
+}
+
+// clear the song
+void song_clear_song(void) {
+	int i;
+	arr_len = 0;
+	for(i = 0; i < SONG_NUM_SEQ; i++) {
+		song_clear_seq(i);
+	}
+	song_journal_clear();
+}
+
+// clear a sequence
+void song_clear_seq(unsigned char seq) {
+	if(seq > (SONG_NUM_SEQ - 1)) return;
+	SONG_DIRTY(seq);
+	int i, j;
+	sequence old_seq;
+	midi_parts old_mparts;
+	song_journal_start();
+	song_journal_seq(seq, 1);
+	old_seq = seqs[seq];
+	old_mparts = mparts[seq];
+	jrnl_off ++;
+	song_free_pages(seq);  // 16 steps
+	song_free_lanes(seq);  // no step lanes
+	seqs[seq].start = 0;  // start at pos 1
+	seqs[seq].len = SONG_PAGE_STEPS;  // 16 steps
+	seqs[seq].dir = SONG_DIR_FWD;  // forward
+	seqs[seq].loop = 0;  // loop 0 times
+	seqs[seq].next = seq;  // play this again
+	seqs[seq].gate1 = 5;  // just less than 16th note at 24ppq
+	seqs[seq].scale1 = SCALE_CHROMATIC;  // chromatic
+	seqs[seq].span1 = 4;  // 4 octaves
+	seqs[seq].offset1 = 0;  // normal offset
+	seqs[seq].gate2 = 5;  // 16th note at 24ppq
+	seqs[seq].scale2 = SCALE_CHROMATIC;  // chromatic
+	seqs[seq].span2 = 4;  // 4 octaves
+	seqs[seq].offset2 = 0;  // normal offset
+	// parts follow the sequence
+	for(i = 0; i < 2; i ++) {
+		seqs[seq].part_start[i] = SONG_PART_FOLLOW;
+		seqs[seq].part_len[i] = SONG_PART_FOLLOW;
+		seqs[seq].part_dir[i] = SONG_PART_FOLLOW;
+		seqs[seq].part_div[i] = SONG_PART_FOLLOW;
+	}
+	// MIDI only parts are silent
+	for(i = 0; i < SONG_NUM_MIDI_PARTS; i ++) {
+		for(j = 0; j < SONG_PAGE_STEPS; j ++) {
+			mparts[seq].notes[i][j] = SONG_STEP_REST;  // rest
+		}
+		mparts[seq].gate[i] = 5;  // 16th note at 24ppq
+		mparts[seq].scale[i] = SCALE_CHROMATIC;  // chromatic
+		mparts[seq].span[i] = 4;  // 4 octaves
+		mparts[seq].offset[i] = 0;  // normal offset
+		mparts[seq].part_start[i] = SONG_PART_FOLLOW;
+		mparts[seq].part_len[i] = SONG_PART_FOLLOW;
+		mparts[seq].part_dir[i] = SONG_PART_FOLLOW;
+		mparts[seq].part_div[i] = SONG_PART_FOLLOW;
+	}
+	// step 1 plays a low note
+	seqs[seq].notes[0][0] = 0;  // base note
+	seqs[seq].notes[1][0] = 0;  // base note
+	seqs[seq].step_len[0] = 0;  // default
+	// steps 2-16 are rests
+	for(i = 1; i < SONG_PAGE_STEPS; i ++) {
+		seqs[seq].notes[0][i] = SONG_STEP_REST;  // rest
+		seqs[seq].notes[1][i] = SONG_STEP_REST;  // rest
+		seqs[seq].step_len[i] = 0;  // default
+	}
+	// padding
+	for(i = 0; i < PADDING1_LEN; i ++) {
+		seqs[seq].padding1[i] = 0xe1;
+	}
+	for(i = 0; i < PADDING2_LEN; i ++) {
+		seqs[seq].padding2[i] = 0xe2;
+	}
+	for(i = 0; i < PADDING3_LEN; i ++) {
+		seqs[seq].padding3[i] = 0xe3;
+	}
+	seqs[seq].version = SONG_VERSION;
+	seqs[seq].configured = SONG_CONFIGURE_MARK;
+	jrnl_off --;
+	song_journal_struct(seq, &old_seq, &old_mparts);
+	song_journal_end();
+}
+
+// copy a sequence
+void song_copy_seq(unsigned char dest, unsigned char src) {	
+	int i, j;
+	sequence old_seq;
+	midi_parts old_mparts;
+	if(src > (SONG_NUM_SEQ - 1)) return;
+	if(dest > (SONG_NUM_SEQ - 1)) return;
+	if(dest == src) return;
+	SONG_DIRTY(dest);
+	song_journal_start();
+	song_journal_seq(dest, 1);
+	old_seq = seqs[dest];
+	old_mparts = mparts[dest];
+	jrnl_off ++;
+	// as many pages and lanes as the pools have room for
+	song_free_pages(dest);
+	song_set_seq_pages(dest, song_get_seq_steps(src) / SONG_PAGE_STEPS);
+	for(i = 0; i < ((song_get_seq_steps(dest) / SONG_PAGE_STEPS) - 1); i ++) {
+		ext_pages[page_map[dest][i]] = ext_pages[page_map[src][i]];
+	}
+	song_free_lanes(dest);
+	for(i = 0; i < SONG_NUM_LANES; i ++) {
+		if(lanes[i].seq != src) continue;
+		for(j = 0; j < SONG_NUM_LANES && lanes[j].seq != LANE_FREE; j ++);
+		if(j == SONG_NUM_LANES) break;
+		lanes[j] = lanes[i];
+		lanes[j].seq = dest;
+	}
+	song_set_seq_start(dest, seqs[src].start);
+	song_set_seq_len(dest, seqs[src].len);
+	seqs[dest].dir = seqs[src].dir;
+	seqs[dest].loop = seqs[src].loop;
+	seqs[dest].next = seqs[src].next;
+	seqs[dest].gate1 = seqs[src].gate1;
+	seqs[dest].scale1 = seqs[src].scale1;
+	seqs[dest].span1 = seqs[src].span1;
+	seqs[dest].offset1 = seqs[src].offset1;
+	seqs[dest].gate2 = seqs[src].gate2;
+	seqs[dest].scale2 = seqs[src].scale2;
+	seqs[dest].span2 = seqs[src].span2;
+	seqs[dest].offset2 = seqs[src].offset1;
+	for(i = 0; i < 2; i ++) {
+		seqs[dest].part_start[i] = seqs[src].part_start[i];
+		seqs[dest].part_len[i] = seqs[src].part_len[i];
+		seqs[dest].part_dir[i] = seqs[src].part_dir[i];
+		seqs[dest].part_div[i] = seqs[src].part_div[i];
+	}
+	for(i = 0; i < SONG_PAGE_STEPS; i ++) {
+		seqs[dest].notes[0][i] = seqs[src].notes[0][i];
+		seqs[dest].notes[1][i] = seqs[src].notes[1][i];
+		seqs[dest].step_len[i] = seqs[src].step_len[i];
+	}
+	mparts[dest] = mparts[src];
+	jrnl_off --;
+	song_journal_struct(dest, &old_seq, &old_mparts);
+	song_journal_seq(dest, 0);
+	song_journal_end();
+}
+
+// get the seq start
+unsigned char song_get_seq_start(unsigned char seq) {
+	if(seq > (SONG_NUM_SEQ - 1)) return 0;
+	return seqs[seq].start;
+}
+
+// set the seq start
+void song_set_seq_start(unsigned char seq, unsigned char start) {
+	if(seq > (SONG_NUM_SEQ - 1)) return;
+	SONG_DIRTY(seq);
+	if(start > (song_get_seq_steps(seq) - 1)) start = song_get_seq_steps(seq) - 1;
+	song_write_byte(seq, &seqs[seq].start, start);
+}
+
+// get the seq len
+unsigned char song_get_seq_len(unsigned char seq) {
+	if(seq > (SONG_NUM_SEQ - 1)) return 0;
+	return seqs[seq].len;
+}
+
+// set the seq len
+void song_set_seq_len(unsigned char seq, unsigned char len) {
+	if(seq > (SONG_NUM_SEQ - 1)) return;
+	SONG_DIRTY(seq);
+	if(len > song_get_seq_steps(seq)) len = song_get_seq_steps(seq);
+	song_write_byte(seq, &seqs[seq].len, len);
+}
+
+// get the number of steps in a seq - 16, 32, 48 or 64
+unsigned char song_get_seq_steps(unsigned char seq) {
+	if(seq > (SONG_NUM_SEQ - 1)) return SONG_PAGE_STEPS;
+	if(seqs[seq].pages < 1 || seqs[seq].pages > SONG_NUM_STEP_PAGES) return SONG_PAGE_STEPS;
+	return seqs[seq].pages * SONG_PAGE_STEPS;
+}
+
+// set the number of step pages in a seq - returns 0 if there are not enough free pages
+//
+// - new pages are rests
+// - the seq start and len are kept inside the steps
+//
+unsigned char song_set_seq_pages(unsigned char seq, unsigned char pages) {
+	unsigned char cur, steps;
+	int i, j, k;
+	if(seq > (SONG_NUM_SEQ - 1)) return 0;
+	if(pages < 1) pages = 1;
+	else if(pages > SONG_NUM_STEP_PAGES) pages = SONG_NUM_STEP_PAGES;
+	cur = song_get_seq_steps(seq) / SONG_PAGE_STEPS;
+	if(pages == cur) return 1;
+	if(pages > cur && (pages - cur) > song_get_free_pages()) return 0;
+	SONG_DIRTY(seq);
+	song_journal_start();
+	song_journal_steps(seq, pages * SONG_PAGE_STEPS, 1);  // the steps that are dropped
+	song_journal_add(seq, 0, JRNL_PAGES, 0, cur, pages);
+	// shorter - the pages at the end go back to the pool
+	for(i = pages; i < cur; i ++) {
+		page_owner[page_map[seq][i - 1]] = PAGE_FREE;
+		page_map[seq][i - 1] = PAGE_FREE;
+	}
+	// longer
+	for(i = cur; i < pages; i ++) {
+		for(j = 0; page_owner[j] != PAGE_FREE; j ++);
+		page_owner[j] = seq;
+		page_map[seq][i - 1] = j;
+		for(k = 0; k < SONG_PAGE_STEPS; k ++) {
+			ext_pages[j].step_len[k] = 0;  // default
+		}
+		for(k = 0; k < (SONG_NUM_PARTS * SONG_PAGE_STEPS); k ++) {
+			ext_pages[j].notes[k / SONG_PAGE_STEPS][k % SONG_PAGE_STEPS] = SONG_STEP_REST;
+		}
+	}
+	seqs[seq].pages = pages;
+	steps = pages * SONG_PAGE_STEPS;
+	if(seqs[seq].start > (steps - 1)) song_write_byte(seq, &seqs[seq].start, steps - 1);
+	if(seqs[seq].len > steps) song_write_byte(seq, &seqs[seq].len, steps);
+	song_journal_end();
+	return 1;
+}
+
+// get the number of step pages left in the pool
+unsigned char song_get_free_pages(void) {
+	unsigned char count = 0;
+	int i;
+	for(i = 0; i < SONG_NUM_EXT_PAGES; i ++) {
+		if(page_owner[i] == PAGE_FREE) count ++;
+	}
+	return count;
+}
+
+// get a step length
+unsigned char song_get_step_len(unsigned char seq, unsigned char step) {
+	unsigned char *len;
+	if(seq > (SONG_NUM_SEQ - 1)) return 0;
+	len = song_step_len(seq, step);
+	if(len == NULL) return 0;
+	return *len;
+}
+
+// set a step length
+void song_set_step_len(unsigned char seq, unsigned char step, unsigned char len) {
+	unsigned char *p;
+	if(seq > (SONG_NUM_SEQ - 1)) return;
+	p = song_step_len(seq, step);
+	if(p == NULL) return;
+	SONG_DIRTY(seq);
+	if(len > 31) len = 31;
+	song_journal_add(seq, 0, JRNL_STEP_LEN, step, *p, len);
+	*p = len;
+}
+
+// get the seq dir
+unsigned char song_get_seq_dir(unsigned char seq) {
+	if(seq > (SONG_NUM_SEQ - 1)) return 0;
+	return seqs[seq].dir;
+}
+
+// set the seq dir
+void song_set_seq_dir(unsigned char seq, unsigned char dir) {
+	if(seq > (SONG_NUM_SEQ - 1)) return;
+	SONG_DIRTY(seq);
+	if(dir > SONG_MAX_DIR) dir = SONG_MAX_DIR;
+	song_write_byte(seq, &seqs[seq].dir, dir);
+}
+
+// get the seq loop
+unsigned char song_get_seq_loop(unsigned char seq) {
+	if(seq > (SONG_NUM_SEQ - 1)) return 0;
+	return seqs[seq].loop;
+}
+
+// set the seq loop
+void song_set_seq_loop(unsigned char seq, unsigned char loop) {
+	if(seq > (SONG_NUM_SEQ - 1)) return;
+	SONG_DIRTY(seq);
+	if(loop > SONG_MAX_LOOPS) loop = SONG_MAX_LOOPS;
+	song_write_byte(seq, &seqs[seq].loop, loop);
+}
+
+// get the seq next
+unsigned char song_get_seq_next(unsigned char seq) {
+	if(seq > (SONG_NUM_SEQ - 1)) return 0;
+	return seqs[seq].next;
+}
+
+// set the seq next
+void song_set_seq_next(unsigned char seq, unsigned char next) {
+	if(seq > (SONG_NUM_SEQ - 1)) return;
+	SONG_DIRTY(seq);
+	if(next > SONG_NUM_SEQ - 1) next = SONG_NUM_SEQ - 1;
+	song_write_byte(seq, &seqs[seq].next, next);
+}
+
+// get a seq note
+unsigned char song_get_note(unsigned char seq, unsigned char part, unsigned char step) {
+	unsigned char *note;
+	if(seq > (SONG_NUM_SEQ - 1)) return 0;
+	if(part > (SONG_NUM_PARTS - 1)) return 0;
+	note = song_step_note(seq, part, step);
+	if(note == NULL) return SONG_STEP_REST;  // past the end of the seq
+	return *note;
+}
+
+// set a seq note
+//
+// - note range should be 0-63 = 0-48 (notes) and 254-255 (extended note types)
+// - notes saved with their raw values
+// - prescale the value based on the span - for input control
+//
+void song_set_note(unsigned char seq, unsigned char part, unsigned char step, unsigned char note) {
+	unsigned char *p;
+	if(seq > (SONG_NUM_SEQ - 1)) return;
+	if(part > (SONG_NUM_PARTS - 1)) return;
+	p = song_step_note(seq, part, step);
+	if(p == NULL) return;
+	if(note > 48 && note != SONG_STEP_RAND && note != SONG_STEP_NONE &&
+		note != SONG_STEP_REST) return;
+	SONG_DIRTY(seq);
+	song_journal_add(seq, part, JRNL_NOTE, step, *p, note);
+	*p = note;
+}
+
+// get a step lane value - the default value if the lane is not used
+unsigned char song_get_lane(unsigned char seq, unsigned char part, unsigned char lane,
+		unsigned char step) {
+	unsigned char i;
+	if(seq > (SONG_NUM_SEQ - 1)) return 0;
+	if(part > (SONG_NUM_PARTS - 1)) return 0;
+	if(lane > (SONG_NUM_LANE_TYPES - 1)) return 0;
+	i = song_find_lane(seq, part, lane);
+	if(i == LANE_NONE || step > (SONG_NUM_STEPS - 1)) return song_lane_default(lane);
+	return lanes[i].val[step];
+}
+
+// set a step lane value - returns 0 if there are no free lanes
+unsigned char song_set_lane(unsigned char seq, unsigned char part, unsigned char lane,
+		unsigned char step, unsigned char value) {
+	unsigned char i, def;
+	int j;
+	if(seq > (SONG_NUM_SEQ - 1)) return 1;
+	if(part > (SONG_NUM_PARTS - 1)) return 1;
+	if(lane > (SONG_NUM_LANE_TYPES - 1)) return 1;
+	if(step > (SONG_NUM_STEPS - 1)) return 1;
+	if((lane == SONG_LANE_CC1 || lane == SONG_LANE_CC2) && value > 127) {
+		value = SONG_LANE_HOLD;
+	}
+	def = song_lane_default(lane);
+	i = song_find_lane(seq, part, lane);
+	// take a lane from the pool
+	if(i == LANE_NONE) {
+		if(value == def) return 1;
+		for(i = 0; i < SONG_NUM_LANES && lanes[i].seq != LANE_FREE; i ++);
+		if(i == SONG_NUM_LANES) return 0;
+		lanes[i].seq = seq;
+		lanes[i].part = part;
+		lanes[i].type = lane;
+		for(j = 0; j < SONG_NUM_STEPS; j ++) {
+			lanes[i].val[j] = def;
+		}
+	}
+	SONG_DIRTY(seq);
+	song_journal_add(seq, part | (lane << 4), JRNL_LANE, step, lanes[i].val[step], value);
+	lanes[i].val[step] = value;
+	// give the lane back when it is all defaults
+	if(value == def) {
+		for(j = 0; j < SONG_NUM_STEPS && lanes[i].val[j] == def; j ++);
+		if(j == SONG_NUM_STEPS) lanes[i].seq = LANE_FREE;
+	}
+	return 1;
+}
+
+// clear a step lane
+void song_clear_lane(unsigned char seq, unsigned char part, unsigned char lane) {
+	unsigned char i;
+	if(seq > (SONG_NUM_SEQ - 1)) return;
+	i = song_find_lane(seq, part, lane);
+	if(i == LANE_NONE) return;
+	SONG_DIRTY(seq);
+	song_journal_start();
+	song_journal_lane(i, 1);
+	song_journal_end();
+	lanes[i].seq = LANE_FREE;
+}
+
+// get the number of free step lanes
+unsigned char song_get_free_lanes(void) {
+	unsigned char count = 0;
+	int i;
+	for(i = 0; i < SONG_NUM_LANES; i ++) {
+		if(lanes[i].seq == LANE_FREE) count ++;
+	}
+	return count;
+}
+
+// get the ratchet count of a step - 1-8
+unsigned char song_get_ratchet(unsigned char seq, unsigned char part, unsigned char step) {
+	return (song_get_lane(seq, part, SONG_LANE_TIMING, step) & 0x07) + 1;
+}
+
+// set the ratchet count of a step - returns 0 if there are no free lanes
+unsigned char song_set_ratchet(unsigned char seq, unsigned char part, unsigned char step,
+		unsigned char ratchet) {
+	unsigned char timing = song_get_lane(seq, part, SONG_LANE_TIMING, step);
+	if(ratchet < 1) ratchet = 1;
+	if(ratchet > SONG_MAX_RATCHET) ratchet = SONG_MAX_RATCHET;
+	return song_set_lane(seq, part, SONG_LANE_TIMING, step,
+		(timing & 0xf8) | (ratchet - 1));
+}
+
+// get the nudge of a step - -7 to +7 in 1/8ths of a clock tick
+char song_get_nudge(unsigned char seq, unsigned char part, unsigned char step) {
+	char nudge = (song_get_lane(seq, part, SONG_LANE_TIMING, step) >> 3) & 0x1f;
+	if(nudge & 0x10) nudge -= 32;  // sign extend
+	if(nudge < -SONG_MAX_NUDGE) return -SONG_MAX_NUDGE;
+	if(nudge > SONG_MAX_NUDGE) return SONG_MAX_NUDGE;
+	return nudge;
+}
+
+// set the nudge of a step - returns 0 if there are no free lanes
+unsigned char song_set_nudge(unsigned char seq, unsigned char part, unsigned char step,
+		char nudge) {
+	unsigned char timing = song_get_lane(seq, part, SONG_LANE_TIMING, step);
+	if(nudge < -SONG_MAX_NUDGE) nudge = -SONG_MAX_NUDGE;
+	if(nudge > SONG_MAX_NUDGE) nudge = SONG_MAX_NUDGE;
+	return song_set_lane(seq, part, SONG_LANE_TIMING, step,
+		(timing & 0x07) | ((nudge << 3) & 0xf8));
+}
+
+// get the condition of a step
+unsigned char song_get_cond(unsigned char seq, unsigned char part, unsigned char step) {
+	return song_get_lane(seq, part, SONG_LANE_COND, step);
+}
+
+// set the condition of a step - returns 0 if there are no free lanes
+unsigned char song_set_cond(unsigned char seq, unsigned char part, unsigned char step,
+		unsigned char cond) {
+	if(!song_cond_valid(cond)) return 1;
+	return song_set_lane(seq, part, SONG_LANE_COND, step, cond);
+}
+
+// check if a part has any step conditions
+unsigned char song_has_conds(unsigned char seq, unsigned char part) {
+	if(seq > (SONG_NUM_SEQ - 1)) return 0;
+	if(part > (SONG_NUM_PARTS - 1)) return 0;
+	return song_find_lane(seq, part, SONG_LANE_COND) != LANE_NONE;
+}
+
+// get the seq gate
+unsigned char song_get_gate(unsigned char seq, unsigned char part) {
+	if(seq > (SONG_NUM_SEQ - 1)) return 0;
+	if(part > (SONG_NUM_PARTS - 1)) return 0;
+	if(part > 1) return mparts[seq].gate[MIDI_PART(part)];
+	if(part == 1) return seqs[seq].gate2;
+	return seqs[seq].gate1;
+}
+
+// set the seq gate
+void song_set_gate(unsigned char seq, unsigned char part, unsigned char gate) {
+	unsigned char *p;
+	unsigned char gat = gate;
+	if(gat > 48) gat = 48;
+	else if(gat < 1) gat = 1;
+	if(seq > (SONG_NUM_SEQ - 1)) return;
+	if(part > (SONG_NUM_PARTS - 1)) return;
+	SONG_DIRTY(seq);
+	if(part > 1) p = &mparts[seq].gate[MIDI_PART(part)];
+	else if(part == 1) p = &seqs[seq].gate2;
+	else p = &seqs[seq].gate1;
+	song_write_byte(seq, p, gat);
+}
+
+// set the seq scale
+unsigned char song_get_scale(unsigned char seq, unsigned char part) {
+	if(seq > (SONG_NUM_SEQ - 1)) return 0;
+	if(part > (SONG_NUM_PARTS - 1)) return 0;
+	if(part > 1) return mparts[seq].scale[MIDI_PART(part)];
+	if(part == 1) return seqs[seq].scale2;
+	return seqs[seq].scale1;
+}
+
+// get the seq scale
+void song_set_scale(unsigned char seq, unsigned char part, unsigned char scale) {
+	unsigned char *p;
+	unsigned char scl = scale;
+	if(scl > 7) scl = 7;
+	if(seq > (SONG_NUM_SEQ - 1)) return;
+	if(part > (SONG_NUM_PARTS - 1)) return;
+	SONG_DIRTY(seq);
+	if(part > 1) p = &mparts[seq].scale[MIDI_PART(part)];
+	else if(part == 1) p = &seqs[seq].scale2;
+	else p = &seqs[seq].scale1;
+	song_write_byte(seq, p, scl);
+}
+
+// get the seq span
+unsigned char song_get_span(unsigned char seq, unsigned char part) {
+	if(seq > (SONG_NUM_SEQ - 1)) return 0;
+	if(part > (SONG_NUM_PARTS - 1)) return 0;
+	if(part > 1) return mparts[seq].span[MIDI_PART(part)];
+	if(part == 1) return seqs[seq].span2;
+	return seqs[seq].span1;
+}
+
+// set the seq span
+void song_set_span(unsigned char seq, unsigned char part, unsigned char span) {
+	unsigned char *p;
+	unsigned char spn = span;
+	if(spn < 1) spn = 1;
+	else if(spn > 4) spn = 4;
+	if(seq > (SONG_NUM_SEQ - 1)) return;
+	if(part > (SONG_NUM_PARTS - 1)) return;
+	SONG_DIRTY(seq);
+	if(part > 1) p = &mparts[seq].span[MIDI_PART(part)];
+	else if(part == 1) p = &seqs[seq].span2;
+	else p = &seqs[seq].span1;
+	song_write_byte(seq, p, spn);
+}
+
+// get the seq offset
+char song_get_offset(unsigned char seq, unsigned char part) {
+	if(seq > (SONG_NUM_SEQ - 1)) return 0;
+	if(part > (SONG_NUM_PARTS - 1)) return 0;
+	if(part > 1) return mparts[seq].offset[MIDI_PART(part)];
+	if(part == 1) return seqs[seq].offset2;
+	return seqs[seq].offset1;
+}
+
+// set the seq offset
+void song_set_offset(unsigned char seq, unsigned char part, char offset) {
+	unsigned char *p;
+	char offst = offset;
+	if(offst < -12) offst = -12;
+	else if(offst > 12) offst = 12;
+	if(seq > (SONG_NUM_SEQ - 1)) return;
+	if(part > (SONG_NUM_PARTS - 1)) return;
+	SONG_DIRTY(seq);
+	if(part > 1) p = (unsigned char *)&mparts[seq].offset[MIDI_PART(part)];
+	else if(part == 1) p = (unsigned char *)&seqs[seq].offset2;
+	else p = (unsigned char *)&seqs[seq].offset1;
+	song_write_byte(seq, p, offst);
+}
+
+// get the start override of a part - SONG_PART_FOLLOW if it follows the seq
+unsigned char song_get_part_start(unsigned char seq, unsigned char part) {
+	unsigned char start;
+	if(seq > (SONG_NUM_SEQ - 1)) return SONG_PART_FOLLOW;
+	if(part > (SONG_NUM_PARTS - 1)) return SONG_PART_FOLLOW;
+	if(part > 1) start = mparts[seq].part_start[MIDI_PART(part)];
+	else start = seqs[seq].part_start[part];
+	if(start > (song_get_seq_steps(seq) - 1)) return SONG_PART_FOLLOW;
+	return start;
+}
+
+// set the start override of a part - SONG_PART_FOLLOW to follow the seq
+void song_set_part_start(unsigned char seq, unsigned char part, unsigned char start) {
+	if(seq > (SONG_NUM_SEQ - 1)) return;
+	if(part > (SONG_NUM_PARTS - 1)) return;
+	SONG_DIRTY(seq);
+	if(start > (song_get_seq_steps(seq) - 1)) start = SONG_PART_FOLLOW;
+	if(part > 1) song_write_byte(seq, &mparts[seq].part_start[MIDI_PART(part)], start);
+	else song_write_byte(seq, &seqs[seq].part_start[part], start);
+}
+
+// get the length override of a part - SONG_PART_FOLLOW if it follows the seq
+unsigned char song_get_part_len(unsigned char seq, unsigned char part) {
+	unsigned char len;
+	if(seq > (SONG_NUM_SEQ - 1)) return SONG_PART_FOLLOW;
+	if(part > (SONG_NUM_PARTS - 1)) return SONG_PART_FOLLOW;
+	if(part > 1) len = mparts[seq].part_len[MIDI_PART(part)];
+	else len = seqs[seq].part_len[part];
+	if(len < 1 || len > song_get_seq_steps(seq)) return SONG_PART_FOLLOW;
+	return len;
+}
+
+// set the length override of a part - SONG_PART_FOLLOW to follow the seq
+void song_set_part_len(unsigned char seq, unsigned char part, unsigned char len) {
+	if(seq > (SONG_NUM_SEQ - 1)) return;
+	if(part > (SONG_NUM_PARTS - 1)) return;
+	SONG_DIRTY(seq);
+	if(len < 1 || len > song_get_seq_steps(seq)) len = SONG_PART_FOLLOW;
+	if(part > 1) song_write_byte(seq, &mparts[seq].part_len[MIDI_PART(part)], len);
+	else song_write_byte(seq, &seqs[seq].part_len[part], len);
+}
+
+// get the dir override of a part - SONG_PART_FOLLOW if it follows the seq
+unsigned char song_get_part_dir(unsigned char seq, unsigned char part) {
+	unsigned char dir;
+	if(seq > (SONG_NUM_SEQ - 1)) return SONG_PART_FOLLOW;
+	if(part > (SONG_NUM_PARTS - 1)) return SONG_PART_FOLLOW;
+	if(part > 1) dir = mparts[seq].part_dir[MIDI_PART(part)];
+	else dir = seqs[seq].part_dir[part];
+	if(dir > SONG_MAX_DIR) return SONG_PART_FOLLOW;
+	return dir;
+}
+
+// set the dir override of a part - SONG_PART_FOLLOW to follow the seq
+void song_set_part_dir(unsigned char seq, unsigned char part, unsigned char dir) {
+	if(seq > (SONG_NUM_SEQ - 1)) return;
+	if(part > (SONG_NUM_PARTS - 1)) return;
+	SONG_DIRTY(seq);
+	if(dir > SONG_MAX_DIR) dir = SONG_PART_FOLLOW;
+	if(part > 1) song_write_byte(seq, &mparts[seq].part_dir[MIDI_PART(part)], dir);
+	else song_write_byte(seq, &seqs[seq].part_dir[part], dir);
+}
+
+// get the clock divide override of a part - SONG_PART_FOLLOW if it uses the system div
+unsigned char song_get_part_div(unsigned char seq, unsigned char part) {
+	unsigned char div;
+	if(seq > (SONG_NUM_SEQ - 1)) return SONG_PART_FOLLOW;
+	if(part > (SONG_NUM_PARTS - 1)) return SONG_PART_FOLLOW;
+	if(part > 1) div = mparts[seq].part_div[MIDI_PART(part)];
+	else div = seqs[seq].part_div[part];
+	if(div < 1 || div > SONG_MAX_PART_DIV) return SONG_PART_FOLLOW;
+	return div;
+}
+
+// set the clock divide override of a part - SONG_PART_FOLLOW to use the system div
+void song_set_part_div(unsigned char seq, unsigned char part, unsigned char div) {
+	if(seq > (SONG_NUM_SEQ - 1)) return;
+	if(part > (SONG_NUM_PARTS - 1)) return;
+	SONG_DIRTY(seq);
+	if(div < 1 || div > SONG_MAX_PART_DIV) div = SONG_PART_FOLLOW;
+	if(part > 1) song_write_byte(seq, &mparts[seq].part_div[MIDI_PART(part)], div);
+	else song_write_byte(seq, &seqs[seq].part_div[part], div);
+}
+
+// copy the notes of a part to another part in the same seq
+void song_part_copy(unsigned char seq, unsigned char src, unsigned char dest) {
+	unsigned char buf[SONG_NUM_STEPS];
+	if(seq > (SONG_NUM_SEQ - 1)) return;
+	if(src > (SONG_NUM_PARTS - 1)) return;
+	if(dest > (SONG_NUM_PARTS - 1)) return;
+	song_part_read(seq, src, buf);
+	song_part_write(seq, dest, buf);
+}
+
+// invert the intervals in the selected part
+void song_part_invert(unsigned char seq, unsigned char part) {
+	if(seq > (SONG_NUM_SEQ - 1)) return;
+	if(part > (SONG_NUM_PARTS - 1)) return;
+	unsigned char buf[SONG_NUM_STEPS];
+	int i;
+	song_part_read(seq, part, buf);
+	for(i = 0; i < song_get_seq_steps(seq); i ++) {
+		if(buf[i] < 49) {
+			buf[i] = 48 - buf[i];
+		}	
+	}	
+	song_part_write(seq, part, buf);
+}
+
+// retrograde the selected part
+void song_part_retrograde(unsigned char seq, unsigned char part) {
+	if(seq > (SONG_NUM_SEQ - 1)) return;
+	if(part > (SONG_NUM_PARTS - 1)) return;
+	unsigned char buf[SONG_NUM_STEPS];
+	int i, j;
+	unsigned char temp;
+	song_part_read(seq, part, buf);
+	j = song_get_seq_steps(seq) - 1;
+	for(i = 0; i < (song_get_seq_steps(seq) >> 1); i ++) {
+		temp = buf[i];
+		buf[i] = buf[j];
+		buf[j] = temp;
+		j --;
+	}	
+	song_part_write(seq, part, buf);
+}
+
+// randomize a part
+void song_part_randomize(unsigned char seq, unsigned char part) {
+	if(seq > (SONG_NUM_SEQ - 1)) return;
+	if(part > (SONG_NUM_PARTS - 1)) return;
+	int i;
+	song_journal_start();
+	for(i = 0; i < song_get_seq_steps(seq); i ++) {
+		song_set_note(seq, part, i, rand() & 0x3f);
+	}
+	song_journal_end();
+}
+
+// clear the selected part
+void song_part_clear(unsigned char seq, unsigned char part) {
+	if(seq > (SONG_NUM_SEQ - 1)) return;
+	if(part > (SONG_NUM_PARTS - 1)) return;
+	unsigned char buf[SONG_NUM_STEPS];
+	int i;
+	for(i = 0; i < song_get_seq_steps(seq); i ++) {
+		buf[i] = SONG_STEP_REST;  // rest
+	}
+	song_part_write(seq, part, buf);
+}
+
+//
+// pattern generators
+//
+// - the new steps are made in a buffer and written to the part at once
+//   so that a playing part never plays half of the old and new pattern
+// - the gate patterns play the note already on a step, or the last note
+//   before it if the step was a rest
+//
+// make a euclidean gate pattern of hits spread over len steps in the selected part
+void song_part_euclid(unsigned char seq, unsigned char part, unsigned char hits,
+		unsigned char len, unsigned char rotate) {
+	unsigned char buf[SONG_NUM_STEPS];
+	int i, pos;
+	if(seq > (SONG_NUM_SEQ - 1)) return;
+	if(part > (SONG_NUM_PARTS - 1)) return;
+	if(len < 1 || len > SONG_NUM_STEPS) return;
+	if(hits > len) hits = len;
+	for(i = 0; i < song_get_seq_steps(seq); i ++) {
+		pos = ((i % len) + len - (rotate % len)) % len;
+		buf[i] = ((pos * hits) % len) < hits;
+	}
+	song_part_gates(seq, part, buf);
+}
+
+// rotate the steps of the selected part later by a number of steps
+void song_part_rotate(unsigned char seq, unsigned char part, unsigned char steps) {
+	unsigned char buf[SONG_NUM_STEPS], rot[SONG_NUM_STEPS];
+	int i, len;
+	if(seq > (SONG_NUM_SEQ - 1)) return;
+	if(part > (SONG_NUM_PARTS - 1)) return;
+	len = song_get_seq_steps(seq);
+	song_part_read(seq, part, buf);
+	for(i = 0; i < len; i ++) {
+		rot[(i + steps) % len] = buf[i];
+	}
+	song_part_write(seq, part, rot);
+}
+
+// shift the steps of the selected part by -63 to +63 steps - rests are shifted in
+void song_part_shift(unsigned char seq, unsigned char part, char steps) {
+	unsigned char buf[SONG_NUM_STEPS], shift[SONG_NUM_STEPS];
+	int i, len;
+	if(seq > (SONG_NUM_SEQ - 1)) return;
+	if(part > (SONG_NUM_PARTS - 1)) return;
+	len = song_get_seq_steps(seq);
+	song_part_read(seq, part, buf);
+	for(i = 0; i < len; i ++) {
+		if((i - steps) < 0 || (i - steps) > (len - 1)) shift[i] = SONG_STEP_REST;
+		else shift[i] = buf[i - steps];
+	}
+	song_part_write(seq, part, shift);
+}
+
+// make a random gate pattern in the selected part - density is 0-100 percent
+void song_part_random_gates(unsigned char seq, unsigned char part, unsigned char density) {
+	unsigned char buf[SONG_NUM_STEPS];
+	int i;
+	if(seq > (SONG_NUM_SEQ - 1)) return;
+	if(part > (SONG_NUM_PARTS - 1)) return;
+	for(i = 0; i < song_get_seq_steps(seq); i ++) {
+		buf[i] = (rand() % 100) < density;
+	}
+	song_part_gates(seq, part, buf);
+}
+
+// make new notes in the selected part that move like the notes already in it
+//
+// - each new step follows a random step of the part that has the same
+//   value as the step before it, so the part keeps the moves and rests
+//   it had without needing a table of them
+//
+void song_part_markov(unsigned char seq, unsigned char part) {
+	unsigned char buf[SONG_NUM_STEPS], gen[SONG_NUM_STEPS];
+	int i, j, len, count, pick;
+	if(seq > (SONG_NUM_SEQ - 1)) return;
+	if(part > (SONG_NUM_PARTS - 1)) return;
+	len = song_get_seq_steps(seq);
+	song_part_read(seq, part, buf);
+	gen[0] = buf[rand() % len];
+	for(i = 1; i < len; i ++) {
+		count = 0;
+		for(j = 0; j < len; j ++) {
+			if(buf[j] == gen[i - 1]) count ++;
+		}
+		pick = rand() % count;
+		for(j = 0; j < len; j ++) {
+			if(buf[j] != gen[i - 1]) continue;
+			if(pick == 0) break;
+			pick --;
+		}
+		gen[i] = buf[(j + 1) % len];
+	}
+	song_part_write(seq, part, gen);
+}
+
+// get the number of arrangement entries - 0 if the seqs follow their next settings
+unsigned char song_get_arr_len(void) {
+	return arr_len;
+}
+
+// set the number of arrangement entries - the arrangement can only be made shorter
+void song_set_arr_len(unsigned char len) {
+	if(len >= arr_len) return;
+	arr_len = len;
+	SONG_DIRTY(SONG_DIRTY_ARR);
+}
+
+// get the seq of an arrangement entry
+unsigned char song_get_arr_seq(unsigned char entry) {
+	if(entry > (arr_len - 1)) return 0;
+	return arr[entry].seq;
+}
+
+// get the repeat count of an arrangement entry - 1-16
+unsigned char song_get_arr_repeat(unsigned char entry) {
+	if(entry > (arr_len - 1)) return 1;
+	return arr[entry].repeat;
+}
+
+// get the transpose of an arrangement entry - -12 to +12 semitones
+char song_get_arr_transpose(unsigned char entry) {
+	if(entry > (arr_len - 1)) return 0;
+	return arr[entry].transpose;
+}
+
+// set an arrangement entry - setting the entry after the last adds an entry
+void song_set_arr_entry(unsigned char entry, unsigned char seq, unsigned char repeat,
+		char transpose) {
+	if(entry > arr_len || entry > (SONG_ARR_LEN - 1)) return;
+	if(seq > (SONG_NUM_SEQ - 1)) seq = SONG_NUM_SEQ - 1;
+	if(repeat < 1) repeat = 1;
+	if(repeat > SONG_ARR_MAX_REPEAT) repeat = SONG_ARR_MAX_REPEAT;
+	if(transpose < -SONG_ARR_MAX_TRANSPOSE) transpose = -SONG_ARR_MAX_TRANSPOSE;
+	if(transpose > SONG_ARR_MAX_TRANSPOSE) transpose = SONG_ARR_MAX_TRANSPOSE;
+	arr[entry].seq = seq;
+	arr[entry].repeat = repeat;
+	arr[entry].transpose = transpose;
+	if(entry == arr_len) arr_len ++;
+	SONG_DIRTY(SONG_DIRTY_ARR);
+}
+
+// clear the undo journal
+void song_journal_clear(void) {
+	jrnl_pos = 0;
+	jrnl_undo = 0;
+	jrnl_redo = 0;
+	jrnl_single = 0;
+	jrnl_lost = 0;
+}
+
+// undo the last edit - returns 0 if there is nothing to undo
+unsigned char song_undo(void) {
+	unsigned char group;
+	if(jrnl_undo == 0) return 0;
+	group = jrnl[JRNL_PREV(jrnl_pos)].group;
+	jrnl_off ++;
+	while(jrnl_undo && jrnl[JRNL_PREV(jrnl_pos)].group == group) {
+		jrnl_pos = JRNL_PREV(jrnl_pos);
+		jrnl_undo --;
+		jrnl_redo ++;
+		if(jrnl[jrnl_pos].field != JRNL_DATA) song_journal_apply(jrnl_pos, 1);
+	}
+	jrnl_off --;
+	jrnl_single = 0;
+	return 1;
+}
+
+// redo the last edit that was undone - returns 0 if there is nothing to redo
+unsigned char song_redo(void) {
+	unsigned char group;
+	if(jrnl_redo == 0) return 0;
+	group = jrnl[jrnl_pos].group;
+	jrnl_off ++;
+	while(jrnl_redo && jrnl[jrnl_pos].group == group) {
+		if(jrnl[jrnl_pos].field != JRNL_DATA) song_journal_apply(jrnl_pos, 0);
+		jrnl_pos = JRNL_NEXT(jrnl_pos);
+		jrnl_undo ++;
+		jrnl_redo --;
+	}
+	jrnl_off --;
+	jrnl_single = 0;
+	return 1;
+}
+
+//
+// LOCAL FUNCTIONS
+//
+// get the packing code for a step value - notes of both parts then step lengths
+unsigned char song_pack_code(unsigned char seq, unsigned char index) {
+	unsigned char val;
+	// step lengths
+	if(index >= (SONG_PAGE_STEPS * 2)) {
+		val = seqs[seq].step_len[index - (SONG_PAGE_STEPS * 2)];
+		if(val > 31) return 31;
+		return val;
+	}
+	// notes
+	return song_pack_note_code(seqs[seq].notes[index / SONG_PAGE_STEPS][index % SONG_PAGE_STEPS]);
+}
+
+// get the packing code for a step page value - notes of each part then step lengths
+unsigned char song_pack_page_code(step_page *pg, unsigned int index) {
+	unsigned char val;
+	// step lengths
+	if(index >= (SONG_NUM_PARTS * SONG_PAGE_STEPS)) {
+		val = pg->step_len[index - (SONG_NUM_PARTS * SONG_PAGE_STEPS)];
+		if(val > 31) return 31;
+		return val;
+	}
+	// notes
+	return song_pack_note_code(pg->notes[index / SONG_PAGE_STEPS][index % SONG_PAGE_STEPS]);
+}
+
+// get the packing code for a note
+unsigned char song_pack_note_code(unsigned char note) {
+	if(note < 49) return note;
+	if(note == SONG_STEP_RAND) return PACK_CODE_RAND;
+	if(note == SONG_STEP_NONE) return PACK_CODE_NONE;
+	return PACK_CODE_REST;  // rests and invalid notes
+}
+
+// get the note for a packing code
+unsigned char song_unpack_note_code(unsigned char code) {
+	if(code == PACK_CODE_RAND) return SONG_STEP_RAND;
+	if(code == PACK_CODE_NONE) return SONG_STEP_NONE;
+	if(code == PACK_CODE_REST) return SONG_STEP_REST;
+	return code;
+}
+
+// get the notes of a part in the first step page
+unsigned char *song_part_notes(unsigned char seq, unsigned char part) {
+	if(part > 1) return mparts[seq].notes[MIDI_PART(part)];
+	return seqs[seq].notes[part];
+}
+
+// get a step note - NULL if the step is past the end of the seq
+unsigned char *song_step_note(unsigned char seq, unsigned char part, unsigned char step) {
+	if(step < SONG_PAGE_STEPS) return song_part_notes(seq, part) + step;
+	if(step > (song_get_seq_steps(seq) - 1)) return NULL;
+	return &ext_pages[page_map[seq][(step / SONG_PAGE_STEPS) - 1]].notes[part][step % SONG_PAGE_STEPS];
+}
+
+// get a step length - NULL if the step is past the end of the seq
+unsigned char *song_step_len(unsigned char seq, unsigned char step) {
+	if(step < SONG_PAGE_STEPS) return &seqs[seq].step_len[step];
+	if(step > (song_get_seq_steps(seq) - 1)) return NULL;
+	return &ext_pages[page_map[seq][(step / SONG_PAGE_STEPS) - 1]].step_len[step % SONG_PAGE_STEPS];
+}
+
+// find the pool lane used by a part of a seq - LANE_NONE if it has none
+unsigned char song_find_lane(unsigned char seq, unsigned char part, unsigned char lane) {
+	unsigned char i;
+	for(i = 0; i < SONG_NUM_LANES; i ++) {
+		if(lanes[i].seq == seq && lanes[i].part == part && lanes[i].type == lane) return i;
+	}
+	return LANE_NONE;
+}
+
+// get the value of the steps of a lane that are not set
+unsigned char song_lane_default(unsigned char lane) {
+	if(lane == SONG_LANE_VEL || lane == SONG_LANE_TIMING) return 0;
+	if(lane == SONG_LANE_COND) return SONG_COND_ALWAYS;
+	return SONG_LANE_HOLD;
+}
+
+// return the step lanes of a seq to the pool
+void song_free_lanes(unsigned char seq) {
+	int i;
+	for(i = 0; i < SONG_NUM_LANES; i ++) {
+		if(lanes[i].seq == seq) lanes[i].seq = LANE_FREE;
+	}
+}
+
+// check a step condition value
+unsigned char song_cond_valid(unsigned char cond) {
+	unsigned char of;
+	if(cond & SONG_COND_RATIO) {
+		if(cond & 0x40) return 0;
+		of = (cond >> 3) & 0x07;  // count - 1
+		return of != 0 && (cond & 0x07) <= of;  // the pass must be within the count
+	}
+	return cond <= SONG_COND_NOT_FILL;
+}
+
+// read the steps of a part into a buffer
+void song_part_read(unsigned char seq, unsigned char part, unsigned char buf[]) {
+	int i;
+	for(i = 0; i < song_get_seq_steps(seq); i ++) {
+		buf[i] = *song_step_note(seq, part, i);
+	}
+}
+
+// write a buffer into the steps of a part
+void song_part_write(unsigned char seq, unsigned char part, unsigned char buf[]) {
+	unsigned char *p;
+	int i;
+	SONG_DIRTY(seq);
+	song_journal_start();
+	for(i = 0; i < song_get_seq_steps(seq); i ++) {
+		p = song_step_note(seq, part, i);
+		song_journal_add(seq, part, JRNL_NOTE, i, *p, buf[i]);
+		*p = buf[i];
+	}
+	song_journal_end();
+}
+
+// write a gate pattern into a part - the buffer holds 1 for each step that plays
+void song_part_gates(unsigned char seq, unsigned char part, unsigned char buf[]) {
+	unsigned char notes[SONG_NUM_STEPS];
+	unsigned char note;
+	int i, len;
+	len = song_get_seq_steps(seq);
+	song_part_read(seq, part, notes);
+	// start with the last note of the part so the first steps have one
+	note = 24;
+	for(i = 0; i < len; i ++) {
+		if(notes[i] < SONG_STEP_RAND) note = notes[i];
+	}
+	for(i = 0; i < len; i ++) {
+		if(notes[i] < SONG_STEP_RAND) note = notes[i];
+		if(buf[i]) buf[i] = note;
+		else buf[i] = SONG_STEP_REST;
+	}
+	song_part_write(seq, part, buf);
+}
+
+// write a byte of the sequence or MIDI only parts structure of a seq
+void song_write_byte(unsigned char seq, unsigned char *p, unsigned char val) {
+	unsigned char *base = (unsigned char *)&seqs[seq];
+	if(p >= base && p < (base + sizeof(sequence))) {
+		song_journal_add(seq, 0, JRNL_SEQ, p - base, *p, val);
+	}
+	else {
+		song_journal_add(seq, 0, JRNL_MPARTS, p - (unsigned char *)&mparts[seq], *p, val);
+	}
+	*p = val;
+}
+
+// start an edit that changes many values - the changes are undone together
+void song_journal_start(void) {
+	if(jrnl_open == 0) {
+		jrnl_new = 1;
+		jrnl_single = 0;
+		jrnl_lost = 0;
+	}
+	jrnl_open ++;
+}
+
+// end an edit that changes many values
+void song_journal_end(void) {
+	if(jrnl_open) jrnl_open --;
+}
+
+// add a change to the journal
+void song_journal_add(unsigned char seq, unsigned char part, unsigned char field,
+		unsigned char step, unsigned char old_val, unsigned char new_val) {
+	jrnl_rec *rec;
+	unsigned char list;
+	int i;
+	if(jrnl_off) return;
+	if(old_val == new_val) return;
+	rec = &jrnl[JRNL_PREV(jrnl_pos)];
+	// a single change - turning the same value again replaces the last change
+	if(jrnl_open == 0) {
+		if(jrnl_single && jrnl_undo && jrnl_redo == 0 && rec->seq == seq &&
+				rec->part == part && rec->field == field && rec->step == step) {
+			rec->new_val = new_val;
+			return;
+		}
+		jrnl_new = 1;
+		jrnl_single = 1;
+		jrnl_lost = 0;
+	}
+	if(jrnl_lost) return;
+	jrnl_redo = 0;  // the edits that were undone can't be redone now
+	// the next step of the last run
+	rec = &jrnl[jrnl_hdr];
+	if(!jrnl_new && rec->seq == seq && rec->part == part &&
+			(rec->field & JRNL_TYPE) == field && (rec->step + rec->count) == step &&
+			rec->count < 255) {
+		list = rec->field & (JRNL_OLD_LIST | JRNL_NEW_LIST);
+		if(list == 0 && rec->old_val == old_val && rec->new_val == new_val) {
+			rec->count ++;
+			return;
+		}
+		// a single step run is made into a list
+		if(list == 0 && rec->count == 1) {
+			if(rec->new_val == new_val) list = JRNL_OLD_LIST;
+			else if(rec->old_val == old_val) list = JRNL_NEW_LIST;
+			else list = JRNL_OLD_LIST | JRNL_NEW_LIST;
+			if(!song_journal_rec()) return;
+			jrnl[JRNL_PREV(jrnl_pos)].field = JRNL_DATA;
+			if(list == JRNL_NEW_LIST) JRNL_VAL(jrnl_hdr, 0) = rec->new_val;
+			else JRNL_VAL(jrnl_hdr, 0) = rec->old_val;
+			if(list == (JRNL_OLD_LIST | JRNL_NEW_LIST)) JRNL_VAL(jrnl_hdr, 1) = rec->new_val;
+			rec->field |= list;
+		}
+		if(list == (JRNL_OLD_LIST | JRNL_NEW_LIST) ||
+				(list == JRNL_OLD_LIST && rec->new_val == new_val) ||
+				(list == JRNL_NEW_LIST && rec->old_val == old_val)) {
+			i = rec->count;
+			if(list == (JRNL_OLD_LIST | JRNL_NEW_LIST)) i <<= 1;
+			if((i % JRNL_DATA_VALS) == 0) {
+				if(!song_journal_rec()) return;
+				jrnl[JRNL_PREV(jrnl_pos)].field = JRNL_DATA;
+			}
+			if(list & JRNL_OLD_LIST) JRNL_VAL(jrnl_hdr, i) = old_val;
+			if(list == (JRNL_OLD_LIST | JRNL_NEW_LIST)) i ++;
+			if(list & JRNL_NEW_LIST) JRNL_VAL(jrnl_hdr, i) = new_val;
+			rec->count ++;
+			return;
+		}
+	}
+	if(jrnl_new) {
+		jrnl_group ++;
+		jrnl_new = 0;
+	}
+	if(!song_journal_rec()) return;
+	jrnl_hdr = JRNL_PREV(jrnl_pos);
+	rec = &jrnl[jrnl_hdr];
+	rec->field = field;
+	rec->seq = seq;
+	rec->part = part;
+	rec->step = step;
+	rec->count = 1;
+	rec->old_val = old_val;
+	rec->new_val = new_val;
+}
+
+// take the next record for the current edit - returns 0 if the edit is too big to keep
+//  - the oldest edits are dropped to make room
+unsigned char song_journal_rec(void) {
+	unsigned char group;
+	if(jrnl_undo == SONG_JOURNAL_LEN) {
+		group = jrnl[jrnl_pos].group;
+		if(group == jrnl_group) {
+			song_journal_clear();
+			jrnl_lost = 1;
+			return 0;
+		}
+		while(jrnl_undo && jrnl[(jrnl_pos + SONG_JOURNAL_LEN - jrnl_undo) %
+				SONG_JOURNAL_LEN].group == group) {
+			jrnl_undo --;
+		}
+	}
+	jrnl[jrnl_pos].group = jrnl_group;
+	jrnl_pos = JRNL_NEXT(jrnl_pos);
+	jrnl_undo ++;
+	return 1;
+}
+
+// set the old or new values of a journal record
+void song_journal_apply(unsigned char pos, unsigned char old) {
+	jrnl_rec *rec = &jrnl[pos];
+	unsigned char *p, val, list;
+	int i;
+	SONG_DIRTY(rec->seq);
+	list = rec->field & (JRNL_OLD_LIST | JRNL_NEW_LIST);
+	for(i = 0; i < rec->count; i ++) {
+		if(list == (JRNL_OLD_LIST | JRNL_NEW_LIST)) val = JRNL_VAL(pos, (i << 1) + !old);
+		else if(old && list == JRNL_OLD_LIST) val = JRNL_VAL(pos, i);
+		else if(!old && list == JRNL_NEW_LIST) val = JRNL_VAL(pos, i);
+		else if(old) val = rec->old_val;
+		else val = rec->new_val;
+		p = NULL;
+		if((rec->field & JRNL_TYPE) == JRNL_NOTE) {
+			p = song_step_note(rec->seq, rec->part, rec->step + i);
+		}
+		else if((rec->field & JRNL_TYPE) == JRNL_STEP_LEN) {
+			p = song_step_len(rec->seq, rec->step + i);
+		}
+		else if((rec->field & JRNL_TYPE) == JRNL_SEQ) {
+			p = (unsigned char *)&seqs[rec->seq] + rec->step + i;
+		}
+		else if((rec->field & JRNL_TYPE) == JRNL_MPARTS) {
+			p = (unsigned char *)&mparts[rec->seq] + rec->step + i;
+		}
+		else if((rec->field & JRNL_TYPE) == JRNL_LANE) {
+			song_set_lane(rec->seq, rec->part & 0x0f, rec->part >> 4, rec->step + i, val);
+		}
+		else if((rec->field & JRNL_TYPE) == JRNL_PAGES) {
+			song_set_seq_pages(rec->seq, val);
+		}
+		if(p != NULL) *p = val;
+	}
+}
+
+// journal the notes and step lengths of a seq from a step to the end
+//  - clear = 1 journals them being cleared, 0 journals them being set from clear
+void song_journal_steps(unsigned char seq, unsigned char from, unsigned char clear) {
+	unsigned char val;
+	int i, j;
+	for(i = 0; i < SONG_NUM_PARTS; i ++) {
+		for(j = from; j < song_get_seq_steps(seq); j ++) {
+			val = *song_step_note(seq, i, j);
+			if(clear) song_journal_add(seq, i, JRNL_NOTE, j, val, SONG_STEP_REST);
+			else song_journal_add(seq, i, JRNL_NOTE, j, SONG_STEP_REST, val);
+		}
+	}
+	for(j = from; j < song_get_seq_steps(seq); j ++) {
+		val = *song_step_len(seq, j);
+		if(clear) song_journal_add(seq, 0, JRNL_STEP_LEN, j, val, 0);
+		else song_journal_add(seq, 0, JRNL_STEP_LEN, j, 0, val);
+	}
+}
+
+// journal the step pages after the first and the lanes of a seq
+//  - clear = 1 journals them being freed, 0 journals them being set from free
+//  - the rest of the seq is journalled with song_journal_struct()
+void song_journal_seq(unsigned char seq, unsigned char clear) {
+	unsigned char pages;
+	int i;
+	pages = song_get_seq_steps(seq) / SONG_PAGE_STEPS;
+	if(clear) {
+		song_journal_steps(seq, SONG_PAGE_STEPS, 1);
+		song_journal_add(seq, 0, JRNL_PAGES, 0, pages, 1);
+	}
+	else {
+		song_journal_add(seq, 0, JRNL_PAGES, 0, 1, pages);
+		song_journal_steps(seq, SONG_PAGE_STEPS, 0);
+	}
+	for(i = 0; i < SONG_NUM_LANES; i ++) {
+		if(lanes[i].seq == seq) song_journal_lane(i, clear);
+	}
+}
+
+// journal the values of a lane
+//  - clear = 1 journals them going back to the default, 0 journals them being set
+void song_journal_lane(unsigned char lane, unsigned char clear) {
+	unsigned char def, part;
+	int i;
+	def = song_lane_default(lanes[lane].type);
+	part = lanes[lane].part | (lanes[lane].type << 4);
+	for(i = 0; i < SONG_NUM_STEPS; i ++) {
+		if(clear) song_journal_add(lanes[lane].seq, part, JRNL_LANE, i, lanes[lane].val[i], def);
+		else song_journal_add(lanes[lane].seq, part, JRNL_LANE, i, def, lanes[lane].val[i]);
+	}
+}
+
+// journal the bytes of the sequence and MIDI only parts structures that were changed
+void song_journal_struct(unsigned char seq, sequence *old_seq, midi_parts *old_mparts) {
+	unsigned char *p;
+	int i;
+	p = (unsigned char *)&seqs[seq];
+	for(i = 0; i < sizeof(sequence); i ++) {
+		if(p + i == &seqs[seq].pages) continue;  // journalled with the step pages
+		song_journal_add(seq, 0, JRNL_SEQ, i, ((unsigned char *)old_seq)[i], p[i]);
+	}
+	p = (unsigned char *)&mparts[seq];
+	for(i = 0; i < sizeof(midi_parts); i ++) {
+		song_journal_add(seq, 0, JRNL_MPARTS, i, ((unsigned char *)old_mparts)[i], p[i]);
+	}
+}
+
+// return the step pages of a seq after the first to the pool
+void song_free_pages(unsigned char seq) {
+	int i;
+	for(i = 0; i < (SONG_NUM_STEP_PAGES - 1); i ++) {
+		if(page_map[seq][i] != PAGE_FREE) page_owner[page_map[seq][i]] = PAGE_FREE;
+		page_map[seq][i] = PAGE_FREE;
+	}
+	seqs[seq].pages = 1;
+}
+
+// pack part settings into 16 bits
+unsigned int song_pack_part(unsigned char gate, unsigned char scale,
+		unsigned char span, char offset) {
+	if(gate < 1) gate = 1;
+	else if(gate > 48) gate = 48;
+	if(scale > 7) scale = 7;
+	if(span < 1) span = 1;
+	else if(span > 4) span = 4;
+	if(offset < -12) offset = -12;
+	else if(offset > 12) offset = 12;
+	return gate | (scale << 6) | ((span - 1) << 9) | ((offset + 12) << 11);
+}
+
+// pack the part overrides - returns 1 if any are used
+unsigned char song_pack_overrides(unsigned char seq, unsigned char buf[],
+		unsigned char ext) {
+	int i;
+	buf[0] = 0;
+	for(i = 0; i < 2; i ++) {
+		buf[0] |= song_pack_part_overrides(seq, i, buf + 1 + (i * PACK_OVR_LEN(ext)),
+			ext) << (i << 2);
+	}
+	return (buf[0] != 0);
+}
+
+// unpack the part overrides
+void song_unpack_overrides(unsigned char seq, unsigned char buf[], unsigned char ext) {
+	int i;
+	for(i = 0; i < 2; i ++) {
+		song_unpack_part_overrides(seq, i, (buf[0] >> (i << 2)) & 0x0f,
+			buf + 1 + (i * PACK_OVR_LEN(ext)), ext);
+	}
+}
+
+// pack the overrides of a part into 2 bytes (3 if ext is set) - returns the
+// mask of those used
+unsigned char song_pack_part_overrides(unsigned char seq, unsigned char part,
+		unsigned char buf[], unsigned char ext) {
+	unsigned char start, len, dir, div, mask = 0;
+	start = song_get_part_start(seq, part);
+	len = song_get_part_len(seq, part);
+	dir = song_get_part_dir(seq, part);
+	div = song_get_part_div(seq, part);
+	if(start != SONG_PART_FOLLOW) mask |= 0x01;
+	else start = 0;
+	if(len != SONG_PART_FOLLOW) mask |= 0x02;
+	else len = 1;
+	if(dir != SONG_PART_FOLLOW) mask |= 0x04;
+	else dir = 0;
+	if(div != SONG_PART_FOLLOW) mask |= 0x08;
+	else div = 0;
+	buf[0] = ((start & 0x0f) << 4) | ((len - 1) & 0x0f);
+	buf[1] = (dir << 5) | div;
+	if(ext) buf[2] = (start >> 4) | (((len - 1) >> 4) << 2);
+	return mask;
+}
+
+// unpack the overrides of a part that are set in the mask
+void song_unpack_part_overrides(unsigned char seq, unsigned char part,
+		unsigned char mask, unsigned char buf[], unsigned char ext) {
+	unsigned char start, len;
+	start = buf[0] >> 4;
+	len = (buf[0] & 0x0f) + 1;
+	if(ext) {
+		start |= (buf[2] & 0x03) << 4;
+		len += ((buf[2] >> 2) & 0x03) << 4;
+	}
+	if(mask & 0x01) song_set_part_start(seq, part, start);
+	if(mask & 0x02) song_set_part_len(seq, part, len);
+	if(mask & 0x04) song_set_part_dir(seq, part, buf[1] >> 5);
+	if(mask & 0x08) song_set_part_div(seq, part, buf[1] & 0x1f);
+}
+
+// pack the MIDI only parts - returns the length or 0 if none are used
+unsigned char song_pack_tracks(unsigned char seq, unsigned char buf[], unsigned char ext) {
+	unsigned char pos, code, run, mask;
+	unsigned char *notes;
+	unsigned int settings;
+	int part, i;
+	buf[0] = 0;
+	pos = 1;
+	for(part = SONG_NUM_CV_PARTS; part < SONG_NUM_PARTS; part ++) {
+		notes = song_part_notes(seq, part);
+		settings = song_pack_part(song_get_gate(seq, part), song_get_scale(seq, part),
+			song_get_span(seq, part), song_get_offset(seq, part));
+		mask = song_pack_part_overrides(seq, part, buf + pos + 3, ext);
+		// silent parts with the default settings are left out
+		if(mask == 0 && settings == song_pack_part(5, SCALE_CHROMATIC, 4, 0)) {
+			for(i = 0; i < SONG_PAGE_STEPS && notes[i] == SONG_STEP_REST; i ++);
+			if(i == SONG_PAGE_STEPS) continue;
+		}
+		buf[0] |= (1 << MIDI_PART(part));
+		buf[pos] = settings & 0xff;
+		buf[pos + 1] = (settings >> 8) & 0xff;
+		buf[pos + 2] = mask;
+		pos += 3;
+		if(mask) pos += PACK_OVR_LEN(ext);
+
+		// notes
+		i = 0;
+		while(i < SONG_PAGE_STEPS) {
+			code = song_pack_note_code(notes[i]);
+			run = 1;
+			while((i + run) < SONG_PAGE_STEPS && song_pack_note_code(notes[i + run]) == code) {
+				run ++;
+			}
+			if(run > 1) {
+				buf[pos ++] = PACK_RUN + (run - 2);
+			}
+			buf[pos ++] = code;
+			i += run;
+		}
+	}
+	if(buf[0] == 0) return 0;
+	return pos;
+}
+
+// unpack the MIDI only parts from a record - returns the position after
+// them or 0 if they are bad
+//
+// - nothing is stored unless store is set so the record can be checked first
+// - parts that this build doesn't have are skipped
+//
+unsigned char song_unpack_tracks(unsigned char seq, unsigned char buf[],
+		unsigned char pos, unsigned char store, unsigned char ext) {
+	unsigned char mask, omask, code, run, part;
+	unsigned int settings;
+	int i, j;
+	if(pos >= buf[0]) return 0;
+	mask = buf[pos ++];
+	if(mask == 0) return 0;
+	for(i = 0; i < 8; i ++) {
+		if(!(mask & (1 << i))) continue;
+		part = i + SONG_NUM_CV_PARTS;
+		if(part > (SONG_NUM_PARTS - 1)) store = 0;
+
+		// settings and overrides
+		if((pos + 3) > buf[0]) return 0;
+		settings = buf[pos] | (buf[pos + 1] << 8);
+		omask = buf[pos + 2];
+		if((settings & 0x3f) < 1 || (settings & 0x3f) > 48) return 0;
+		if(((settings >> 11) & 0x1f) > 24) return 0;
+		if(omask & 0xf0) return 0;
+		pos += 3;
+		if(omask && (pos + PACK_OVR_LEN(ext)) > buf[0]) return 0;
+		if(store) {
+			song_set_gate(seq, part, settings & 0x3f);
+			song_set_scale(seq, part, (settings >> 6) & 0x07);
+			song_set_span(seq, part, ((settings >> 9) & 0x03) + 1);
+			song_set_offset(seq, part, (char)((settings >> 11) & 0x1f) - 12);
+			song_unpack_part_overrides(seq, part, omask, buf + pos, ext);
+		}
+		if(omask) pos += PACK_OVR_LEN(ext);
+
+		// notes
+		j = 0;
+		while(j < SONG_PAGE_STEPS) {
+			if(pos >= buf[0]) return 0;
+			code = buf[pos ++];
+			run = 1;
+			if(code >= PACK_RUN) {
+				if(pos >= buf[0]) return 0;
+				run = (code - PACK_RUN) + 2;
+				code = buf[pos ++];
+			}
+			if(code >= PACK_RUN) return 0;
+			if(code > 48 && code < PACK_CODE_RAND) return 0;
+			if((j + run) > SONG_PAGE_STEPS) return 0;
+			while(run) {
+				if(store) song_set_note(seq, part, j, song_unpack_note_code(code));
+				j ++;
+				run --;
+			}
+		}
+	}
+	return pos;
+}
@@ -1,133 +1,334 @@
-/*
- * K2579 Step Sequencer - Song
- *
- * Copyright 2011: Kilpatrick Audio
- * Written by: Andrew Kilpatrick
- *
- */
-#define SONG_VERSION 0x01
-#define SONG_CONFIGURE_MARK 0x55
-
-// song parameters
-#define SONG_NUM_STEPS 16
-#define SONG_NUM_SEQ 16
-#define SONG_MAX_LOOPS 15
-
-// sequence directions
-#define SONG_DIR_BACK 0
-#define SONG_DIR_PONG 1
-#define SONG_DIR_RAND 2
-#define SONG_DIR_FWD 3
-#define SONG_MAX_DIR 3
-
-// sequence step values
-#define SONG_STEP_RAND 253
-#define SONG_STEP_NONE 254
-#define SONG_STEP_REST 255
-
-// intialize the song
-void song_init(void);
-
-// load a buffer into a sequence
-void song_load_seq_buf(unsigned char seq, unsigned char buf[]);
-
-// save a buffer from a sequence
-void song_save_seq_buf(unsigned char seq, unsigned char buf[]);
-
-// clear the song
-void song_clear_song(void);
-
-// clear a sequence
-void song_clear_seq(unsigned char seq);
-
-// copy a sequence
-void song_copy_seq(unsigned char dest, unsigned char src);
-
-// get the seq start
-unsigned char song_get_seq_start(unsigned char seq);
-
-// set the seq start
-void song_set_seq_start(unsigned char seq, unsigned char start);
-
-// get the seq len
-unsigned char song_get_seq_len(unsigned char seq);
-
-// set the seq len
-void song_set_seq_len(unsigned char seq, unsigned char len);
-
-// get a step length
-unsigned char song_get_step_len(unsigned char seq, unsigned char step);
-
-// set a step length
-void song_set_step_len(unsigned char seq, unsigned char step, unsigned char len);
-
-// get the seq dir
-unsigned char song_get_seq_dir(unsigned char seq);
-
-// set the seq dir
-void song_set_seq_dir(unsigned char seq, unsigned char dir);
-
-// get the seq loop
-unsigned char song_get_seq_loop(unsigned char seq);
-
-// set the seq loop
-void song_set_seq_loop(unsigned char seq, unsigned char loop);
-
-// get the seq next
-unsigned char song_get_seq_next(unsigned char seq);
-
-// set the seq next
-void song_set_seq_next(unsigned char seq, unsigned char next);
-
-// get a seq note
-unsigned char song_get_note(unsigned char seq, unsigned char part, unsigned char step);
-
-// set a seq note
-//
-// - note range should be 0-63 = 0-48 (notes) and 254-255 (extended note types)
-// - notes saved with their raw values
-// - prescale the value based on the span - for input control
-//
-void song_set_note(unsigned char seq, unsigned char part, unsigned char step, unsigned char note);
-
-// get the seq gate
-unsigned char song_get_gate(unsigned char seq, unsigned char part);
-
-// set the seq gate
-void song_set_gate(unsigned char seq, unsigned char part, unsigned char gate);
-
-// set the seq scale
-unsigned char song_get_scale(unsigned char seq, unsigned char part);
-
-// get the seq scale
-void song_set_scale(unsigned char seq, unsigned char part, unsigned char scale);
-
-// get the seq span
-unsigned char song_get_span(unsigned char seq, unsigned char part);
-
-// set the seq span
-void song_set_span(unsigned char seq, unsigned char part, unsigned char span);
-
-// get the seq offset
-char song_get_offset(unsigned char seq, unsigned char part);
-
-// set the seq offset
-void song_set_offset(unsigned char seq, unsigned char part, char offset);
-
-// copy a part to the other part in the same seq
-void song_part_copy(unsigned char seq, unsigned char part);
-
-// invert the intervals in the selected part
-void song_part_invert(unsigned char seq, unsigned char part);
-
-// retrograde the selected part
-void song_part_retrograde(unsigned char seq, unsigned char part);
-
-// randomize the selected part
-void song_part_randomize(unsigned char seq, unsigned char part);
-
-// clear the selected part
-void song_part_clear(unsigned char seq, unsigned char part);
-
-// get a random note - used for RAND note type
-unsigned char song_get_rand_note(void);
+/*
+ * K2579 Step Sequencer - Song
+ *
+ * Copyright 2011: Kilpatrick Audio
+ * Written by: Andrew Kilpatrick
+ *
+ */
+#define SONG_VERSION 0x01
+#define SONG_CONFIGURE_MARK 0x55
+
+// song parameters
+#define SONG_NUM_STEPS 64  // the most steps a sequence can have
+#define SONG_PAGE_STEPS 16  // steps are stored in pages of 16
+#define SONG_NUM_STEP_PAGES (SONG_NUM_STEPS / SONG_PAGE_STEPS)
+#define SONG_NUM_EXT_PAGES 16  // shared pages for the steps after step 16
+#define SONG_NUM_SEQ 16
+#define SONG_NUM_PARTS 8  // 2-8 parts - the parts after the CV parts are MIDI only
+#define SONG_NUM_CV_PARTS 2  // parts 1 and 2 have the CV / gate outputs
+#define SONG_MAX_LOOPS 15
+#define SONG_MAX_PART_DIV 24
+
+// part overrides
+#define SONG_PART_FOLLOW 255  // the part uses the sequence setting
+
+// sequence directions
+#define SONG_DIR_BACK 0
+#define SONG_DIR_PONG 1
+#define SONG_DIR_RAND 2
+#define SONG_DIR_FWD 3
+#define SONG_MAX_DIR 3
+
+// sequence step values
+#define SONG_STEP_RAND 253
+#define SONG_STEP_NONE 254
+#define SONG_STEP_REST 255
+
+// step lanes - per step values of a part that are only stored if used
+#define SONG_NUM_LANES 8  // shared lanes for all the seqs
+#define SONG_LANE_VEL 0  // 0 = default velocity, 1-127 = velocity, | SONG_LANE_ACCENT
+#define SONG_LANE_CC1 1  // 0-127 or SONG_LANE_HOLD
+#define SONG_LANE_CC2 2  // 0-127 or SONG_LANE_HOLD
+#define SONG_LANE_TIMING 3  // ratchet - 1 in bits 0-2, signed nudge in bits 3-7
+#define SONG_LANE_COND 4  // SONG_COND_ values
+#define SONG_NUM_LANE_TYPES 5
+#define SONG_LANE_ACCENT 0x80
+#define SONG_LANE_HOLD 255  // the controller is left as it is
+#define SONG_MAX_RATCHET 8  // notes played evenly through the step
+#define SONG_MAX_NUDGE 7  // +/- 1/8ths of a clock tick
+
+// step conditions - whether a step plays in a pass of the loop
+#define SONG_COND_ALWAYS 0
+#define SONG_COND_MAX_PROB 99  // 1-99 = percent chance
+#define SONG_COND_FIRST 100  // the first pass only
+#define SONG_COND_NOT_FIRST 101  // all but the first pass
+#define SONG_COND_FILL 102  // only while fill is on
+#define SONG_COND_NOT_FILL 103  // only while fill is off
+#define SONG_COND_RATIO 0x80  // | (of - 1) << 3 | (pass - 1) - pass of every 2-8
+#define SONG_COND_MAX_OF 8
+
+// song arrangement - the seqs played in order when the arrangement is used
+#define SONG_ARR_LEN 32  // entries in the arrangement
+#define SONG_ARR_MAX_REPEAT 16  // times through the seq
+#define SONG_ARR_MAX_TRANSPOSE 12  // +/- semitones
+#define SONG_DIRTY_ARR SONG_NUM_SEQ  // the arrangement's bit in the changed mask
+
+// undo journal
+#define SONG_JOURNAL_LEN 64  // edit records - 8 bytes each
+
+// packed sequence records
+// max length of a packed sequence record - 198 bytes with 8 parts
+#define SONG_PACKED_SEQ_MAX (18 + ((SONG_NUM_PARTS - SONG_NUM_CV_PARTS) * 6) + \
+	((SONG_NUM_PARTS + 1) * SONG_PAGE_STEPS))
+// max length of a packed step page record - 146 bytes with 8 parts
+#define SONG_PACKED_PAGE_MAX (2 + ((SONG_NUM_PARTS + 1) * SONG_PAGE_STEPS))
+// max length of a packed lane record - 130 bytes
+#define SONG_PACKED_LANE_MAX (2 + (SONG_NUM_STEPS * 2))
+#define SONG_LANE_RECORD 0x40  // set in byte 1 of a lane record - not a step page
+// max length of the packed arrangement - 64 bytes
+#define SONG_PACKED_ARR_MAX (SONG_ARR_LEN * 2)
+
+// intialize the song
+void song_init(void);
+
+// get the mask of sequences changed since the song was last loaded or saved
+// - bit SONG_DIRTY_ARR is set if the arrangement changed
+unsigned int song_get_dirty(void);
+
+// clear sequences from the changed mask
+void song_clear_dirty(unsigned int mask);
+
+// load a buffer into a sequence
+void song_load_seq_buf(unsigned char seq, unsigned char buf[]);
+
+// save a buffer from a sequence
+void song_save_seq_buf(unsigned char seq, unsigned char buf[]);
+
+// pack a sequence into a compact record - returns the record length
+unsigned char song_pack_seq(unsigned char seq, unsigned char buf[]);
+
+// unpack a compact record into a sequence - returns 1 if the record was valid
+unsigned char song_unpack_seq(unsigned char seq, unsigned char buf[], unsigned char len);
+
+// pack a step page of a sequence - returns the record length or 0 if the
+// sequence does not have the page
+unsigned char song_pack_page(unsigned char seq, unsigned char page, unsigned char buf[]);
+
+// unpack a step page record into a sequence - returns 1 if the record was valid
+unsigned char song_unpack_page(unsigned char seq, unsigned char buf[], unsigned char len);
+
+// pack the step lanes of a sequence - returns the length of the lane records
+unsigned int song_pack_lanes(unsigned char seq, unsigned char buf[]);
+
+// get the most bytes the records of a sequence can pack into
+unsigned int song_packed_seq_max(unsigned char seq);
+
+// unpack a lane record into a sequence - returns 1 if the record was valid
+unsigned char song_unpack_lane(unsigned char seq, unsigned char buf[], unsigned char len);
+
+// pack the arrangement - returns the length
+unsigned char song_pack_arr(unsigned char buf[]);
+
+// unpack an arrangement of a number of entries - returns 1 if it was valid
+unsigned char song_unpack_arr(unsigned char buf[], unsigned char entries);
+
+// clear the song
+void song_clear_song(void);
+
+// clear a sequence
+void song_clear_seq(unsigned char seq);
+
+// copy a sequence
+void song_copy_seq(unsigned char dest, unsigned char src);
+
+// get the seq start
+unsigned char song_get_seq_start(unsigned char seq);
+
+// set the seq start
+void song_set_seq_start(unsigned char seq, unsigned char start);
+
+// get the seq len
+unsigned char song_get_seq_len(unsigned char seq);
+
+// get the number of steps in a seq - a multiple of SONG_PAGE_STEPS
+unsigned char song_get_seq_steps(unsigned char seq);
+
+// set the number of step pages in a seq - returns 0 if there are not
+// enough free pages
+unsigned char song_set_seq_pages(unsigned char seq, unsigned char pages);
+
+// get the number of free step pages
+unsigned char song_get_free_pages(void);
+
+// set the seq len
+void song_set_seq_len(unsigned char seq, unsigned char len);
+
+// get a step length
+unsigned char song_get_step_len(unsigned char seq, unsigned char step);
+
+// set a step length
+void song_set_step_len(unsigned char seq, unsigned char step, unsigned char len);
+
+// get the seq dir
+unsigned char song_get_seq_dir(unsigned char seq);
+
+// set the seq dir
+void song_set_seq_dir(unsigned char seq, unsigned char dir);
+
+// get the seq loop
+unsigned char song_get_seq_loop(unsigned char seq);
+
+// set the seq loop
+void song_set_seq_loop(unsigned char seq, unsigned char loop);
+
+// get the seq next
+unsigned char song_get_seq_next(unsigned char seq);
+
+// set the seq next
+void song_set_seq_next(unsigned char seq, unsigned char next);
+
+// get a seq note
+unsigned char song_get_note(unsigned char seq, unsigned char part, unsigned char step);
+
+// set a seq note
+//
+// - note range should be 0-63 = 0-48 (notes) and 254-255 (extended note types)
+// - notes saved with their raw values
+// - prescale the value based on the span - for input control
+//
+void song_set_note(unsigned char seq, unsigned char part, unsigned char step, unsigned char note);
+
+// get a step lane value - the default value if the lane is not used
+unsigned char song_get_lane(unsigned char seq, unsigned char part, unsigned char lane,
+	unsigned char step);
+
+// set a step lane value - returns 0 if there are no free lanes
+unsigned char song_set_lane(unsigned char seq, unsigned char part, unsigned char lane,
+	unsigned char step, unsigned char value);
+
+// clear a step lane
+void song_clear_lane(unsigned char seq, unsigned char part, unsigned char lane);
+
+// get the number of free step lanes
+unsigned char song_get_free_lanes(void);
+
+// get the ratchet count of a step - 1-8
+unsigned char song_get_ratchet(unsigned char seq, unsigned char part, unsigned char step);
+
+// set the ratchet count of a step - returns 0 if there are no free lanes
+unsigned char song_set_ratchet(unsigned char seq, unsigned char part, unsigned char step,
+	unsigned char ratchet);
+
+// get the nudge of a step - -7 to +7 in 1/8ths of a clock tick
+char song_get_nudge(unsigned char seq, unsigned char part, unsigned char step);
+
+// set the nudge of a step - returns 0 if there are no free lanes
+unsigned char song_set_nudge(unsigned char seq, unsigned char part, unsigned char step,
+	char nudge);
+
+// get the condition of a step
+unsigned char song_get_cond(unsigned char seq, unsigned char part, unsigned char step);
+
+// set the condition of a step - returns 0 if there are no free lanes
+unsigned char song_set_cond(unsigned char seq, unsigned char part, unsigned char step,
+	unsigned char cond);
+
+// check if a part has any step conditions
+unsigned char song_has_conds(unsigned char seq, unsigned char part);
+
+// get the seq gate
+unsigned char song_get_gate(unsigned char seq, unsigned char part);
+
+// set the seq gate
+void song_set_gate(unsigned char seq, unsigned char part, unsigned char gate);
+
+// set the seq scale
+unsigned char song_get_scale(unsigned char seq, unsigned char part);
+
+// get the seq scale
+void song_set_scale(unsigned char seq, unsigned char part, unsigned char scale);
+
+// get the seq span
+unsigned char song_get_span(unsigned char seq, unsigned char part);
+
+// set the seq span
+void song_set_span(unsigned char seq, unsigned char part, unsigned char span);
+
+// get the seq offset
+char song_get_offset(unsigned char seq, unsigned char part);
+
+// set the seq offset
+void song_set_offset(unsigned char seq, unsigned char part, char offset);
+
+// get the start override of a part - SONG_PART_FOLLOW if it follows the seq
+unsigned char song_get_part_start(unsigned char seq, unsigned char part);
+
+// set the start override of a part - SONG_PART_FOLLOW to follow the seq
+void song_set_part_start(unsigned char seq, unsigned char part, unsigned char start);
+
+// get the length override of a part - SONG_PART_FOLLOW if it follows the seq
+unsigned char song_get_part_len(unsigned char seq, unsigned char part);
+
+// set the length override of a part - SONG_PART_FOLLOW to follow the seq
+void song_set_part_len(unsigned char seq, unsigned char part, unsigned char len);
+
+// get the dir override of a part - SONG_PART_FOLLOW if it follows the seq
+unsigned char song_get_part_dir(unsigned char seq, unsigned char part);
+
+// set the dir override of a part - SONG_PART_FOLLOW to follow the seq
+void song_set_part_dir(unsigned char seq, unsigned char part, unsigned char dir);
+
+// get the clock divide override of a part - SONG_PART_FOLLOW if it uses the system div
+unsigned char song_get_part_div(unsigned char seq, unsigned char part);
+
+// set the clock divide override of a part - SONG_PART_FOLLOW to use the system div
+void song_set_part_div(unsigned char seq, unsigned char part, unsigned char div);
+
+// copy the notes of a part to another part in the same seq
+void song_part_copy(unsigned char seq, unsigned char src, unsigned char dest);
+
+// invert the intervals in the selected part
+void song_part_invert(unsigned char seq, unsigned char part);
+
+// retrograde the selected part
+void song_part_retrograde(unsigned char seq, unsigned char part);
+
+// randomize the selected part
+void song_part_randomize(unsigned char seq, unsigned char part);
+
+// clear the selected part
+void song_part_clear(unsigned char seq, unsigned char part);
+
+// make a euclidean gate pattern of hits spread over len steps in the selected part
+void song_part_euclid(unsigned char seq, unsigned char part, unsigned char hits,
+	unsigned char len, unsigned char rotate);
+
+// rotate the steps of the selected part later by a number of steps
+void song_part_rotate(unsigned char seq, unsigned char part, unsigned char steps);
+
+// shift the steps of the selected part by -63 to +63 steps - rests are shifted in
+void song_part_shift(unsigned char seq, unsigned char part, char steps);
+
+// make a random gate pattern in the selected part - density is 0-100 percent
+void song_part_random_gates(unsigned char seq, unsigned char part, unsigned char density);
+
+// make new notes in the selected part that move like the notes already in it
+void song_part_markov(unsigned char seq, unsigned char part);
+
+// get the number of arrangement entries - 0 if the seqs follow their next settings
+unsigned char song_get_arr_len(void);
+
+// set the number of arrangement entries - the arrangement can only be made shorter
+void song_set_arr_len(unsigned char len);
+
+// get the seq of an arrangement entry
+unsigned char song_get_arr_seq(unsigned char entry);
+
+// get the repeat count of an arrangement entry - 1-16
+unsigned char song_get_arr_repeat(unsigned char entry);
+
+// get the transpose of an arrangement entry - -12 to +12 semitones
+char song_get_arr_transpose(unsigned char entry);
+
+// set an arrangement entry - setting the entry after the last adds an entry
+void song_set_arr_entry(unsigned char entry, unsigned char seq, unsigned char repeat,
+	char transpose);
+
+// clear the undo journal
+void song_journal_clear(void);
+
+// undo the last edit - returns 0 if there is nothing to undo
+unsigned char song_undo(void);
+
+// redo the last edit that was undone - returns 0 if there is nothing to redo
+unsigned char song_redo(void);
@@ -1,122 +1,791 @@
-/*
- * K2579 Step Sequencer - Song File Manager
- *
- * Copyright 2011: Kilpatrick Audio
- * Written by: Andrew Kilpatrick
- *
- */
-#include "song_file.h"
-#include "song.h"
-#include "eeprom.h"
-#include "sysconfig.h"
-#include "clock.h"
-#include "sequencer.h"
-#include "gui.h"
-
-// file manager states
-#define SONG_FILE_IDLE 0
-#define SONG_FILE_LOADING 1
-#define SONG_FILE_SAVING 2
-#define SONG_FILE_ERASING 3
-
-#define SONG_FILE_BUFFERS 64
-
-unsigned char seq_buf[128];
-// song file states
-unsigned char song_file_state;
-unsigned int song_file_buf_count;
-unsigned char processing_song;
-unsigned char skip_count;
-
-// initialize the song file manager
-void song_file_init(void) {
-	song_file_state = SONG_FILE_IDLE;
-	processing_song = 0;
-	skip_count = 0;
-	// load the last loaded song
-	song_file_load(sysconfig_get_current_song());
-}
-
-// song file task
-void song_file_task(void) {
-	unsigned char seq;
-	unsigned char buf_offset;
-
-	// load song
-	if(song_file_state == SONG_FILE_LOADING) {
-		// force playback to stop
-		clock_stop_command();
-
-		// load the song data for song
-		int addr = (processing_song << 11) | (song_file_buf_count << 5);
-
-		// load a buffer from the EEPROM
-		buf_offset = (addr & 0x60);
-		eeprom_read_page(addr, seq_buf + buf_offset);
-
-		// we have loaded a sequence of 4 buffers = 128 bytes
-		if((song_file_buf_count & 0x03) == 0x03) {
-			seq = (addr >> 7) & 0x0f;
-			// check if this buffer is valid
-			if(seq_buf[0x7f] != SONG_CONFIGURE_MARK) {
-				song_clear_song();
-				song_file_state = SONG_FILE_IDLE;
-				return;
-			}
-			song_load_seq_buf(seq, seq_buf);
-		}
-
-		song_file_buf_count ++;
-		// loading is complete
-		if(song_file_buf_count == SONG_FILE_BUFFERS) {
-			song_file_state = SONG_FILE_IDLE;
-			sysconfig_set_current_song(processing_song);
-			sequencer_new_song_loaded();
-			gui_song_load_updated();
-		}
-	}
-	// save song
-	else if(song_file_state == SONG_FILE_SAVING) {
-		// force playback to stop
-		clock_stop_command();
-
-		// save the song data for a song
-		int addr = (processing_song << 11) | (song_file_buf_count << 5);
-
-		// need to get 4 new buffers - 128 bytes
-		if((song_file_buf_count & 0x03) == 0x00) {
-			seq = (addr >> 7) & 0x0f;
-			song_save_seq_buf(seq, seq_buf);
-		}
-
-		// save a buffer to the EEPROM
-		buf_offset = (addr & 0x60);
-		eeprom_write_page(addr, seq_buf + buf_offset);
-
-		song_file_buf_count ++;
-		// saving is complete
-		if(song_file_buf_count == SONG_FILE_BUFFERS) {
-			song_file_state = SONG_FILE_IDLE;
-			sysconfig_set_current_song(processing_song);
-			gui_song_save_updated();
-		}
-	}
-}
-
-// load song from flash
-void song_file_load(unsigned char song) {
-	if(song > 7) return;
-	if(song_file_state != SONG_FILE_IDLE) return;
-	song_file_state = SONG_FILE_LOADING;
-	song_file_buf_count = 0;
-	processing_song = song;
-}
-
-// save song to flash
-void song_file_save(unsigned char song) {
-	if(song > 7) return;
-	if(song_file_state != SONG_FILE_IDLE) return;
-	song_file_state = SONG_FILE_SAVING;
-	song_file_buf_count = 0;
-	processing_song = song;
-}
+/*
+ * K2579 Step Sequencer - Song File Manager
+ *
+ * Copyright 2011: Kilpatrick Audio
+ * Written by: Andrew Kilpatrick
+ *
+ * Song storage - version 3:
+ *  - songs are packed and stored with a variable length in the song heap
+ *  - the song directory holds the heap start page and page count of each song
+ *  - each song image starts with a header:
+ *     0 - magic
+ *     1 - version
+ *     2-3 - image length in bytes including the header
+ *     4-5 - CRC-16 of the image after the header
+ *     6 - number of sequences
+ *     7 - number of arrangement entries - 0 in older images
+ *     8-39 - sequence record offsets in bytes - 16 bits each
+ *  - version 2 images have a 24 byte header with 8 bit record offsets in
+ *    4 byte units - these are still loaded but always saved as version 3
+ *  - sequence records are packed by song_pack_seq() on 4 byte boundaries
+ *  - sequences longer than 16 steps have a song_pack_page() record for each
+ *    page after the first straight after their sequence record, then the
+ *    song_pack_lanes() records of the step lanes used - the zero padding
+ *    or the end of the slot ends them
+ *  - the song_pack_arr() arrangement ends the image after the last slot
+ *  - records keep their slot when the song is saved again if they still fit
+ *    so that only the pages of changed sequences (and the header) are written
+ *  - version 1 songs (2K each at song << 11) are migrated at startup
+ *
+ * Song directory page:
+ *  0 - magic
+ *  1 - version
+ *  2 - next version 1 song to migrate
+ *  4-19 - song entries: heap start page (or 0xff if empty), page count
+ *  30-31 - CRC-16 of bytes 0-29
+ *
+ */
+#include "song_file.h"
+#include "song.h"
+#include "eeprom.h"
+#include "crc.h"
+#include "sysconfig.h"
+#include "clock.h"
+#include "sequencer.h"
+#include "gui.h"
+#include "sysex_bulk.h"
+
+// file manager states
+#define SONG_FILE_IDLE 0
+#define SONG_FILE_LOADING 1
+#define SONG_FILE_SAVING 2
+#define SONG_FILE_ERASING 3
+#define SONG_FILE_WRITING 4
+#define SONG_FILE_COMPACTING 5
+#define SONG_FILE_RESTORING 6
+#define SONG_FILE_READING 7
+#define SONG_FILE_READ_CHUNK EEPROM_PAGE_SIZE  // bytes read per task pass
+
+// song image
+#define SONG_FILE_MAGIC 0x4b
+#define SONG_FILE_VERSION 0x03
+#define SONG_FILE_V2 0x02
+#define HDR_MAGIC 0
+#define HDR_VERSION 1
+#define HDR_LEN 2
+#define HDR_CRC 4
+#define HDR_NUM_SEQ 6
+#define HDR_ARR_LEN 7
+#define HDR_OFFSETS 8
+#define SONG_FILE_HEADER_LEN 40
+#define SONG_FILE_V2_HEADER_LEN 24
+#define SONG_FILE_SLOT_SLACK 4  // spare bytes after each record for edits
+#define SONG_FILE_SLOT_MAX (((SONG_PACKED_SEQ_MAX + 3) & ~0x03) + SONG_FILE_SLOT_SLACK)
+#define SONG_FILE_MAX_PAGES ((SONG_FILE_HEADER_LEN + (SONG_NUM_SEQ * SONG_FILE_SLOT_MAX) + \
+	(SONG_NUM_EXT_PAGES * SONG_PACKED_PAGE_MAX) + (SONG_NUM_LANES * SONG_PACKED_LANE_MAX) + \
+	SONG_PACKED_ARR_MAX + EEPROM_PAGE_SIZE - 1) / EEPROM_PAGE_SIZE)
+#define SONG_FILE_HEAP_PAGES ((EEPROM_SIZE - EEPROM_SONG_HEAP_ADDR) / EEPROM_PAGE_SIZE)
+
+// song directory
+#define DIR_VERSION_NUM 0x02
+#define DIR_MAGIC 0
+#define DIR_VERSION 1
+#define DIR_MIGRATE 2
+#define DIR_ENTRIES 4
+#define DIR_CRC 30
+#define DIR_EMPTY 0xff
+#define DIR_START(song) song_dir[DIR_ENTRIES + ((song) << 1)]
+#define DIR_PAGES(song) song_dir[DIR_ENTRIES + ((song) << 1) + 1]
+
+// version 1 songs
+#define SONG_FILE_LEGACY_SONGS (EEPROM_SIZE >> 11)
+#define SONG_FILE_LEGACY_SEQ_LEN 128
+// the heap pages a version 1 song overlaps - song 0 starts below the heap
+#define LEGACY_START(song) ((song) ? ((((song) << 11) - EEPROM_SONG_HEAP_ADDR) / EEPROM_PAGE_SIZE) : 0)
+#define LEGACY_END(song) (((((song) + 1) << 11) - EEPROM_SONG_HEAP_ADDR) / EEPROM_PAGE_SIZE)
+
+unsigned char song_buf[SONG_FILE_MAX_PAGES * EEPROM_PAGE_SIZE];
+unsigned char song_dir[EEPROM_PAGE_SIZE];
+unsigned char page_buf[EEPROM_PAGE_SIZE];
+// song file states
+unsigned char song_file_state;
+unsigned int song_file_buf_count;
+unsigned char song_file_num_pages;
+unsigned char processing_song;
+unsigned char processing_start;
+unsigned char skip_count;
+// incremental saving
+unsigned char page_check[SONG_FILE_MAX_PAGES];  // pages to compare and write
+unsigned int slot_offset[SONG_NUM_SEQ];  // record slots of the stored song
+unsigned int slot_len;
+unsigned char slot_song;  // the song the slots belong to or DIR_EMPTY
+unsigned int saving_dirty;  // changed sequences being saved
+unsigned char pages_written;
+// streamed images
+unsigned int stream_pos;
+unsigned int stream_len;
+unsigned int stream_limit;
+unsigned int stream_crc;
+unsigned int stream_start;
+unsigned char stream_seq;
+// compaction
+unsigned char compacted;
+unsigned char compact_song;
+unsigned char compact_dest;
+// migration
+unsigned char legacy_pending;  // version 1 songs not read yet - not written over
+
+// local functions
+unsigned int song_file_pack(unsigned char keep_slots);
+unsigned char song_file_read(void);
+void song_file_stream_start(unsigned int limit);
+unsigned char song_file_stream_byte(unsigned char data);
+unsigned char song_file_stream_done(void);
+void song_file_set_slots(unsigned char song);
+unsigned int song_file_header_len(void);
+unsigned int song_file_seq_end(void);
+unsigned int song_file_get_offset(unsigned char seq);
+unsigned char song_file_alloc(unsigned char song, unsigned char pages);
+unsigned char song_file_compact_next(void);
+unsigned char song_file_dir_valid(void);
+void song_file_dir_write(void);
+void song_file_migrate(void);
+
+// initialize the song file manager
+void song_file_init(void) {
+	int i;
+	song_file_state = SONG_FILE_IDLE;
+	processing_song = 0;
+	skip_count = 0;
+	slot_song = DIR_EMPTY;
+	pages_written = 0;
+	legacy_pending = 0;
+
+	// load the song directory
+	eeprom_read_page(EEPROM_SONG_DIR_ADDR, song_dir);
+	if(!song_file_dir_valid()) {
+		for(i = 0; i < EEPROM_PAGE_SIZE; i ++) {
+			song_dir[i] = 0x00;
+		}
+		song_dir[DIR_MAGIC] = SONG_FILE_MAGIC;
+		song_dir[DIR_VERSION] = DIR_VERSION_NUM;
+		song_dir[DIR_MIGRATE] = 0;
+		for(i = 0; i < SONG_FILE_NUM_SONGS; i ++) {
+			DIR_START(i) = DIR_EMPTY;
+			DIR_PAGES(i) = 0;
+		}
+	}
+	// convert any version 1 songs
+	if(song_dir[DIR_MIGRATE] < SONG_FILE_LEGACY_SONGS) {
+		song_file_migrate();
+	}
+
+	// load the last loaded song
+	song_file_load(sysconfig_get_current_song());
+}
+
+// song file task
+void song_file_task(void) {
+	int addr, i;
+
+	// the EEPROM is being replaced underneath us
+	if(sysex_bulk_restoring()) return;
+
+	// load song
+	if(song_file_state == SONG_FILE_LOADING) {
+		// force playback to stop
+		clock_stop_command();
+
+		// empty song slot
+		if(DIR_START(processing_song) == DIR_EMPTY) {
+			song_clear_song();
+			song_file_state = SONG_FILE_IDLE;
+			return;
+		}
+
+		// stream the song from the EEPROM a chunk at a time
+		song_file_stream_start(DIR_PAGES(processing_song) * EEPROM_PAGE_SIZE);
+		song_file_state = SONG_FILE_READING;
+	}
+	// read the next chunk of the song being loaded
+	else if(song_file_state == SONG_FILE_READING) {
+		if(!song_file_read()) {
+			song_file_state = SONG_FILE_IDLE;
+			song_clear_song();
+			slot_song = DIR_EMPTY;
+			return;
+		}
+		if(stream_pos < stream_len) return;
+		song_file_state = SONG_FILE_IDLE;
+		if(!song_file_stream_done()) {
+			song_clear_song();
+			slot_song = DIR_EMPTY;
+			return;
+		}
+		song_file_set_slots(processing_song);
+		song_clear_dirty(0xffffffff);
+		song_journal_clear();
+		sysconfig_set_current_song(processing_song);
+		sequencer_new_song_loaded();
+		gui_song_load_updated();
+	}
+	// save song - pack the song and find a place for it
+	else if(song_file_state == SONG_FILE_SAVING) {
+		// force playback to stop
+		clock_stop_command();
+
+		// keep the record slots if we are saving over the same song
+		saving_dirty = song_get_dirty();
+		song_file_num_pages = (song_file_pack(slot_song == processing_song) +
+			(EEPROM_PAGE_SIZE - 1)) / EEPROM_PAGE_SIZE;
+		processing_start = song_file_alloc(processing_song, song_file_num_pages);
+		// no contiguous space - compact the heap and try again
+		if(processing_start == DIR_EMPTY && !compacted) {
+			compacted = 1;
+			if(song_file_compact_next()) {
+				song_file_state = SONG_FILE_COMPACTING;
+				return;
+			}
+			processing_start = song_file_alloc(processing_song, song_file_num_pages);
+		}
+		// out of space
+		if(processing_start == DIR_EMPTY) {
+			song_file_state = SONG_FILE_IDLE;
+			gui_song_save_failed();
+			return;
+		}
+		// the song is moving - every page needs to be written
+		if(processing_start != DIR_START(processing_song)) {
+			for(i = 0; i < SONG_FILE_MAX_PAGES; i ++) {
+				page_check[i] = 1;
+			}
+		}
+		song_file_buf_count = 0;
+		pages_written = 0;
+		song_file_state = SONG_FILE_WRITING;
+	}
+	// save song - write the song pages and then the directory
+	else if(song_file_state == SONG_FILE_WRITING) {
+		// force playback to stop
+		clock_stop_command();
+
+		// skip pages that have not changed
+		while(song_file_buf_count < song_file_num_pages &&
+				!page_check[song_file_buf_count]) {
+			song_file_buf_count ++;
+		}
+
+		// save a page to the EEPROM if it is different
+		if(song_file_buf_count < song_file_num_pages) {
+			addr = EEPROM_SONG_HEAP_ADDR +
+				((processing_start + song_file_buf_count) * EEPROM_PAGE_SIZE);
+			eeprom_read_page(addr, page_buf);
+			for(i = 0; i < EEPROM_PAGE_SIZE; i ++) {
+				if(page_buf[i] != song_buf[(song_file_buf_count * EEPROM_PAGE_SIZE) + i]) {
+					eeprom_write_page(addr, song_buf + (song_file_buf_count * EEPROM_PAGE_SIZE));
+					pages_written ++;
+					break;
+				}
+			}
+			song_file_buf_count ++;
+			return;
+		}
+
+		// saving is complete
+		if(DIR_START(processing_song) != processing_start ||
+				DIR_PAGES(processing_song) != song_file_num_pages) {
+			DIR_START(processing_song) = processing_start;
+			DIR_PAGES(processing_song) = song_file_num_pages;
+			song_file_dir_write();
+			pages_written ++;
+		}
+		song_file_set_slots(processing_song);
+		song_clear_dirty(saving_dirty);
+		song_file_state = SONG_FILE_IDLE;
+		sysconfig_set_current_song(processing_song);
+		gui_song_save_updated();
+	}
+	// move songs down to close gaps in the heap
+	else if(song_file_state == SONG_FILE_COMPACTING) {
+		// move a page
+		if(song_file_buf_count < DIR_PAGES(compact_song)) {
+			addr = EEPROM_SONG_HEAP_ADDR +
+				((DIR_START(compact_song) + song_file_buf_count) * EEPROM_PAGE_SIZE);
+			eeprom_read_page(addr, page_buf);
+			addr = EEPROM_SONG_HEAP_ADDR +
+				((compact_dest + song_file_buf_count) * EEPROM_PAGE_SIZE);
+			eeprom_write_page(addr, page_buf);
+			song_file_buf_count ++;
+			return;
+		}
+
+		// the song has been moved
+		DIR_START(compact_song) = compact_dest;
+		song_file_dir_write();
+		if(!song_file_compact_next()) {
+			song_file_state = SONG_FILE_SAVING;
+		}
+	}
+}
+
+// load song from flash
+void song_file_load(unsigned char song) {
+	if(song > (SONG_FILE_NUM_SONGS - 1)) return;
+	if(song_file_state != SONG_FILE_IDLE) return;
+	song_file_state = SONG_FILE_LOADING;
+	processing_song = song;
+}
+
+// get the EEPROM address of a stored song - returns -1 if the slot is empty
+int song_file_get_addr(unsigned char song) {
+	if(song > (SONG_FILE_NUM_SONGS - 1)) return -1;
+	if(DIR_START(song) == DIR_EMPTY) return -1;
+	return EEPROM_SONG_HEAP_ADDR + (DIR_START(song) * EEPROM_PAGE_SIZE);
+}
+
+// get the length of a stored song image in bytes - 0 if the slot is empty
+int song_file_get_len(unsigned char song) {
+	unsigned char hdr[2];
+	int len;
+	if(song_file_get_addr(song) == -1) return 0;
+	eeprom_read(song_file_get_addr(song) + HDR_LEN, hdr, 2);
+	len = hdr[0] | (hdr[1] << 8);
+	if(len > (DIR_PAGES(song) * EEPROM_PAGE_SIZE)) return 0;
+	return len;
+}
+
+// check if a song is being loaded or saved
+unsigned char song_file_busy(void) {
+	if(song_file_state != SONG_FILE_IDLE) return 1;
+	return 0;
+}
+
+// start restoring a song image from outside - returns 0 if busy
+unsigned char song_file_restore_start(void) {
+	if(song_file_state != SONG_FILE_IDLE) return 0;
+	clock_stop_command();
+	song_file_stream_start(sizeof(song_buf));
+	song_file_state = SONG_FILE_RESTORING;
+	return 1;
+}
+
+// add the next byte of a song image being restored - returns 0 if bad
+unsigned char song_file_restore_byte(unsigned char data) {
+	if(song_file_state != SONG_FILE_RESTORING) return 0;
+	return song_file_stream_byte(data);
+}
+
+// finish restoring a song image and save it to a song slot
+//
+// - the song is unpacked straight into the current song as it arrives
+//   so a bad or partial image reloads the current song instead
+// - returns 1 if the song was valid
+//
+unsigned char song_file_restore_end(unsigned char song) {
+	if(song_file_state != SONG_FILE_RESTORING) return 0;
+	song_file_state = SONG_FILE_IDLE;
+	if(song > (SONG_FILE_NUM_SONGS - 1) || !song_file_stream_done()) {
+		song_file_load(sysconfig_get_current_song());
+		return 0;
+	}
+	slot_song = DIR_EMPTY;
+	sysconfig_set_current_song(song);
+	sequencer_new_song_loaded();
+	gui_song_load_updated();
+	song_file_save(song);
+	return 1;
+}
+
+// get the number of pages written by the last save
+unsigned char song_file_get_pages_written(void) {
+	return pages_written;
+}
+
+// save song to flash
+void song_file_save(unsigned char song) {
+	if(song > (SONG_FILE_NUM_SONGS - 1)) return;
+	if(song_file_state != SONG_FILE_IDLE) return;
+	song_file_state = SONG_FILE_SAVING;
+	song_file_buf_count = 0;
+	processing_song = song;
+	compacted = 0;
+}
+
+//
+// LOCAL FUNCTIONS
+//
+// pack the song into the song buffer - returns the image length
+//
+// - if keep_slots is set records stay in their old slots while they fit
+// - page_check is set for each page that may have changed
+// - kept slots can leave gaps, so the song is laid out again from the
+//   start if a record might not fit in the buffer after them
+//
+unsigned int song_file_pack(unsigned char keep_slots) {
+	unsigned int pos = SONG_FILE_HEADER_LEN;
+	unsigned int start, end, crc;
+	unsigned int dirty = song_get_dirty();
+	unsigned char kept = keep_slots;
+	int seq, i;
+
+	// the header pages always change with the CRC and the record offsets
+	for(i = 0; i < SONG_FILE_MAX_PAGES; i ++) {
+		page_check[i] = !keep_slots;
+	}
+	for(i = 0; i <= ((SONG_FILE_HEADER_LEN - 1) / EEPROM_PAGE_SIZE); i ++) {
+		page_check[i] = 1;
+	}
+
+	// sequence records
+	for(seq = 0; seq < SONG_NUM_SEQ; seq ++) {
+		if(keep_slots) pos = slot_offset[seq];
+		if(kept && (pos + song_packed_seq_max(seq) + 3 + SONG_FILE_SLOT_SLACK) >
+				sizeof(song_buf)) {
+			return song_file_pack(0);
+		}
+		start = pos;
+		pos += song_pack_seq(seq, song_buf + pos);
+		for(i = 1; i < (song_get_seq_steps(seq) / SONG_PAGE_STEPS); i ++) {
+			pos += song_pack_page(seq, i, song_buf + pos);
+		}
+		pos += song_pack_lanes(seq, song_buf + pos);
+		// the record still fits in its slot
+		if(keep_slots) {
+			if(seq == (SONG_NUM_SEQ - 1)) end = slot_len;
+			else end = slot_offset[seq + 1];
+			if(pos <= end) {
+				while(pos < end) {
+					song_buf[pos ++] = 0x00;
+				}
+				if(dirty & (1 << seq)) {
+					for(i = start / EEPROM_PAGE_SIZE; i <= (end - 1) / EEPROM_PAGE_SIZE; i ++) {
+						page_check[i] = 1;
+					}
+				}
+			}
+			// the record has grown - lay out the rest of the song again
+			else {
+				keep_slots = 0;
+				for(i = start / EEPROM_PAGE_SIZE; i < SONG_FILE_MAX_PAGES; i ++) {
+					page_check[i] = 1;
+				}
+			}
+		}
+		// new slot with some room to grow
+		if(!keep_slots) {
+			while(pos & 0x03) {
+				song_buf[pos ++] = 0x00;
+			}
+			for(i = 0; i < SONG_FILE_SLOT_SLACK; i ++) {
+				song_buf[pos ++] = 0x00;
+			}
+		}
+		song_buf[HDR_OFFSETS + (seq << 1)] = start & 0xff;
+		song_buf[HDR_OFFSETS + (seq << 1) + 1] = (start >> 8) & 0xff;
+	}
+
+	// arrangement - its pages are always checked
+	if(kept && (pos + SONG_PACKED_ARR_MAX) > sizeof(song_buf)) {
+		return song_file_pack(0);
+	}
+	start = pos;
+	pos += song_pack_arr(song_buf + pos);
+	if(pos > start) {
+		for(i = start / EEPROM_PAGE_SIZE; i <= (pos - 1) / EEPROM_PAGE_SIZE; i ++) {
+			page_check[i] = 1;
+		}
+	}
+
+	// header
+	crc = crc16_buf(CRC16_INIT, song_buf + SONG_FILE_HEADER_LEN, pos - SONG_FILE_HEADER_LEN);
+	song_buf[HDR_MAGIC] = SONG_FILE_MAGIC;
+	song_buf[HDR_VERSION] = SONG_FILE_VERSION;
+	song_buf[HDR_LEN] = pos & 0xff;
+	song_buf[HDR_LEN + 1] = (pos >> 8) & 0xff;
+	song_buf[HDR_CRC] = crc & 0xff;
+	song_buf[HDR_CRC + 1] = (crc >> 8) & 0xff;
+	song_buf[HDR_NUM_SEQ] = SONG_NUM_SEQ;
+	song_buf[HDR_ARR_LEN] = song_get_arr_len();
+	return pos;
+}
+
+// read and unpack the next chunk of the song being loaded - returns 0 if bad
+//
+// - each chunk is one short sequential EEPROM transaction so that the
+//   task never holds up the MIDI input for long
+//
+unsigned char song_file_read(void) {
+	int count;
+	if(!eeprom_read_start(EEPROM_SONG_HEAP_ADDR +
+			(DIR_START(processing_song) * EEPROM_PAGE_SIZE) + stream_pos)) return 0;
+	for(count = 1; stream_pos < stream_len; count ++) {
+		if(!song_file_stream_byte(eeprom_read_byte(count == SONG_FILE_READ_CHUNK ||
+				stream_pos == (stream_len - 1)))) {
+			eeprom_read_stop();
+			return 0;
+		}
+		if(count == SONG_FILE_READ_CHUNK) break;
+	}
+	eeprom_read_stop();
+	return 1;
+}
+
+// start unpacking a song image arriving a byte at a time
+void song_file_stream_start(unsigned int limit) {
+	if(limit > sizeof(song_buf)) limit = sizeof(song_buf);
+	stream_pos = 0;
+	stream_len = limit;  // until the header says otherwise
+	stream_limit = limit;
+	stream_crc = CRC16_INIT;
+	stream_seq = 0;
+}
+
+// unpack the next byte of a song image - returns 0 if the image is bad
+//
+// - each record is unpacked and checked as soon as it has arrived
+//
+unsigned char song_file_stream_byte(unsigned char data) {
+	unsigned int end, pos;
+	int seq;
+	if(stream_pos >= stream_len) return 0;
+	song_buf[stream_pos] = data;
+	stream_pos ++;
+
+	// header - the length depends on the version
+	if(stream_pos <= HDR_VERSION) return 1;
+	if(stream_pos < song_file_header_len()) return 1;
+	if(stream_pos == song_file_header_len()) {
+		stream_len = song_buf[HDR_LEN] | (song_buf[HDR_LEN + 1] << 8);
+		// version 2 images have no arrangement
+		if(song_buf[HDR_VERSION] == SONG_FILE_V2) song_buf[HDR_ARR_LEN] = 0;
+		if(song_buf[HDR_MAGIC] != SONG_FILE_MAGIC ||
+				(song_buf[HDR_VERSION] != SONG_FILE_VERSION &&
+				song_buf[HDR_VERSION] != SONG_FILE_V2) ||
+				song_buf[HDR_NUM_SEQ] != SONG_NUM_SEQ ||
+				stream_len <= song_file_header_len() ||
+				stream_len > stream_limit ||
+				stream_len <= (song_file_header_len() + (song_buf[HDR_ARR_LEN] << 1)) ||
+				!song_unpack_arr(song_buf, 0)) return 0;
+		// records must be in order to be unpacked as they arrive
+		for(seq = 0; seq < SONG_NUM_SEQ; seq ++) {
+			end = song_file_get_offset(seq);
+			if(end < song_file_header_len() || end >= song_file_seq_end() ||
+					(seq && end <= song_file_get_offset(seq - 1))) {
+				return 0;
+			}
+		}
+		stream_start = song_file_get_offset(0);
+		return 1;
+	}
+
+	// sequence records
+	stream_crc = crc16_update(stream_crc, data);
+	// the arrangement after the last record
+	if(stream_seq == SONG_NUM_SEQ) {
+		if(stream_pos < stream_len) return 1;
+		return song_unpack_arr(song_buf + stream_start, song_buf[HDR_ARR_LEN]);
+	}
+	if(stream_seq == (SONG_NUM_SEQ - 1)) end = song_file_seq_end();
+	else end = song_file_get_offset(stream_seq + 1);
+	// the record is complete
+	if(stream_pos == end) {
+		if(!song_unpack_seq(stream_seq, song_buf + stream_start,
+				((end - stream_start) > 255) ? 255 : (end - stream_start))) {
+			return 0;
+		}
+		// step pages after the first and step lanes
+		pos = stream_start + song_buf[stream_start];
+		while(pos < end && song_buf[pos] != 0x00) {
+			if((pos + 1) < end && (song_buf[pos + 1] & SONG_LANE_RECORD)) {
+				if(!song_unpack_lane(stream_seq, song_buf + pos,
+						((end - pos) > 255) ? 255 : (end - pos))) {
+					return 0;
+				}
+			}
+			else if(!song_unpack_page(stream_seq, song_buf + pos,
+					((end - pos) > 255) ? 255 : (end - pos))) {
+				return 0;
+			}
+			pos += song_buf[pos];
+		}
+		stream_seq ++;
+		stream_start = end;
+	}
+	return 1;
+}
+
+// check that a streamed song image is complete and matches its CRC
+unsigned char song_file_stream_done(void) {
+	if(stream_pos <= HDR_VERSION || stream_pos < song_file_header_len() ||
+			stream_pos != stream_len) return 0;
+	if(song_buf[HDR_CRC] != (stream_crc & 0xff)) return 0;
+	if(song_buf[HDR_CRC + 1] != ((stream_crc >> 8) & 0xff)) return 0;
+	return 1;
+}
+
+// remember the record slots of the image in the song buffer
+void song_file_set_slots(unsigned char song) {
+	int seq;
+	slot_len = song_file_seq_end();
+	slot_song = song;
+	// older images are laid out again with the new header
+	if(song_buf[HDR_VERSION] != SONG_FILE_VERSION || slot_len > sizeof(song_buf) ||
+			song_file_get_offset(0) < SONG_FILE_HEADER_LEN) {
+		slot_song = DIR_EMPTY;
+	}
+	for(seq = 0; seq < SONG_NUM_SEQ; seq ++) {
+		slot_offset[seq] = song_file_get_offset(seq);
+		// slots must be in order to be reused
+		if(slot_offset[seq] >= slot_len ||
+				(seq && slot_offset[seq] <= slot_offset[seq - 1])) {
+			slot_song = DIR_EMPTY;
+		}
+	}
+}
+
+// get the header length of the image in the song buffer
+unsigned int song_file_header_len(void) {
+	if(song_buf[HDR_VERSION] == SONG_FILE_V2) return SONG_FILE_V2_HEADER_LEN;
+	return SONG_FILE_HEADER_LEN;
+}
+
+// get the end of the sequence records of the image in the song buffer
+unsigned int song_file_seq_end(void) {
+	unsigned int len = song_buf[HDR_LEN] | (song_buf[HDR_LEN + 1] << 8);
+	return len - (song_buf[HDR_ARR_LEN] << 1);
+}
+
+// get a sequence record offset from the image in the song buffer
+unsigned int song_file_get_offset(unsigned char seq) {
+	if(song_buf[HDR_VERSION] == SONG_FILE_V2) return song_buf[HDR_OFFSETS + seq] << 2;
+	return song_buf[HDR_OFFSETS + (seq << 1)] | (song_buf[HDR_OFFSETS + (seq << 1) + 1] << 8);
+}
+
+// find a place in the heap for a song - returns the start page or DIR_EMPTY
+unsigned char song_file_alloc(unsigned char song, unsigned char pages) {
+	int pos, i, collide;
+	// the song fits where it is already
+	if(DIR_START(song) != DIR_EMPTY && DIR_PAGES(song) >= pages) {
+		return DIR_START(song);
+	}
+	// first fit - the old copy of the song is being replaced
+	pos = 0;
+	while((pos + pages) <= SONG_FILE_HEAP_PAGES) {
+		collide = 0;
+		for(i = 0; i < SONG_FILE_NUM_SONGS; i ++) {
+			if(i == song || DIR_START(i) == DIR_EMPTY) continue;
+			if(DIR_START(i) < (pos + pages) && (DIR_START(i) + DIR_PAGES(i)) > pos) {
+				pos = DIR_START(i) + DIR_PAGES(i);
+				collide = 1;
+				break;
+			}
+		}
+		// version 1 songs that haven't been migrated yet
+		for(i = 0; i < SONG_FILE_LEGACY_SONGS && !collide; i ++) {
+			if(i == song || !(legacy_pending & (1 << i))) continue;
+			if(LEGACY_START(i) < (pos + pages) && LEGACY_END(i) > pos) {
+				pos = LEGACY_END(i);
+				collide = 1;
+			}
+		}
+		if(!collide) return pos;
+	}
+	return DIR_EMPTY;
+}
+
+// find the next song to move down in the heap - returns 1 if there is work to do
+unsigned char song_file_compact_next(void) {
+	int pos, i;
+	unsigned char next;
+	pos = 0;
+	while(1) {
+		// find the lowest song at or after pos
+		next = DIR_EMPTY;
+		for(i = 0; i < SONG_FILE_NUM_SONGS; i ++) {
+			if(DIR_START(i) == DIR_EMPTY || DIR_START(i) < pos) continue;
+			if(next == DIR_EMPTY || DIR_START(i) < DIR_START(next)) next = i;
+		}
+		if(next == DIR_EMPTY) return 0;
+		// there is a gap before this song
+		if(DIR_START(next) > pos) {
+			compact_song = next;
+			compact_dest = pos;
+			song_file_buf_count = 0;
+			return 1;
+		}
+		pos = DIR_START(next) + DIR_PAGES(next);
+	}
+}
+
+// check if the song directory is valid
+unsigned char song_file_dir_valid(void) {
+	unsigned int crc;
+	if(song_dir[DIR_MAGIC] != SONG_FILE_MAGIC) return 0;
+	if(song_dir[DIR_VERSION] != DIR_VERSION_NUM) return 0;
+	crc = crc16_buf(CRC16_INIT, song_dir, DIR_CRC);
+	if(song_dir[DIR_CRC] != (crc & 0xff)) return 0;
+	if(song_dir[DIR_CRC + 1] != ((crc >> 8) & 0xff)) return 0;
+	return 1;
+}
+
+// write the song directory to the EEPROM
+void song_file_dir_write(void) {
+	unsigned int crc = crc16_buf(CRC16_INIT, song_dir, DIR_CRC);
+	song_dir[DIR_CRC] = crc & 0xff;
+	song_dir[DIR_CRC + 1] = (crc >> 8) & 0xff;
+	eeprom_write_page(EEPROM_SONG_DIR_ADDR, song_dir);
+}
+
+// migrate version 1 songs to the packed format - called at startup
+//
+// - version 1 songs are 2K each at song << 11 so the heap overlaps them -
+//   a packed song is only written to pages that are free and not part of
+//   a version 1 song that is still to be read
+// - song 0 only has the 31 heap pages below song 1 so a large song 0 is
+//   put off until the songs after it have been moved out of the way
+// - the directory page is part of version 1 song 0 so it isn't written
+//   until song 0 has been read
+//
+void song_file_migrate(void) {
+	unsigned char song, pass, valid, start, pages;
+	int seq, i;
+	legacy_pending = 0;
+	for(song = song_dir[DIR_MIGRATE]; song < SONG_FILE_LEGACY_SONGS; song ++) {
+		legacy_pending |= (1 << song);
+	}
+	for(pass = 0; pass < 2; pass ++) {
+		for(song = song_dir[DIR_MIGRATE]; song < SONG_FILE_LEGACY_SONGS; song ++) {
+			if(!(legacy_pending & (1 << song))) continue;
+			// read the version 1 song
+			valid = 1;
+			for(seq = 0; seq < SONG_NUM_SEQ && valid; seq ++) {
+				for(i = 0; i < (SONG_FILE_LEGACY_SEQ_LEN / EEPROM_PAGE_SIZE); i ++) {
+					eeprom_read_page((song << 11) | (seq << 7) | (i * EEPROM_PAGE_SIZE),
+						song_buf + (i * EEPROM_PAGE_SIZE));
+				}
+				if(song_buf[SONG_FILE_LEGACY_SEQ_LEN - 1] != SONG_CONFIGURE_MARK) {
+					valid = 0;
+				}
+				else {
+					song_load_seq_buf(seq, song_buf);
+				}
+			}
+
+			// store the packed song
+			if(valid) {
+				pages = (song_file_pack(0) + (EEPROM_PAGE_SIZE - 1)) / EEPROM_PAGE_SIZE;
+				start = song_file_alloc(song, pages);
+				// try again once the later songs have been moved
+				if(start == DIR_EMPTY && pass == 0) continue;
+				if(start != DIR_EMPTY) {
+					for(i = 0; i < pages; i ++) {
+						eeprom_write_page(EEPROM_SONG_HEAP_ADDR + ((start + i) * EEPROM_PAGE_SIZE),
+							song_buf + (i * EEPROM_PAGE_SIZE));
+					}
+					DIR_START(song) = start;
+					DIR_PAGES(song) = pages;
+				}
+			}
+			legacy_pending &= ~(1 << song);
+			// the songs before the first one still to do are done
+			while(song_dir[DIR_MIGRATE] < SONG_FILE_LEGACY_SONGS &&
+					!(legacy_pending & (1 << song_dir[DIR_MIGRATE]))) {
+				song_dir[DIR_MIGRATE] ++;
+			}
+			if(!(legacy_pending & (1 << (EEPROM_SONG_DIR_ADDR >> 11)))) {
+				song_file_dir_write();
+			}
+		}
+	}
+	song_clear_song();
+}
@@ -1,19 +1,41 @@
-/*
- * K2579 Step Sequencer - Song File Manager
- *
- * Copyright 2011: Kilpatrick Audio
- * Written by: Andrew Kilpatrick
- *
- */
-// initialize the song file manager
-void song_file_init(void);
-
-// song file task - run on the main thread
-void song_file_task(void);
-
-// load song from flash
-void song_file_load(unsigned char song);
-
-// save song to flash
-void song_file_save(unsigned char song);
-
+/*
+ * K2579 Step Sequencer - Song File Manager
+ *
+ * Copyright 2011: Kilpatrick Audio
+ * Written by: Andrew Kilpatrick
+ *
+ */
+#define SONG_FILE_NUM_SONGS 8
+
+// initialize the song file manager
+void song_file_init(void);
+
+// song file task - run on the main thread
+void song_file_task(void);
+
+// load song from flash
+void song_file_load(unsigned char song);
+
+// save song to flash
+void song_file_save(unsigned char song);
+
+// get the number of pages written by the last save
+unsigned char song_file_get_pages_written(void);
+
+// get the EEPROM address of a stored song - returns -1 if the slot is empty
+int song_file_get_addr(unsigned char song);
+
+// get the length of a stored song image in bytes - 0 if the slot is empty
+int song_file_get_len(unsigned char song);
+
+// check if a song is being loaded or saved
+unsigned char song_file_busy(void);
+
+// start restoring a song image from outside - returns 0 if busy
+unsigned char song_file_restore_start(void);
+
+// add the next byte of a song image being restored - returns 0 if bad
+unsigned char song_file_restore_byte(unsigned char data);
+
+// finish restoring a song image and save it to a song slot
+unsigned char song_file_restore_end(unsigned char song);
@@ -1,264 +1,830 @@
-/*
- * K2579 Step Sequencer - System Config
- *
- * Copyright 2011: Kilpatrick Audio
- * Written by: Andrew Kilpatrick
- *
- * sysconfig page map:
- *  0 - clock div
- *  1 - mod1 assign
- *  2 - mod2 assign
- *  3 - live audition
- *  4 - midi part 1 channel		- remote
- *  5 - midi part 2 channel		- remote
- *  6 - key transpose
- *  7 - key trigger
- *  8 - LCD contrast			- remote
- *  9 - clock speed 			- remote
- * 10 - reset song / sequence
- * 11 - current loaded song
- * 31 - configured
- *
- */
-#include "sysconfig.h"
-#include "eeprom.h"
-#include "seq_midi.h"
-#include "screen_handler.h"
-#include "clock.h"
-
-#define EEPROM_CONFIG_ADDR 0x4000
-#define EEPROM_CONFIG_MARK 0x55
-
-// flag for resaving the page
-unsigned char dirty;
-unsigned int save_timer;
-#define SYSCONFIG_SAVE_TIME 312
-
-// parameters
-unsigned char params[32];
-#define PARAM_CLOCK_DIV 0
-#define PARAM_MOD1_ASSIGN 1
-#define PARAM_MOD2_ASSIGN 2
-#define PARAM_LIVE_AUDITION 3
-#define PARAM_MIDI_PT1_CHAN 4
-#define PARAM_MIDI_PT2_CHAN 5
-#define PARAM_KEY_TRANSPOSE 6
-#define PARAM_KEY_TRIGGER 7
-#define PARAM_LCD_CONTRAST 8
-#define PARAM_CLOCK_SPEED 9
-#define PARAM_RESET_MODE 10
-#define PARAM_CURRENT_SONG 11
-#define PARAM_KEY_MAP 12
-#define PARAM_CONFIGURED 31
-
-// init the global config
-void sysconfig_init(void) {
-	int i;
-	for(i = 0; i < 32; i ++) {
-		params[i] = 0x00;
-	}
-
-	// load config from EEPROM
-	eeprom_read_page(EEPROM_CONFIG_ADDR, params);
-	// force parameters that are remote
-	sysconfig_set_midi_channel(0, params[PARAM_MIDI_PT1_CHAN]);
-	sysconfig_set_midi_channel(1, params[PARAM_MIDI_PT2_CHAN]);
-	sysconfig_set_lcd_contrast(params[PARAM_LCD_CONTRAST]);
-	sysconfig_set_clock_speed(params[PARAM_CLOCK_SPEED]);
-	dirty = 0;  // clear the dirty flag
-
-	// should we seed this for the first time?
-	if(params[PARAM_CONFIGURED] != EEPROM_CONFIG_MARK) {
-		sysconfig_reset_all();
-	}
-	save_timer = 0;
-}
-
-// run the sysconfig task
-void sysconfig_task(void) {
-	save_timer ++;
-	if(save_timer >= SYSCONFIG_SAVE_TIME) {
-		save_timer = 0;
-		if(!dirty) return;
-		eeprom_write_page(EEPROM_CONFIG_ADDR, params);
-		dirty = 0;
-	}
-}
-
-// reset all settings
-void sysconfig_reset_all(void) {
-	int i;
-	for(i = 0; i < 32; i ++) {
-		params[i] = 0xff;
-	}
-	sysconfig_set_clock_div(6);
-	sysconfig_set_mod_assign(0, SYSCONFIG_MOD_NONE);
-	sysconfig_set_mod_assign(1, SYSCONFIG_MOD_NONE);
-	sysconfig_set_live_aud(1);
-	sysconfig_set_midi_channel(0, 0);
-	sysconfig_set_midi_channel(1, 1);
-	sysconfig_set_key_transpose(SYSCONFIG_KEY_TRANSPOSE12);
-	sysconfig_set_key_trigger(0);
-	sysconfig_set_lcd_contrast(160);
-	sysconfig_set_clock_speed(100);
-	sysconfig_set_reset_mode(SYSCONFIG_RESET_MODE_SONG);
-	sysconfig_set_current_song(0);
-	sysconfig_set_key_map(SYSCONFIG_KEY_MAP_A);
-	params[PARAM_CONFIGURED] = EEPROM_CONFIG_MARK;
-	dirty = 1;  // mark this for storing on the next pass
-}
-
-// get the clock divider
-unsigned char sysconfig_get_clock_div(void) {
-	return params[PARAM_CLOCK_DIV];
-}
-
-// set the clock divider
-void sysconfig_set_clock_div(unsigned char div) {
-	if(div < 1) {
-		params[PARAM_CLOCK_DIV] = 1;
-	}
-	else if(div > SYSCONFIG_MAX_CLOCK_DIV) {
-		params[PARAM_CLOCK_DIV] = SYSCONFIG_MAX_CLOCK_DIV;
-	}
-	else params[PARAM_CLOCK_DIV] = div;
-	dirty = 1;
-}
-
-// get a mod assignment
-unsigned char sysconfig_get_mod_assign(unsigned char part) {
-	if(part) return params[PARAM_MOD2_ASSIGN];
-	return params[PARAM_MOD1_ASSIGN];
-}
-
-// set a mod assignment
-void sysconfig_set_mod_assign(unsigned char part, unsigned char assign) {
-	if(part) {
-		if(assign > SYSCONFIG_MAX_MOD_ASSIGN) {
-			params[PARAM_MOD2_ASSIGN] = SYSCONFIG_MAX_MOD_ASSIGN;
-		}
-		else {
-			params[PARAM_MOD2_ASSIGN] = assign;
-		}
-	}
-	else {
-		if(assign > SYSCONFIG_MAX_MOD_ASSIGN) {
-			params[PARAM_MOD1_ASSIGN] = SYSCONFIG_MAX_MOD_ASSIGN;
-		}
-		else {
-			params[PARAM_MOD1_ASSIGN] = assign;
-		}
-	}
-	dirty = 1;
-}
-
-// get the live audition state
-unsigned char sysconfig_get_live_aud(void) {
-	return params[PARAM_LIVE_AUDITION];
-}
-
-// set the live audition state
-void sysconfig_set_live_aud(unsigned char aud) {
-	if(aud) params[PARAM_LIVE_AUDITION] = 1;
-	else params[PARAM_LIVE_AUDITION] = 0;
-	dirty = 1;
-}
-
-// get a midi part channel
-unsigned char sysconfig_get_midi_channel(unsigned char part) {
-	if(part > 1) return 0;
-	if(part == 1) return seq_midi_get_channel(1);
-	return seq_midi_get_channel(0);
-}
-
-// set a midi part channel
-void sysconfig_set_midi_channel(unsigned char part, unsigned char channel) {
-	if(part > 1) return;
-	if(channel > 15) seq_midi_set_channel(part, 15);
-	else seq_midi_set_channel(part, channel);
-	if(part == 1) params[PARAM_MIDI_PT2_CHAN] = seq_midi_get_channel(1);
-	else params[PARAM_MIDI_PT1_CHAN] = seq_midi_get_channel(0);
-	dirty = 1;
-}
-
-// get the key transpose assignment
-unsigned char sysconfig_get_key_transpose(void) {
-	return params[PARAM_KEY_TRANSPOSE];
-}
-
-// set the key transpose assignment
-void sysconfig_set_key_transpose(unsigned char assign) {
-	if(assign > 3) params[PARAM_KEY_TRANSPOSE] = 3;
-	else params[PARAM_KEY_TRANSPOSE] = assign;
-	dirty = 1;
-}
-
-// get the key trigger mode
-unsigned char sysconfig_get_key_trigger(void) {
-	return params[PARAM_KEY_TRIGGER];
-}
-
-// set the key trigger mode
-void sysconfig_set_key_trigger(unsigned char mode) {
-	if(mode > 1) params[PARAM_KEY_TRIGGER] = SYSCONFIG_KEY_TRIGGER_MOM;
-	else params[PARAM_KEY_TRIGGER] = mode;
-	dirty = 1;
-}
-
-// get the screen contrast
-unsigned char sysconfig_get_lcd_contrast(void) {
-	return screen_get_contrast();
-}
-
-// set the screen contrast
-void sysconfig_set_lcd_contrast(unsigned char contrast) {
-	screen_set_contrast(contrast);
-	params[PARAM_LCD_CONTRAST] = contrast;
-	dirty = 1;
-}
-
-// get the clock speed
-unsigned char sysconfig_get_clock_speed(void) {
-	return clock_get_speed();
-}
-
-// set the clock speed
-void sysconfig_set_clock_speed(unsigned char speed) {
-	clock_set_speed(speed);
-	params[PARAM_CLOCK_SPEED] = speed;
-	dirty = 1;
-}
-
-// get the reset mode
-unsigned char sysconfig_get_reset_mode(void) {
-	return params[PARAM_RESET_MODE];
-}
-
-// set the reset mode
-void sysconfig_set_reset_mode(unsigned char reset_mode) {
-	params[PARAM_RESET_MODE] = reset_mode;
-	dirty = 1;
-}
-
-// get the current song
-unsigned char sysconfig_get_current_song(void) {
-	return params[PARAM_CURRENT_SONG];
-}
-
-// set the current song
-void sysconfig_set_current_song(unsigned char current_song) {
-	params[PARAM_CURRENT_SONG] = current_song;
-	dirty = 1;
-}
-
-// get the key map
-unsigned char sysconfig_get_key_map(void) {
-	return params[PARAM_KEY_MAP];
-}
-
-// set the key map
-void sysconfig_set_key_map(unsigned char key_map) {
-	params[PARAM_KEY_MAP] = key_map;
-	dirty = 1;
-}
-
+/*
+ * K2579 Step Sequencer - System Config
+ *
+ * Copyright 2011: Kilpatrick Audio
+ * Written by: Andrew Kilpatrick
+ *
+ * sysconfig page map:
+ *  0 - clock div
+ *  1 - mod1 assign
+ *  2 - mod2 assign
+ *  3 - live audition
+ *  4 - midi part 1 channel		- remote
+ *  5 - midi part 2 channel		- remote
+ *  6 - key transpose
+ *  7 - key trigger
+ *  8 - LCD contrast			- remote
+ *  9 - clock speed 			- remote
+ * 10 - reset song / sequence
+ * 11 - current loaded song
+ * 12 - key map | (NRPN param channel + 1, 0 = off) << 2
+ * 13 - CC map stored
+ * 14 - record mode
+ * 15 - arp part 1 mode
+ * 16 - arp part 2 mode
+ * 17 - arp part 1 octaves
+ * 18 - arp part 2 octaves
+ * 19-24 - midi part 3-8 channels	- remote
+ * 25 - lane CC 1 controller
+ * 26 - lane CC 2 controller
+ * 27 - accent gate
+ * 28 - random seed
+ * 29 - seq launch mode | seq switch mode << 2
+ * 30 - seq launch bar length in steps
+ * 31 - configured
+ *
+ * journal storage:
+ *  - settings are stored as a log of [id, value] records in a ring of
+ *    EEPROM pages so that no single page takes every write
+ *  - each save writes the changed settings to the next page in the ring
+ *  - settings set back to the value already stored are not written and
+ *    a save with nothing left to write is skipped
+ *  - the live records of the page after that are carried forward in the
+ *    same write so the page being written never holds the only copy of
+ *    a setting - a failed write only loses the new changes
+ *  - a record holding the default value isn't carried forward - the
+ *    replay gives the default once the page is reused
+ *  - at boot the pages are replayed from oldest to newest
+ *
+ * journal page format:
+ *  0 - magic
+ *  1-2 - sequence number
+ *  3-4 - number of times this page has been written
+ *  5 - number of records
+ *  6-29 - records - 2 bytes each: id, value
+ *  30-31 - CRC16 of bytes 0-29
+ *
+ * CC map storage:
+ *  - 128 entries of 4 bytes in the 16 pages after the journal
+ *  - 0 - target (bits 0-3), curve (bits 4-6)
+ *  - 1 - channel - 0-15 or SYSCONFIG_CC_CHAN_PARTS
+ *  - 2 - range min
+ *  - 3 - range max
+ *  - changed pages are written before the journal so the CC map stored
+ *    mark never points at pages that weren't written
+ *
+ */
+#include "sysconfig.h"
+#include "eeprom.h"
+#include "seq_midi.h"
+#include "screen_handler.h"
+#include "clock.h"
+#include "crc.h"
+#include "arp.h"
+#include "song.h"
+#include "sysex_bulk.h"
+
+#define EEPROM_CONFIG_ADDR 0x4000  // legacy single page config
+#define EEPROM_CONFIG_MARK 0x55
+
+// changed parameters to be saved
+unsigned long dirty;
+#define SYSCONFIG_DIRTY(param) dirty |= (1UL << (param))
+unsigned char saving;
+unsigned int save_timer;
+#define SYSCONFIG_SAVE_TIME 312
+
+// journal
+#define JOURNAL_ADDR EEPROM_SYSTEM_ADDR
+#define JOURNAL_MARK 0xc5
+#define JOURNAL_MAGIC 0
+#define JOURNAL_SEQ 1
+#define JOURNAL_WEAR 3
+#define JOURNAL_COUNT 5
+#define JOURNAL_RECORDS 6
+#define JOURNAL_MAX_RECORDS 12
+#define JOURNAL_CRC 30
+#define JOURNAL_NONE 0xff
+unsigned char journal_buf[SYSCONFIG_JOURNAL_PAGES * EEPROM_PAGE_SIZE];
+unsigned int journal_wear[SYSCONFIG_JOURNAL_PAGES];  // writes per page
+unsigned char journal_head;  // the next page to write
+unsigned int journal_seq;  // the next sequence number
+unsigned char param_page[32];  // the page holding the latest record of each param
+unsigned char param_default[32];  // the values the journal is replayed over
+unsigned char param_stored[32];  // the values a replay of the journal gives
+
+// CC map
+#define CC_MAP_ADDR (JOURNAL_ADDR + (SYSCONFIG_JOURNAL_PAGES * EEPROM_PAGE_SIZE))
+#define CC_MAP_MARK 0xa5
+#define CC_MAP_PAGES 16
+#define CC_MAP_TARGET 0
+#define CC_MAP_CHAN 1
+#define CC_MAP_MIN 2
+#define CC_MAP_MAX 3
+unsigned char cc_map[128][4];
+unsigned int cc_map_dirty;  // changed pages - 8 entries per page
+unsigned int cc_map_chans;  // channels used by the map other than the parts
+unsigned char cc_curve[SYSCONFIG_CC_NUM_CURVES][128];  // precomputed curves
+
+// parameters
+unsigned char params[32];
+#define PARAM_CLOCK_DIV 0
+#define PARAM_MOD1_ASSIGN 1
+#define PARAM_MOD2_ASSIGN 2
+#define PARAM_LIVE_AUDITION 3
+#define PARAM_MIDI_PT1_CHAN 4
+#define PARAM_MIDI_PT2_CHAN 5
+#define PARAM_KEY_TRANSPOSE 6
+#define PARAM_KEY_TRIGGER 7
+#define PARAM_LCD_CONTRAST 8
+#define PARAM_CLOCK_SPEED 9
+#define PARAM_RESET_MODE 10
+#define PARAM_CURRENT_SONG 11
+#define PARAM_KEY_MAP 12
+#define PARAM_CC_MAP 13
+#define PARAM_REC_MODE 14
+#define PARAM_ARP1_MODE 15
+#define PARAM_ARP2_MODE 16
+#define PARAM_ARP1_OCTAVES 17
+#define PARAM_ARP2_OCTAVES 18
+#define PARAM_MIDI_TRACK_CHAN 19  // parts 3 and up
+#define PARAM_LANE_CC1 25
+#define PARAM_LANE_CC2 26
+#define PARAM_ACCENT_GATE 27
+#define PARAM_RAND_SEED 28
+#define PARAM_LAUNCH_MODE 29
+#define PARAM_LAUNCH_BAR 30
+#define PARAM_CONFIGURED 31
+#define NUM_PARAMS 32
+
+// local functions
+unsigned char sysconfig_journal_load(void);
+void sysconfig_journal_write(void);
+void sysconfig_cc_map_load(void);
+void sysconfig_cc_map_write(void);
+void sysconfig_cc_map_update(void);
+
+// init the global config
+void sysconfig_init(void) {
+	unsigned long all;
+	int i;
+	for(i = 0; i < NUM_PARAMS; i ++) {
+		param_page[i] = JOURNAL_NONE;
+	}
+	saving = 0;
+	save_timer = 0;
+
+	// precompute the CC curves
+	for(i = 0; i < 128; i ++) {
+		cc_curve[SYSCONFIG_CC_CURVE_LIN][i] = i;
+		cc_curve[SYSCONFIG_CC_CURVE_EXP][i] = ((i * i) + 63) / 127;
+		cc_curve[SYSCONFIG_CC_CURVE_LOG][i] = 127 - ((((127 - i) * (127 - i)) + 63) / 127);
+		cc_curve[SYSCONFIG_CC_CURVE_SWITCH][i] = (i > 63) ? 127 : 0;
+		cc_curve[SYSCONFIG_CC_CURVE_INV][i] = 127 - i;
+	}
+
+	// start from defaults so that params missing from the journal are sane
+	sysconfig_reset_all();
+	all = dirty;
+	dirty = 0;
+	params[PARAM_CC_MAP] = 0xff;  // only set if the journal says so
+	for(i = 0; i < NUM_PARAMS; i ++) {
+		param_default[i] = params[i];
+		param_stored[i] = params[i];
+	}
+
+	// load config from the journal
+	if(!sysconfig_journal_load()) {
+		// no journal yet - take the old single page config if it exists
+		eeprom_read_page(EEPROM_CONFIG_ADDR, journal_buf);
+		if(journal_buf[PARAM_CONFIGURED] == EEPROM_CONFIG_MARK) {
+			for(i = 0; i < NUM_PARAMS; i ++) {
+				params[i] = journal_buf[i];
+			}
+		}
+		dirty = all;  // store everything in the journal
+	}
+
+	// load the CC map if it has been stored
+	if(params[PARAM_CC_MAP] == CC_MAP_MARK) {
+		sysconfig_cc_map_load();
+	}
+	else {
+		params[PARAM_CC_MAP] = CC_MAP_MARK;
+		SYSCONFIG_DIRTY(PARAM_CC_MAP);
+	}
+	all = dirty;
+
+	// force parameters that are remote
+	sysconfig_set_midi_channel(0, params[PARAM_MIDI_PT1_CHAN]);
+	sysconfig_set_midi_channel(1, params[PARAM_MIDI_PT2_CHAN]);
+	for(i = SONG_NUM_CV_PARTS; i < SONG_NUM_PARTS; i ++) {
+		sysconfig_set_midi_channel(i, params[PARAM_MIDI_TRACK_CHAN +
+			(i - SONG_NUM_CV_PARTS)]);
+	}
+	sysconfig_set_lcd_contrast(params[PARAM_LCD_CONTRAST]);
+	sysconfig_set_clock_speed(params[PARAM_CLOCK_SPEED]);
+	dirty = all;
+}
+
+// run the sysconfig task
+void sysconfig_task(void) {
+	save_timer ++;
+	if(save_timer >= SYSCONFIG_SAVE_TIME) {
+		save_timer = 0;
+		if(dirty || cc_map_dirty) saving = 1;
+	}
+	// write one page per pass until all changes are stored
+	if(!saving) return;
+	// the EEPROM is being replaced underneath us
+	if(sysex_bulk_restoring()) return;
+	if(cc_map_dirty) sysconfig_cc_map_write();
+	else if(dirty) sysconfig_journal_write();
+	if(!dirty && !cc_map_dirty) saving = 0;
+}
+
+// check if settings are waiting to be written
+unsigned char sysconfig_save_pending(void) {
+	return saving;
+}
+
+// get the number of times a journal page has been written
+unsigned int sysconfig_get_page_writes(unsigned char page) {
+	if(page > (SYSCONFIG_JOURNAL_PAGES - 1)) return 0;
+	return journal_wear[page];
+}
+
+// reset all settings
+void sysconfig_reset_all(void) {
+	int i;
+	for(i = 0; i < 32; i ++) {
+		params[i] = 0xff;
+	}
+	sysconfig_set_clock_div(6);
+	sysconfig_set_mod_assign(0, SYSCONFIG_MOD_NONE);
+	sysconfig_set_mod_assign(1, SYSCONFIG_MOD_NONE);
+	sysconfig_set_live_aud(1);
+	for(i = 0; i < SONG_NUM_PARTS; i ++) {
+		sysconfig_set_midi_channel(i, i);
+	}
+	sysconfig_set_key_transpose(SYSCONFIG_KEY_TRANSPOSE12);
+	sysconfig_set_key_trigger(0);
+	sysconfig_set_lcd_contrast(160);
+	sysconfig_set_clock_speed(100);
+	sysconfig_set_reset_mode(SYSCONFIG_RESET_MODE_SONG);
+	sysconfig_set_current_song(0);
+	sysconfig_set_key_map(SYSCONFIG_KEY_MAP_A);
+	sysconfig_set_param_channel(15);
+	sysconfig_set_rec_mode(SYSCONFIG_REC_OVERDUB);
+	sysconfig_set_arp_mode(0, ARP_OFF);
+	sysconfig_set_arp_mode(1, ARP_OFF);
+	sysconfig_set_arp_octaves(0, 1);
+	sysconfig_set_arp_octaves(1, 1);
+	sysconfig_set_lane_cc(0, 1);  // mod wheel
+	sysconfig_set_lane_cc(1, 74);  // brightness
+	sysconfig_set_accent_gate(0);
+	sysconfig_set_rand_seed(0);
+	sysconfig_set_launch_mode(SYSCONFIG_LAUNCH_LOOP);
+	sysconfig_set_switch_mode(SYSCONFIG_SWITCH_RESTART);
+	sysconfig_set_launch_bar(16);
+	sysconfig_reset_cc_map();
+	params[PARAM_CONFIGURED] = EEPROM_CONFIG_MARK;
+	SYSCONFIG_DIRTY(PARAM_CONFIGURED);
+}
+
+// get the clock divider
+unsigned char sysconfig_get_clock_div(void) {
+	return params[PARAM_CLOCK_DIV];
+}
+
+// set the clock divider
+void sysconfig_set_clock_div(unsigned char div) {
+	if(div < 1) {
+		params[PARAM_CLOCK_DIV] = 1;
+	}
+	else if(div > SYSCONFIG_MAX_CLOCK_DIV) {
+		params[PARAM_CLOCK_DIV] = SYSCONFIG_MAX_CLOCK_DIV;
+	}
+	else params[PARAM_CLOCK_DIV] = div;
+	SYSCONFIG_DIRTY(PARAM_CLOCK_DIV);
+}
+
+// get a mod assignment
+unsigned char sysconfig_get_mod_assign(unsigned char part) {
+	if(part) return params[PARAM_MOD2_ASSIGN];
+	return params[PARAM_MOD1_ASSIGN];
+}
+
+// set a mod assignment
+void sysconfig_set_mod_assign(unsigned char part, unsigned char assign) {
+	if(part) {
+		if(assign > SYSCONFIG_MAX_MOD_ASSIGN) {
+			params[PARAM_MOD2_ASSIGN] = SYSCONFIG_MAX_MOD_ASSIGN;
+		}
+		else {
+			params[PARAM_MOD2_ASSIGN] = assign;
+		}
+	}
+	else {
+		if(assign > SYSCONFIG_MAX_MOD_ASSIGN) {
+			params[PARAM_MOD1_ASSIGN] = SYSCONFIG_MAX_MOD_ASSIGN;
+		}
+		else {
+			params[PARAM_MOD1_ASSIGN] = assign;
+		}
+	}
+	if(part) SYSCONFIG_DIRTY(PARAM_MOD2_ASSIGN);
+	else SYSCONFIG_DIRTY(PARAM_MOD1_ASSIGN);
+}
+
+// get the live audition state
+unsigned char sysconfig_get_live_aud(void) {
+	return params[PARAM_LIVE_AUDITION];
+}
+
+// set the live audition state
+void sysconfig_set_live_aud(unsigned char aud) {
+	if(aud) params[PARAM_LIVE_AUDITION] = 1;
+	else params[PARAM_LIVE_AUDITION] = 0;
+	SYSCONFIG_DIRTY(PARAM_LIVE_AUDITION);
+}
+
+// get a midi part channel
+unsigned char sysconfig_get_midi_channel(unsigned char part) {
+	if(part > (SONG_NUM_PARTS - 1)) return 0;
+	if(part > 1) return seq_midi_get_channel(part);
+	if(part == 1) return seq_midi_get_channel(1);
+	return seq_midi_get_channel(0);
+}
+
+// set a midi part channel
+void sysconfig_set_midi_channel(unsigned char part, unsigned char channel) {
+	if(part > (SONG_NUM_PARTS - 1)) return;
+	// MIDI only parts - unset channels start on the part number
+	if(part > 1) {
+		if(channel > 15) channel = part;
+		seq_midi_set_channel(part, channel);
+		params[PARAM_MIDI_TRACK_CHAN + (part - SONG_NUM_CV_PARTS)] = channel;
+		SYSCONFIG_DIRTY(PARAM_MIDI_TRACK_CHAN + (part - SONG_NUM_CV_PARTS));
+		return;
+	}
+	if(channel > 15) seq_midi_set_channel(part, 15);
+	else seq_midi_set_channel(part, channel);
+	if(part == 1) params[PARAM_MIDI_PT2_CHAN] = seq_midi_get_channel(1);
+	else params[PARAM_MIDI_PT1_CHAN] = seq_midi_get_channel(0);
+	if(part == 1) SYSCONFIG_DIRTY(PARAM_MIDI_PT2_CHAN);
+	else SYSCONFIG_DIRTY(PARAM_MIDI_PT1_CHAN);
+}
+
+// get the key transpose assignment
+unsigned char sysconfig_get_key_transpose(void) {
+	return params[PARAM_KEY_TRANSPOSE];
+}
+
+// set the key transpose assignment
+void sysconfig_set_key_transpose(unsigned char assign) {
+	if(assign > 3) params[PARAM_KEY_TRANSPOSE] = 3;
+	else params[PARAM_KEY_TRANSPOSE] = assign;
+	SYSCONFIG_DIRTY(PARAM_KEY_TRANSPOSE);
+}
+
+// get the key trigger mode
+unsigned char sysconfig_get_key_trigger(void) {
+	return params[PARAM_KEY_TRIGGER];
+}
+
+// set the key trigger mode
+void sysconfig_set_key_trigger(unsigned char mode) {
+	if(mode > 1) params[PARAM_KEY_TRIGGER] = SYSCONFIG_KEY_TRIGGER_MOM;
+	else params[PARAM_KEY_TRIGGER] = mode;
+	SYSCONFIG_DIRTY(PARAM_KEY_TRIGGER);
+}
+
+// get the screen contrast
+unsigned char sysconfig_get_lcd_contrast(void) {
+	return screen_get_contrast();
+}
+
+// set the screen contrast
+void sysconfig_set_lcd_contrast(unsigned char contrast) {
+	screen_set_contrast(contrast);
+	params[PARAM_LCD_CONTRAST] = contrast;
+	SYSCONFIG_DIRTY(PARAM_LCD_CONTRAST);
+}
+
+// get the clock speed
+unsigned char sysconfig_get_clock_speed(void) {
+	return clock_get_speed();
+}
+
+// set the clock speed
+void sysconfig_set_clock_speed(unsigned char speed) {
+	clock_set_speed(speed);
+	params[PARAM_CLOCK_SPEED] = speed;
+	SYSCONFIG_DIRTY(PARAM_CLOCK_SPEED);
+}
+
+// get the reset mode
+unsigned char sysconfig_get_reset_mode(void) {
+	return params[PARAM_RESET_MODE];
+}
+
+// set the reset mode
+void sysconfig_set_reset_mode(unsigned char reset_mode) {
+	params[PARAM_RESET_MODE] = reset_mode;
+	SYSCONFIG_DIRTY(PARAM_RESET_MODE);
+}
+
+// get the current song
+unsigned char sysconfig_get_current_song(void) {
+	return params[PARAM_CURRENT_SONG];
+}
+
+// set the current song
+void sysconfig_set_current_song(unsigned char current_song) {
+	params[PARAM_CURRENT_SONG] = current_song;
+	SYSCONFIG_DIRTY(PARAM_CURRENT_SONG);
+}
+
+// get the key map
+unsigned char sysconfig_get_key_map(void) {
+	return params[PARAM_KEY_MAP] & 0x03;
+}
+
+// set the key map
+void sysconfig_set_key_map(unsigned char key_map) {
+	if(key_map > SYSCONFIG_KEY_MAP_REC) return;
+	params[PARAM_KEY_MAP] = (params[PARAM_KEY_MAP] & 0x7c) | key_map;
+	SYSCONFIG_DIRTY(PARAM_KEY_MAP);
+	seq_midi_update_thru();
+}
+
+// get the channel that NRPN param access listens on
+unsigned char sysconfig_get_param_channel(void) {
+	unsigned char chan = (params[PARAM_KEY_MAP] >> 2) & 0x1f;
+	if(chan == 0 || chan > 16) return SYSCONFIG_PARAM_CHAN_OFF;
+	return chan - 1;
+}
+
+// set the channel that NRPN param access listens on
+void sysconfig_set_param_channel(unsigned char channel) {
+	if(channel > SYSCONFIG_PARAM_CHAN_OFF) return;
+	if(channel == SYSCONFIG_PARAM_CHAN_OFF) channel = 0;
+	else channel ++;
+	params[PARAM_KEY_MAP] = (params[PARAM_KEY_MAP] & 0x03) | (channel << 2);
+	SYSCONFIG_DIRTY(PARAM_KEY_MAP);
+	seq_midi_update_thru();
+}
+
+// get the record mode
+unsigned char sysconfig_get_rec_mode(void) {
+	if(params[PARAM_REC_MODE] == SYSCONFIG_REC_REPLACE) return SYSCONFIG_REC_REPLACE;
+	return SYSCONFIG_REC_OVERDUB;
+}
+
+// set the record mode
+void sysconfig_set_rec_mode(unsigned char rec_mode) {
+	if(rec_mode > SYSCONFIG_REC_REPLACE) return;
+	params[PARAM_REC_MODE] = rec_mode;
+	SYSCONFIG_DIRTY(PARAM_REC_MODE);
+}
+
+// get the arp mode of a part
+unsigned char sysconfig_get_arp_mode(unsigned char part) {
+	if(part > 1) return ARP_OFF;
+	if(params[PARAM_ARP1_MODE + part] > ARP_MAX_MODE) return ARP_OFF;
+	return params[PARAM_ARP1_MODE + part];
+}
+
+// set the arp mode of a part
+void sysconfig_set_arp_mode(unsigned char part, unsigned char mode) {
+	if(part > 1 || mode > ARP_MAX_MODE) return;
+	if(mode != params[PARAM_ARP1_MODE + part]) arp_clear(part);
+	params[PARAM_ARP1_MODE + part] = mode;
+	SYSCONFIG_DIRTY(PARAM_ARP1_MODE + part);
+}
+
+// get the arp octave range of a part
+unsigned char sysconfig_get_arp_octaves(unsigned char part) {
+	if(part > 1) return 1;
+	if(params[PARAM_ARP1_OCTAVES + part] < 1 ||
+			params[PARAM_ARP1_OCTAVES + part] > ARP_MAX_OCTAVES) return 1;
+	return params[PARAM_ARP1_OCTAVES + part];
+}
+
+// set the arp octave range of a part
+void sysconfig_set_arp_octaves(unsigned char part, unsigned char octaves) {
+	if(part > 1 || octaves < 1 || octaves > ARP_MAX_OCTAVES) return;
+	params[PARAM_ARP1_OCTAVES + part] = octaves;
+	SYSCONFIG_DIRTY(PARAM_ARP1_OCTAVES + part);
+}
+
+// get the controller sent by a CC lane
+unsigned char sysconfig_get_lane_cc(unsigned char lane) {
+	if(lane > 1) return 0;
+	if(params[PARAM_LANE_CC1 + lane] > SYSCONFIG_MAX_LANE_CC) return lane ? 74 : 1;
+	return params[PARAM_LANE_CC1 + lane];
+}
+
+// set the controller sent by a CC lane
+void sysconfig_set_lane_cc(unsigned char lane, unsigned char controller) {
+	if(lane > 1 || controller > SYSCONFIG_MAX_LANE_CC) return;
+	params[PARAM_LANE_CC1 + lane] = controller;
+	SYSCONFIG_DIRTY(PARAM_LANE_CC1 + lane);
+}
+
+// get the clock pulses added to the gate of accented steps on the CV outputs
+unsigned char sysconfig_get_accent_gate(void) {
+	if(params[PARAM_ACCENT_GATE] > SYSCONFIG_MAX_ACCENT_GATE) return 0;
+	return params[PARAM_ACCENT_GATE];
+}
+
+// set the clock pulses added to the gate of accented steps on the CV outputs
+void sysconfig_set_accent_gate(unsigned char gate) {
+	if(gate > SYSCONFIG_MAX_ACCENT_GATE) gate = SYSCONFIG_MAX_ACCENT_GATE;
+	params[PARAM_ACCENT_GATE] = gate;
+	SYSCONFIG_DIRTY(PARAM_ACCENT_GATE);
+}
+
+// get the random seed - 0 = free running
+unsigned char sysconfig_get_rand_seed(void) {
+	if(params[PARAM_RAND_SEED] > SYSCONFIG_MAX_RAND_SEED) return 0;
+	return params[PARAM_RAND_SEED];
+}
+
+// set the random seed - 0 = free running
+void sysconfig_set_rand_seed(unsigned char seed) {
+	if(seed > SYSCONFIG_MAX_RAND_SEED) seed = SYSCONFIG_MAX_RAND_SEED;
+	params[PARAM_RAND_SEED] = seed;
+	SYSCONFIG_DIRTY(PARAM_RAND_SEED);
+}
+
+// get when a cued seq starts
+unsigned char sysconfig_get_launch_mode(void) {
+	return params[PARAM_LAUNCH_MODE] & 0x03;
+}
+
+// set when a cued seq starts
+void sysconfig_set_launch_mode(unsigned char mode) {
+	if(mode > SYSCONFIG_LAUNCH_BAR) return;
+	params[PARAM_LAUNCH_MODE] = (params[PARAM_LAUNCH_MODE] & 0x0c) | mode;
+	SYSCONFIG_DIRTY(PARAM_LAUNCH_MODE);
+}
+
+// get where a cued seq starts
+unsigned char sysconfig_get_switch_mode(void) {
+	if(((params[PARAM_LAUNCH_MODE] >> 2) & 0x03) > SYSCONFIG_SWITCH_LEGATO) {
+		return SYSCONFIG_SWITCH_RESTART;
+	}
+	return (params[PARAM_LAUNCH_MODE] >> 2) & 0x03;
+}
+
+// set where a cued seq starts
+void sysconfig_set_switch_mode(unsigned char mode) {
+	if(mode > SYSCONFIG_SWITCH_LEGATO) return;
+	params[PARAM_LAUNCH_MODE] = (params[PARAM_LAUNCH_MODE] & 0x03) | (mode << 2);
+	SYSCONFIG_DIRTY(PARAM_LAUNCH_MODE);
+}
+
+// get the bar length in steps for the bar launch mode
+unsigned char sysconfig_get_launch_bar(void) {
+	if(params[PARAM_LAUNCH_BAR] < 1 || params[PARAM_LAUNCH_BAR] > SONG_NUM_STEPS) return 16;
+	return params[PARAM_LAUNCH_BAR];
+}
+
+// set the bar length in steps for the bar launch mode
+void sysconfig_set_launch_bar(unsigned char steps) {
+	if(steps < 1 || steps > SONG_NUM_STEPS) return;
+	params[PARAM_LAUNCH_BAR] = steps;
+	SYSCONFIG_DIRTY(PARAM_LAUNCH_BAR);
+}
+
+// reset the CC map to the factory assignments
+void sysconfig_reset_cc_map(void) {
+	int i;
+	for(i = 0; i < 128; i ++) {
+		cc_map[i][CC_MAP_TARGET] = SYSCONFIG_CC_NONE;
+		cc_map[i][CC_MAP_CHAN] = SYSCONFIG_CC_CHAN_PARTS;
+		cc_map[i][CC_MAP_MIN] = 0;
+		cc_map[i][CC_MAP_MAX] = 127;
+	}
+	cc_map[1][CC_MAP_TARGET] = SYSCONFIG_MOD_KEY_MAP;
+	for(i = 20; i < 26; i ++) {
+		cc_map[i][CC_MAP_TARGET] = i - 19;  // mod 1-6
+	}
+	cc_map[31][CC_MAP_TARGET] = SYSCONFIG_CC_RESTORE;
+	cc_map[64][CC_MAP_TARGET] = SYSCONFIG_MOD_SEQ_DIR;
+	cc_map_dirty = 0xffff;
+	sysconfig_cc_map_update();
+}
+
+// get the target of a CC
+unsigned char sysconfig_get_cc_target(unsigned char controller) {
+	return cc_map[controller & 0x7f][CC_MAP_TARGET] & 0x0f;
+}
+
+// get the channel a CC responds on
+unsigned char sysconfig_get_cc_channel(unsigned char controller) {
+	return cc_map[controller & 0x7f][CC_MAP_CHAN];
+}
+
+// set the target and channel of a CC
+void sysconfig_set_cc_map(unsigned char controller, unsigned char target,
+		unsigned char channel) {
+	unsigned char *entry = cc_map[controller & 0x7f];
+	if(target > SYSCONFIG_CC_MAX_TARGET) target = SYSCONFIG_CC_NONE;
+	if(channel > SYSCONFIG_CC_CHAN_PARTS) channel = SYSCONFIG_CC_CHAN_PARTS;
+	entry[CC_MAP_TARGET] = (entry[CC_MAP_TARGET] & 0x70) | target;
+	entry[CC_MAP_CHAN] = channel;
+	cc_map_dirty |= (1 << ((controller & 0x7f) >> 3));
+	sysconfig_cc_map_update();
+}
+
+// get the curve of a CC
+unsigned char sysconfig_get_cc_curve(unsigned char controller) {
+	return (cc_map[controller & 0x7f][CC_MAP_TARGET] >> 4) & 0x07;
+}
+
+// get the low end of the range of a CC
+unsigned char sysconfig_get_cc_min(unsigned char controller) {
+	return cc_map[controller & 0x7f][CC_MAP_MIN];
+}
+
+// get the high end of the range of a CC
+unsigned char sysconfig_get_cc_max(unsigned char controller) {
+	return cc_map[controller & 0x7f][CC_MAP_MAX];
+}
+
+// set the range and curve of a CC - min can be above max to invert
+void sysconfig_set_cc_range(unsigned char controller, unsigned char min,
+		unsigned char max, unsigned char curve) {
+	unsigned char *entry = cc_map[controller & 0x7f];
+	if(curve > (SYSCONFIG_CC_NUM_CURVES - 1)) curve = SYSCONFIG_CC_CURVE_LIN;
+	entry[CC_MAP_TARGET] = (entry[CC_MAP_TARGET] & 0x0f) | (curve << 4);
+	entry[CC_MAP_MIN] = min & 0x7f;
+	entry[CC_MAP_MAX] = max & 0x7f;
+	cc_map_dirty |= (1 << ((controller & 0x7f) >> 3));
+}
+
+// apply the curve and range of a CC to a value
+unsigned char sysconfig_get_cc_value(unsigned char controller, unsigned char value) {
+	unsigned char *entry = cc_map[controller & 0x7f];
+	int min = entry[CC_MAP_MIN];
+	value = cc_curve[(entry[CC_MAP_TARGET] >> 4) & 0x07][value & 0x7f];
+	return min + ((value * (entry[CC_MAP_MAX] - min)) / 127);
+}
+
+// get the channels used by the CC map other than the part channels
+unsigned int sysconfig_get_cc_channels(void) {
+	return cc_map_chans;
+}
+
+//
+// local functions
+//
+// load the journal and replay it into the params - returns 0 if empty
+unsigned char sysconfig_journal_load(void) {
+	unsigned char *page;
+	unsigned char newest = JOURNAL_NONE;
+	unsigned int crc, page_seq, seq = 0;
+	int i, p, n;
+
+	// read the whole ring in one go
+	eeprom_read(JOURNAL_ADDR, journal_buf, SYSCONFIG_JOURNAL_PAGES * EEPROM_PAGE_SIZE);
+
+	// find the valid pages and the newest one
+	for(p = 0; p < SYSCONFIG_JOURNAL_PAGES; p ++) {
+		page = journal_buf + (p * EEPROM_PAGE_SIZE);
+		crc = crc16_buf(CRC16_INIT, page, JOURNAL_CRC);
+		if(page[JOURNAL_MAGIC] != JOURNAL_MARK ||
+				page[JOURNAL_COUNT] > JOURNAL_MAX_RECORDS ||
+				page[JOURNAL_CRC] != (crc & 0xff) ||
+				page[JOURNAL_CRC + 1] != ((crc >> 8) & 0xff)) {
+			page[JOURNAL_MAGIC] = 0x00;  // mark invalid
+			journal_wear[p] = 0;
+			continue;
+		}
+		journal_wear[p] = page[JOURNAL_WEAR] | (page[JOURNAL_WEAR + 1] << 8);
+		page_seq = page[JOURNAL_SEQ] | (page[JOURNAL_SEQ + 1] << 8);
+		// sequence numbers wrap so compare them by difference
+		if(newest == JOURNAL_NONE || ((page_seq - seq) & 0xffff) < 0x8000) {
+			newest = p;
+			seq = page_seq;
+		}
+	}
+	journal_head = 0;
+	journal_seq = 0;
+	if(newest == JOURNAL_NONE) return 0;
+
+	// replay from the oldest page to the newest
+	for(i = 1; i <= SYSCONFIG_JOURNAL_PAGES; i ++) {
+		p = (newest + i) & (SYSCONFIG_JOURNAL_PAGES - 1);
+		page = journal_buf + (p * EEPROM_PAGE_SIZE);
+		if(page[JOURNAL_MAGIC] != JOURNAL_MARK) continue;
+		for(n = 0; n < page[JOURNAL_COUNT]; n ++) {
+			if(page[JOURNAL_RECORDS + (n << 1)] > (NUM_PARAMS - 1)) continue;
+			params[page[JOURNAL_RECORDS + (n << 1)]] = page[JOURNAL_RECORDS + (n << 1) + 1];
+			param_stored[page[JOURNAL_RECORDS + (n << 1)]] = page[JOURNAL_RECORDS + (n << 1) + 1];
+			param_page[page[JOURNAL_RECORDS + (n << 1)]] = p;
+		}
+	}
+	journal_head = (newest + 1) & (SYSCONFIG_JOURNAL_PAGES - 1);
+	journal_seq = (seq + 1) & 0xffff;
+	return 1;
+}
+
+// write changed params to the next journal page
+void sysconfig_journal_write(void) {
+	unsigned char *page = journal_buf;
+	unsigned char next = (journal_head + 1) & (SYSCONFIG_JOURNAL_PAGES - 1);
+	unsigned int crc;
+	int i, count = 0;
+
+	// params set back to the value already stored have nothing to write
+	for(i = 0; i < NUM_PARAMS; i ++) {
+		if(params[i] == param_stored[i]) dirty &= ~(1UL << i);
+	}
+	if(!dirty) return;
+
+	// carry forward params that would be lost when the next page is reused
+	// - a param left at its default is replayed without a record
+	for(i = 0; i < NUM_PARAMS; i ++) {
+		if(param_page[i] != next) continue;
+		if(!(dirty & (1UL << i)) && params[i] == param_default[i]) {
+			param_page[i] = JOURNAL_NONE;
+			continue;
+		}
+		page[JOURNAL_RECORDS + (count << 1)] = i;
+		page[JOURNAL_RECORDS + (count << 1) + 1] = params[i];
+		param_page[i] = journal_head;
+		param_stored[i] = params[i];
+		dirty &= ~(1UL << i);
+		count ++;
+	}
+	// changed params
+	for(i = 0; i < NUM_PARAMS && count < JOURNAL_MAX_RECORDS; i ++) {
+		if(dirty & (1UL << i)) {
+			page[JOURNAL_RECORDS + (count << 1)] = i;
+			page[JOURNAL_RECORDS + (count << 1) + 1] = params[i];
+			param_page[i] = journal_head;
+			param_stored[i] = params[i];
+			dirty &= ~(1UL << i);
+			count ++;
+		}
+	}
+	for(i = JOURNAL_RECORDS + (count << 1); i < JOURNAL_CRC; i ++) {
+		page[i] = 0xff;
+	}
+
+	// header
+	journal_wear[journal_head] ++;
+	page[JOURNAL_MAGIC] = JOURNAL_MARK;
+	page[JOURNAL_SEQ] = journal_seq & 0xff;
+	page[JOURNAL_SEQ + 1] = (journal_seq >> 8) & 0xff;
+	page[JOURNAL_WEAR] = journal_wear[journal_head] & 0xff;
+	page[JOURNAL_WEAR + 1] = (journal_wear[journal_head] >> 8) & 0xff;
+	page[JOURNAL_COUNT] = count;
+	crc = crc16_buf(CRC16_INIT, page, JOURNAL_CRC);
+	page[JOURNAL_CRC] = crc & 0xff;
+	page[JOURNAL_CRC + 1] = (crc >> 8) & 0xff;
+	eeprom_write_page(JOURNAL_ADDR + (journal_head * EEPROM_PAGE_SIZE), page);
+
+	journal_head = next;
+	journal_seq = (journal_seq + 1) & 0xffff;
+}
+
+// load the CC map and check each entry
+void sysconfig_cc_map_load(void) {
+	int i;
+	eeprom_read(CC_MAP_ADDR, cc_map[0], CC_MAP_PAGES * EEPROM_PAGE_SIZE);
+	for(i = 0; i < 128; i ++) {
+		if((cc_map[i][CC_MAP_TARGET] & 0x0f) > SYSCONFIG_CC_MAX_TARGET) {
+			cc_map[i][CC_MAP_TARGET] = SYSCONFIG_CC_NONE;
+		}
+		if(((cc_map[i][CC_MAP_TARGET] >> 4) & 0x07) > (SYSCONFIG_CC_NUM_CURVES - 1)) {
+			cc_map[i][CC_MAP_TARGET] &= 0x0f;
+		}
+		if(cc_map[i][CC_MAP_CHAN] > SYSCONFIG_CC_CHAN_PARTS) {
+			cc_map[i][CC_MAP_CHAN] = SYSCONFIG_CC_CHAN_PARTS;
+		}
+		cc_map[i][CC_MAP_MIN] &= 0x7f;
+		cc_map[i][CC_MAP_MAX] &= 0x7f;
+	}
+	cc_map_dirty = 0;
+	sysconfig_cc_map_update();
+}
+
+// write the first changed CC map page
+void sysconfig_cc_map_write(void) {
+	int page;
+	for(page = 0; page < CC_MAP_PAGES; page ++) {
+		if(cc_map_dirty & (1 << page)) {
+			eeprom_write_page(CC_MAP_ADDR + (page * EEPROM_PAGE_SIZE), cc_map[page << 3]);
+			cc_map_dirty &= ~(1 << page);
+			return;
+		}
+	}
+}
+
+// find the channels used by the map and update the MIDI thru filter
+void sysconfig_cc_map_update(void) {
+	int i;
+	cc_map_chans = 0;
+	for(i = 0; i < 128; i ++) {
+		if((cc_map[i][CC_MAP_TARGET] & 0x0f) != SYSCONFIG_CC_NONE &&
+				cc_map[i][CC_MAP_CHAN] < SYSCONFIG_CC_CHAN_PARTS) {
+			cc_map_chans |= (1 << cc_map[i][CC_MAP_CHAN]);
+		}
+	}
+	seq_midi_update_thru();
+}
@@ -1,115 +1,254 @@
-/*
- * K2579 Step Sequencer - System Config
- *
- * Copyright 2011: Kilpatrick Audio
- * Written by: Andrew Kilpatrick
- *
- */
-#define SYSCONFIG_MAX_CLOCK_DIV 24
-
-// mod input assignments
-#define SYSCONFIG_MOD_NONE 0
-#define SYSCONFIG_MOD_NEXT_SEQ 1
-#define SYSCONFIG_MOD_SEQ_START 2
-#define SYSCONFIG_MOD_SEQ_LEN 3
-#define SYSCONFIG_MOD_RUN_STOP 4
-#define SYSCONFIG_MOD_GATE1 5
-#define SYSCONFIG_MOD_GATE2 6
-#define SYSCONFIG_MOD_SEQ_DIR 7
-#define SYSCONFIG_MOD_KEY_MAP 8
-#define SYSCONFIG_MAX_MOD_ASSIGN 7
-// the KEY_MAP mod is not assignable
-
-// key transpose assignment
-#define SYSCONFIG_KEY_TRANSPOSE_OFF 0
-#define SYSCONFIG_KEY_TRANSPOSE1 1
-#define SYSCONFIG_KEY_TRANSPOSE2 2
-#define SYSCONFIG_KEY_TRANSPOSE12 3
-
-// key trigger assignments
-#define SYSCONFIG_KEY_TRIGGER_LATCH 0
-#define SYSCONFIG_KEY_TRIGGER_MOM 1
-
-// key map
-#define SYSCONFIG_KEY_MAP_A 0
-#define SYSCONFIG_KEY_MAP_B 1
-
-// reset modes
-#define SYSCONFIG_RESET_MODE_SONG 0
-#define SYSCONFIG_RESET_MODE_SEQ 1
-
-// init the global config
-void sysconfig_init(void);
-
-// run the sysconfig task
-void sysconfig_task(void);
-
-// reset all settings
-void sysconfig_reset_all(void);
-
-// get the clock divider
-unsigned char sysconfig_get_clock_div(void);
-
-// set the clock divider
-void sysconfig_set_clock_div(unsigned char div);
-
-// get a mod assignment
-unsigned char sysconfig_get_mod_assign(unsigned char part);
-
-// set a mod assign
-void sysconfig_set_mod_assign(unsigned char part, unsigned char assign);
-
-// get the live audition state
-unsigned char sysconfig_get_live_aud(void);
-
-// set the live audition state
-void sysconfig_set_live_aud(unsigned char aud);
-
-// get a midi part channel
-unsigned char sysconfig_get_midi_channel(unsigned char part);
-
-// set a midi part channel
-void sysconfig_set_midi_channel(unsigned char part, unsigned char channel);
-
-// get the key transpose assignment
-unsigned char sysconfig_get_key_transpose(void);
-
-// set the key transpose assignment
-void sysconfig_set_key_transpose(unsigned char assign);
-
-// get the key trigger mode
-unsigned char sysconfig_get_key_trigger(void);
-
-// set the key trigger mode
-void sysconfig_set_key_trigger(unsigned char mode);
-
-// get the screen contrast
-unsigned char sysconfig_get_lcd_contrast(void);
-
-// set the screen contrast
-void sysconfig_set_lcd_contrast(unsigned char contrast);
-
-// get the clock speed
-unsigned char sysconfig_get_clock_speed(void);
-
-// set the clock speed
-void sysconfig_set_clock_speed(unsigned char speed);
-
-// get the reset mode
-unsigned char sysconfig_get_reset_mode(void);
-
-// set the reset mode
-void sysconfig_set_reset_mode(unsigned char reset);
-
-// get the current song
-unsigned char sysconfig_get_current_song(void);
-
-// set the current song
-void sysconfig_set_current_song(unsigned char current_song);
-
-// get the key map
-unsigned char sysconfig_get_key_map(void);
-
-// set the key map
-void sysconfig_set_key_map(unsigned char key_map);
-
+/*
+ * K2579 Step Sequencer - System Config
+ *
+ * Copyright 2011: Kilpatrick Audio
+ * Written by: Andrew Kilpatrick
+ *
+ */
+#define SYSCONFIG_MAX_CLOCK_DIV 24
+#define SYSCONFIG_MAX_LANE_CC 119  // 120-127 are channel mode messages
+#define SYSCONFIG_MAX_ACCENT_GATE 24
+#define SYSCONFIG_MAX_RAND_SEED 127
+#define SYSCONFIG_JOURNAL_PAGES 16  // must be a power of 2
+
+// mod input assignments
+#define SYSCONFIG_MOD_NONE 0
+#define SYSCONFIG_MOD_NEXT_SEQ 1
+#define SYSCONFIG_MOD_SEQ_START 2
+#define SYSCONFIG_MOD_SEQ_LEN 3
+#define SYSCONFIG_MOD_RUN_STOP 4
+#define SYSCONFIG_MOD_GATE1 5
+#define SYSCONFIG_MOD_GATE2 6
+#define SYSCONFIG_MOD_SEQ_DIR 7
+#define SYSCONFIG_MOD_KEY_MAP 8
+#define SYSCONFIG_MAX_MOD_ASSIGN 7
+// the KEY_MAP mod is not assignable
+#define SYSCONFIG_MOD_FILL 11  // CC map only
+
+// key transpose assignment
+#define SYSCONFIG_KEY_TRANSPOSE_OFF 0
+#define SYSCONFIG_KEY_TRANSPOSE1 1
+#define SYSCONFIG_KEY_TRANSPOSE2 2
+#define SYSCONFIG_KEY_TRANSPOSE12 3
+
+// key trigger assignments
+#define SYSCONFIG_KEY_TRIGGER_LATCH 0
+#define SYSCONFIG_KEY_TRIGGER_MOM 1
+
+// key map
+#define SYSCONFIG_KEY_MAP_A 0
+#define SYSCONFIG_KEY_MAP_B 1
+#define SYSCONFIG_KEY_MAP_REC 2  // part channel notes are recorded
+
+// record modes
+#define SYSCONFIG_REC_OVERDUB 0  // keep the steps that are not played
+#define SYSCONFIG_REC_REPLACE 1  // steps passed without a note become rests
+
+// reset modes
+#define SYSCONFIG_RESET_MODE_SONG 0
+#define SYSCONFIG_RESET_MODE_SEQ 1
+
+// seq launch modes - when a cued seq starts
+#define SYSCONFIG_LAUNCH_LOOP 0  // at the end of the loop pass
+#define SYSCONFIG_LAUNCH_NOW 1  // on the next clock tick
+#define SYSCONFIG_LAUNCH_BEAT 2  // on the next beat
+#define SYSCONFIG_LAUNCH_BAR 3  // on the next bar of the launch bar steps
+
+// seq switch modes - where a cued seq starts
+#define SYSCONFIG_SWITCH_RESTART 0  // at the start of the seq
+#define SYSCONFIG_SWITCH_PHASE 1  // where it would be if it had played from the song start
+#define SYSCONFIG_SWITCH_LEGATO 2  // at the step index of the seq it replaces
+
+// CC map targets - SYSCONFIG_MOD_NEXT_SEQ to SYSCONFIG_MOD_KEY_MAP and
+// SYSCONFIG_MOD_FILL are sent as control overrides
+#define SYSCONFIG_CC_NONE 0  // echo to the MIDI out on the part channels
+#define SYSCONFIG_CC_RESTORE 9  // control restore when above 63
+#define SYSCONFIG_CC_IGNORE 10  // drop it
+#define SYSCONFIG_CC_MAX_TARGET 11
+
+// CC map channels
+#define SYSCONFIG_CC_CHAN_PARTS 16  // either part channel
+
+// NRPN param channel
+#define SYSCONFIG_PARAM_CHAN_OFF 16  // no NRPN param access
+
+// CC map curves
+#define SYSCONFIG_CC_CURVE_LIN 0
+#define SYSCONFIG_CC_CURVE_EXP 1
+#define SYSCONFIG_CC_CURVE_LOG 2
+#define SYSCONFIG_CC_CURVE_SWITCH 3
+#define SYSCONFIG_CC_CURVE_INV 4
+#define SYSCONFIG_CC_NUM_CURVES 5
+
+// init the global config
+void sysconfig_init(void);
+
+// run the sysconfig task
+void sysconfig_task(void);
+
+// check if settings are waiting to be written
+unsigned char sysconfig_save_pending(void);
+
+// get the number of times a journal page has been written
+unsigned int sysconfig_get_page_writes(unsigned char page);
+
+// reset all settings
+void sysconfig_reset_all(void);
+
+// get the clock divider
+unsigned char sysconfig_get_clock_div(void);
+
+// set the clock divider
+void sysconfig_set_clock_div(unsigned char div);
+
+// get a mod assignment
+unsigned char sysconfig_get_mod_assign(unsigned char part);
+
+// set a mod assign
+void sysconfig_set_mod_assign(unsigned char part, unsigned char assign);
+
+// get the live audition state
+unsigned char sysconfig_get_live_aud(void);
+
+// set the live audition state
+void sysconfig_set_live_aud(unsigned char aud);
+
+// get a midi part channel
+unsigned char sysconfig_get_midi_channel(unsigned char part);
+
+// set a midi part channel
+void sysconfig_set_midi_channel(unsigned char part, unsigned char channel);
+
+// get the key transpose assignment
+unsigned char sysconfig_get_key_transpose(void);
+
+// set the key transpose assignment
+void sysconfig_set_key_transpose(unsigned char assign);
+
+// get the key trigger mode
+unsigned char sysconfig_get_key_trigger(void);
+
+// set the key trigger mode
+void sysconfig_set_key_trigger(unsigned char mode);
+
+// get the screen contrast
+unsigned char sysconfig_get_lcd_contrast(void);
+
+// set the screen contrast
+void sysconfig_set_lcd_contrast(unsigned char contrast);
+
+// get the clock speed
+unsigned char sysconfig_get_clock_speed(void);
+
+// set the clock speed
+void sysconfig_set_clock_speed(unsigned char speed);
+
+// get the reset mode
+unsigned char sysconfig_get_reset_mode(void);
+
+// set the reset mode
+void sysconfig_set_reset_mode(unsigned char reset);
+
+// get the current song
+unsigned char sysconfig_get_current_song(void);
+
+// set the current song
+void sysconfig_set_current_song(unsigned char current_song);
+
+// get the key map
+unsigned char sysconfig_get_key_map(void);
+
+// set the key map
+void sysconfig_set_key_map(unsigned char key_map);
+
+// get the channel that NRPN param access listens on
+unsigned char sysconfig_get_param_channel(void);
+
+// set the channel that NRPN param access listens on
+void sysconfig_set_param_channel(unsigned char channel);
+
+// get the record mode
+unsigned char sysconfig_get_rec_mode(void);
+
+// set the record mode
+void sysconfig_set_rec_mode(unsigned char rec_mode);
+
+// get the arp mode of a part
+unsigned char sysconfig_get_arp_mode(unsigned char part);
+
+// set the arp mode of a part
+void sysconfig_set_arp_mode(unsigned char part, unsigned char mode);
+
+// get the arp octave range of a part
+unsigned char sysconfig_get_arp_octaves(unsigned char part);
+
+// set the arp octave range of a part
+void sysconfig_set_arp_octaves(unsigned char part, unsigned char octaves);
+
+// get the controller sent by a CC lane
+unsigned char sysconfig_get_lane_cc(unsigned char lane);
+
+// set the controller sent by a CC lane
+void sysconfig_set_lane_cc(unsigned char lane, unsigned char controller);
+
+// get the clock pulses added to the gate of accented steps on the CV outputs
+unsigned char sysconfig_get_accent_gate(void);
+
+// set the clock pulses added to the gate of accented steps on the CV outputs
+void sysconfig_set_accent_gate(unsigned char gate);
+
+// get the random seed - 0 = free running
+unsigned char sysconfig_get_rand_seed(void);
+
+// set the random seed - 0 = free running
+void sysconfig_set_rand_seed(unsigned char seed);
+
+// get when a cued seq starts
+unsigned char sysconfig_get_launch_mode(void);
+
+// set when a cued seq starts
+void sysconfig_set_launch_mode(unsigned char mode);
+
+// get where a cued seq starts
+unsigned char sysconfig_get_switch_mode(void);
+
+// set where a cued seq starts
+void sysconfig_set_switch_mode(unsigned char mode);
+
+// get the bar length in steps for the bar launch mode
+unsigned char sysconfig_get_launch_bar(void);
+
+// set the bar length in steps for the bar launch mode
+void sysconfig_set_launch_bar(unsigned char steps);
+
+// reset the CC map to the factory assignments
+void sysconfig_reset_cc_map(void);
+
+// get the target of a CC
+unsigned char sysconfig_get_cc_target(unsigned char controller);
+
+// get the channel a CC responds on
+unsigned char sysconfig_get_cc_channel(unsigned char controller);
+
+// set the target and channel of a CC
+void sysconfig_set_cc_map(unsigned char controller, unsigned char target,
+	unsigned char channel);
+
+// get the curve of a CC
+unsigned char sysconfig_get_cc_curve(unsigned char controller);
+
+// get the low end of the range of a CC
+unsigned char sysconfig_get_cc_min(unsigned char controller);
+
+// get the high end of the range of a CC
+unsigned char sysconfig_get_cc_max(unsigned char controller);
+
+// set the range and curve of a CC - min can be above max to invert
+void sysconfig_set_cc_range(unsigned char controller, unsigned char min,
+	unsigned char max, unsigned char curve);
+
+// apply the curve and range of a CC to a value
+unsigned char sysconfig_get_cc_value(unsigned char controller, unsigned char value);
+
+// get the channels used by the CC map other than the part channels
+unsigned int sysconfig_get_cc_channels(void);
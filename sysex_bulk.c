@@ -0,0 +1,490 @@
+/*
+ * K2579 Step Sequencer - SysEx Bulk Dump / Restore
+ *
+ * Copyright 2011: Kilpatrick Audio
+ * Written by: Andrew Kilpatrick
+ *
+ * A dump or restore is a stream of messages:
+ *  - HEADER - type, song, raw length
+ *  - DATA - one per block of up to 64 raw bytes packed 8-to-7
+ *  - END - CRC16 of all the raw data
+ *
+ * Every message ends with a 7 bit checksum of its payload and must be
+ * answered with an ACK before the next one is sent. The unit sends the
+ * ACK for a restore block only once the block has been written, so the
+ * host is held off while the EEPROM is busy. A message answered with an
+ * error status is sent again.
+ *
+ * While the whole EEPROM is being restored the config and song file
+ * tasks write nothing, and a restore is refused while a save is going.
+ *
+ * 8-to-7 packing - each group of up to 7 bytes is sent as one byte
+ * holding the top bits (bit 0 = first byte) followed by the low 7 bits
+ * of each byte.
+ *
+ * Received messages are decoded as the bytes arrive - the last byte of
+ * a message is held back until the next one arrives since it might be
+ * the checksum.
+ *
+ */
+#include "sysex_bulk.h"
+#include "midi.h"
+#include "eeprom.h"
+#include "crc.h"
+#include "sysconfig.h"
+#include "song_file.h"
+
+// states
+#define BULK_IDLE 0
+#define BULK_DUMP_SEND 1  // the next dump message needs to be sent
+#define BULK_DUMP_WAIT 2  // waiting for the host to ACK
+#define BULK_RESTORE 3  // waiting for the next restore message
+#define BULK_RESTORE_WRITE 4  // writing a restore block to the EEPROM
+#define BULK_TIMEOUT 125  // 2 seconds
+
+unsigned char bulk_state;
+unsigned char bulk_type;
+unsigned char bulk_song;
+int bulk_addr;  // start of the data in the EEPROM
+unsigned int bulk_len;  // total raw length
+unsigned int bulk_pos;  // raw bytes done
+unsigned int bulk_block;  // the current block
+unsigned int bulk_crc;
+unsigned char bulk_msg;  // the dump message in flight
+unsigned char bulk_fresh;  // the dump block needs to be read
+unsigned char bulk_write_count;  // pages of the block written
+unsigned int bulk_timer;
+unsigned char bulk_buf[BULK_BLOCK_SIZE];
+unsigned char bulk_buf_len;
+unsigned char bulk_tx_buf[BULK_PACKED_SIZE + 3];
+// receive
+unsigned char rx_cmd;  // the command being received or 0
+unsigned char rx_buf[5];  // payload of the short commands
+unsigned char rx_pos;  // payload bytes received
+unsigned char rx_held;  // the last byte received
+unsigned char rx_held_valid;
+unsigned char rx_sum;
+unsigned int rx_block;
+unsigned char rx_msb;  // top bits of the current 8-to-7 group
+unsigned char rx_unpacked;  // bytes unpacked into the block buffer
+unsigned char rx_overflow;
+
+// local functions
+void sysex_bulk_rx_payload(unsigned char data);
+void sysex_bulk_rx_request(void);
+void sysex_bulk_rx_header(unsigned char chk_ok);
+void sysex_bulk_rx_block(unsigned char chk_ok);
+void sysex_bulk_rx_stream_end(unsigned char chk_ok);
+void sysex_bulk_rx_ack(void);
+void sysex_bulk_send_msg(void);
+void sysex_bulk_send(unsigned char cmd, unsigned char data[], unsigned char len);
+void sysex_bulk_ack(unsigned char cmd, unsigned char status);
+void sysex_bulk_abort(void);
+unsigned char sysex_bulk_checksum(unsigned char data[], unsigned char len);
+
+// initialize the bulk dump handler
+void sysex_bulk_init(void) {
+	bulk_state = BULK_IDLE;
+	bulk_timer = 0;
+	rx_cmd = 0;
+}
+
+// run the bulk dump task
+void sysex_bulk_task(void) {
+	if(bulk_state == BULK_IDLE) return;
+
+	// give up if the other end has gone away
+	bulk_timer ++;
+	if(bulk_timer > BULK_TIMEOUT) {
+		sysex_bulk_abort();
+		return;
+	}
+
+	// send the next dump message
+	if(bulk_state == BULK_DUMP_SEND) {
+		sysex_bulk_send_msg();
+		bulk_timer = 0;
+		bulk_state = BULK_DUMP_WAIT;
+	}
+	// write a page of a restore block
+	else if(bulk_state == BULK_RESTORE_WRITE) {
+		eeprom_write_page(bulk_addr + bulk_pos + (bulk_write_count * EEPROM_PAGE_SIZE),
+			bulk_buf + (bulk_write_count * EEPROM_PAGE_SIZE));
+		bulk_write_count ++;
+		if((bulk_write_count * EEPROM_PAGE_SIZE) < bulk_buf_len) return;
+		// the block is stored - let the host send the next one
+		bulk_pos += bulk_buf_len;
+		bulk_block ++;
+		bulk_timer = 0;
+		bulk_state = BULK_RESTORE;
+		sysex_bulk_ack(BULK_CMD_DATA, BULK_OK);
+	}
+}
+
+// start receiving a bulk command
+void sysex_bulk_rx_start(unsigned char cmd) {
+	rx_cmd = cmd;
+	// only unpack into the block buffer when it is free
+	if(cmd == BULK_CMD_DATA && bulk_state != BULK_RESTORE) rx_cmd = 0;
+	rx_pos = 0;
+	rx_held_valid = 0;
+	rx_sum = 0;
+	rx_block = 0;
+	rx_unpacked = 0;
+	rx_overflow = 0;
+}
+
+// receive a bulk command byte
+void sysex_bulk_rx_data(unsigned char data_byte) {
+	if(!rx_cmd) return;
+	if(rx_held_valid) sysex_bulk_rx_payload(rx_held);
+	rx_held = data_byte;
+	rx_held_valid = 1;
+}
+
+// end of a bulk command
+void sysex_bulk_rx_end(void) {
+	unsigned char chk_ok = 0;
+	if(!rx_cmd) return;
+	// the held byte is the checksum on messages that have one
+	if(rx_cmd == BULK_CMD_REQUEST || rx_cmd == BULK_CMD_ACK) {
+		if(rx_held_valid) sysex_bulk_rx_payload(rx_held);
+	}
+	else if(rx_held_valid) chk_ok = ((rx_sum & 0x7f) == rx_held);
+
+	if(rx_cmd == BULK_CMD_REQUEST) sysex_bulk_rx_request();
+	else if(rx_cmd == BULK_CMD_HEADER) sysex_bulk_rx_header(chk_ok);
+	else if(rx_cmd == BULK_CMD_DATA) sysex_bulk_rx_block(chk_ok);
+	else if(rx_cmd == BULK_CMD_END) sysex_bulk_rx_stream_end(chk_ok);
+	else if(rx_cmd == BULK_CMD_ACK) sysex_bulk_rx_ack();
+	rx_cmd = 0;
+}
+
+// pack 8 bit data into 7 bit data - returns the packed length
+int sysex_bulk_pack(unsigned char src[], int len, unsigned char dest[]) {
+	int i, out = 0, msb = 0;
+	for(i = 0; i < len; i ++) {
+		// start a new group with the top bits byte
+		if((i % 7) == 0) {
+			msb = out;
+			dest[out ++] = 0x00;
+		}
+		if(src[i] & 0x80) dest[msb] |= (1 << (i % 7));
+		dest[out ++] = src[i] & 0x7f;
+	}
+	return out;
+}
+
+//
+// LOCAL FUNCTIONS
+//
+// handle a payload byte as it arrives
+void sysex_bulk_rx_payload(unsigned char data) {
+	unsigned char i;
+	rx_sum += data;
+	// data blocks are unpacked as they arrive - block (2 bytes), packed data
+	if(rx_cmd == BULK_CMD_DATA) {
+		if(rx_pos < 2) {
+			rx_block |= data << (rx_pos * 7);
+		}
+		else {
+			i = (rx_pos - 2) & 0x07;
+			if(i == 0) rx_msb = data;
+			else if(rx_unpacked < BULK_BLOCK_SIZE) {
+				bulk_buf[rx_unpacked] = data;
+				if(rx_msb & (1 << (i - 1))) bulk_buf[rx_unpacked] |= 0x80;
+				rx_unpacked ++;
+			}
+			else rx_overflow = 1;
+		}
+	}
+	// short commands are kept
+	else if(rx_pos < sizeof(rx_buf)) rx_buf[rx_pos] = data;
+	if(rx_pos < 255) rx_pos ++;
+}
+
+// handle a dump request - type, song
+void sysex_bulk_rx_request(void) {
+	unsigned char *data = rx_buf;
+	if(rx_pos != 2) return;
+	if(bulk_state != BULK_IDLE) {
+		sysex_bulk_ack(BULK_CMD_REQUEST, BULK_ERR_BUSY);
+		return;
+	}
+	bulk_type = data[0];
+	bulk_song = data[1];
+	if(bulk_type == BULK_TYPE_ALL) {
+		bulk_addr = 0;
+		bulk_len = EEPROM_SIZE;
+	}
+	else if(bulk_type == BULK_TYPE_SONG) {
+		bulk_addr = song_file_get_addr(bulk_song);
+		bulk_len = song_file_get_len(bulk_song);
+	}
+	else bulk_len = 0;
+	// nothing to dump
+	if(bulk_len == 0) {
+		sysex_bulk_ack(BULK_CMD_REQUEST, BULK_ERR_DATA);
+		return;
+	}
+	bulk_pos = 0;
+	bulk_block = 0;
+	bulk_crc = CRC16_INIT;
+	bulk_msg = BULK_CMD_HEADER;
+	bulk_timer = 0;
+	bulk_state = BULK_DUMP_SEND;
+}
+
+// handle a restore header - type, song, len (3 bytes), checksum
+void sysex_bulk_rx_header(unsigned char chk_ok) {
+	unsigned char *data = rx_buf;
+	if(rx_pos != 5) return;
+	if(!chk_ok) {
+		sysex_bulk_ack(BULK_CMD_HEADER, BULK_ERR_CHECKSUM);
+		return;
+	}
+	// a new header restarts a restore that is in progress
+	if(bulk_state == BULK_RESTORE) sysex_bulk_abort();
+	if(bulk_state != BULK_IDLE) {
+		sysex_bulk_ack(BULK_CMD_HEADER, BULK_ERR_BUSY);
+		return;
+	}
+	bulk_type = data[0];
+	bulk_song = data[1];
+	bulk_len = data[2] | (data[3] << 7) | ((unsigned int)data[4] << 14);
+	if(bulk_type == BULK_TYPE_ALL) {
+		if(bulk_len != EEPROM_SIZE) {
+			sysex_bulk_ack(BULK_CMD_HEADER, BULK_ERR_DATA);
+			return;
+		}
+		// don't write over a save that is still going
+		if(song_file_busy() || sysconfig_save_pending()) {
+			sysex_bulk_ack(BULK_CMD_HEADER, BULK_ERR_BUSY);
+			return;
+		}
+		bulk_addr = 0;
+	}
+	else if(bulk_type == BULK_TYPE_SONG) {
+		if(bulk_song > (SONG_FILE_NUM_SONGS - 1) || bulk_len == 0) {
+			sysex_bulk_ack(BULK_CMD_HEADER, BULK_ERR_DATA);
+			return;
+		}
+		if(!song_file_restore_start()) {
+			sysex_bulk_ack(BULK_CMD_HEADER, BULK_ERR_BUSY);
+			return;
+		}
+	}
+	else {
+		sysex_bulk_ack(BULK_CMD_HEADER, BULK_ERR_DATA);
+		return;
+	}
+	bulk_pos = 0;
+	bulk_block = 0;
+	bulk_crc = CRC16_INIT;
+	bulk_timer = 0;
+	bulk_state = BULK_RESTORE;
+	sysex_bulk_ack(BULK_CMD_HEADER, BULK_OK);
+}
+
+// handle a restore data block - block (2 bytes), packed data, checksum
+void sysex_bulk_rx_block(unsigned char chk_ok) {
+	unsigned int block = rx_block, expected;
+	int i;
+	if(bulk_state != BULK_RESTORE || rx_pos < 4) return;
+	if(!chk_ok) {
+		sysex_bulk_ack(BULK_CMD_DATA, BULK_ERR_CHECKSUM);
+		return;
+	}
+	// our ACK got lost - the block is already stored
+	if((block + 1) == bulk_block) {
+		sysex_bulk_ack(BULK_CMD_DATA, BULK_OK);
+		return;
+	}
+	if(block != bulk_block) {
+		sysex_bulk_ack(BULK_CMD_DATA, BULK_ERR_SEQUENCE);
+		return;
+	}
+	expected = bulk_len - bulk_pos;
+	if(expected > BULK_BLOCK_SIZE) expected = BULK_BLOCK_SIZE;
+	if(rx_overflow || rx_unpacked != expected) {
+		sysex_bulk_ack(BULK_CMD_DATA, BULK_ERR_DATA);
+		return;
+	}
+	bulk_buf_len = expected;
+	bulk_crc = crc16_buf(bulk_crc, bulk_buf, bulk_buf_len);
+	bulk_timer = 0;
+
+	// songs are unpacked as they arrive
+	if(bulk_type == BULK_TYPE_SONG) {
+		for(i = 0; i < bulk_buf_len; i ++) {
+			if(!song_file_restore_byte(bulk_buf[i])) {
+				sysex_bulk_abort();
+				sysex_bulk_ack(BULK_CMD_DATA, BULK_ERR_DATA);
+				return;
+			}
+		}
+		bulk_pos += bulk_buf_len;
+		bulk_block ++;
+		sysex_bulk_ack(BULK_CMD_DATA, BULK_OK);
+	}
+	// raw data is written by the task - the ACK is sent when it is done
+	else {
+		bulk_write_count = 0;
+		bulk_state = BULK_RESTORE_WRITE;
+	}
+}
+
+// handle the end of a restore - CRC16 (3 bytes), checksum
+void sysex_bulk_rx_stream_end(unsigned char chk_ok) {
+	unsigned char *data = rx_buf;
+	unsigned int crc;
+	if(bulk_state != BULK_RESTORE || rx_pos != 3) return;
+	if(!chk_ok) {
+		sysex_bulk_ack(BULK_CMD_END, BULK_ERR_CHECKSUM);
+		return;
+	}
+	crc = data[0] | (data[1] << 7) | (data[2] << 14);
+	if(bulk_pos != bulk_len || crc != bulk_crc) {
+		sysex_bulk_abort();
+		sysex_bulk_ack(BULK_CMD_END, BULK_ERR_DATA);
+		return;
+	}
+	bulk_state = BULK_IDLE;
+	// the song is saved to its slot
+	if(bulk_type == BULK_TYPE_SONG) {
+		if(!song_file_restore_end(bulk_song)) {
+			sysex_bulk_ack(BULK_CMD_END, BULK_ERR_DATA);
+			return;
+		}
+	}
+	// everything changed underneath us - start again from the EEPROM
+	else {
+		sysconfig_init();
+		song_file_init();
+	}
+	sysex_bulk_ack(BULK_CMD_END, BULK_OK);
+}
+
+// handle an ACK from the host while dumping - cmd, status, block (2 bytes)
+void sysex_bulk_rx_ack(void) {
+	unsigned char *data = rx_buf;
+	if(bulk_state != BULK_DUMP_WAIT || rx_pos != 4) return;
+	if(data[0] != bulk_msg) return;
+	// the message was bad - send it again
+	if(data[1] != BULK_OK) {
+		bulk_state = BULK_DUMP_SEND;
+		return;
+	}
+	// dump is complete
+	if(bulk_msg == BULK_CMD_END) {
+		bulk_state = BULK_IDLE;
+		return;
+	}
+	if(bulk_msg == BULK_CMD_DATA) {
+		bulk_pos += bulk_buf_len;
+		bulk_block ++;
+	}
+	if(bulk_pos < bulk_len) {
+		bulk_msg = BULK_CMD_DATA;
+		bulk_fresh = 1;
+	}
+	else bulk_msg = BULK_CMD_END;
+	bulk_state = BULK_DUMP_SEND;
+}
+
+// send the dump message in flight
+void sysex_bulk_send_msg(void) {
+	int len;
+	if(bulk_msg == BULK_CMD_HEADER) {
+		bulk_tx_buf[0] = bulk_type;
+		bulk_tx_buf[1] = bulk_song;
+		bulk_tx_buf[2] = bulk_len & 0x7f;
+		bulk_tx_buf[3] = (bulk_len >> 7) & 0x7f;
+		bulk_tx_buf[4] = (bulk_len >> 14) & 0x7f;
+		sysex_bulk_send(BULK_CMD_HEADER, bulk_tx_buf, 5);
+	}
+	else if(bulk_msg == BULK_CMD_DATA) {
+		// read the block the first time it is sent
+		if(bulk_fresh) {
+			bulk_buf_len = BULK_BLOCK_SIZE;
+			if((bulk_len - bulk_pos) < BULK_BLOCK_SIZE) bulk_buf_len = bulk_len - bulk_pos;
+			eeprom_read(bulk_addr + bulk_pos, bulk_buf, bulk_buf_len);
+			bulk_crc = crc16_buf(bulk_crc, bulk_buf, bulk_buf_len);
+			bulk_fresh = 0;
+		}
+		bulk_tx_buf[0] = bulk_block & 0x7f;
+		bulk_tx_buf[1] = (bulk_block >> 7) & 0x7f;
+		len = sysex_bulk_pack(bulk_buf, bulk_buf_len, bulk_tx_buf + 2);
+		sysex_bulk_send(BULK_CMD_DATA, bulk_tx_buf, len + 2);
+	}
+	else {
+		bulk_tx_buf[0] = bulk_crc & 0x7f;
+		bulk_tx_buf[1] = (bulk_crc >> 7) & 0x7f;
+		bulk_tx_buf[2] = (bulk_crc >> 14) & 0x7f;
+		sysex_bulk_send(BULK_CMD_END, bulk_tx_buf, 3);
+	}
+}
+
+// send a bulk message with a checksum
+void sysex_bulk_send(unsigned char cmd, unsigned char data[], unsigned char len) {
+	int i;
+	_midi_tx_sysex_start();
+	_midi_tx_sysex_data(0x00);
+	_midi_tx_sysex_data(0x01);
+	_midi_tx_sysex_data(0x72);
+	_midi_tx_sysex_data(midi_get_device_type());
+	_midi_tx_sysex_data(cmd);
+	for(i = 0; i < len; i ++) {
+		_midi_tx_sysex_data(data[i]);
+	}
+	_midi_tx_sysex_data(sysex_bulk_checksum(data, len));
+	_midi_tx_sysex_end();
+}
+
+// send an ACK for a received message
+void sysex_bulk_ack(unsigned char cmd, unsigned char status) {
+	_midi_tx_sysex_start();
+	_midi_tx_sysex_data(0x00);
+	_midi_tx_sysex_data(0x01);
+	_midi_tx_sysex_data(0x72);
+	_midi_tx_sysex_data(midi_get_device_type());
+	_midi_tx_sysex_data(BULK_CMD_ACK);
+	_midi_tx_sysex_data(cmd);
+	_midi_tx_sysex_data(status);
+	_midi_tx_sysex_data(bulk_block & 0x7f);
+	_midi_tx_sysex_data((bulk_block >> 7) & 0x7f);
+	_midi_tx_sysex_end();
+}
+
+// stop a dump or restore
+void sysex_bulk_abort(void) {
+	// throw away a partly restored song
+	if(bulk_type == BULK_TYPE_SONG &&
+			(bulk_state == BULK_RESTORE || bulk_state == BULK_RESTORE_WRITE)) {
+		song_file_restore_end(SONG_FILE_NUM_SONGS);
+	}
+	// part of the EEPROM was replaced - start again from what is there
+	else if(sysex_bulk_restoring()) {
+		bulk_state = BULK_IDLE;
+		sysconfig_init();
+		song_file_init();
+	}
+	bulk_state = BULK_IDLE;
+}
+
+// check if a restore of the whole EEPROM is in progress
+unsigned char sysex_bulk_restoring(void) {
+	if(bulk_type != BULK_TYPE_ALL) return 0;
+	if(bulk_state == BULK_RESTORE || bulk_state == BULK_RESTORE_WRITE) return 1;
+	return 0;
+}
+
+// compute the 7 bit checksum of a payload
+unsigned char sysex_bulk_checksum(unsigned char data[], unsigned char len) {
+	unsigned char sum = 0;
+	int i;
+	for(i = 0; i < len; i ++) {
+		sum += data[i];
+	}
+	return sum & 0x7f;
+}
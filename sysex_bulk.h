@@ -0,0 +1,49 @@
+/*
+ * K2579 Step Sequencer - SysEx Bulk Dump / Restore
+ *
+ * Copyright 2011: Kilpatrick Audio
+ * Written by: Andrew Kilpatrick
+ *
+ */
+// bulk commands - after the F0 00 01 72 <dev type> header
+#define BULK_CMD_REQUEST 0x73  // type, song
+#define BULK_CMD_HEADER 0x74  // type, song, len (3 bytes), checksum
+#define BULK_CMD_DATA 0x75  // block (2 bytes), packed data, checksum
+#define BULK_CMD_END 0x76  // CRC16 (3 bytes), checksum
+#define BULK_CMD_ACK 0x77  // cmd, status, block (2 bytes)
+
+// dump types
+#define BULK_TYPE_ALL 0  // the whole EEPROM
+#define BULK_TYPE_SONG 1  // a single song image
+
+// ACK status
+#define BULK_OK 0
+#define BULK_ERR_CHECKSUM 1
+#define BULK_ERR_SEQUENCE 2
+#define BULK_ERR_DATA 3
+#define BULK_ERR_BUSY 4
+
+// data blocks
+#define BULK_BLOCK_SIZE 64  // raw bytes per data message
+#define BULK_PACKED_SIZE 74  // 8-to-7 packed size of a full block
+
+// initialize the bulk dump handler
+void sysex_bulk_init(void);
+
+// run the bulk dump task
+void sysex_bulk_task(void);
+
+// start receiving a bulk command
+void sysex_bulk_rx_start(unsigned char cmd);
+
+// receive a bulk command byte
+void sysex_bulk_rx_data(unsigned char data_byte);
+
+// end of a bulk command
+void sysex_bulk_rx_end(void);
+
+// check if a restore of the whole EEPROM is in progress
+unsigned char sysex_bulk_restoring(void);
+
+// pack 8 bit data into 7 bit data - returns the packed length
+int sysex_bulk_pack(unsigned char src[], int len, unsigned char dest[]);
@@ -0,0 +1,66 @@
+/*
+ * K2579 Step Sequencer - Text Formatting
+ *
+ * Copyright 2011: Kilpatrick Audio
+ * Written by: Andrew Kilpatrick
+ *
+ */
+#include "text.h"
+
+// write a string
+char *text_str(char *dest, char *src) {
+	while(*src) *dest ++ = *src ++;
+	*dest = 0;
+	return dest;
+}
+
+// write a character
+char *text_char(char *dest, char ch) {
+	*dest ++ = ch;
+	*dest = 0;
+	return dest;
+}
+
+// write a number
+char *text_int(char *dest, int val, unsigned char fmt) {
+	char digits[10];
+	unsigned int num;
+	unsigned char len, pad;
+	char sign;
+	sign = 0;
+	if(val < 0) {
+		sign = '-';
+		num = -(unsigned int)val;
+	}
+	else {
+		if(fmt & TEXT_SIGN) sign = '+';
+		num = val;
+	}
+	// digits from the bottom up
+	len = 0;
+	do {
+		digits[len ++] = '0' + (num % 10);
+		num /= 10;
+	} while(num);
+	pad = fmt & TEXT_WIDTH;
+	if(sign) pad = (pad > len + 1) ? pad - (len + 1) : 0;
+	else pad = (pad > len) ? pad - len : 0;
+	// the sign goes before zeros and after spaces
+	if(sign && (fmt & TEXT_ZERO)) *dest ++ = sign;
+	while(pad) {
+		if(fmt & TEXT_ZERO) *dest ++ = '0';
+		else *dest ++ = ' ';
+		pad --;
+	}
+	if(sign && !(fmt & TEXT_ZERO)) *dest ++ = sign;
+	while(len) *dest ++ = digits[-- len];
+	*dest = 0;
+	return dest;
+}
+
+// write a name from a table - ? if the index is out of range
+char *text_name(char *dest, char *const names[], unsigned char index,
+		unsigned char count) {
+	if(index >= count) return text_char(dest, '?');
+	return text_str(dest, names[index]);
+}
@@ -0,0 +1,32 @@
+/*
+ * K2579 Step Sequencer - Text Formatting
+ *
+ * Copyright 2011: Kilpatrick Audio
+ * Written by: Andrew Kilpatrick
+ *
+ * Builds the screen lines without sprintf. Each call writes at dest,
+ * ends the text and returns the end so calls can be chained:
+ *
+ *   p = text_str(str, "st ");
+ *   p = text_int(p, step + 1, TEXT_ZERO | 2);
+ *
+ */
+#define TEXT_LINE_LEN 16  // characters on a screen line
+
+// number formats - the minimum width with the flags or'd in
+#define TEXT_WIDTH 0x0f  // padded on the left to this width
+#define TEXT_ZERO 0x80  // pad with 0 instead of spaces
+#define TEXT_SIGN 0x40  // show + on positive numbers
+
+// write a string
+char *text_str(char *dest, char *src);
+
+// write a character
+char *text_char(char *dest, char ch);
+
+// write a number
+char *text_int(char *dest, int val, unsigned char fmt);
+
+// write a name from a table - ? if the index is out of range
+char *text_name(char *dest, char *const names[], unsigned char index,
+	unsigned char count);
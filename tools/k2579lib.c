@@ -0,0 +1,268 @@
+/*
+ * K2579 Step Sequencer - SysEx Librarian
+ *
+ * Copyright 2011: Kilpatrick Audio
+ * Written by: Andrew Kilpatrick
+ *
+ * Host tool for the bulk dump / restore protocol. Dumps are saved as
+ * .syx files holding the HEADER, DATA and END messages exactly as the
+ * unit sent them, and a restore sends the same messages back, waiting
+ * for the ACK of each one before sending the next.
+ *
+ * usage:
+ *  k2579lib <midi device> dump-all <file.syx>
+ *  k2579lib <midi device> dump-song <song 1-8> <file.syx>
+ *  k2579lib <midi device> restore <file.syx> [song 1-8]
+ *
+ * The MIDI device is a raw MIDI device such as /dev/snd/midiC1D0.
+ *
+ * build: cc -o k2579lib k2579lib.c
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include "../sysex_bulk.h"
+
+#define DEV_TYPE 0x42  // K2579
+#define HDR_LEN 5  // 00 01 72 <dev type> <cmd>
+#define MSG_MAX 256
+#define TIMEOUT_MS 3000
+#define RETRIES 3
+
+int midi_fd;
+
+// read a sysex message - returns the length between F0 and F7 or -1
+int read_msg(unsigned char msg[]) {
+	struct pollfd pfd;
+	unsigned char b;
+	int len = -1;
+	while(1) {
+		pfd.fd = midi_fd;
+		pfd.events = POLLIN;
+		if(poll(&pfd, 1, TIMEOUT_MS) <= 0) return -1;
+		if(read(midi_fd, &b, 1) != 1) return -1;
+		if(b >= 0xf8) continue;  // realtime
+		if(b == 0xf0) len = 0;
+		else if(b == 0xf7) {
+			if(len >= 0) return len;
+		}
+		else if(b & 0x80) len = -1;  // some other message
+		else if(len >= 0 && len < MSG_MAX) msg[len ++] = b;
+	}
+}
+
+// read a bulk message for us - returns the command or -1
+int read_bulk(unsigned char msg[], int *len) {
+	while(1) {
+		*len = read_msg(msg);
+		if(*len < 0) return -1;
+		if(*len > HDR_LEN && msg[0] == 0x00 && msg[1] == 0x01 &&
+				msg[2] == 0x72 && msg[3] == DEV_TYPE) {
+			return msg[4];
+		}
+	}
+}
+
+// write a sysex message
+void write_msg(unsigned char msg[], int len) {
+	unsigned char b = 0xf0;
+	write(midi_fd, &b, 1);
+	write(midi_fd, msg, len);
+	b = 0xf7;
+	write(midi_fd, &b, 1);
+}
+
+// compute the 7 bit checksum of a payload
+unsigned char checksum(unsigned char data[], int len) {
+	unsigned char sum = 0;
+	int i;
+	for(i = 0; i < len; i ++) sum += data[i];
+	return sum & 0x7f;
+}
+
+// send a bulk command
+void send_bulk(unsigned char cmd, unsigned char data[], int len) {
+	unsigned char msg[MSG_MAX];
+	msg[0] = 0x00;
+	msg[1] = 0x01;
+	msg[2] = 0x72;
+	msg[3] = DEV_TYPE;
+	msg[4] = cmd;
+	memcpy(msg + HDR_LEN, data, len);
+	write_msg(msg, len + HDR_LEN);
+}
+
+// send an ACK
+void send_ack(unsigned char cmd, unsigned char status) {
+	unsigned char data[4] = {cmd, status, 0, 0};
+	send_bulk(BULK_CMD_ACK, data, 4);
+}
+
+// update a CCITT CRC16 - the same as the firmware
+unsigned int crc16_update(unsigned int crc, unsigned char data) {
+	int i;
+	crc ^= (data << 8);
+	for(i = 0; i < 8; i ++) {
+		if(crc & 0x8000) crc = (crc << 1) ^ 0x1021;
+		else crc <<= 1;
+	}
+	return crc & 0xffff;
+}
+
+// unpack 7 bit data into 8 bit data - the same as the firmware
+int unpack(unsigned char src[], int len, unsigned char dest[]) {
+	int i, out = 0, bit = 0;
+	unsigned char msb = 0;
+	for(i = 0; i < len; i ++) {
+		if((i & 0x07) == 0) {
+			msb = src[i];
+			bit = 0;
+			continue;
+		}
+		dest[out] = src[i] & 0x7f;
+		if(msb & (1 << bit)) dest[out] |= 0x80;
+		out ++;
+		bit ++;
+	}
+	return out;
+}
+
+// dump from the unit into a file
+int dump(unsigned char type, unsigned char song, char *filename) {
+	unsigned char msg[MSG_MAX], data[MSG_MAX], req[2] = {type, song};
+	unsigned int crc = 0xffff, len = 0, got = 0;
+	int cmd, msg_len, i, n;
+	FILE *f = fopen(filename, "wb");
+	if(f == NULL) {
+		perror(filename);
+		return 1;
+	}
+	send_bulk(BULK_CMD_REQUEST, req, 2);
+	while(1) {
+		cmd = read_bulk(msg, &msg_len);
+		if(cmd < 0) {
+			fprintf(stderr, "timeout waiting for the unit\n");
+			break;
+		}
+		if(cmd == BULK_CMD_ACK && msg_len >= HDR_LEN + 2) {
+			fprintf(stderr, "the unit refused the request: %d\n", msg[HDR_LEN + 1]);
+			break;
+		}
+		if(cmd != BULK_CMD_HEADER && cmd != BULK_CMD_DATA && cmd != BULK_CMD_END) continue;
+		// bad message - ask for it again
+		if(checksum(msg + HDR_LEN, msg_len - HDR_LEN - 1) != msg[msg_len - 1]) {
+			send_ack(cmd, BULK_ERR_CHECKSUM);
+			continue;
+		}
+		if(cmd == BULK_CMD_HEADER) {
+			len = msg[HDR_LEN + 2] | (msg[HDR_LEN + 3] << 7) | (msg[HDR_LEN + 4] << 14);
+		}
+		// check the data as it goes by
+		else if(cmd == BULK_CMD_DATA) {
+			n = unpack(msg + HDR_LEN + 2, msg_len - HDR_LEN - 3, data);
+			for(i = 0; i < n; i ++) crc = crc16_update(crc, data[i]);
+			got += n;
+			fprintf(stderr, "\r%u / %u bytes", got, len);
+		}
+		fputc(0xf0, f);
+		fwrite(msg, 1, msg_len, f);
+		fputc(0xf7, f);
+		send_ack(cmd, BULK_OK);
+		if(cmd == BULK_CMD_END) {
+			fprintf(stderr, "\n");
+			fclose(f);
+			if(got != len || crc != (unsigned int)(msg[HDR_LEN] | (msg[HDR_LEN + 1] << 7) |
+					(msg[HDR_LEN + 2] << 14))) {
+				fprintf(stderr, "dump is corrupt\n");
+				return 1;
+			}
+			fprintf(stderr, "dump ok\n");
+			return 0;
+		}
+	}
+	fclose(f);
+	return 1;
+}
+
+// restore a file to the unit
+int restore(char *filename, int song) {
+	unsigned char msg[MSG_MAX], reply[MSG_MAX];
+	int c, len, reply_len, cmd, tries, count = 0;
+	FILE *f = fopen(filename, "rb");
+	if(f == NULL) {
+		perror(filename);
+		return 1;
+	}
+	while(1) {
+		// next message from the file
+		while((c = fgetc(f)) != EOF && c != 0xf0);
+		if(c == EOF) break;
+		len = 0;
+		while((c = fgetc(f)) != EOF && c != 0xf7 && len < MSG_MAX) msg[len ++] = c;
+		if(len <= HDR_LEN || msg[0] != 0x00 || msg[1] != 0x01 || msg[2] != 0x72) continue;
+		msg[3] = DEV_TYPE;
+		// restore a song to a different slot
+		if(msg[4] == BULK_CMD_HEADER && song >= 0 && len == HDR_LEN + 6) {
+			msg[HDR_LEN + 1] = song;
+			msg[len - 1] = checksum(msg + HDR_LEN, len - HDR_LEN - 1);
+		}
+		for(tries = 0; tries < RETRIES; tries ++) {
+			write_msg(msg, len);
+			do {
+				cmd = read_bulk(reply, &reply_len);
+			} while(cmd >= 0 && (cmd != BULK_CMD_ACK || reply_len < HDR_LEN + 2 ||
+				reply[HDR_LEN] != msg[4]));
+			if(cmd < 0) {
+				fprintf(stderr, "\ntimeout waiting for the unit\n");
+				fclose(f);
+				return 1;
+			}
+			if(reply[HDR_LEN + 1] == BULK_OK) break;
+			if(reply[HDR_LEN + 1] == BULK_ERR_BUSY || reply[HDR_LEN + 1] == BULK_ERR_DATA) {
+				tries = RETRIES;
+			}
+		}
+		if(tries == RETRIES) {
+			fprintf(stderr, "\nthe unit rejected the data: %d\n", reply[HDR_LEN + 1]);
+			fclose(f);
+			return 1;
+		}
+		count ++;
+		fprintf(stderr, "\r%d messages", count);
+	}
+	fclose(f);
+	fprintf(stderr, "\nrestore ok\n");
+	return 0;
+}
+
+int main(int argc, char *argv[]) {
+	int ret = 1;
+	if(argc < 4) {
+		fprintf(stderr, "usage: %s <midi device> dump-all <file.syx>\n"
+			"       %s <midi device> dump-song <song 1-8> <file.syx>\n"
+			"       %s <midi device> restore <file.syx> [song 1-8]\n",
+			argv[0], argv[0], argv[0]);
+		return 1;
+	}
+	midi_fd = open(argv[1], O_RDWR);
+	if(midi_fd < 0) {
+		perror(argv[1]);
+		return 1;
+	}
+	if(strcmp(argv[2], "dump-all") == 0) {
+		ret = dump(BULK_TYPE_ALL, 0, argv[3]);
+	}
+	else if(strcmp(argv[2], "dump-song") == 0 && argc > 4) {
+		ret = dump(BULK_TYPE_SONG, atoi(argv[3]) - 1, argv[4]);
+	}
+	else if(strcmp(argv[2], "restore") == 0) {
+		ret = restore(argv[3], (argc > 4) ? (atoi(argv[4]) - 1) : -1);
+	}
+	else fprintf(stderr, "unknown command: %s\n", argv[2]);
+	close(midi_fd);
+	return ret;
+}
@@ -0,0 +1,143 @@
+/*
+ * K2579 Step Sequencer - MIDI Parser Benchmark
+ *
+ * Copyright 2011: Kilpatrick Audio
+ * Written by: Andrew Kilpatrick
+ *
+ * Host benchmark for the MIDI receive parser. The firmware parser is
+ * built in directly and fed a recorded MIDI stream through the receive
+ * buffer in the same way the UART interrupt and timer task do, and the
+ * parse rate is reported in bytes and messages per second.
+ *
+ * usage:
+ *  midi_bench [file.mid]
+ *
+ * The file is a raw MIDI capture (not a standard MIDI file). With no
+ * file a dense stream of notes, CCs with running status, clock, pitch
+ * bend and short sysex messages is generated instead.
+ *
+ * build: cc -O2 -o midi_bench midi_bench.c
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#define MIDI_HOST
+#include "../midi.c"
+
+#define GEN_LEN 65536  // size of the generated stream
+#define MIN_BYTES 50000000  // bytes to parse for a measurement
+
+unsigned long cb_count;  // callbacks run - keeps the stubs from going away
+
+// callbacks
+void _midi_learn_control(unsigned char channel, unsigned char controller) { cb_count ++; }
+void _midi_rx_note_off(unsigned char channel, unsigned char note) { cb_count ++; }
+void _midi_rx_note_on(unsigned char channel, unsigned char note, unsigned char velocity) { cb_count ++; }
+void _midi_rx_key_pressure(unsigned char channel, unsigned char note, unsigned char pressure) { cb_count ++; }
+void _midi_rx_control_change(unsigned char channel, unsigned char controller, unsigned char value) { cb_count ++; }
+void _midi_rx_all_sounds_off(unsigned char channel) { cb_count ++; }
+void _midi_rx_reset_all_controllers(unsigned char channel) { cb_count ++; }
+void _midi_rx_local_control(unsigned char channel, unsigned char value) { cb_count ++; }
+void _midi_rx_all_notes_off(unsigned char channel) { cb_count ++; }
+void _midi_rx_omni_off(unsigned char channel) { cb_count ++; }
+void _midi_rx_omni_on(unsigned char channel) { cb_count ++; }
+void _midi_rx_mono_on(unsigned char channel) { cb_count ++; }
+void _midi_rx_poly_on(unsigned char channel) { cb_count ++; }
+void _midi_rx_program_change(unsigned char channel, unsigned char program) { cb_count ++; }
+void _midi_rx_channel_pressure(unsigned char channel, unsigned char pressure) { cb_count ++; }
+void _midi_rx_pitch_bend(unsigned char channel, unsigned int bend) { cb_count ++; }
+void _midi_rx_mtc_qframe(unsigned char data) { cb_count ++; }
+void _midi_rx_song_position(unsigned int pos) { cb_count ++; }
+void _midi_rx_song_select(unsigned char song) { cb_count ++; }
+void _midi_rx_sysex_cmd_start(unsigned char cmd) { cb_count ++; }
+void _midi_rx_sysex_cmd_data(unsigned char data_byte) { cb_count ++; }
+void _midi_rx_sysex_cmd_end(unsigned char complete) { cb_count ++; }
+void _midi_rx_timing_tick(void) { cb_count ++; }
+void _midi_rx_start_song(void) { cb_count ++; }
+void _midi_rx_continue_song(void) { cb_count ++; }
+void _midi_rx_stop_song(void) { cb_count ++; }
+void _midi_rx_active_sensing(void) { cb_count ++; }
+void _midi_rx_system_reset(void) { cb_count ++; }
+void _midi_restart_device(void) { cb_count ++; }
+
+// generate a dense test stream - returns the length
+int generate(unsigned char buf[], int size) {
+	int len = 0, i;
+	unsigned char n = 0;
+	while(len < size - 32) {
+		// note on and off with running status
+		buf[len ++] = 0x90 | (n & 0x0f);
+		buf[len ++] = n & 0x7f;
+		buf[len ++] = 100;
+		buf[len ++] = n & 0x7f;
+		buf[len ++] = 0;
+		buf[len ++] = 0xf8;  // clock in the middle of things
+		// CC sweep with running status
+		buf[len ++] = 0xb0 | (n & 0x0f);
+		for(i = 0; i < 4; i ++) {
+			buf[len ++] = 74;
+			buf[len ++] = (n + i) & 0x7f;
+		}
+		// pitch bend
+		buf[len ++] = 0xe0 | (n & 0x0f);
+		buf[len ++] = n & 0x7f;
+		buf[len ++] = 0x40;
+		// a sysex for someone else
+		if((n & 0x07) == 0) {
+			buf[len ++] = 0xf0;
+			buf[len ++] = 0x43;
+			for(i = 0; i < 6; i ++) buf[len ++] = i;
+			buf[len ++] = 0xf7;
+		}
+		n ++;
+	}
+	return len;
+}
+
+int main(int argc, char *argv[]) {
+	static unsigned char buf[GEN_LEN];
+	struct timespec t0, t1;
+	unsigned long total = 0;
+	double secs;
+	int len, pos;
+	FILE *f;
+
+	if(argc > 1) {
+		f = fopen(argv[1], "rb");
+		if(f == NULL) {
+			perror(argv[1]);
+			return 1;
+		}
+		len = fread(buf, 1, GEN_LEN, f);
+		fclose(f);
+		if(len <= 0) {
+			fprintf(stderr, "%s: no data\n", argv[1]);
+			return 1;
+		}
+	}
+	else len = generate(buf, GEN_LEN);
+
+	midi_init(0x42);
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	while(total < MIN_BYTES) {
+		// fill the receive buffer as the UART would and drain it by task calls
+		for(pos = 0; pos < len; pos ++) {
+			midi_rx_byte(buf[pos]);
+			if((pos & 0x07) == 0x07) midi_rx_task();
+		}
+		while(rx_in_pos != rx_out_pos) midi_rx_task();
+		total += len;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	secs = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+
+	printf("stream: %d bytes (%s)\n", len, (argc > 1) ? argv[1] : "generated");
+	printf("parsed: %lu bytes, %lu messages in %.3f s\n",
+		midi_get_rx_stat(MIDI_STAT_BYTES), midi_get_rx_stat(MIDI_STAT_MSGS), secs);
+	printf("rate: %.0f bytes/s, %.0f messages/s\n",
+		midi_get_rx_stat(MIDI_STAT_BYTES) / secs, midi_get_rx_stat(MIDI_STAT_MSGS) / secs);
+	printf("max backlog: %lu, budget hits: %lu, callbacks: %lu\n",
+		midi_get_rx_stat(MIDI_STAT_MAX_BACKLOG), midi_get_rx_stat(MIDI_STAT_BUDGET_HITS), cb_count);
+	return 0;
+}
@@ -0,0 +1,164 @@
+/*
+ * K2579 Step Sequencer - Text Formatting Benchmark
+ *
+ * Copyright 2011: Kilpatrick Audio
+ * Written by: Andrew Kilpatrick
+ *
+ * Host benchmark for the screen line formatter. A set of typical screen
+ * redraws - the play bar, the note, lane, part step and arrangement
+ * pages and the CC map - is built once with sprintf the way the GUI used
+ * to and once with the text functions, and the time for each redraw is
+ * reported along with the speedup. Both versions are checked to give
+ * the same text first.
+ *
+ * usage:
+ *  text_bench [redraws]
+ *
+ * build: cc -O2 -o text_bench text_bench.c
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../text.c"
+#include "../scale.c"
+
+#define DEF_REDRAWS 2000000  // redraws of each page per measurement
+#define NUM_PAGES 6
+
+char str[256];  // the GUI line buffer size when it used sprintf
+char *const cc_names[] = {"none", "seq next", "seq start", "seq len"};
+unsigned long sum;  // keeps the lines from going away
+
+// the old note name if-chain for the chromatic scales
+void sprintf_note_name(unsigned char note, char *dest) {
+	unsigned char degree = note % 12;
+	unsigned char octave = note / 12;
+	if(degree == 0) sprintf(dest, "C %d", (octave + 1));
+	else if(degree == 1) sprintf(dest, "C#%d", (octave + 1));
+	else if(degree == 2) sprintf(dest, "D %d", (octave + 1));
+	else if(degree == 3) sprintf(dest, "D#%d", (octave + 1));
+	else if(degree == 4) sprintf(dest, "E %d", (octave + 1));
+	else if(degree == 5) sprintf(dest, "F %d", (octave + 1));
+	else if(degree == 6) sprintf(dest, "F#%d", (octave + 1));
+	else if(degree == 7) sprintf(dest, "G %d", (octave + 1));
+	else if(degree == 8) sprintf(dest, "G#%d", (octave + 1));
+	else if(degree == 9) sprintf(dest, "A %d", (octave + 1));
+	else if(degree == 10) sprintf(dest, "A#%d", (octave + 1));
+	else sprintf(dest, "B %d", (octave + 1));
+}
+
+// build a page line with sprintf
+void redraw_sprintf(int page, int i) {
+	char notename[16];
+	unsigned char step = i & 0x3f;
+	if(page == 0) {
+		sprintf(str, "playing:  %02d:%02d", (i & 0x0f) + 1, step + 1);
+	}
+	else if(page == 1) {
+		sprintf_note_name(i % 49, notename);
+		sprintf(str, "st %02d  note %s", step + 1, notename);
+	}
+	else if(page == 2) {
+		sprintf(str, "st %02d  vel %3d", step + 1, i & 0x7f);
+	}
+	else if(page == 3) {
+		sprintf(str, "start %02d", step + 1);
+		sprintf(str + 8, "  len %02d", (i & 0x1f) + 1);
+	}
+	else if(page == 4) {
+		sprintf(str, "en %02d  trans %+d", (i & 0x1f) + 1, (i % 25) - 12);
+	}
+	else {
+		sprintf(str, "cc%03d ", i & 0x7f);
+		strcat(str, cc_names[i & 0x03]);
+	}
+}
+
+// build a page line with the text functions
+void redraw_text(int page, int i) {
+	char *p;
+	unsigned char step = i & 0x3f;
+	if(page == 0) {
+		p = text_int(text_str(str, "playing:  "), (i & 0x0f) + 1, TEXT_ZERO | 2);
+		text_int(text_char(p, ':'), step + 1, TEXT_ZERO | 2);
+	}
+	else if(page == 1) {
+		p = text_int(text_str(str, "st "), step + 1, TEXT_ZERO | 2);
+		scale_note_to_name(i % 49, SCALE_CHROMATIC, text_str(p, "  note "));
+	}
+	else if(page == 2) {
+		p = text_int(text_str(str, "st "), step + 1, TEXT_ZERO | 2);
+		text_int(text_str(p, "  vel "), i & 0x7f, 3);
+	}
+	else if(page == 3) {
+		p = text_int(text_str(str, "start "), step + 1, TEXT_ZERO | 2);
+		text_int(text_str(p, "  len "), (i & 0x1f) + 1, TEXT_ZERO | 2);
+	}
+	else if(page == 4) {
+		p = text_int(text_str(str, "en "), (i & 0x1f) + 1, TEXT_ZERO | 2);
+		text_int(text_str(p, "  trans "), (i % 25) - 12, TEXT_SIGN);
+	}
+	else {
+		p = text_char(text_int(text_str(str, "cc"), i & 0x7f, TEXT_ZERO | 3), ' ');
+		text_name(p, cc_names, i & 0x03, 4);
+	}
+}
+
+// time a number of redraws of a page - returns ns per redraw
+double bench(void (*redraw)(int page, int i), int page, int redraws) {
+	struct timespec t0, t1;
+	int i;
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for(i = 0; i < redraws; i ++) {
+		redraw(page, i);
+		sum += str[8] + str[14];
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	return ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / redraws;
+}
+
+int main(int argc, char *argv[]) {
+	char *names[NUM_PAGES] = {"play bar", "note", "lane", "part steps",
+		"arrange", "cc map"};
+	char line[TEXT_LINE_LEN + 1];
+	double ns_sprintf, ns_text, tot_sprintf, tot_text;
+	int redraws, page, i;
+
+	redraws = DEF_REDRAWS;
+	if(argc > 1) redraws = atoi(argv[1]);
+	if(redraws < 1) {
+		fprintf(stderr, "usage: text_bench [redraws]\n");
+		return 1;
+	}
+
+	// both versions must give the same text
+	for(page = 0; page < NUM_PAGES; page ++) {
+		for(i = 0; i < 4096; i ++) {
+			redraw_sprintf(page, i);
+			strcpy(line, str);
+			redraw_text(page, i);
+			if(strcmp(line, str)) {
+				fprintf(stderr, "%s: '%s' != '%s'\n", names[page], line, str);
+				return 1;
+			}
+		}
+	}
+
+	tot_sprintf = 0;
+	tot_text = 0;
+	printf("%-12s %10s %10s %8s\n", "page", "sprintf ns", "text ns", "speedup");
+	for(page = 0; page < NUM_PAGES; page ++) {
+		ns_sprintf = bench(redraw_sprintf, page, redraws);
+		ns_text = bench(redraw_text, page, redraws);
+		tot_sprintf += ns_sprintf;
+		tot_text += ns_text;
+		printf("%-12s %10.1f %10.1f %7.1fx\n", names[page], ns_sprintf, ns_text,
+			ns_sprintf / ns_text);
+	}
+	printf("%-12s %10.1f %10.1f %7.1fx\n", "average", tot_sprintf / NUM_PAGES,
+		tot_text / NUM_PAGES, tot_sprintf / tot_text);
+	printf("(checksum %lu)\n", sum);
+	return 0;
+}